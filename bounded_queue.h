@@ -0,0 +1,163 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Bounded queue connecting the pipeline stages
+#ifndef bounded_queue_h
+#define bounded_queue_h
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief What to do when pushing into a full queue
+     */
+    enum class DropPolicy
+    {
+        // Wait for the consumer, e.g. offline transcoding
+        kBlock,
+        // Drop the oldest queued item, e.g. live camera input
+        kDropOldest,
+        // Drop the pushed item
+        kDropNewest
+    };
+
+    /**
+     * @brief Parse "block", "drop_oldest" or "drop_newest"
+     */
+    inline absl::StatusOr<DropPolicy> ParseDropPolicy(const std::string& policy)
+    {
+        if (policy == "block") { return DropPolicy::kBlock; }
+        if (policy == "drop_oldest") { return DropPolicy::kDropOldest; }
+        if (policy == "drop_newest") { return DropPolicy::kDropNewest; }
+        return absl::InvalidArgumentError("Unknown drop policy: " + policy);
+    }
+
+    /**
+     * @brief Thread safe FIFO queue holding at most capacity items
+     *
+     * Close() wakes up all waiting producers and consumers; pushing into a
+     * closed queue fails, while the queued items can still be popped.
+     * Dropped items are destroyed after the lock is released, so that their
+     * destructors may block, e.g. on the Python GIL.
+     */
+    template<typename T>
+    class BoundedQueue
+    {
+    private:
+        const size_t m_capacity;
+        const DropPolicy m_policy;
+
+        mutable absl::Mutex m_mutex;
+        std::deque<T> m_items ABSL_GUARDED_BY(m_mutex);
+        bool m_closed ABSL_GUARDED_BY(m_mutex) = false;
+        size_t m_dropped ABSL_GUARDED_BY(m_mutex) = 0;
+
+    public:
+        BoundedQueue(size_t capacity, DropPolicy policy)
+            : m_capacity(capacity > 0 ? capacity: 1), m_policy(policy)
+        {}
+
+        /**
+         * @brief Push an item, returns false if it was dropped or the queue is closed
+         */
+        bool Push(T item)
+        {
+            // Declared first to outlive the lock
+            std::optional<T> evicted;
+            absl::MutexLock lock(&m_mutex);
+            if (m_policy == DropPolicy::kBlock)
+            {
+                auto has_room = [this]()
+                { return m_closed || m_items.size() < m_capacity; };
+                m_mutex.Await(absl::Condition(&has_room));
+            }
+            if (m_closed) { return false; }
+
+            if (m_items.size() >= m_capacity)
+            {
+                ++m_dropped;
+                if (m_policy == DropPolicy::kDropNewest) { return false; }
+                evicted = std::move(m_items.front());
+                m_items.pop_front();
+            }
+            m_items.push_back(std::move(item));
+            return true;
+        }
+
+        /**
+         * @brief Wait for an item, returns false once the queue is closed and empty
+         */
+        bool Pop(T* item)
+        {
+            absl::MutexLock lock(&m_mutex);
+            auto has_item = [this]()
+            { return m_closed || !m_items.empty(); };
+            m_mutex.Await(absl::Condition(&has_item));
+            if (m_items.empty()) { return false; }
+
+            *item = std::move(m_items.front());
+            m_items.pop_front();
+            return true;
+        }
+
+        /**
+         * @brief Wait for an item for at most timeout, returns false if none
+         *        arrived or the queue is closed and empty
+         */
+        bool PopFor(T* item, absl::Duration timeout)
+        {
+            absl::MutexLock lock(&m_mutex);
+            auto has_item = [this]()
+            { return m_closed || !m_items.empty(); };
+            m_mutex.AwaitWithTimeout(absl::Condition(&has_item), timeout);
+            if (m_items.empty()) { return false; }
+
+            *item = std::move(m_items.front());
+            m_items.pop_front();
+            return true;
+        }
+
+        void Close()
+        {
+            absl::MutexLock lock(&m_mutex);
+            m_closed = true;
+        }
+
+        bool closed() const
+        {
+            absl::MutexLock lock(&m_mutex);
+            return m_closed;
+        }
+
+        // Number of items dropped so far
+        size_t dropped() const
+        {
+            absl::MutexLock lock(&m_mutex);
+            return m_dropped;
+        }
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,137 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Online anomaly scores of the proctor results against per-face baselines
+#include "mp_proctor/calculators/anomaly/proctor_anomaly.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        // MAD of a normal distribution in standard deviations
+        constexpr double kMadToSigma = 1.4826;
+    } // namespace
+
+    void RobustBaseline::Update(double value, double rate, double min_scale, bool warming)
+    {
+        if (warming || m_count == 0)
+        {
+            m_count++;
+            m_median += (value - m_median) / m_count;
+            m_deviation += (std::fabs(value - m_median) - m_deviation) / m_count;
+            return;
+        }
+
+        const double step = rate * std::max(m_deviation, min_scale);
+        m_median += value > m_median ? step: value < m_median ? -step: 0;
+        m_deviation += std::fabs(value - m_median) > m_deviation ? step: -step;
+        m_deviation = std::max(m_deviation, 0.0);
+    }
+
+    double RobustBaseline::Score(double value, double min_scale) const
+    {
+        if (m_count == 0) { return 0; }
+        return std::fabs(value - m_median) / (kMadToSigma * std::max(m_deviation, min_scale));
+    }
+
+    ProctorAnomalyScorer::ProctorAnomalyScorer(const ProctorAnomalyScorerOptions& options)
+        : m_options(options)
+    {}
+
+    void ProctorAnomalyScorer::Observe(
+        Track* track, ProctorAnomalyField field, double value, double rate, bool warming,
+        ProctorAnomaly* anomaly
+    )
+    {
+        RobustBaseline& baseline = track->baselines[field];
+        if (!warming)
+        {
+            anomaly->field_scores[field] = baseline.Score(value, m_options.min_scale);
+            anomaly->score = std::max(anomaly->score, anomaly->field_scores[field]);
+            anomaly->scored_fields |= 1u << field;
+        }
+        baseline.Update(value, rate, m_options.min_scale, warming);
+    }
+
+    void ProctorAnomalyScorer::Update(
+        int64_t timestamp_us, const std::vector<ProctorResult>& results,
+        std::vector<ProctorAnomaly>* anomalies
+    )
+    {
+        anomalies->assign(results.size(), ProctorAnomaly());
+        if (timestamp_us <= m_last_timestamp_us) { return; }
+        m_last_timestamp_us = timestamp_us;
+
+        if (m_tracks.size() < results.size()) { m_tracks.resize(results.size()); }
+        for (size_t face = 0; face < results.size(); ++face)
+        {
+            const ProctorResult& result = results[face];
+            if (result.is_carried_forward) { continue; }
+            Track& track = m_tracks[face];
+            if (!track.is_seen)
+            {
+                track.is_seen = true;
+                track.first_us = track.last_us = timestamp_us;
+            }
+
+            // Time based steps, so that the baselines forget at the same
+            // pace whatever the frame rate
+            const int64_t elapsed_us = timestamp_us - track.last_us;
+            const double rate = -std::expm1(
+                -static_cast<double>(std::min(elapsed_us, m_options.baseline_window_us)) / m_options.baseline_window_us
+            );
+            const int64_t seen_us = timestamp_us - track.first_us;
+            const bool warming = seen_us < m_options.warmup_us;
+            track.last_us = timestamp_us;
+
+            ProctorAnomaly* anomaly = &(*anomalies)[face];
+            if (result.present_fields & PROCTOR_FIELD_ORIENTATION)
+            {
+                this->Observe(&track, kAnomalyHorizontalAlign, result.horizontal_align, rate, warming, anomaly);
+                this->Observe(&track, kAnomalyVerticalAlign, result.vertical_align, rate, warming, anomaly);
+            }
+            if (result.present_fields & PROCTOR_FIELD_ACTIVITY)
+            {
+                this->Observe(&track, kAnomalyFacialActivity, result.facial_activity, rate, warming, anomaly);
+            }
+            if (result.present_fields & PROCTOR_FIELD_MOVEMENT)
+            {
+                this->Observe(&track, kAnomalyFaceMovement, result.face_movement, rate, warming, anomaly);
+            }
+            if (result.present_fields & PROCTOR_FIELD_BLINK)
+            {
+                // Blinks per minute, each onset adds an exponentially
+                // decaying impulse
+                const double window_us = m_options.blink_window_us;
+                track.blink_rate *= std::exp(-elapsed_us / window_us);
+                const bool closed = result.is_left_eye_blinking && result.is_right_eye_blinking;
+                if (closed && !track.eyes_closed) { track.blink_rate += 60e6 / window_us; }
+                track.eyes_closed = closed;
+                // The rate builds up over the first window
+                if (seen_us >= m_options.blink_window_us)
+                {
+                    this->Observe(
+                        &track, kAnomalyBlinkRate, track.blink_rate, rate,
+                        seen_us < m_options.blink_window_us + m_options.warmup_us, anomaly
+                    );
+                }
+            }
+        }
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,128 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Online anomaly scores of the proctor results against per-face baselines
+#ifndef proctor_anomaly_h
+#define proctor_anomaly_h
+
+#include <cstdint>
+#include <vector>
+
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    enum ProctorAnomalyField
+    {
+        kAnomalyHorizontalAlign,
+        kAnomalyVerticalAlign,
+        kAnomalyFacialActivity,
+        kAnomalyFaceMovement,
+        kAnomalyBlinkRate,
+        kProctorAnomalyFieldCount
+    };
+
+    // Anomaly of a face on a frame
+    struct ProctorAnomaly
+    {
+        // Largest of the field scores
+        double score = 0;
+        // Robust z-score of each field, |value - median| / (1.4826 MAD)
+        double field_scores[kProctorAnomalyFieldCount] = {};
+        // Bit (1 << ProctorAnomalyField) of the fields with a warm baseline
+        unsigned int scored_fields = 0;
+    };
+
+    /**
+     * @brief Options of ProctorAnomalyScorer, see proctor_anomaly_calculator.proto
+     */
+    struct ProctorAnomalyScorerOptions
+    {
+        int64_t baseline_window_us = 30000000;
+        int64_t warmup_us = 10000000;
+        int64_t blink_window_us = 20000000;
+        double min_scale = 0.001;
+    };
+
+    /**
+     * @brief Running median and median absolute deviation of a value
+     *
+     * The estimates start as the mean and mean absolute deviation of the
+     * warmup values, then step towards the value by a fraction of the
+     * deviation (frugal quantile estimation), so that an update is O(1) and
+     * an outlier moves them by one step at most.
+     */
+    class RobustBaseline
+    {
+    private:
+        double m_median = 0;
+        double m_deviation = 0;
+        int64_t m_count = 0;
+
+    public:
+        // rate is the step size in (0, 1], ignored while warming up
+        void Update(double value, double rate, double min_scale, bool warming);
+        // Robust z-score of value, 0 before the first update
+        double Score(double value, double min_scale) const;
+
+        double median() const { return m_median; }
+        double deviation() const { return m_deviation; }
+    };
+
+    /**
+     * @brief Score each result against the baselines of its face, before
+     *        updating them
+     *
+     * Faces are identified by their index in the results. The blink rate is
+     * the onsets of both eyes closing, decayed over blink_window_us. The
+     * baselines forget with a time constant of baseline_window_us, whatever
+     * the frame rate, and score once they have seen warmup_us of a face
+     * (the blink rate after blink_window_us more). Carried forward results are
+     * not scored.
+     */
+    class ProctorAnomalyScorer
+    {
+    private:
+        struct Track
+        {
+            RobustBaseline baselines[kProctorAnomalyFieldCount];
+            int64_t first_us = 0;
+            int64_t last_us = 0;
+            bool is_seen = false;
+            bool eyes_closed = false;
+            double blink_rate = 0;
+        };
+
+        ProctorAnomalyScorerOptions m_options;
+        std::vector<Track> m_tracks;
+        int64_t m_last_timestamp_us = INT64_MIN;
+
+        void Observe(
+            Track* track, ProctorAnomalyField field, double value, double rate, bool warming,
+            ProctorAnomaly* anomaly
+        );
+
+    public:
+        explicit ProctorAnomalyScorer(const ProctorAnomalyScorerOptions& options);
+
+        // Score the results of a frame, anomalies is resized to the results
+        void Update(
+            int64_t timestamp_us, const std::vector<ProctorResult>& results,
+            std::vector<ProctorAnomaly>* anomalies
+        );
+    };
+
+} // namespace mediapipe
+
+#endif
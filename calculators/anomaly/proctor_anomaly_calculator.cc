@@ -0,0 +1,137 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to score the anomalies of the proctor results online
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/anomaly/proctor_anomaly.h"
+#include "mp_proctor/calculators/anomaly/proctor_anomaly_calculator.pb.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]   = "RESULTS";
+        constexpr char kAnomaliesTag[] = "ANOMALIES";
+        constexpr char kScoreTag[]     = "SCORE";
+    } // namespace
+
+    /**
+     * @brief Score each result against robust baselines of its face
+     *        (running median and MAD of the align, activity, movement and
+     *        blink rate), see proctor_anomaly.h
+     *
+     * An update is O(1) per face and keeps no history.
+     *
+     * INPUTS:
+     *      RESULTS - Results of the faces of a frame (std::vector<ProctorResult>)
+     * OUTPUTS:
+     *      ANOMALIES - Optional anomaly of each result (std::vector<ProctorAnomaly>)
+     *      SCORE - Optional largest score of the frame (double)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "ProctorAnomalyCalculator"
+     *   input_stream: "RESULTS:proctor_results"
+     *   output_stream: "ANOMALIES:proctor_anomalies"
+     *   output_stream: "SCORE:anomaly_score"
+     * }
+     *
+     */
+    class ProctorAnomalyCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<ProctorAnomalyScorer> m_scorer;
+
+    public:
+        ProctorAnomalyCalculator() = default;
+        ~ProctorAnomalyCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(ProctorAnomalyCalculator);
+
+    absl::Status ProctorAnomalyCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->Outputs().HasTag(kAnomaliesTag))
+        {
+            cc->Outputs().Tag(kAnomaliesTag).Set<std::vector<ProctorAnomaly>>();
+        }
+        if (cc->Outputs().HasTag(kScoreTag))
+        {
+            cc->Outputs().Tag(kScoreTag).Set<double>();
+        }
+
+        // Frames without anomalies still advance the bound of the outputs
+        cc->SetTimestampOffset(TimestampDiff(0));
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorAnomalyCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<ProctorAnomalyCalculatorOptions>();
+        if (options.baseline_window_us() <= 0 || options.blink_window_us() <= 0 ||
+            options.warmup_us() < 0 || options.min_scale() <= 0)
+        {
+            return absl::InvalidArgumentError("ProctorAnomalyCalculator: windows and min_scale must be positive!");
+        }
+
+        ProctorAnomalyScorerOptions scorer_options;
+        scorer_options.baseline_window_us = options.baseline_window_us();
+        scorer_options.warmup_us = options.warmup_us();
+        scorer_options.blink_window_us = options.blink_window_us();
+        scorer_options.min_scale = options.min_scale();
+        m_scorer = absl::make_unique<ProctorAnomalyScorer>(scorer_options);
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorAnomalyCalculator::Process(CalculatorContext* cc)
+    {
+        if (cc->Inputs().Tag(kResultsTag).IsEmpty()) { return absl::OkStatus(); }
+
+        auto anomalies = absl::make_unique<std::vector<ProctorAnomaly>>();
+        m_scorer->Update(
+            cc->InputTimestamp().Value(),
+            cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>(),
+            anomalies.get()
+        );
+
+        if (cc->Outputs().HasTag(kScoreTag))
+        {
+            double score = 0;
+            for (const ProctorAnomaly& anomaly: *anomalies) { score = std::max(score, anomaly.score); }
+            cc->Outputs().Tag(kScoreTag).AddPacket(MakePacket<double>(score).At(cc->InputTimestamp()));
+        }
+        if (cc->Outputs().HasTag(kAnomaliesTag))
+        {
+            cc->Outputs().Tag(kAnomaliesTag).Add(anomalies.release(), cc->InputTimestamp());
+        }
+        return absl::OkStatus();
+    } // Process()
+
+} // namespace mediapipe
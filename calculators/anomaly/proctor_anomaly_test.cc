@@ -0,0 +1,132 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the online anomaly scores of the proctor results
+#include "mp_proctor/calculators/anomaly/proctor_anomaly.h"
+
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr int64_t kFrameUs = 33333;
+        constexpr unsigned int kContinuousFields = (1u << kAnomalyHorizontalAlign) |
+            (1u << kAnomalyVerticalAlign) | (1u << kAnomalyFacialActivity) | (1u << kAnomalyFaceMovement);
+
+        // A face looking at the screen, with some noise
+        ProctorResult MakeResult(std::mt19937* random)
+        {
+            std::uniform_real_distribution<double> noise(-0.01, 0.01);
+            ProctorResult result = {};
+            result.horizontal_align = 0.1 + noise(*random);
+            result.vertical_align = -0.05 + noise(*random);
+            result.facial_activity = 0.2 + noise(*random);
+            result.face_movement = 0.02 + noise(*random);
+            result.present_fields = PROCTOR_FIELD_ORIENTATION | PROCTOR_FIELD_ACTIVITY | PROCTOR_FIELD_MOVEMENT;
+            return result;
+        }
+
+        // Feed frames of one face from start_us until end_us, returns the next timestamp
+        int64_t Feed(ProctorAnomalyScorer* scorer, int64_t start_us, int64_t end_us, std::mt19937* random)
+        {
+            std::vector<ProctorAnomaly> anomalies;
+            int64_t timestamp_us = start_us;
+            for (; timestamp_us < end_us; timestamp_us += kFrameUs)
+            {
+                scorer->Update(timestamp_us, {MakeResult(random)}, &anomalies);
+            }
+            return timestamp_us;
+        }
+    } // namespace
+
+    TEST(ProctorAnomalyScorerTest, ScoresOnlyAfterWarmup)
+    {
+        std::mt19937 random(1);
+        ProctorAnomalyScorerOptions options;
+        ProctorAnomalyScorer scorer(options);
+
+        std::vector<ProctorAnomaly> anomalies;
+        int64_t timestamp_us = 0;
+        for (; timestamp_us < options.warmup_us; timestamp_us += kFrameUs)
+        {
+            scorer.Update(timestamp_us, {MakeResult(&random)}, &anomalies);
+            ASSERT_EQ(anomalies.size(), 1);
+            EXPECT_EQ(anomalies[0].scored_fields, 0u);
+            EXPECT_EQ(anomalies[0].score, 0);
+        }
+        scorer.Update(timestamp_us, {MakeResult(&random)}, &anomalies);
+        EXPECT_EQ(anomalies[0].scored_fields, kContinuousFields);
+    }
+
+    TEST(ProctorAnomalyScorerTest, ScoresOutliersAboveNoise)
+    {
+        std::mt19937 random(2);
+        ProctorAnomalyScorer scorer(ProctorAnomalyScorerOptions{});
+        int64_t timestamp_us = Feed(&scorer, 0, 15000000, &random);
+
+        std::vector<ProctorAnomaly> anomalies;
+        scorer.Update(timestamp_us, {MakeResult(&random)}, &anomalies);
+        EXPECT_LT(anomalies[0].score, 3);
+
+        // Looking away
+        ProctorResult away = MakeResult(&random);
+        away.horizontal_align = 0.6;
+        timestamp_us += kFrameUs;
+        scorer.Update(timestamp_us, {away}, &anomalies);
+        EXPECT_GT(anomalies[0].field_scores[kAnomalyHorizontalAlign], 10);
+        EXPECT_EQ(anomalies[0].score, anomalies[0].field_scores[kAnomalyHorizontalAlign]);
+        EXPECT_LT(anomalies[0].field_scores[kAnomalyVerticalAlign], 3);
+
+        // One outlier barely moves the baseline
+        timestamp_us += kFrameUs;
+        scorer.Update(timestamp_us, {MakeResult(&random)}, &anomalies);
+        EXPECT_LT(anomalies[0].score, 3);
+    }
+
+    TEST(ProctorAnomalyScorerTest, SkipsCarriedForwardResults)
+    {
+        std::mt19937 random(3);
+        ProctorAnomalyScorer scorer(ProctorAnomalyScorerOptions{});
+        int64_t timestamp_us = Feed(&scorer, 0, 15000000, &random);
+
+        ProctorResult carried = MakeResult(&random);
+        carried.horizontal_align = 0.6;
+        carried.is_carried_forward = true;
+        std::vector<ProctorAnomaly> anomalies;
+        scorer.Update(timestamp_us, {carried}, &anomalies);
+        EXPECT_EQ(anomalies[0].scored_fields, 0u);
+        EXPECT_EQ(anomalies[0].score, 0);
+    }
+
+    TEST(ProctorAnomalyScorerTest, WarmsUpEachFace)
+    {
+        std::mt19937 random(4);
+        ProctorAnomalyScorerOptions options;
+        ProctorAnomalyScorer scorer(options);
+        int64_t timestamp_us = Feed(&scorer, 0, 15000000, &random);
+
+        // A second face joins
+        std::vector<ProctorAnomaly> anomalies;
+        scorer.Update(timestamp_us, {MakeResult(&random), MakeResult(&random)}, &anomalies);
+        ASSERT_EQ(anomalies.size(), 2);
+        EXPECT_EQ(anomalies[0].scored_fields, kContinuousFields);
+        EXPECT_EQ(anomalies[1].scored_fields, 0u);
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,87 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Proctoring event structure
+#ifndef proctor_event_h
+#define proctor_event_h
+
+#include <cstdint>
+
+namespace mediapipe
+{
+    enum class ProctorEventType
+    {
+        // Both eyes closed
+        kEyesClosed,
+        kLookLeft,
+        kLookRight,
+        kLookUp,
+        kLookDown,
+        kNoFace,
+        // More than one face in the frame
+        kMultipleFaces,
+        // Facial activity above the threshold, e.g. talking
+        kHighActivity
+    };
+
+    constexpr int kProctorEventTypeCount = 8;
+
+    enum class ProctorEventPhase
+    {
+        kStart,
+        kEnd
+    };
+
+    /**
+     * @brief Start or end of an interval during which a condition held
+     */
+    struct ProctorEvent
+    {
+        ProctorEventType type;
+        ProctorEventPhase phase;
+        // Index of the face in the results, -1 for the frame level events
+        // (kNoFace, kMultipleFaces)
+        int face;
+        // First frame the condition held
+        int64_t start_us;
+        // Last frame the condition held, as of this event
+        int64_t end_us;
+        // Frames the condition held, as of this event
+        int frames;
+        // Mean and most extreme value over these frames: the align of the
+        // look events, the facial activity, the face count, 1 for kEyesClosed
+        // and 0 for kNoFace
+        double mean_value;
+        double peak_value;
+    };
+
+    inline const char* ProctorEventTypeName(ProctorEventType type)
+    {
+        switch (type)
+        {
+            case ProctorEventType::kEyesClosed:     return "eyes_closed";
+            case ProctorEventType::kLookLeft:       return "look_left";
+            case ProctorEventType::kLookRight:      return "look_right";
+            case ProctorEventType::kLookUp:         return "look_up";
+            case ProctorEventType::kLookDown:       return "look_down";
+            case ProctorEventType::kNoFace:         return "no_face";
+            case ProctorEventType::kMultipleFaces:  return "multiple_faces";
+            case ProctorEventType::kHighActivity:   return "high_activity";
+        }
+        return "unknown";
+    }
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,160 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to turn per-frame proctor results into sparse events
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/events/proctor_event.h"
+#include "mp_proctor/calculators/events/proctor_event_calculator.pb.h"
+#include "mp_proctor/calculators/events/proctor_event_tracker.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[] = "RESULTS";
+        constexpr char kTickTag[]    = "TICK";
+        constexpr char kEventsTag[]  = "EVENTS";
+    } // namespace
+
+    /**
+     * @brief Emit start and end events of the intervals during which the
+     *        eyes stay closed, a face looks away, no face or several faces
+     *        are found, or the facial activity stays high
+     *
+     * An event starts once its condition held for a minimum duration and
+     * ends once it stopped holding for longer than release_us. The align
+     * and activity thresholds have hysteresis, so values hovering around a
+     * threshold do not produce bursts of events. Packets are only emitted
+     * when events occur.
+     *
+     * INPUTS:
+     *      RESULTS - Results of a frame (std::vector<ProctorResult>)
+     *      TICK - Optional clock of the analyzed frames (Any); a tick without
+     *             results counts as a frame without faces
+     * OUTPUTS:
+     *      EVENTS - Events that occurred at this frame (std::vector<ProctorEvent>)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "ProctorEventCalculator"
+     *   input_stream: "RESULTS:multi_face_proctor_results"
+     *   input_stream: "TICK:throttled_input_video"
+     *   output_stream: "EVENTS:proctor_events"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.ProctorEventCalculatorOptions] {
+     *       look_away_min_us: 3000000
+     *     }
+     *   }
+     * }
+     *
+     */
+    class ProctorEventCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<ProctorEventTracker> m_tracker;
+        Timestamp m_last_timestamp = Timestamp::Unset();
+
+        void Output(CalculatorContext* cc, std::vector<ProctorEvent> events, Timestamp timestamp);
+
+    public:
+        ProctorEventCalculator() = default;
+        ~ProctorEventCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(ProctorEventCalculator);
+
+    absl::Status ProctorEventCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            cc->Inputs().Tag(kTickTag).SetAny();
+        }
+        cc->Outputs().Tag(kEventsTag).Set<std::vector<ProctorEvent>>();
+
+        // Frames without events still advance the bound of EVENTS
+        cc->SetTimestampOffset(TimestampDiff(0));
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorEventCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<ProctorEventCalculatorOptions>();
+        if (options.release_us() < 0 || options.align_hysteresis() < 0 || options.activity_hysteresis() < 0)
+        {
+            return absl::InvalidArgumentError("ProctorEventCalculator: release_us and hysteresis must not be negative!");
+        }
+
+        ProctorEventTrackerOptions tracker_options;
+        tracker_options.eyes_closed_min_us = options.eyes_closed_min_us();
+        tracker_options.look_away_min_us = options.look_away_min_us();
+        tracker_options.no_face_min_us = options.no_face_min_us();
+        tracker_options.multiple_faces_min_us = options.multiple_faces_min_us();
+        tracker_options.activity_min_us = options.activity_min_us();
+        tracker_options.release_us = options.release_us();
+        tracker_options.align_hysteresis = options.align_hysteresis();
+        tracker_options.activity_threshold = options.activity_threshold();
+        tracker_options.activity_hysteresis = options.activity_hysteresis();
+        m_tracker = absl::make_unique<ProctorEventTracker>(tracker_options);
+        return absl::OkStatus();
+    }
+
+    void ProctorEventCalculator::Output(CalculatorContext* cc, std::vector<ProctorEvent> events, Timestamp timestamp)
+    {
+        if (events.empty()) { return; }
+        cc->Outputs().Tag(kEventsTag).Add(new std::vector<ProctorEvent>(std::move(events)), timestamp);
+    }
+
+    absl::Status ProctorEventCalculator::Process(CalculatorContext* cc)
+    {
+        static const std::vector<ProctorResult> kNoResults;
+        const auto& results = cc->Inputs().Tag(kResultsTag).IsEmpty() ?
+            kNoResults:
+            cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>();
+
+        std::vector<ProctorEvent> events;
+        m_tracker->Update(cc->InputTimestamp().Value(), results, &events);
+        m_last_timestamp = cc->InputTimestamp();
+        this->Output(cc, std::move(events), cc->InputTimestamp());
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status ProctorEventCalculator::Close(CalculatorContext* cc)
+    {
+        // Events still going on end with the session
+        if (m_tracker && m_last_timestamp != Timestamp::Unset())
+        {
+            std::vector<ProctorEvent> events;
+            m_tracker->Finish(&events);
+            this->Output(cc, std::move(events), m_last_timestamp.NextAllowedInStream());
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,178 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Turns per-frame proctor results into start/end events
+#include "mp_proctor/calculators/events/proctor_event_tracker.h"
+
+#include <cmath>
+
+#include "mp_proctor/calculators/util/proctor_thresholds.h"
+
+namespace mediapipe
+{
+
+    ProctorEventTracker::ProctorEventTracker(const ProctorEventTrackerOptions& options)
+        : m_options(options)
+    {}
+
+    int64_t ProctorEventTracker::MinDuration(ProctorEventType type) const
+    {
+        switch (type)
+        {
+            case ProctorEventType::kEyesClosed:     return m_options.eyes_closed_min_us;
+            case ProctorEventType::kNoFace:         return m_options.no_face_min_us;
+            case ProctorEventType::kMultipleFaces:  return m_options.multiple_faces_min_us;
+            case ProctorEventType::kHighActivity:   return m_options.activity_min_us;
+            default:                                return m_options.look_away_min_us;
+        }
+    }
+
+    ProctorEvent ProctorEventTracker::MakeEvent(const Key& key, const Interval& interval, ProctorEventPhase phase)
+    {
+        ProctorEvent event;
+        event.type = static_cast<ProctorEventType>(key.first);
+        event.phase = phase;
+        event.face = key.second;
+        event.start_us = interval.start_us;
+        event.end_us = interval.last_us;
+        event.frames = interval.frames;
+        event.mean_value = interval.frames > 0 ? interval.sum / interval.frames: 0;
+        event.peak_value = interval.peak;
+        return event;
+    }
+
+    void ProctorEventTracker::Observe(
+        ProctorEventType type, int face, bool enters, bool holds, double value,
+        int64_t timestamp_us, std::vector<ProctorEvent>* events
+    )
+    {
+        const Key key(static_cast<int>(type), face);
+        auto it = m_intervals.find(key);
+        const bool is_tracked = it != m_intervals.end();
+        if (!(is_tracked ? holds: enters))
+        {
+            // Events yet to start reset at once, see Update() for the started ones
+            if (is_tracked && !it->second.is_started) { m_intervals.erase(it); }
+            return;
+        }
+
+        if (it == m_intervals.end())
+        {
+            it = m_intervals.emplace(key, Interval()).first;
+            it->second.start_us = timestamp_us;
+        }
+        Interval& interval = it->second;
+        interval.last_us = timestamp_us;
+        interval.observed_us = timestamp_us;
+        interval.frames += 1;
+        interval.sum += value;
+        if (std::fabs(value) > std::fabs(interval.peak)) { interval.peak = value; }
+
+        if (!interval.is_started && timestamp_us - interval.start_us >= this->MinDuration(type))
+        {
+            interval.is_started = true;
+            events->push_back(MakeEvent(key, interval, ProctorEventPhase::kStart));
+        }
+    }
+
+    void ProctorEventTracker::ObserveFace(
+        int face, const ProctorResult& result, int64_t timestamp_us, std::vector<ProctorEvent>* events
+    )
+    {
+        if (result.present_fields & PROCTOR_FIELD_BLINK)
+        {
+            const bool closed = result.is_left_eye_blinking && result.is_right_eye_blinking;
+            this->Observe(ProctorEventType::kEyesClosed, face, closed, closed, 1, timestamp_us, events);
+        }
+
+        if (result.present_fields & PROCTOR_FIELD_ORIENTATION)
+        {
+            const double margin = m_options.align_hysteresis;
+            const double horizontal = result.horizontal_align;
+            const double vertical = result.vertical_align;
+            this->Observe(
+                ProctorEventType::kLookLeft, face, horizontal <= kLookLeftThreshold,
+                horizontal <= kLookLeftThreshold + margin, horizontal, timestamp_us, events
+            );
+            this->Observe(
+                ProctorEventType::kLookRight, face, horizontal >= kLookRightThreshold,
+                horizontal >= kLookRightThreshold - margin, horizontal, timestamp_us, events
+            );
+            this->Observe(
+                ProctorEventType::kLookUp, face, vertical <= kLookUpThreshold,
+                vertical <= kLookUpThreshold + margin, vertical, timestamp_us, events
+            );
+            this->Observe(
+                ProctorEventType::kLookDown, face, vertical >= kLookDownThreshold,
+                vertical >= kLookDownThreshold - margin, vertical, timestamp_us, events
+            );
+        }
+
+        if (result.present_fields & PROCTOR_FIELD_ACTIVITY)
+        {
+            const double activity = result.facial_activity;
+            this->Observe(
+                ProctorEventType::kHighActivity, face, activity >= m_options.activity_threshold,
+                activity >= m_options.activity_threshold - m_options.activity_hysteresis,
+                activity, timestamp_us, events
+            );
+        }
+    }
+
+    void ProctorEventTracker::Update(
+        int64_t timestamp_us, const std::vector<ProctorResult>& results, std::vector<ProctorEvent>* events
+    )
+    {
+        if (timestamp_us <= m_last_timestamp_us) { return; }
+        m_last_timestamp_us = timestamp_us;
+
+        const int face_count = results.size();
+        this->Observe(ProctorEventType::kNoFace, -1, face_count == 0, face_count == 0, 0, timestamp_us, events);
+        this->Observe(
+            ProctorEventType::kMultipleFaces, -1, face_count > 1, face_count > 1,
+            face_count, timestamp_us, events
+        );
+        for (int face = 0; face < face_count; ++face)
+        {
+            this->ObserveFace(face, results[face], timestamp_us, events);
+        }
+
+        // Conditions that did not hold in this frame, e.g. the face is gone
+        // or the field is absent
+        for (auto it = m_intervals.begin(); it != m_intervals.end();)
+        {
+            const Interval& interval = it->second;
+            if (interval.observed_us == timestamp_us) { ++it; continue; }
+            if (!interval.is_started || timestamp_us - interval.last_us > m_options.release_us)
+            {
+                if (interval.is_started) { events->push_back(MakeEvent(it->first, interval, ProctorEventPhase::kEnd)); }
+                it = m_intervals.erase(it);
+            }
+            else { ++it; }
+        }
+    }
+
+    void ProctorEventTracker::Finish(std::vector<ProctorEvent>* events)
+    {
+        for (const auto& entry: m_intervals)
+        {
+            if (entry.second.is_started)
+            {
+                events->push_back(MakeEvent(entry.first, entry.second, ProctorEventPhase::kEnd));
+            }
+        }
+        m_intervals.clear();
+    }
+
+} // namespace mediapipe
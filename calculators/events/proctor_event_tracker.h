@@ -0,0 +1,100 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Turns per-frame proctor results into start/end events
+#ifndef proctor_event_tracker_h
+#define proctor_event_tracker_h
+
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "mp_proctor/calculators/events/proctor_event.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of ProctorEventTracker, see proctor_event_calculator.proto
+     */
+    struct ProctorEventTrackerOptions
+    {
+        int64_t eyes_closed_min_us = 300000;
+        int64_t look_away_min_us = 2000000;
+        int64_t no_face_min_us = 1000000;
+        int64_t multiple_faces_min_us = 500000;
+        int64_t activity_min_us = 1000000;
+        int64_t release_us = 200000;
+        double align_hysteresis = 0.05;
+        double activity_threshold = 0.5;
+        double activity_hysteresis = 0.1;
+    };
+
+    /**
+     * @brief Tracks the conditions of each face and emits an event when a
+     *        condition started holding for its minimum duration, and when
+     *        it stopped holding for longer than release_us
+     *
+     * Faces are identified by their index in the results.
+     */
+    class ProctorEventTracker
+    {
+    private:
+        struct Interval
+        {
+            bool is_started = false;
+            int64_t start_us = 0;
+            int64_t last_us = 0;
+            int64_t observed_us = 0;
+            int frames = 0;
+            double sum = 0;
+            double peak = 0;
+        };
+        // (ProctorEventType, face)
+        using Key = std::pair<int, int>;
+
+        ProctorEventTrackerOptions m_options;
+        std::map<Key, Interval> m_intervals;
+        int64_t m_last_timestamp_us = INT64_MIN;
+
+        int64_t MinDuration(ProctorEventType type) const;
+        // Record the condition of a frame; enters is the condition to begin
+        // tracking an interval, holds the one to keep tracking it
+        void Observe(
+            ProctorEventType type, int face, bool enters, bool holds, double value,
+            int64_t timestamp_us, std::vector<ProctorEvent>* events
+        );
+        void ObserveFace(
+            int face, const ProctorResult& result, int64_t timestamp_us, std::vector<ProctorEvent>* events
+        );
+        static ProctorEvent MakeEvent(const Key& key, const Interval& interval, ProctorEventPhase phase);
+
+    public:
+        explicit ProctorEventTracker(const ProctorEventTrackerOptions& options);
+
+        /**
+         * @brief Update with the results of a frame, empty if no face was found
+         *
+         * Timestamps must increase.
+         */
+        void Update(int64_t timestamp_us, const std::vector<ProctorResult>& results, std::vector<ProctorEvent>* events);
+
+        // End all started events, e.g. at the end of the session
+        void Finish(std::vector<ProctorEvent>* events);
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,300 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Memory mappable index of the proctoring event intervals of a session
+#include "mp_proctor/calculators/events/proctor_interval_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        // Levels below which a subtree is scanned linearly
+        constexpr int kScanLevel = 3;
+
+        int RootLevel(size_t count)
+        {
+            int level = -1;
+            while ((size_t{1} << (level + 1)) <= count) { ++level; }
+            return level;
+        }
+
+        /**
+         * @brief Set max_end_us of the implicit interval tree over intervals
+         *        sorted by start, and return the level of its root
+         *
+         * Nodes whose right child is past the end take the largest end of
+         * the incomplete part of the tree instead.
+         */
+        int BuildIntervalTree(std::vector<ProctorInterval>* intervals)
+        {
+            const int64_t n = intervals->size();
+            if (n == 0) { return -1; }
+            ProctorInterval* a = intervals->data();
+
+            int64_t last_i = 0;
+            int64_t last = 0;
+            for (int64_t i = 0; i < n; i += 2)
+            {
+                last_i = i;
+                last = a[i].max_end_us = a[i].end_us;
+            }
+            int k = 1;
+            for (; (int64_t{1} << k) <= n; ++k)
+            {
+                const int64_t x = int64_t{1} << (k - 1);
+                for (int64_t i = (x << 1) - 1; i < n; i += x << 2)
+                {
+                    const int64_t left = a[i - x].max_end_us;
+                    const int64_t right = i + x < n ? a[i + x].max_end_us: last;
+                    a[i].max_end_us = std::max(a[i].end_us, std::max(left, right));
+                }
+                last_i = (last_i >> k & 1) ? last_i - x: last_i + x;
+                if (last_i < n && a[last_i].max_end_us > last) { last = a[last_i].max_end_us; }
+            }
+            return k - 1;
+        }
+
+        bool SameFace(const ProctorInterval& a, const ProctorInterval& b)
+        { return a.face == b.face || a.face < 0 || b.face < 0; }
+    } // namespace
+
+    void ProctorIntervalIndexBuilder::Add(const ProctorEvent& event)
+    {
+        const std::pair<int, int> key(static_cast<int>(event.type), event.face);
+        ProctorInterval interval;
+        std::memset(&interval, 0, sizeof(interval));
+        interval.start_us = event.start_us;
+        interval.end_us = event.end_us;
+        interval.face = event.face;
+        interval.frames = event.frames;
+        interval.mean_value = static_cast<float>(event.mean_value);
+        interval.peak_value = static_cast<float>(event.peak_value);
+        interval.type = static_cast<uint8_t>(event.type);
+
+        if (event.phase == ProctorEventPhase::kStart)
+        {
+            interval.flags = kProctorIntervalOpen;
+            m_open[key] = interval;
+        }
+        else
+        {
+            m_open.erase(key);
+            m_intervals.push_back(interval);
+        }
+        this->AdvanceTo(event.end_us);
+    }
+
+    void ProctorIntervalIndexBuilder::AdvanceTo(int64_t timestamp_us)
+    { m_as_of_us = std::max(m_as_of_us, timestamp_us); }
+
+    absl::Status ProctorIntervalIndexBuilder::Write(const std::string& path) const
+    {
+        std::vector<ProctorInterval> by_type[kProctorEventTypeCount];
+        for (const ProctorInterval& interval: m_intervals) { by_type[interval.type].push_back(interval); }
+        for (const auto& entry: m_open)
+        {
+            ProctorInterval interval = entry.second;
+            interval.end_us = std::max(interval.end_us, m_as_of_us);
+            by_type[interval.type].push_back(interval);
+        }
+
+        std::string header;
+        PutFixed(kProctorIntervalIndexMagic, &header);
+        PutFixed(kProctorIntervalIndexVersion, &header);
+        PutFixed(static_cast<uint16_t>(kProctorEventTypeCount), &header);
+        PutFixed(m_as_of_us, &header);
+        uint64_t first = 0;
+        for (auto& intervals: by_type)
+        {
+            std::sort(intervals.begin(), intervals.end(), [](const ProctorInterval& a, const ProctorInterval& b)
+            { return a.start_us != b.start_us ? a.start_us < b.start_us: a.end_us < b.end_us; });
+            const int root_level = BuildIntervalTree(&intervals);
+            PutFixed(first, &header);
+            PutFixed(static_cast<uint32_t>(intervals.size()), &header);
+            PutFixed(static_cast<int32_t>(root_level), &header);
+            first += intervals.size();
+        }
+
+        const std::string temporary_path = path + ".tmp";
+        FILE* file = std::fopen(temporary_path.c_str(), "wb");
+        if (file == nullptr) { return absl::NotFoundError("Could not create " + temporary_path); }
+        bool failed = std::fwrite(header.data(), 1, header.size(), file) != header.size();
+        for (const auto& intervals: by_type)
+        {
+            if (failed || intervals.empty()) { continue; }
+            failed = std::fwrite(intervals.data(), sizeof(ProctorInterval), intervals.size(), file) != intervals.size();
+        }
+        failed |= std::fclose(file) != 0;
+        if (failed || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary_path.c_str());
+            return absl::InternalError("Failed to write the interval index " + path);
+        }
+        return absl::OkStatus();
+    }
+
+    ProctorIntervalIndex::~ProctorIntervalIndex()
+    {
+        if (m_data != nullptr) { munmap(const_cast<uint8_t*>(m_data), m_size); }
+    }
+
+    absl::StatusOr<std::unique_ptr<ProctorIntervalIndex>> ProctorIntervalIndex::Open(const std::string& path)
+    {
+        constexpr size_t kTableEnd = kProctorIntervalIndexHeaderBytes +
+            kProctorEventTypeCount * kProctorIntervalIndexTypeBytes;
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return absl::NotFoundError("Could not open " + path); }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kTableEnd)
+        {
+            close(fd);
+            return absl::DataLossError(path + " is not an interval index");
+        }
+
+        std::unique_ptr<ProctorIntervalIndex> index(new ProctorIntervalIndex());
+        index->m_size = info.st_size;
+        void* data = mmap(nullptr, index->m_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) { return absl::InternalError("Could not map " + path); }
+        index->m_data = static_cast<const uint8_t*>(data);
+
+        if (GetFixed<uint32_t>(index->m_data) != kProctorIntervalIndexMagic)
+        {
+            return absl::DataLossError(path + " is not an interval index");
+        }
+        if (GetFixed<uint16_t>(index->m_data + 4) != kProctorIntervalIndexVersion ||
+            GetFixed<uint16_t>(index->m_data + 6) != kProctorEventTypeCount)
+        {
+            return absl::FailedPreconditionError("Unsupported interval index version");
+        }
+        index->m_as_of_us = GetFixed<int64_t>(index->m_data + 8);
+
+        const ProctorInterval* intervals = reinterpret_cast<const ProctorInterval*>(index->m_data + kTableEnd);
+        const uint64_t interval_count = (index->m_size - kTableEnd) / sizeof(ProctorInterval);
+        for (int type = 0; type < kProctorEventTypeCount; ++type)
+        {
+            const uint8_t* entry = index->m_data + kProctorIntervalIndexHeaderBytes + type * kProctorIntervalIndexTypeBytes;
+            const uint64_t first = GetFixed<uint64_t>(entry);
+            const uint32_t count = GetFixed<uint32_t>(entry + 8);
+            const int32_t root_level = GetFixed<int32_t>(entry + 12);
+            if (first > interval_count || count > interval_count - first || root_level != RootLevel(count))
+            {
+                return absl::DataLossError("Corrupted interval index " + path);
+            }
+            index->m_types[type] = {intervals + first, count, root_level};
+        }
+        return index;
+    }
+
+    void ProctorIntervalIndex::Overlapping(
+        ProctorEventType type, int64_t from_us, int64_t to_us, std::vector<ProctorInterval>* out
+    ) const
+    {
+        const TypeTable& table = m_types[static_cast<int>(type)];
+        const int64_t n = table.count;
+        const ProctorInterval* a = table.intervals;
+        if (n == 0 || from_us > to_us) { return; }
+
+        // Top-down traversal, left subtrees first so that out stays sorted
+        struct Node
+        {
+            int64_t x;
+            int k;
+            bool left_done;
+        } stack[64];
+        int top = 0;
+        stack[top++] = {(int64_t{1} << table.root_level) - 1, table.root_level, false};
+        while (top > 0)
+        {
+            const Node node = stack[--top];
+            if (node.k <= kScanLevel)
+            {
+                const int64_t begin = node.x >> node.k << node.k;
+                const int64_t end = std::min(begin + (int64_t{1} << (node.k + 1)) - 1, n);
+                for (int64_t i = begin; i < end && a[i].start_us <= to_us; ++i)
+                {
+                    if (a[i].end_us >= from_us) { out->push_back(a[i]); }
+                }
+            }
+            else if (!node.left_done)
+            {
+                const int64_t left = node.x - (int64_t{1} << (node.k - 1));
+                stack[top++] = {node.x, node.k, true};
+                // The max_end_us of children past the end is unknown
+                if (left >= n || a[left].max_end_us >= from_us)
+                {
+                    stack[top++] = {left, node.k - 1, false};
+                }
+            }
+            else if (node.x < n && a[node.x].start_us <= to_us)
+            {
+                if (a[node.x].end_us >= from_us) { out->push_back(a[node.x]); }
+                stack[top++] = {node.x + (int64_t{1} << (node.k - 1)), node.k - 1, false};
+            }
+        }
+    }
+
+    void ProctorIntervalIndex::Starting(
+        ProctorEventType type, int64_t from_us, int64_t to_us, std::vector<ProctorInterval>* out
+    ) const
+    {
+        const TypeTable& table = m_types[static_cast<int>(type)];
+        const ProctorInterval* end = table.intervals + table.count;
+        const ProctorInterval* it = std::lower_bound(
+            table.intervals, end, from_us,
+            [](const ProctorInterval& interval, int64_t t) { return interval.start_us < t; }
+        );
+        for (; it != end && it->start_us <= to_us; ++it) { out->push_back(*it); }
+    }
+
+    void ProctorIntervalIndex::Intersect(
+        ProctorEventType first, ProctorEventType second, int64_t from_us, int64_t to_us,
+        std::vector<ProctorIntervalOverlap>* out
+    ) const
+    {
+        std::vector<ProctorInterval> firsts, seconds;
+        this->Overlapping(first, from_us, to_us, &firsts);
+        const size_t out_begin = out->size();
+        for (const ProctorInterval& a: firsts)
+        {
+            seconds.clear();
+            this->Overlapping(second, std::max(a.start_us, from_us), std::min(a.end_us, to_us), &seconds);
+            for (const ProctorInterval& b: seconds)
+            {
+                if (!SameFace(a, b)) { continue; }
+                ProctorIntervalOverlap overlap;
+                overlap.start_us = std::max({a.start_us, b.start_us, from_us});
+                overlap.end_us = std::min({a.end_us, b.end_us, to_us});
+                overlap.first = a;
+                overlap.second = b;
+                out->push_back(overlap);
+            }
+        }
+        std::sort(out->begin() + out_begin, out->end(), [](const ProctorIntervalOverlap& a, const ProctorIntervalOverlap& b)
+        { return a.start_us != b.start_us ? a.start_us < b.start_us: a.end_us < b.end_us; });
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,180 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Memory mappable index of the proctoring event intervals of a session
+#ifndef proctor_interval_index_h
+#define proctor_interval_index_h
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/events/proctor_event.h"
+
+/**
+ * An index file starts with a 16 bytes header
+ *
+ *      uint32 magic                "MPIX"
+ *      uint16 version
+ *      uint16 type_count           kProctorEventTypeCount
+ *      int64  as_of_us             Latest timestamp known to the index
+ *
+ * followed by a table of type_count entries, one per ProctorEventType
+ *
+ *      uint64 first                Index of the first interval of the type
+ *      uint32 count
+ *      int32  root_level           Level of the root of its interval tree
+ *
+ * and by the ProctorInterval records of each type in turn, sorted by start.
+ * The records of a type form an implicit interval tree: the node at index i
+ * has the level of the number of trailing 1 bits of i, its children at level
+ * k are i -/+ 2^(k-1), and max_end_us is the largest end_us of its subtree.
+ * Overlap queries visit O(log n + k) nodes without any pointer.
+ */
+
+namespace mediapipe
+{
+    constexpr uint32_t kProctorIntervalIndexMagic   = 0x5849504d; // "MPIX"
+    constexpr uint16_t kProctorIntervalIndexVersion = 1;
+    constexpr size_t kProctorIntervalIndexHeaderBytes = 16;
+    constexpr size_t kProctorIntervalIndexTypeBytes   = 16;
+
+    // ProctorInterval::flags
+    constexpr uint8_t kProctorIntervalOpen = 1;
+
+    /**
+     * @brief Interval during which a condition held, stored as is in the
+     *        index file
+     */
+    struct ProctorInterval
+    {
+        // First and last frame the condition held
+        int64_t start_us;
+        int64_t end_us;
+        // Largest end_us of the subtree rooted at this interval
+        int64_t max_end_us;
+        // Index of the face, -1 for the frame level types
+        int32_t face;
+        int32_t frames;
+        float mean_value;
+        float peak_value;
+        // ProctorEventType
+        uint8_t type;
+        // kProctorIntervalOpen if the interval had not ended yet, end_us is
+        // then the as_of_us of the index
+        uint8_t flags;
+        uint8_t reserved[6];
+    };
+    static_assert(sizeof(ProctorInterval) == 48, "ProctorInterval is stored as is");
+
+    /**
+     * @brief Collects the intervals of a ProctorEvent stream and writes them
+     *        as an index
+     */
+    class ProctorIntervalIndexBuilder
+    {
+    private:
+        std::vector<ProctorInterval> m_intervals;
+        // Started intervals, by (ProctorEventType, face)
+        std::map<std::pair<int, int>, ProctorInterval> m_open;
+        int64_t m_as_of_us = 0;
+
+    public:
+        // Start events open an interval, end events close it
+        void Add(const ProctorEvent& event);
+        // Advance the latest known timestamp, up to which open intervals extend
+        void AdvanceTo(int64_t timestamp_us);
+
+        /**
+         * @brief Write the index, including the open intervals
+         *
+         * The file is written next to path and renamed, so that readers
+         * always map a complete index.
+         */
+        absl::Status Write(const std::string& path) const;
+    };
+
+    /**
+     * @brief Overlap of two intervals found by ProctorIntervalIndex::Intersect()
+     */
+    struct ProctorIntervalOverlap
+    {
+        int64_t start_us;
+        int64_t end_us;
+        ProctorInterval first;
+        ProctorInterval second;
+    };
+
+    /**
+     * @brief Memory mapped index with logarithmic time queries
+     *
+     * Time ranges are inclusive on both ends, as are the intervals.
+     */
+    class ProctorIntervalIndex
+    {
+    private:
+        struct TypeTable
+        {
+            const ProctorInterval* intervals = nullptr;
+            uint32_t count = 0;
+            int32_t root_level = -1;
+        };
+
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        int64_t m_as_of_us = 0;
+        TypeTable m_types[kProctorEventTypeCount];
+
+        ProctorIntervalIndex() = default;
+
+    public:
+        ~ProctorIntervalIndex();
+
+        ProctorIntervalIndex(const ProctorIntervalIndex&) = delete;
+        ProctorIntervalIndex& operator=(const ProctorIntervalIndex&) = delete;
+
+        static absl::StatusOr<std::unique_ptr<ProctorIntervalIndex>> Open(const std::string& path);
+
+        int64_t as_of_us() const { return m_as_of_us; }
+        size_t size(ProctorEventType type) const { return m_types[static_cast<int>(type)].count; }
+
+        // Append the intervals of type overlapping [from_us, to_us], by start
+        void Overlapping(
+            ProctorEventType type, int64_t from_us, int64_t to_us, std::vector<ProctorInterval>* out
+        ) const;
+        // Append the intervals of type starting within [from_us, to_us], by start
+        void Starting(
+            ProctorEventType type, int64_t from_us, int64_t to_us, std::vector<ProctorInterval>* out
+        ) const;
+        /**
+         * @brief Append the overlaps within [from_us, to_us] of the intervals
+         *        of two types, e.g. looking down with high activity, by start
+         *
+         * Intervals of two faces do not overlap, unless one of the types is
+         * a frame level one.
+         */
+        void Intersect(
+            ProctorEventType first, ProctorEventType second, int64_t from_us, int64_t to_us,
+            std::vector<ProctorIntervalOverlap>* out
+        ) const;
+    };
+
+} // namespace mediapipe
+
+#endif
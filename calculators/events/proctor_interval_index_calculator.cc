@@ -0,0 +1,145 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to index the proctoring event intervals of a session
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/events/proctor_event.h"
+#include "mp_proctor/calculators/events/proctor_interval_index.h"
+#include "mp_proctor/calculators/events/proctor_interval_index_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kEventsTag[]     = "EVENTS";
+        constexpr char kTickTag[]       = "TICK";
+        constexpr char kOutputPathTag[] = "OUTPUT_PATH";
+    } // namespace
+
+    /**
+     * @brief Collect the intervals of ProctorEventCalculator into an interval
+     *        index (see proctor_interval_index.h), queried with
+     *        ProctorIntervalIndex
+     *
+     * The index is rewritten every snapshot_interval_us of stream time, so
+     * that a running session can be reviewed, and on Close. Started events
+     * are indexed as open intervals up to the latest timestamp.
+     *
+     * INPUTS:
+     *      EVENTS - Events of a frame (std::vector<ProctorEvent>)
+     *      TICK - Optional clock of the analyzed frames (Any), extending the
+     *             open intervals and triggering the snapshots between events
+     * INPUT SIDE PACKETS:
+     *      OUTPUT_PATH - Optional path of the index, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "ProctorIntervalIndexCalculator"
+     *   input_stream: "EVENTS:proctor_events"
+     *   input_stream: "TICK:throttled_input_video"
+     *   input_side_packet: "OUTPUT_PATH:interval_index_path"
+     * }
+     *
+     */
+    class ProctorIntervalIndexCalculator: public CalculatorBase
+    {
+    private:
+        ProctorIntervalIndexBuilder m_builder;
+        std::string m_path;
+        int64_t m_snapshot_interval_us = 0;
+        Timestamp m_last_snapshot = Timestamp::Unset();
+
+    public:
+        ProctorIntervalIndexCalculator() = default;
+        ~ProctorIntervalIndexCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(ProctorIntervalIndexCalculator);
+
+    absl::Status ProctorIntervalIndexCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kEventsTag).Set<std::vector<ProctorEvent>>();
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            cc->Inputs().Tag(kTickTag).SetAny();
+        }
+        if (cc->InputSidePackets().HasTag(kOutputPathTag))
+        {
+            cc->InputSidePackets().Tag(kOutputPathTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorIntervalIndexCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<ProctorIntervalIndexCalculatorOptions>();
+        if (options.snapshot_interval_us() < 0)
+        {
+            return absl::InvalidArgumentError("ProctorIntervalIndexCalculator: snapshot_interval_us must not be negative!");
+        }
+        m_path = options.output_path();
+        if (cc->InputSidePackets().HasTag(kOutputPathTag) &&
+            !cc->InputSidePackets().Tag(kOutputPathTag).IsEmpty())
+        {
+            m_path = cc->InputSidePackets().Tag(kOutputPathTag).Get<std::string>();
+        }
+        if (m_path.empty())
+        {
+            return absl::InvalidArgumentError("ProctorIntervalIndexCalculator: no output path!");
+        }
+        m_snapshot_interval_us = options.snapshot_interval_us();
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorIntervalIndexCalculator::Process(CalculatorContext* cc)
+    {
+        if (!cc->Inputs().Tag(kEventsTag).IsEmpty())
+        {
+            for (const ProctorEvent& event: cc->Inputs().Tag(kEventsTag).Get<std::vector<ProctorEvent>>())
+            {
+                m_builder.Add(event);
+            }
+        }
+        m_builder.AdvanceTo(cc->InputTimestamp().Value());
+
+        if (m_snapshot_interval_us <= 0) { return absl::OkStatus(); }
+        if (m_last_snapshot == Timestamp::Unset())
+        {
+            m_last_snapshot = cc->InputTimestamp();
+        }
+        else if (cc->InputTimestamp().Value() - m_last_snapshot.Value() >= m_snapshot_interval_us)
+        {
+            m_last_snapshot = cc->InputTimestamp();
+            return m_builder.Write(m_path);
+        }
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status ProctorIntervalIndexCalculator::Close(CalculatorContext* cc)
+    { return m_path.empty() ? absl::OkStatus(): m_builder.Write(m_path); }
+
+} // namespace mediapipe
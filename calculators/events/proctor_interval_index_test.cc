@@ -0,0 +1,197 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the interval index of the proctoring events
+#include "mp_proctor/calculators/events/proctor_interval_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        std::string TempPath(const std::string& name)
+        {
+            const char* dir = std::getenv("TEST_TMPDIR");
+            return std::string(dir != nullptr ? dir: "/tmp") + "/" + name;
+        }
+
+        ProctorEvent MakeEvent(
+            ProctorEventType type, ProctorEventPhase phase, int face, int64_t start_us, int64_t end_us
+        )
+        {
+            ProctorEvent event = {};
+            event.type = type;
+            event.phase = phase;
+            event.face = face;
+            event.start_us = start_us;
+            event.end_us = end_us;
+            event.frames = 1;
+            return event;
+        }
+
+        struct Span
+        {
+            int64_t start_us;
+            int64_t end_us;
+            int face;
+        };
+
+        // Random intervals of type, back to back per face, added to builder
+        std::vector<Span> AddRandomIntervals(
+            ProctorEventType type, int faces, int count, std::mt19937* random, ProctorIntervalIndexBuilder* builder
+        )
+        {
+            std::uniform_int_distribution<int64_t> gap(0, 2000000);
+            std::uniform_int_distribution<int64_t> length(0, 5000000);
+            std::vector<int64_t> next_us(faces, 0);
+            std::vector<Span> spans;
+            for (int i = 0; i < count; i++)
+            {
+                const int face = i % faces;
+                const int64_t start_us = next_us[face] + gap(*random);
+                const int64_t end_us = start_us + length(*random);
+                next_us[face] = end_us + 1;
+                builder->Add(MakeEvent(type, ProctorEventPhase::kStart, face, start_us, start_us));
+                builder->Add(MakeEvent(type, ProctorEventPhase::kEnd, face, start_us, end_us));
+                spans.push_back({start_us, end_us, face});
+            }
+            std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b)
+            { return a.start_us != b.start_us ? a.start_us < b.start_us: a.end_us < b.end_us; });
+            return spans;
+        }
+
+        std::vector<int64_t> Starts(const std::vector<ProctorInterval>& intervals)
+        {
+            std::vector<int64_t> starts;
+            for (const auto& interval: intervals) { starts.push_back(interval.start_us); }
+            return starts;
+        }
+    } // namespace
+
+    TEST(ProctorIntervalIndexTest, QueriesMatchLinearScan)
+    {
+        // Counts around the powers of two of the implicit tree
+        for (int count: {1, 2, 3, 7, 8, 9, 15, 16, 17, 100, 255, 256, 257, 1000})
+        {
+            std::mt19937 random(count);
+            ProctorIntervalIndexBuilder builder;
+            const std::vector<Span> spans = AddRandomIntervals(
+                ProctorEventType::kLookDown, 3, count, &random, &builder
+            );
+            const std::string path = TempPath("interval_index_" + std::to_string(count) + ".mpix");
+            ASSERT_TRUE(builder.Write(path).ok());
+            auto index = ProctorIntervalIndex::Open(path);
+            ASSERT_TRUE(index.ok()) << index.status();
+            ASSERT_EQ((*index)->size(ProctorEventType::kLookDown), count);
+            EXPECT_EQ((*index)->size(ProctorEventType::kLookUp), 0);
+
+            const int64_t last_us = spans.back().end_us;
+            std::uniform_int_distribution<int64_t> time(-1000000, last_us + 1000000);
+            for (int query = 0; query < 50; query++)
+            {
+                int64_t from_us = time(random);
+                int64_t to_us = time(random);
+                if (from_us > to_us) { std::swap(from_us, to_us); }
+
+                std::vector<int64_t> overlapping, starting;
+                for (const Span& span: spans)
+                {
+                    if (span.start_us <= to_us && span.end_us >= from_us) { overlapping.push_back(span.start_us); }
+                    if (span.start_us >= from_us && span.start_us <= to_us) { starting.push_back(span.start_us); }
+                }
+                std::vector<ProctorInterval> intervals;
+                (*index)->Overlapping(ProctorEventType::kLookDown, from_us, to_us, &intervals);
+                EXPECT_EQ(Starts(intervals), overlapping) << "count " << count << ", [" << from_us << ", " << to_us << "]";
+                intervals.clear();
+                (*index)->Starting(ProctorEventType::kLookDown, from_us, to_us, &intervals);
+                EXPECT_EQ(Starts(intervals), starting) << "count " << count << ", [" << from_us << ", " << to_us << "]";
+            }
+        }
+    }
+
+    TEST(ProctorIntervalIndexTest, IntersectsIntervalsOfTheSameFace)
+    {
+        ProctorIntervalIndexBuilder builder;
+        for (const Span& span: std::vector<Span>{{0, 100, 0}, {50, 300, 1}})
+        {
+            builder.Add(MakeEvent(ProctorEventType::kLookDown, ProctorEventPhase::kStart, span.face, span.start_us, span.start_us));
+            builder.Add(MakeEvent(ProctorEventType::kLookDown, ProctorEventPhase::kEnd, span.face, span.start_us, span.end_us));
+        }
+        for (const Span& span: std::vector<Span>{{80, 200, 0}, {250, 400, -1}})
+        {
+            const ProctorEventType type = span.face < 0 ? ProctorEventType::kMultipleFaces: ProctorEventType::kHighActivity;
+            builder.Add(MakeEvent(type, ProctorEventPhase::kStart, span.face, span.start_us, span.start_us));
+            builder.Add(MakeEvent(type, ProctorEventPhase::kEnd, span.face, span.start_us, span.end_us));
+        }
+        const std::string path = TempPath("interval_index_intersect.mpix");
+        ASSERT_TRUE(builder.Write(path).ok());
+        auto index = ProctorIntervalIndex::Open(path);
+        ASSERT_TRUE(index.ok()) << index.status();
+
+        std::vector<ProctorIntervalOverlap> overlaps;
+        (*index)->Intersect(ProctorEventType::kLookDown, ProctorEventType::kHighActivity, 0, 1000, &overlaps);
+        // Face 1 looking down does not overlap the activity of face 0
+        ASSERT_EQ(overlaps.size(), 1);
+        EXPECT_EQ(overlaps[0].start_us, 80);
+        EXPECT_EQ(overlaps[0].end_us, 100);
+
+        overlaps.clear();
+        (*index)->Intersect(ProctorEventType::kLookDown, ProctorEventType::kMultipleFaces, 0, 280, &overlaps);
+        // Frame level intervals overlap any face, clipped to the range
+        ASSERT_EQ(overlaps.size(), 1);
+        EXPECT_EQ(overlaps[0].first.face, 1);
+        EXPECT_EQ(overlaps[0].start_us, 250);
+        EXPECT_EQ(overlaps[0].end_us, 280);
+    }
+
+    TEST(ProctorIntervalIndexTest, ExtendsOpenIntervals)
+    {
+        ProctorIntervalIndexBuilder builder;
+        builder.Add(MakeEvent(ProctorEventType::kNoFace, ProctorEventPhase::kStart, -1, 1000, 1000));
+        builder.AdvanceTo(5000);
+        const std::string path = TempPath("interval_index_open.mpix");
+        ASSERT_TRUE(builder.Write(path).ok());
+        auto index = ProctorIntervalIndex::Open(path);
+        ASSERT_TRUE(index.ok()) << index.status();
+
+        EXPECT_EQ((*index)->as_of_us(), 5000);
+        std::vector<ProctorInterval> intervals;
+        (*index)->Overlapping(ProctorEventType::kNoFace, 4000, 4500, &intervals);
+        ASSERT_EQ(intervals.size(), 1);
+        EXPECT_EQ(intervals[0].end_us, 5000);
+        EXPECT_EQ(intervals[0].flags, kProctorIntervalOpen);
+    }
+
+    TEST(ProctorIntervalIndexTest, RejectsOtherFiles)
+    {
+        const std::string path = TempPath("interval_index_garbage.mpix");
+        FILE* file = std::fopen(path.c_str(), "wb");
+        ASSERT_NE(file, nullptr);
+        const std::string garbage(256, 'x');
+        std::fwrite(garbage.data(), 1, garbage.size(), file);
+        std::fclose(file);
+        EXPECT_TRUE(absl::IsDataLoss(ProctorIntervalIndex::Open(path).status()));
+        EXPECT_TRUE(absl::IsNotFound(ProctorIntervalIndex::Open(TempPath("missing.mpix")).status()));
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,106 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Queries an interval index, e.g. the intervals where a face looked down
+// with high activity between minute 40 and 70:
+//   proctor_interval_query --index_path=exam.mpix --type=look_down \
+//     --with=high_activity --from_seconds=2400 --to_seconds=4200
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/events/proctor_event.h"
+#include "mp_proctor/calculators/events/proctor_interval_index.h"
+
+ABSL_FLAG(std::string, index_path, "",
+          "Interval index of ProctorIntervalIndexCalculator.");
+ABSL_FLAG(std::string, type, "look_down",
+          "Intervals to report, e.g. eyes_closed, look_left, no_face.");
+ABSL_FLAG(std::string, with, "",
+          "Only report the overlaps with the intervals of this type.");
+ABSL_FLAG(double, from_seconds, 0, "Start of the time range.");
+ABSL_FLAG(double, to_seconds, -1, "End of the time range, -1 for the end.");
+
+namespace {
+
+absl::StatusOr<mediapipe::ProctorEventType> ParseType(
+    const std::string& name) {
+  for (int type = 0; type < mediapipe::kProctorEventTypeCount; ++type) {
+    const auto event_type = static_cast<mediapipe::ProctorEventType>(type);
+    if (name == mediapipe::ProctorEventTypeName(event_type)) return event_type;
+  }
+  return absl::InvalidArgumentError("Unknown interval type " + name);
+}
+
+std::string FormatInterval(const mediapipe::ProctorInterval& interval) {
+  return absl::StrFormat(
+      "%s face=%d %.3f-%.3f s frames=%d mean=%.3f peak=%.3f%s",
+      mediapipe::ProctorEventTypeName(
+          static_cast<mediapipe::ProctorEventType>(interval.type)),
+      interval.face, interval.start_us / 1e6, interval.end_us / 1e6,
+      interval.frames, interval.mean_value, interval.peak_value,
+      interval.flags & mediapipe::kProctorIntervalOpen ? " (open)" : "");
+}
+
+absl::Status Query() {
+  ASSIGN_OR_RETURN(auto index, mediapipe::ProctorIntervalIndex::Open(
+                                   absl::GetFlag(FLAGS_index_path)));
+  ASSIGN_OR_RETURN(const auto type, ParseType(absl::GetFlag(FLAGS_type)));
+  const int64_t from_us =
+      static_cast<int64_t>(absl::GetFlag(FLAGS_from_seconds) * 1e6);
+  const int64_t to_us =
+      absl::GetFlag(FLAGS_to_seconds) < 0
+          ? INT64_MAX
+          : static_cast<int64_t>(absl::GetFlag(FLAGS_to_seconds) * 1e6);
+
+  if (absl::GetFlag(FLAGS_with).empty()) {
+    std::vector<mediapipe::ProctorInterval> intervals;
+    index->Overlapping(type, from_us, to_us, &intervals);
+    for (const auto& interval : intervals) {
+      std::cout << FormatInterval(interval) << "\n";
+    }
+    return absl::OkStatus();
+  }
+
+  ASSIGN_OR_RETURN(const auto with, ParseType(absl::GetFlag(FLAGS_with)));
+  std::vector<mediapipe::ProctorIntervalOverlap> overlaps;
+  index->Intersect(type, with, from_us, to_us, &overlaps);
+  for (const auto& overlap : overlaps) {
+    std::cout << absl::StrFormat("%.3f-%.3f s: ", overlap.start_us / 1e6,
+                                 overlap.end_us / 1e6)
+              << FormatInterval(overlap.first) << " | "
+              << FormatInterval(overlap.second) << "\n";
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  const absl::Status status = Query();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to query the index: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,287 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to capture evidence frames and face crops on a trigger
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mp_proctor/calculators/events/proctor_event.h"
+#include "mp_proctor/calculators/evidence/evidence_capture_calculator.pb.h"
+#include "mp_proctor/calculators/evidence/evidence_writer.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageTag[]      = "IMAGE";
+        constexpr char kLandmarksTag[]  = "LANDMARKS";
+        constexpr char kTriggerTag[]    = "TRIGGER";
+        constexpr char kEventsTag[]     = "EVENTS";
+        constexpr char kScoreTag[]      = "SCORE";
+        constexpr char kOutputDirTag[]  = "OUTPUT_DIR";
+        constexpr char kSessionIdTag[]  = "SESSION_ID";
+    } // namespace
+
+    /**
+     * @brief Capture the frame and the aligned face crops when a trigger
+     *        fires, encoded to JPEG and written by EvidenceWriter
+     *
+     * The packets are handed to the encoder threads as they are, so the
+     * graph neither copies the frame nor waits for the encoding or the disk.
+     * The face crops are computed by the encoders from the landmarks, with
+     * the alignment of face_reid_cpu.pbtxt (see face_crop.h). Captures are
+     * rate limited by min_interval_us and max_captures, and dropped while
+     * queue_size captures wait for the encoders.
+     *
+     * The triggers usually come later than the frames, from the end of the
+     * analysis, and only at some timestamps. Inputs are therefore taken as
+     * they arrive and matched by timestamp: the last max_pending_frames
+     * frames are held until a trigger at their timestamp fires, and a
+     * trigger arriving first waits for its frame. The capture includes the
+     * landmarks received by then.
+     *
+     * INPUTS:
+     *      IMAGE - Frame to capture (ImageFrame)
+     *      LANDMARKS - Optional landmarks of the faces (std::vector<NormalizedLandmarkList>)
+     *      TRIGGER - Optional trigger, any packet (Any)
+     *      EVENTS - Optional events, the start events of event_types trigger (std::vector<ProctorEvent>)
+     *      SCORE - Optional score, triggering at score_threshold, e.g. of ProctorAnomalyCalculator (double)
+     * INPUT SIDE PACKETS:
+     *      OUTPUT_DIR - Optional directory of the captures, overriding the options (std::string)
+     *      SESSION_ID - Optional session id, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "EvidenceCaptureCalculator"
+     *   input_stream: "IMAGE:throttled_input_video"
+     *   input_stream: "LANDMARKS:multi_face_landmarks"
+     *   input_stream: "EVENTS:proctor_events"
+     *   input_side_packet: "SESSION_ID:session_id"
+     *   options: {
+     *     [mediapipe.EvidenceCaptureCalculatorOptions.ext] {
+     *       output_dir: "/var/lib/mp_proctor/evidence"
+     *       event_types: "look_down"
+     *       event_types: "multiple_faces"
+     *     }
+     *   }
+     * }
+     *
+     */
+    class EvidenceCaptureCalculator: public CalculatorBase
+    {
+    private:
+        struct PendingFrame
+        {
+            Packet image;
+            Packet landmarks;
+        };
+
+        std::unique_ptr<EvidenceWriter> m_writer;
+        std::set<std::string> m_event_types;
+        double m_score_threshold = 0;
+        int m_max_pending_frames = 0;
+
+        // Recent frames, and reasons of the triggers still waiting for their frame
+        std::map<Timestamp, PendingFrame> m_frames;
+        std::map<Timestamp, std::string> m_triggers;
+        Timestamp m_last_capture = Timestamp::Unset();
+
+        // Reason of the capture of this frame, empty if none fired
+        std::string Trigger(CalculatorContext* cc) const;
+
+    public:
+        EvidenceCaptureCalculator() = default;
+        ~EvidenceCaptureCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(EvidenceCaptureCalculator);
+
+    absl::Status EvidenceCaptureCalculator::GetContract(CalculatorContract* cc)
+    {
+        if (!cc->Inputs().HasTag(kTriggerTag) && !cc->Inputs().HasTag(kEventsTag) && !cc->Inputs().HasTag(kScoreTag))
+        {
+            return absl::InvalidArgumentError("EvidenceCaptureCalculator: no TRIGGER, EVENTS nor SCORE input!");
+        }
+        cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
+        if (cc->Inputs().HasTag(kLandmarksTag))
+        {
+            cc->Inputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmarkList>>();
+        }
+        if (cc->Inputs().HasTag(kTriggerTag))
+        {
+            cc->Inputs().Tag(kTriggerTag).SetAny();
+        }
+        if (cc->Inputs().HasTag(kEventsTag))
+        {
+            cc->Inputs().Tag(kEventsTag).Set<std::vector<ProctorEvent>>();
+        }
+        if (cc->Inputs().HasTag(kScoreTag))
+        {
+            cc->Inputs().Tag(kScoreTag).Set<double>();
+        }
+        if (cc->InputSidePackets().HasTag(kOutputDirTag))
+        {
+            cc->InputSidePackets().Tag(kOutputDirTag).Set<std::string>().Optional();
+        }
+        if (cc->InputSidePackets().HasTag(kSessionIdTag))
+        {
+            cc->InputSidePackets().Tag(kSessionIdTag).Set<std::string>().Optional();
+        }
+
+        // Frames must not queue up until the next trigger
+        cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+        return absl::OkStatus();
+    }
+
+    absl::Status EvidenceCaptureCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<EvidenceCaptureCalculatorOptions>();
+        for (const std::string& type: options.event_types())
+        {
+            bool is_known = false;
+            for (int i = 0; i < kProctorEventTypeCount; ++i)
+            {
+                is_known |= type == ProctorEventTypeName(static_cast<ProctorEventType>(i));
+            }
+            if (!is_known)
+            {
+                return absl::InvalidArgumentError("EvidenceCaptureCalculator: unknown event type " + type + "!");
+            }
+            m_event_types.insert(type);
+        }
+        m_score_threshold = options.score_threshold();
+        m_max_pending_frames = options.max_pending_frames();
+        if (m_max_pending_frames <= 0)
+        {
+            return absl::InvalidArgumentError("EvidenceCaptureCalculator: max_pending_frames must be positive!");
+        }
+
+        EvidenceWriterOptions writer_options;
+        writer_options.output_dir = options.output_dir();
+        if (cc->InputSidePackets().HasTag(kOutputDirTag) &&
+            !cc->InputSidePackets().Tag(kOutputDirTag).IsEmpty())
+        {
+            writer_options.output_dir = cc->InputSidePackets().Tag(kOutputDirTag).Get<std::string>();
+        }
+        writer_options.session_id = options.session_id();
+        if (cc->InputSidePackets().HasTag(kSessionIdTag) &&
+            !cc->InputSidePackets().Tag(kSessionIdTag).IsEmpty())
+        {
+            writer_options.session_id = cc->InputSidePackets().Tag(kSessionIdTag).Get<std::string>();
+        }
+        writer_options.encoder_threads = options.encoder_threads();
+        writer_options.queue_size = options.queue_size();
+        writer_options.jpeg_quality = options.jpeg_quality();
+        writer_options.min_interval_us = options.min_interval_us();
+        writer_options.max_captures = options.max_captures();
+        writer_options.crop_size = options.crop_size();
+        ASSIGN_OR_RETURN(m_writer, EvidenceWriter::Create(writer_options));
+        return absl::OkStatus();
+    }
+
+    std::string EvidenceCaptureCalculator::Trigger(CalculatorContext* cc) const
+    {
+        if (cc->Inputs().HasTag(kTriggerTag) && !cc->Inputs().Tag(kTriggerTag).IsEmpty())
+        {
+            return "trigger";
+        }
+        if (cc->Inputs().HasTag(kEventsTag) && !cc->Inputs().Tag(kEventsTag).IsEmpty())
+        {
+            for (const ProctorEvent& event: cc->Inputs().Tag(kEventsTag).Get<std::vector<ProctorEvent>>())
+            {
+                const std::string type = ProctorEventTypeName(event.type);
+                if (event.phase == ProctorEventPhase::kStart &&
+                    (m_event_types.empty() || m_event_types.count(type) > 0))
+                {
+                    return type;
+                }
+            }
+        }
+        if (cc->Inputs().HasTag(kScoreTag) && !cc->Inputs().Tag(kScoreTag).IsEmpty() &&
+            cc->Inputs().Tag(kScoreTag).Get<double>() >= m_score_threshold)
+        {
+            return "anomaly";
+        }
+        return "";
+    }
+
+    absl::Status EvidenceCaptureCalculator::Process(CalculatorContext* cc)
+    {
+        const Timestamp timestamp = cc->InputTimestamp();
+        if (!cc->Inputs().Tag(kImageTag).IsEmpty())
+        {
+            m_frames[timestamp].image = cc->Inputs().Tag(kImageTag).Value();
+            // Frames arrive in order, earlier triggers missed theirs
+            m_triggers.erase(m_triggers.begin(), m_triggers.lower_bound(timestamp));
+        }
+        if (cc->Inputs().HasTag(kLandmarksTag) && !cc->Inputs().Tag(kLandmarksTag).IsEmpty())
+        {
+            m_frames[timestamp].landmarks = cc->Inputs().Tag(kLandmarksTag).Value();
+        }
+        while (static_cast<int>(m_frames.size()) > m_max_pending_frames) { m_frames.erase(m_frames.begin()); }
+
+        std::string reason = this->Trigger(cc);
+        if (!reason.empty()) { m_triggers.emplace(timestamp, std::move(reason)); }
+
+        auto trigger = m_triggers.find(timestamp);
+        auto frame = m_frames.find(timestamp);
+        if (trigger == m_triggers.end() || frame == m_frames.end() || frame->second.image.IsEmpty())
+        {
+            return absl::OkStatus();
+        }
+        // Each frame is captured once, whichever trigger came first
+        if (m_last_capture == Timestamp::Unset() || timestamp > m_last_capture)
+        {
+            m_last_capture = timestamp;
+            EvidenceRequest request;
+            request.timestamp_us = timestamp.Value();
+            request.reason = std::move(trigger->second);
+            request.image = frame->second.image;
+            request.landmarks = frame->second.landmarks;
+            m_writer->Capture(std::move(request));
+        }
+        m_triggers.erase(trigger);
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status EvidenceCaptureCalculator::Close(CalculatorContext* cc)
+    {
+        if (!m_writer) { return absl::OkStatus(); }
+        m_writer->Close();
+        const EvidenceMetrics metrics = m_writer->metrics();
+        LOG(INFO) << "Evidence: " << metrics.written << " captures written, " << metrics.failed << " failed, "
+            << metrics.rate_limited << " rate limited and " << metrics.dropped << " dropped";
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
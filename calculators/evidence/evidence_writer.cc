@@ -0,0 +1,226 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Asynchronous evidence capture of key frames and aligned face crops
+#include "mp_proctor/calculators/evidence/evidence_writer.h"
+
+#include <sys/stat.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kTemporaryExtension[] = ".tmp";
+
+        bool MakeDirectory(const std::string& path)
+        { return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST; }
+
+        // Create path and its missing parents
+        bool MakeDirectories(const std::string& path)
+        {
+            for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1))
+            {
+                if (!MakeDirectory(path.substr(0, slash))) { return false; }
+            }
+            return MakeDirectory(path);
+        }
+
+        // Session ids come from the clients, keep them to a single directory
+        std::string SessionDirectoryName(const std::string& session_id)
+        {
+            std::string name = session_id.empty() ? "session": session_id;
+            for (char& c: name)
+            {
+                const bool is_safe = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                    (c >= '0' && c <= '9') || c == '-' || c == '_' || c == '.';
+                if (!is_safe) { c = '_'; }
+            }
+            if (name == "." || name == "..") { name = "session"; }
+            return name;
+        }
+
+        // Write through a temporary file, so that readers never see a
+        // partial file
+        absl::Status WriteFile(const std::string& path, const void* data, size_t size)
+        {
+            const std::string temporary_path = path + kTemporaryExtension;
+            FILE* file = std::fopen(temporary_path.c_str(), "wb");
+            if (file == nullptr) { return absl::NotFoundError("Could not create " + temporary_path); }
+            bool failed = std::fwrite(data, 1, size, file) != size;
+            failed |= std::fclose(file) != 0;
+            if (failed || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+            {
+                std::remove(temporary_path.c_str());
+                return absl::InternalError("Failed to write " + path);
+            }
+            return absl::OkStatus();
+        }
+
+        absl::Status WriteJpeg(const std::string& path, const cv::Mat& image, int quality)
+        {
+            std::vector<uchar> jpeg;
+            if (!cv::imencode(".jpg", image, jpeg, {cv::IMWRITE_JPEG_QUALITY, quality}))
+            {
+                return absl::InternalError("Failed to encode " + path);
+            }
+            return WriteFile(path, jpeg.data(), jpeg.size());
+        }
+    } // namespace
+
+    EvidenceWriter::EvidenceWriter(const EvidenceWriterOptions& options, const std::string& session_dir)
+        : m_options(options), m_session_dir(session_dir),
+          m_queue(options.queue_size, DropPolicy::kDropNewest)
+    {}
+
+    EvidenceWriter::~EvidenceWriter()
+    { this->Close(); }
+
+    absl::StatusOr<std::unique_ptr<EvidenceWriter>> EvidenceWriter::Create(const EvidenceWriterOptions& options)
+    {
+        RET_CHECK(!options.output_dir.empty()) << "No evidence output directory";
+        RET_CHECK_GT(options.encoder_threads, 0);
+        RET_CHECK_GT(options.queue_size, 0);
+        RET_CHECK(options.jpeg_quality >= 1 && options.jpeg_quality <= 100);
+        RET_CHECK_GE(options.min_interval_us, 0);
+        RET_CHECK_GE(options.max_captures, 0);
+        RET_CHECK_GE(options.crop_size, 0);
+
+        const std::string session_dir = options.output_dir + "/" + SessionDirectoryName(options.session_id);
+        if (!MakeDirectories(session_dir))
+        {
+            return absl::NotFoundError("Could not create the evidence directory " + session_dir);
+        }
+
+        std::unique_ptr<EvidenceWriter> writer(new EvidenceWriter(options, session_dir));
+        for (int i = 0; i < options.encoder_threads; ++i)
+        {
+            writer->m_workers.emplace_back(&EvidenceWriter::Run, writer.get());
+        }
+        return writer;
+    }
+
+    bool EvidenceWriter::Capture(EvidenceRequest request)
+    {
+        const bool is_limited =
+            (m_options.max_captures > 0 && m_accepted >= m_options.max_captures) ||
+            (m_has_captured && request.timestamp_us - m_last_capture_us < m_options.min_interval_us);
+        if (request.image.IsEmpty()) { return false; }
+        if (is_limited)
+        {
+            absl::MutexLock lock(&m_mutex);
+            m_metrics.rate_limited++;
+            return false;
+        }
+
+        // A dropped capture delays the next one as well, rather than
+        // retrying on every frame while the encoders are behind
+        m_has_captured = true;
+        m_last_capture_us = request.timestamp_us;
+        if (!m_queue.Push(std::move(request))) { return false; }
+        m_accepted++;
+        absl::MutexLock lock(&m_mutex);
+        m_metrics.captures++;
+        return true;
+    }
+
+    EvidenceMetrics EvidenceWriter::metrics() const
+    {
+        absl::MutexLock lock(&m_mutex);
+        EvidenceMetrics metrics = m_metrics;
+        metrics.dropped = m_queue.dropped();
+        return metrics;
+    }
+
+    void EvidenceWriter::Close()
+    {
+        m_queue.Close();
+        for (std::thread& worker: m_workers)
+        {
+            if (worker.joinable()) { worker.join(); }
+        }
+    }
+
+    void EvidenceWriter::Run()
+    {
+        EvidenceRequest request;
+        while (m_queue.Pop(&request))
+        {
+            const absl::Status status = this->Write(request);
+            // Release the frame before waiting for the next request
+            request = EvidenceRequest();
+            absl::MutexLock lock(&m_mutex);
+            if (status.ok())
+            {
+                m_metrics.written++;
+            }
+            else
+            {
+                m_metrics.failed++;
+                LOG(WARNING) << "Evidence capture failed: " << status.message();
+            }
+        }
+    }
+
+    absl::Status EvidenceWriter::Write(const EvidenceRequest& request)
+    {
+        const ImageFrame& frame = request.image.Get<ImageFrame>();
+        const cv::Mat image = formats::MatView(&frame);
+        cv::Mat bgr;
+        switch (image.type())
+        {
+            case CV_8UC3:   cv::cvtColor(image, bgr, cv::COLOR_RGB2BGR); break;
+            case CV_8UC4:   cv::cvtColor(image, bgr, cv::COLOR_RGBA2BGR); break;
+            case CV_8UC1:   bgr = image; break;
+            default:
+                return absl::InvalidArgumentError(absl::StrCat("Unsupported image format ", static_cast<int>(frame.Format())));
+        }
+
+        const std::string dir = absl::StrFormat("%s/%012d", m_session_dir, request.timestamp_us);
+        if (!MakeDirectory(dir)) { return absl::NotFoundError("Could not create " + dir); }
+        MP_RETURN_IF_ERROR(WriteJpeg(dir + "/frame.jpg", bgr, m_options.jpeg_quality));
+
+        if (m_options.crop_size > 0 && !request.landmarks.IsEmpty())
+        {
+            const auto& faces = request.landmarks.Get<std::vector<NormalizedLandmarkList>>();
+            for (size_t face = 0; face < faces.size(); ++face)
+            {
+                cv::Mat crop;
+                if (!AlignedFaceCrop(bgr, faces[face], m_options.crop_size, &crop)) { continue; }
+                MP_RETURN_IF_ERROR(WriteJpeg(
+                    absl::StrCat(dir, "/face_", face, ".jpg"), crop, m_options.jpeg_quality
+                ));
+            }
+        }
+
+        const std::string trigger = request.reason + "\n";
+        return WriteFile(dir + "/trigger.txt", trigger.data(), trigger.size());
+    }
+
+} // namespace mediapipe
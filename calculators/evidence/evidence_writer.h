@@ -0,0 +1,134 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Asynchronous evidence capture of key frames and aligned face crops
+#ifndef evidence_writer_h
+#define evidence_writer_h
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/packet.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/bounded_queue.h"
+#include "mp_proctor/calculators/util/face_crop.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of EvidenceWriter
+     */
+    struct EvidenceWriterOptions
+    {
+        // Captures are written to output_dir/session_id/<timestamp_us>/
+        std::string output_dir;
+        std::string session_id;
+
+        // Encoder threads, and captures waiting for them; the newest are
+        // dropped beyond queue_size
+        int encoder_threads = 1;
+        int queue_size = 8;
+        int jpeg_quality = 85;
+
+        // Stream time from a capture to the next one, and captures of the
+        // session, 0 for no limit
+        int64_t min_interval_us = 2000000;
+        int max_captures = 100;
+
+        // Side of the aligned face crops, 0 to not crop the faces
+        int crop_size = kAlignedFaceSize;
+    };
+
+    /**
+     * @brief Counters of EvidenceWriter
+     */
+    struct EvidenceMetrics
+    {
+        // Captures queued, and skipped by the rate limits
+        uint64_t captures = 0;
+        uint64_t rate_limited = 0;
+        // Captures dropped because the encoders fell behind
+        uint64_t dropped = 0;
+        uint64_t written = 0;
+        uint64_t failed = 0;
+    };
+
+    /**
+     * @brief Frame to capture, the packets are shared rather than copied
+     */
+    struct EvidenceRequest
+    {
+        int64_t timestamp_us = 0;
+        // Why the frame is captured, e.g. the event type
+        std::string reason;
+        // ImageFrame
+        Packet image;
+        // Optional std::vector<NormalizedLandmarkList> of the faces
+        Packet landmarks;
+    };
+
+    /**
+     * @brief Writes the captures as JPEG files on a pool of encoder threads
+     *
+     * Capture() applies the rate limits and queues the request, it never
+     * waits for the encoders nor the disk. A capture is the directory
+     * output_dir/session_id/<timestamp_us> holding frame.jpg, face_<i>.jpg
+     * for the faces with iris landmarks, and trigger.txt with the reason.
+     */
+    class EvidenceWriter
+    {
+    private:
+        EvidenceWriterOptions m_options;
+        std::string m_session_dir;
+        BoundedQueue<EvidenceRequest> m_queue;
+        std::vector<std::thread> m_workers;
+
+        // Owned by the caller of Capture()
+        int m_accepted = 0;
+        bool m_has_captured = false;
+        int64_t m_last_capture_us = 0;
+
+        mutable absl::Mutex m_mutex;
+        EvidenceMetrics m_metrics ABSL_GUARDED_BY(m_mutex);
+
+        EvidenceWriter(const EvidenceWriterOptions& options, const std::string& session_dir);
+
+        void Run();
+        absl::Status Write(const EvidenceRequest& request);
+
+    public:
+        ~EvidenceWriter();
+
+        EvidenceWriter(const EvidenceWriter&) = delete;
+        EvidenceWriter& operator=(const EvidenceWriter&) = delete;
+
+        static absl::StatusOr<std::unique_ptr<EvidenceWriter>> Create(const EvidenceWriterOptions& options);
+
+        // Queue a capture, returns false if it was rate limited or dropped
+        bool Capture(EvidenceRequest request);
+
+        EvidenceMetrics metrics() const;
+
+        // Write the queued captures and stop the encoders
+        void Close();
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -20,7 +20,7 @@
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/util/render_data.pb.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
 
 namespace mediapipe
 {
@@ -76,23 +76,14 @@ namespace mediapipe
 
     absl::Status EyeBlinkCalculator::Process(CalculatorContext* cc)
     {
-        auto landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
-        std::map<std::string, double> blink_map;
-        
-        // Right Eye
-        cv::Vec3d ur_el { landmarks.landmark(386).x(), landmarks.landmark(386).y() };
-        cv::Vec3d lr_el { landmarks.landmark(374).x(), landmarks.landmark(374).y() };
-
-        // Left Eye
-        cv::Vec3d ul_el { landmarks.landmark(159).x(), landmarks.landmark(159).y() };
-        cv::Vec3d ll_el { landmarks.landmark(145).x(), landmarks.landmark(145).y() };
+        FaceCoordinates std_landmarks;
+        LandmarksToCoordinates(cc->Inputs().Index(0).Get<NormalizedLandmarkList>(), &std_landmarks);
+        const EyeBlinkMetrics blink = ComputeEyeBlink(std_landmarks);
 
-        auto r_dist = cv::norm(ur_el - lr_el, cv::NORM_L2);
-        auto l_dist = cv::norm(ul_el - ll_el, cv::NORM_L2);
-
-        blink_map["left"] = l_dist;
-        blink_map["right"] = r_dist;
-        blink_map["threshold"] = (-0.0228 * landmarks.landmark(1).x()) + (0.0162 * landmarks.landmark(1).y()) + (0.0792 * exp(pow(landmarks.landmark(1).y(), 2)));
+        std::map<std::string, double> blink_map;
+        blink_map["left"] = blink.left;
+        blink_map["right"] = blink.right;
+        blink_map["threshold"] = blink.threshold;
 
         Packet packet = MakePacket<decltype(blink_map)>(blink_map).At(cc->InputTimestamp());
         cc->Outputs().Index(0).AddPacket(packet);
@@ -0,0 +1,260 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to lower the analysis frame rate while the faces stay still
+#include <set>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+#include "mp_proctor/calculators/face_activity/adaptive_frame_sampler_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageTag[]    = "IMAGE";
+        constexpr char kFeedbackTag[] = "FEEDBACK";
+        constexpr char kFinishedTag[] = "FINISHED";
+        constexpr char kSkippedTag[]  = "SKIPPED";
+        constexpr char kAllowTag[]    = "ALLOW";
+        constexpr char kSkipTag[]     = "SKIP";
+    } // namespace
+
+    /**
+     * @brief Drop input frames while the recent face movement and facial
+     *        activity stay below the configured thresholds
+     *
+     * The full frame rate is restored as soon as movement or activity rises,
+     * or the number of faces changes. A frame is only skipped when no other
+     * frame is being analyzed, so that the SKIP tick can be answered with the
+     * latest analyzed result (see ProctorResultCarryForwardCalculator).
+     * Frames dropped by a FlowLimiterCalculator further down never finish,
+     * so its ALLOW output should be fed back, or the sampler waits for the
+     * next sent frame to finish before skipping again.
+     * FINISHED must only tick for analyzed frames, since a frame finished
+     * without FEEDBACK means that no face was found. Frames skipped further
+     * down without analysis, e.g. by FrameChangeGateCalculator, go to
+     * SKIPPED instead, which keeps the sampler state as it is.
+     *
+     * INPUTS:
+     *      IMAGE - Input frame (Any)
+     *      FEEDBACK - Results of the analyzed frames, back edge (std::vector<ProctorResult>)
+     *      FINISHED - Any packet emitted once a frame is fully analyzed, back edge
+     *      SKIPPED - Optional, frames skipped downstream without analysis, back edge (Any)
+     *      ALLOW - Optional, ALLOW of the downstream FlowLimiterCalculator, back edge (bool)
+     * OUTPUTS:
+     *      IMAGE - Frames to be analyzed (Same as input)
+     *      SKIP - Timestamps of the skipped frames (bool)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "AdaptiveFrameSamplerCalculator"
+     *   input_stream: "IMAGE:input_video"
+     *   input_stream: "FEEDBACK:analyzed_proctor_results"
+     *   input_stream: "FINISHED:analyzed_frame"
+     *   input_stream: "SKIPPED:unchanged_frame"
+     *   input_stream: "ALLOW:allowed_frame"
+     *   input_stream_info: {
+     *     tag_index: "FEEDBACK"
+     *     back_edge: true
+     *   }
+     *   input_stream_info: {
+     *     tag_index: "FINISHED"
+     *     back_edge: true
+     *   }
+     *   input_stream_info: {
+     *     tag_index: "SKIPPED"
+     *     back_edge: true
+     *   }
+     *   input_stream_info: {
+     *     tag_index: "ALLOW"
+     *     back_edge: true
+     *   }
+     *   output_stream: "IMAGE:sampled_input_video"
+     *   output_stream: "SKIP:skipped_frame"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.AdaptiveFrameSamplerCalculatorOptions] {
+     *       idle_fps: 2.0
+     *     }
+     *   }
+     * }
+     *
+     */
+    class AdaptiveFrameSamplerCalculator: public CalculatorBase
+    {
+    private:
+        AdaptiveFrameSamplerCalculatorOptions m_options;
+        int64 m_idle_period_us = 0;
+
+        Timestamp m_last_sent = Timestamp::Unset();
+        Timestamp m_last_feedback = Timestamp::Unset();
+        // Sent frames neither finished nor dropped downstream
+        std::set<Timestamp> m_in_flight;
+
+        int m_face_count = 0;
+        int m_quiet_count = 0;
+
+        void OnFeedback(const std::vector<ProctorResult>& results, Timestamp timestamp);
+        void OnFinished(Timestamp timestamp);
+        void OnSkipped(Timestamp timestamp);
+        void OnDropped(Timestamp timestamp);
+        bool IsInFlight() const;
+
+    public:
+        AdaptiveFrameSamplerCalculator() = default;
+        ~AdaptiveFrameSamplerCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(AdaptiveFrameSamplerCalculator);
+
+    absl::Status AdaptiveFrameSamplerCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kImageTag).SetAny();
+        cc->Inputs().Tag(kFeedbackTag).Set<std::vector<ProctorResult>>();
+        cc->Inputs().Tag(kFinishedTag).SetAny();
+        if (cc->Inputs().HasTag(kSkippedTag))
+        {
+            cc->Inputs().Tag(kSkippedTag).SetAny();
+        }
+        if (cc->Inputs().HasTag(kAllowTag))
+        {
+            cc->Inputs().Tag(kAllowTag).Set<bool>();
+        }
+        cc->Outputs().Tag(kImageTag).SetSameAs(&cc->Inputs().Tag(kImageTag));
+        cc->Outputs().Tag(kSkipTag).Set<bool>();
+
+        // Back edges must not hold back the incoming frames
+        cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+        return absl::OkStatus();
+    }
+
+    absl::Status AdaptiveFrameSamplerCalculator::Open(CalculatorContext* cc)
+    {
+        m_options = cc->Options<AdaptiveFrameSamplerCalculatorOptions>();
+        if (m_options.idle_fps() <= 0)
+        {
+            return absl::InvalidArgumentError("AdaptiveFrameSamplerCalculator: idle_fps must be positive!");
+        }
+        m_idle_period_us = static_cast<int64>(1e6 / m_options.idle_fps());
+        return absl::OkStatus();
+    }
+
+    void AdaptiveFrameSamplerCalculator::OnFeedback(const std::vector<ProctorResult>& results, Timestamp timestamp)
+    {
+        constexpr unsigned int kRequiredFields = PROCTOR_FIELD_MOVEMENT | PROCTOR_FIELD_ACTIVITY;
+        bool is_quiet = !results.empty();
+        for (const auto& result: results)
+        {
+            if ((result.present_fields & kRequiredFields) != kRequiredFields ||
+                result.face_movement >= m_options.movement_threshold() ||
+                result.facial_activity >= m_options.activity_threshold())
+            {
+                is_quiet = false;
+            }
+        }
+
+        // A face appeared or disappeared; go back to full rate
+        if (static_cast<int>(results.size()) != m_face_count)
+        {
+            is_quiet = false;
+        }
+        m_face_count = results.size();
+        m_quiet_count = is_quiet ? m_quiet_count + 1: 0;
+        m_last_feedback = timestamp;
+    }
+
+    void AdaptiveFrameSamplerCalculator::OnFinished(Timestamp timestamp)
+    {
+        // The analyzed frame produced no result, i.e. no face was found
+        if (m_last_feedback != timestamp)
+        {
+            m_face_count = 0;
+            m_quiet_count = 0;
+        }
+        this->OnSkipped(timestamp);
+    }
+
+    void AdaptiveFrameSamplerCalculator::OnSkipped(Timestamp timestamp)
+    {
+        // Earlier frames finished before, or were dropped on the way
+        m_in_flight.erase(m_in_flight.begin(), m_in_flight.upper_bound(timestamp));
+    }
+
+    void AdaptiveFrameSamplerCalculator::OnDropped(Timestamp timestamp)
+    { m_in_flight.erase(timestamp); }
+
+    bool AdaptiveFrameSamplerCalculator::IsInFlight() const
+    { return !m_in_flight.empty(); }
+
+    absl::Status AdaptiveFrameSamplerCalculator::Process(CalculatorContext* cc)
+    {
+        if (!cc->Inputs().Tag(kFeedbackTag).IsEmpty())
+        {
+            this->OnFeedback(
+                cc->Inputs().Tag(kFeedbackTag).Get<std::vector<ProctorResult>>(),
+                cc->InputTimestamp()
+            );
+        }
+        if (!cc->Inputs().Tag(kFinishedTag).IsEmpty())
+        {
+            this->OnFinished(cc->InputTimestamp());
+        }
+        if (cc->Inputs().HasTag(kSkippedTag) && !cc->Inputs().Tag(kSkippedTag).IsEmpty())
+        {
+            this->OnSkipped(cc->InputTimestamp());
+        }
+        // A frame the limiter dropped is no longer in flight
+        if (cc->Inputs().HasTag(kAllowTag) && !cc->Inputs().Tag(kAllowTag).IsEmpty() &&
+            !cc->Inputs().Tag(kAllowTag).Get<bool>())
+        {
+            this->OnDropped(cc->InputTimestamp());
+        }
+        if (cc->Inputs().Tag(kImageTag).IsEmpty()) { return absl::OkStatus(); }
+
+        const Timestamp timestamp = cc->InputTimestamp();
+        const bool is_idle = m_quiet_count >= m_options.quiet_frames();
+        const bool is_due = m_last_sent == Timestamp::Unset() ||
+            (timestamp - m_last_sent).Value() >= m_idle_period_us;
+
+        if (!is_idle || is_due)
+        {
+            m_last_sent = timestamp;
+            m_in_flight.insert(timestamp);
+            cc->Outputs().Tag(kImageTag).AddPacket(cc->Inputs().Tag(kImageTag).Value());
+        } else if (!this->IsInFlight())
+        {
+            cc->Outputs().Tag(kSkipTag).AddPacket(MakePacket<bool>(true).At(timestamp));
+        }
+        // Otherwise the frame is dropped, just like FlowLimiterCalculator would
+
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status AdaptiveFrameSamplerCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
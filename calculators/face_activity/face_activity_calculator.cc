@@ -20,8 +20,8 @@
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/status.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
 
 namespace mediapipe
 {
@@ -45,7 +45,7 @@ namespace mediapipe
     class FaceActivityCalculator: public CalculatorBase
     {
     private:
-        cv::Mat m_prev_landmark_mat;
+        FaceCoordinates m_prev_std_landmarks;
 
     public:
         FaceActivityCalculator() = default;
@@ -73,23 +73,11 @@ namespace mediapipe
 
     absl::Status FaceActivityCalculator::Process(CalculatorContext* cc)
     {
-        auto landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
-        cv::Mat cur_landmark_mat(landmarks.landmark_size(), 3, CV_64FC1);
-
-        for (int i = 0; i < landmarks.landmark_size(); ++i) {
-            cur_landmark_mat.at<double>(i, 0) = landmarks.landmark(i).x();
-            cur_landmark_mat.at<double>(i, 1) = landmarks.landmark(i).y();
-            cur_landmark_mat.at<double>(i, 2) = landmarks.landmark(i).z();
-        }
-        
-        // Initialize prev_landmark_mat
-        if (m_prev_landmark_mat.size().area() == 0)
-        {
-            m_prev_landmark_mat = cur_landmark_mat;
-        }
-        
-        auto delta = cv::norm(cur_landmark_mat - m_prev_landmark_mat, cv::NORM_L2);
-        m_prev_landmark_mat = cur_landmark_mat;
+        FaceCoordinates std_landmarks;
+        LandmarksToCoordinates(cc->Inputs().Index(0).Get<NormalizedLandmarkList>(), &std_landmarks);
+        // The first frame has no activity
+        auto delta = ComputeFacialActivity(m_prev_std_landmarks, std_landmarks);
+        m_prev_std_landmarks = std::move(std_landmarks);
             
         Packet packet = MakePacket<double>(delta).At(cc->InputTimestamp());
         cc->Outputs().Index(0).AddPacket(packet);
@@ -20,8 +20,8 @@
 #include "absl/memory/memory.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/status.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
 
 namespace mediapipe
 {
@@ -45,7 +45,7 @@ namespace mediapipe
     class FaceMovementCalculator: public CalculatorBase
     {
     private:
-        cv::Vec3f m_prev_vec;
+        FaceCoordinates m_prev_landmarks;
 
     public:
         FaceMovementCalculator() = default;
@@ -73,11 +73,10 @@ namespace mediapipe
 
     absl::Status FaceMovementCalculator::Process(CalculatorContext* cc)
     {
-        auto landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
-        auto cur_landmark = landmarks.landmark(0);
-        cv::Vec3f cur_vec (cur_landmark.x(), cur_landmark.y(), cur_landmark.z());
-        auto delta = cv::norm(cur_vec - m_prev_vec, cv::NORM_L2);
-        m_prev_vec = cur_vec;
+        FaceCoordinates landmarks;
+        LandmarksToCoordinates(cc->Inputs().Index(0).Get<NormalizedLandmarkList>(), &landmarks);
+        auto delta = ComputeFaceMovement(m_prev_landmarks, landmarks);
+        m_prev_landmarks = std::move(landmarks);
             
         Packet packet = MakePacket<decltype(delta)>(delta).At(cc->InputTimestamp());
         cc->Outputs().Index(0).AddPacket(packet);
@@ -20,6 +20,7 @@
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
 
 namespace mediapipe
 {
@@ -73,10 +74,13 @@ namespace mediapipe
 
     absl::Status FaceOrientationCalculator::Process(CalculatorContext* cc)
     {
-        auto landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
+        FaceCoordinates std_landmarks;
+        LandmarksToCoordinates(cc->Inputs().Index(0).Get<NormalizedLandmarkList>(), &std_landmarks);
+        const FaceOrientationMetrics orientation = ComputeFaceOrientation(std_landmarks);
+
         std::map<std::string, double> orientation_map;
-        orientation_map["horizontal_align"]   = landmarks.landmark(1).x();
-        orientation_map["vertical_align"]     = landmarks.landmark(1).y();
+        orientation_map["horizontal_align"]   = orientation.horizontal_align;
+        orientation_map["vertical_align"]     = orientation.vertical_align;
             
         Packet packet = MakePacket<decltype(orientation_map)>(orientation_map).At(cc->InputTimestamp());
         cc->Outputs().Index(0).AddPacket(packet);
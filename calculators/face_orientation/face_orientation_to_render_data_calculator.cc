@@ -22,6 +22,7 @@
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/util/color.pb.h"
 #include "mediapipe/util/render_data.pb.h"
+#include "mp_proctor/calculators/util/proctor_thresholds.h"
 
 namespace mediapipe
 {
@@ -111,12 +112,8 @@ namespace mediapipe
             if(!multi_face_orientations.empty())
             {
                 auto orientation = multi_face_orientations.at(0);
-                std::string hor_align =    orientation.at("horizontal_align") >= 0.3 ? "Right":
-                                            orientation.at("horizontal_align") <= -0.3 ? "Left":
-                                            "Neutral";
-                std::string ver_align =    orientation.at("vertical_align") >= 0.6 ? "Down":
-                                            orientation.at("vertical_align") <= -0.05 ? "Up":
-                                            "Neutral";
+                std::string hor_align = HorizontalAlignLabel(orientation.at("horizontal_align"));
+                std::string ver_align = VerticalAlignLabel(orientation.at("vertical_align"));
                 
                 this->Annotateorientation(render_data, hor_align, 0.05);
                 this->Annotateorientation(render_data, ver_align, 0.6);
@@ -0,0 +1,135 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to downscale a frame while keeping its aspect ratio
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/image/downscale_image_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageTag[]       = "IMAGE";
+        constexpr char kTargetWidthTag[] = "TARGET_WIDTH";
+    } // namespace
+
+    /**
+     * @brief Downscale a frame to the target width, keeping the aspect ratio
+     *
+     * Used to feed a smaller copy to face detection and landmarks while other
+     * nodes keep the full resolution frame. Landmarks are normalized, so they
+     * apply to either resolution. Frames that are not wider than the target
+     * are forwarded without a copy.
+     *
+     * INPUTS:
+     *      IMAGE - Input frame (ImageFrame)
+     * INPUT SIDE PACKETS:
+     *      TARGET_WIDTH - Optional target width overriding the options (int)
+     * OUTPUTS:
+     *      IMAGE - Downscaled frame (ImageFrame)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "DownscaleImageCalculator"
+     *   input_stream: "IMAGE:throttled_input_video"
+     *   input_side_packet: "TARGET_WIDTH:detection_width"
+     *   output_stream: "IMAGE:detection_input_video"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.DownscaleImageCalculatorOptions] {
+     *       target_width: 640
+     *     }
+     *   }
+     * }
+     *
+     */
+    class DownscaleImageCalculator: public CalculatorBase
+    {
+    private:
+        int m_target_width = 0;
+
+    public:
+        DownscaleImageCalculator() = default;
+        ~DownscaleImageCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(DownscaleImageCalculator);
+
+    absl::Status DownscaleImageCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
+        if (cc->InputSidePackets().HasTag(kTargetWidthTag))
+        {
+            cc->InputSidePackets().Tag(kTargetWidthTag).Set<int>().Optional();
+        }
+        cc->Outputs().Tag(kImageTag).Set<ImageFrame>();
+        return absl::OkStatus();
+    }
+
+    absl::Status DownscaleImageCalculator::Open(CalculatorContext* cc)
+    {
+        cc->SetOffset(TimestampDiff(0));
+        m_target_width = cc->Options<DownscaleImageCalculatorOptions>().target_width();
+        if (cc->InputSidePackets().HasTag(kTargetWidthTag) &&
+            !cc->InputSidePackets().Tag(kTargetWidthTag).IsEmpty())
+        {
+            m_target_width = cc->InputSidePackets().Tag(kTargetWidthTag).Get<int>();
+        }
+        if (m_target_width < 0)
+        {
+            return absl::InvalidArgumentError("DownscaleImageCalculator: target width must not be negative!");
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status DownscaleImageCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& input_packet = cc->Inputs().Tag(kImageTag).Value();
+        const auto& input_frame = input_packet.Get<ImageFrame>();
+        if (m_target_width == 0 || input_frame.Width() <= m_target_width)
+        {
+            cc->Outputs().Tag(kImageTag).AddPacket(input_packet);
+            return absl::OkStatus();
+        }
+
+        const int height = std::max(1, static_cast<int>(
+            static_cast<int64>(input_frame.Height()) * m_target_width / input_frame.Width()));
+        auto output_frame = absl::make_unique<ImageFrame>(
+            input_frame.Format(), m_target_width, height, ImageFrame::kDefaultAlignmentBoundary);
+        cv::Mat output_mat = formats::MatView(output_frame.get());
+        cv::resize(formats::MatView(&input_frame), output_mat, output_mat.size(), 0, 0, cv::INTER_AREA);
+        cc->Outputs().Tag(kImageTag).Add(output_frame.release(), cc->InputTimestamp());
+
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status DownscaleImageCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
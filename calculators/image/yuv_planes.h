@@ -0,0 +1,90 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// OpenCV views of the planes of an I420 or NV12 YUVImage
+#ifndef yuv_planes_h
+#define yuv_planes_h
+
+#include <algorithm>
+
+#include "libyuv/video_common.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Planes of a YUVImage without copying the pixels
+     *
+     * y - Full resolution luma (CV_8UC1)
+     * u, v - Half resolution chroma of I420 (CV_8UC1)
+     * uv - Half resolution interleaved chroma of NV12 (CV_8UC2)
+     */
+    struct YuvPlanes
+    {
+        cv::Mat y;
+        cv::Mat u;
+        cv::Mat v;
+        cv::Mat uv;
+
+        bool IsNv12() const { return !uv.empty(); }
+    };
+
+    inline absl::Status GetYuvPlanes(const YUVImage& image, YuvPlanes* planes)
+    {
+        if (image.bit_depth() != 8)
+        {
+            return absl::InvalidArgumentError("Only 8 bit YUV images are supported!");
+        }
+        const int width = image.width(), height = image.height();
+        const int chroma_width = (width + 1) / 2, chroma_height = (height + 1) / 2;
+        auto view = [](int rows, int cols, int type, const uint8* data, int stride)
+        { return cv::Mat(rows, cols, type, const_cast<uint8*>(data), stride); };
+
+        planes->y = view(height, width, CV_8UC1, image.data(0), image.stride(0));
+        switch (image.fourcc())
+        {
+        case libyuv::FOURCC_I420:
+            planes->u = view(chroma_height, chroma_width, CV_8UC1, image.data(1), image.stride(1));
+            planes->v = view(chroma_height, chroma_width, CV_8UC1, image.data(2), image.stride(2));
+            planes->uv = cv::Mat();
+            return absl::OkStatus();
+        case libyuv::FOURCC_NV12:
+            planes->uv = view(chroma_height, chroma_width, CV_8UC2, image.data(1), image.stride(1));
+            planes->u = cv::Mat();
+            planes->v = cv::Mat();
+            return absl::OkStatus();
+        default:
+            return absl::InvalidArgumentError("Only I420 and NV12 YUV images are supported!");
+        }
+    }
+
+    /**
+     * @brief BT.601 limited range YUV to RGB, with the coefficients of
+     *        cv::COLOR_YUV2RGB_I420
+     */
+    inline void YuvToRgbPixel(int y, int u, int v, uint8* rgb)
+    {
+        auto clamp = [](int value) { return static_cast<uint8>(std::min(255, std::max(0, value))); };
+        const int c = 1192 * std::max(0, y - 16);
+        const int d = u - 128, e = v - 128;
+        rgb[0] = clamp((c + 1634 * e + 512) >> 10);
+        rgb[1] = clamp((c - 833 * e - 400 * d + 512) >> 10);
+        rgb[2] = clamp((c + 2066 * d + 512) >> 10);
+    }
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,181 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to convert a YUV frame into a resized RGB ImageFrame
+#include <algorithm>
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/image/yuv_planes.h"
+#include "mp_proctor/calculators/image/yuv_to_image_frame_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageYuvTag[] = "IMAGE_YUV";
+        constexpr char kImageTag[]    = "IMAGE";
+        constexpr char kSizeTag[]     = "SIZE";
+    } // namespace
+
+    /**
+     * @brief Convert an I420 or NV12 frame into an SRGB ImageFrame of the
+     *        target size
+     *
+     * The planes are resized first and only the resized pixels are color
+     * converted, so a downscaled frame for face detection costs a fraction
+     * of a full frame conversion.
+     *
+     * INPUTS:
+     *      IMAGE_YUV - Input frame (YUVImage)
+     * OUTPUTS:
+     *      IMAGE - Resized RGB frame (ImageFrame)
+     *      SIZE - Optional size of the input frame (std::pair<int, int>)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "YuvToImageFrameCalculator"
+     *   input_stream: "IMAGE_YUV:input_yuv"
+     *   output_stream: "IMAGE:input_video"
+     *   output_stream: "SIZE:input_size"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.YuvToImageFrameCalculatorOptions] {
+     *       target_width: 640
+     *     }
+     *   }
+     * }
+     *
+     */
+    class YuvToImageFrameCalculator: public CalculatorBase
+    {
+    private:
+        YuvToImageFrameCalculatorOptions m_options;
+        // Resized planes, packed as expected by cv::cvtColor
+        cv::Mat m_packed;
+
+        std::pair<int, int> GetTargetSize(int width, int height) const;
+
+    public:
+        YuvToImageFrameCalculator() = default;
+        ~YuvToImageFrameCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(YuvToImageFrameCalculator);
+
+    absl::Status YuvToImageFrameCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kImageYuvTag).Set<YUVImage>();
+        cc->Outputs().Tag(kImageTag).Set<ImageFrame>();
+        if (cc->Outputs().HasTag(kSizeTag))
+        {
+            cc->Outputs().Tag(kSizeTag).Set<std::pair<int, int>>();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status YuvToImageFrameCalculator::Open(CalculatorContext* cc)
+    {
+        cc->SetOffset(TimestampDiff(0));
+        m_options = cc->Options<YuvToImageFrameCalculatorOptions>();
+        if (m_options.target_width() < 0 || m_options.target_height() < 0)
+        {
+            return absl::InvalidArgumentError("YuvToImageFrameCalculator: target size must not be negative!");
+        }
+        return absl::OkStatus();
+    }
+
+    std::pair<int, int> YuvToImageFrameCalculator::GetTargetSize(int width, int height) const
+    {
+        int target_width = m_options.target_width(), target_height = m_options.target_height();
+        if (target_width == 0 && target_height == 0)
+        {
+            target_width = width;
+            target_height = height;
+        } else if (target_width == 0)
+        {
+            target_width = static_cast<int>(static_cast<int64>(width) * target_height / height);
+        } else if (target_height == 0)
+        {
+            target_height = static_cast<int>(static_cast<int64>(height) * target_width / width);
+        }
+        // 4:2:0 chroma needs even sizes
+        return {std::max(2, target_width & ~1), std::max(2, target_height & ~1)};
+    }
+
+    absl::Status YuvToImageFrameCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& yuv_image = cc->Inputs().Tag(kImageYuvTag).Get<YUVImage>();
+        YuvPlanes planes;
+        MP_RETURN_IF_ERROR(GetYuvPlanes(yuv_image, &planes));
+
+        int width, height;
+        std::tie(width, height) = this->GetTargetSize(yuv_image.width(), yuv_image.height());
+        const int interpolation = width < yuv_image.width() ? cv::INTER_AREA: cv::INTER_LINEAR;
+
+        // Luma followed by the chroma plane(s), i.e. a contiguous I420 or NV12 frame
+        m_packed.create(height * 3 / 2, width, CV_8UC1);
+        uint8* chroma = m_packed.ptr<uint8>(height);
+        cv::Mat y(height, width, CV_8UC1, m_packed.data);
+        cv::resize(planes.y, y, y.size(), 0, 0, interpolation);
+        if (planes.IsNv12())
+        {
+            cv::Mat uv(height / 2, width / 2, CV_8UC2, chroma);
+            cv::resize(planes.uv, uv, uv.size(), 0, 0, interpolation);
+        } else
+        {
+            cv::Mat u(height / 2, width / 2, CV_8UC1, chroma);
+            cv::Mat v(height / 2, width / 2, CV_8UC1, chroma + (width / 2) * (height / 2));
+            cv::resize(planes.u, u, u.size(), 0, 0, interpolation);
+            cv::resize(planes.v, v, v.size(), 0, 0, interpolation);
+        }
+
+        auto output_frame = absl::make_unique<ImageFrame>(
+            ImageFormat::SRGB, width, height, ImageFrame::kDefaultAlignmentBoundary);
+        cv::Mat output_mat = formats::MatView(output_frame.get());
+        cv::cvtColor(
+            m_packed, output_mat,
+            planes.IsNv12() ? cv::COLOR_YUV2RGB_NV12: cv::COLOR_YUV2RGB_I420
+        );
+        cc->Outputs().Tag(kImageTag).Add(output_frame.release(), cc->InputTimestamp());
+
+        if (cc->Outputs().HasTag(kSizeTag))
+        {
+            cc->Outputs().Tag(kSizeTag).AddPacket(
+                MakePacket<std::pair<int, int>>(yuv_image.width(), yuv_image.height())
+                    .At(cc->InputTimestamp())
+            );
+        }
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status YuvToImageFrameCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
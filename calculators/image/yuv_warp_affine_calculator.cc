@@ -0,0 +1,182 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to warp a region of a YUV frame into an RGB ImageFrame
+#include <array>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/yuv_image.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/image/yuv_planes.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageYuvTag[]   = "IMAGE_YUV";
+        constexpr char kMatrixTag[]     = "MATRIX";
+        constexpr char kOutputSizeTag[] = "OUTPUT_SIZE";
+        constexpr char kImageTag[]      = "IMAGE";
+
+        // Black in limited range YUV
+        constexpr int kBorderLuma   = 16;
+        constexpr int kBorderChroma = 128;
+
+        // Normalized output-to-input matrix to the pixel space of a plane
+        cv::Mat PlaneTransform(const std::array<float, 16>& matrix, const cv::Size& plane, const cv::Size& output)
+        {
+            cv::Mat transform(2, 3, CV_32F);
+            for (int row = 0; row < 2; ++row)
+            {
+                const float scale = row == 0 ? plane.width: plane.height;
+                transform.at<float>(row, 0) = scale * matrix[row * 4 + 0] / output.width;
+                transform.at<float>(row, 1) = scale * matrix[row * 4 + 1] / output.height;
+                transform.at<float>(row, 2) = scale * matrix[row * 4 + 3];
+            }
+            return transform;
+        }
+
+        void WarpPlane(
+            const cv::Mat& plane,
+            const std::array<float, 16>& matrix,
+            const cv::Size& output_size,
+            int border,
+            cv::Mat* output
+        )
+        {
+            cv::warpAffine(
+                plane, *output, PlaneTransform(matrix, plane.size(), output_size), output_size,
+                cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_CONSTANT, cv::Scalar::all(border)
+            );
+        }
+    } // namespace
+
+    /**
+     * @brief WarpAffineCalculatorCpu counterpart sampling an I420 or NV12
+     *        frame, e.g. the aligned face crop for re-identification
+     *
+     * Only the warped region is color converted. Pixels outside of the input
+     * frame are black, like BORDER_ZERO.
+     *
+     * INPUTS:
+     *      IMAGE_YUV - Input frame (YUVImage)
+     *      MATRIX - Normalized output-to-input transform, same as for
+     *               WarpAffineCalculator (std::array<float, 16>)
+     *      OUTPUT_SIZE - Output size (std::pair<int, int>)
+     * OUTPUTS:
+     *      IMAGE - Warped RGB frame (ImageFrame)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "YuvWarpAffineCalculator"
+     *   input_stream: "IMAGE_YUV:input_yuv"
+     *   input_stream: "MATRIX:similarity_transform"
+     *   input_stream: "OUTPUT_SIZE:output_size"
+     *   output_stream: "IMAGE:transformed_image"
+     * }
+     *
+     */
+    class YuvWarpAffineCalculator: public CalculatorBase
+    {
+    private:
+        cv::Mat m_y;
+        cv::Mat m_u;
+        cv::Mat m_v;
+        cv::Mat m_uv;
+
+    public:
+        YuvWarpAffineCalculator() = default;
+        ~YuvWarpAffineCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(YuvWarpAffineCalculator);
+
+    absl::Status YuvWarpAffineCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kImageYuvTag).Set<YUVImage>();
+        cc->Inputs().Tag(kMatrixTag).Set<std::array<float, 16>>();
+        cc->Inputs().Tag(kOutputSizeTag).Set<std::pair<int, int>>();
+        cc->Outputs().Tag(kImageTag).Set<ImageFrame>();
+        return absl::OkStatus();
+    }
+
+    absl::Status YuvWarpAffineCalculator::Open(CalculatorContext* cc)
+    {
+        cc->SetOffset(TimestampDiff(0));
+        return absl::OkStatus();
+    }
+
+    absl::Status YuvWarpAffineCalculator::Process(CalculatorContext* cc)
+    {
+        if (cc->Inputs().Tag(kImageYuvTag).IsEmpty() ||
+            cc->Inputs().Tag(kMatrixTag).IsEmpty() ||
+            cc->Inputs().Tag(kOutputSizeTag).IsEmpty())
+        {
+            return absl::OkStatus();
+        }
+        YuvPlanes planes;
+        MP_RETURN_IF_ERROR(GetYuvPlanes(cc->Inputs().Tag(kImageYuvTag).Get<YUVImage>(), &planes));
+        const auto& matrix = cc->Inputs().Tag(kMatrixTag).Get<std::array<float, 16>>();
+        const auto& output_size = cc->Inputs().Tag(kOutputSizeTag).Get<std::pair<int, int>>();
+        const cv::Size size(output_size.first, output_size.second);
+
+        // The chroma is warped to the full output size, i.e. 4:4:4
+        WarpPlane(planes.y, matrix, size, kBorderLuma, &m_y);
+        if (planes.IsNv12())
+        {
+            WarpPlane(planes.uv, matrix, size, kBorderChroma, &m_uv);
+        } else
+        {
+            WarpPlane(planes.u, matrix, size, kBorderChroma, &m_u);
+            WarpPlane(planes.v, matrix, size, kBorderChroma, &m_v);
+        }
+
+        auto output_frame = absl::make_unique<ImageFrame>(
+            ImageFormat::SRGB, size.width, size.height, ImageFrame::kDefaultAlignmentBoundary);
+        cv::Mat output_mat = formats::MatView(output_frame.get());
+        for (int row = 0; row < size.height; ++row)
+        {
+            const uint8* y = m_y.ptr<uint8>(row);
+            const uint8* u = planes.IsNv12() ? m_uv.ptr<uint8>(row): m_u.ptr<uint8>(row);
+            const uint8* v = planes.IsNv12() ? m_uv.ptr<uint8>(row) + 1: m_v.ptr<uint8>(row);
+            const int chroma_step = planes.IsNv12() ? 2: 1;
+            uint8* rgb = output_mat.ptr<uint8>(row);
+            for (int col = 0; col < size.width; ++col)
+            {
+                YuvToRgbPixel(y[col], u[col * chroma_step], v[col * chroma_step], rgb + col * 3);
+            }
+        }
+        cc->Outputs().Tag(kImageTag).Add(output_frame.release(), cc->InputTimestamp());
+
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status YuvWarpAffineCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
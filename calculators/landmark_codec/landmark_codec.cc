@@ -0,0 +1,195 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Quantized delta codec of face landmarks
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr int kAxes = 3;
+        constexpr uint32_t kMaxLevels = 65535;
+        // Fixed bytes of a face after its landmark count
+        constexpr size_t kFaceHeaderBytes = kAxes * 4 * 2 + kAxes * 2;
+
+        uint16_t Quantize(float value, float min, float extent, uint16_t levels)
+        {
+            if (extent <= 0) { return 0; }
+            const double q = std::round((static_cast<double>(value) - min) / extent * levels);
+            return static_cast<uint16_t>(std::min<double>(std::max(q, 0.0), levels));
+        }
+
+        float Dequantize(uint16_t q, float min, float extent, uint16_t levels)
+        { return levels == 0 ? min: static_cast<float>(min + static_cast<double>(q) * extent / levels); }
+    } // namespace
+
+    LandmarkEncoder::LandmarkEncoder(const LandmarkCodecOptions& options)
+        : m_options(options)
+    {}
+
+    void LandmarkEncoder::Encode(const LandmarkFaces& faces, std::string* out)
+    {
+        out->clear();
+        const bool is_keyframe = m_frames_since_keyframe < 0 ||
+            m_frames_since_keyframe + 1 >= m_options.keyframe_interval;
+        m_frames_since_keyframe = is_keyframe ? 0: m_frames_since_keyframe + 1;
+
+        std::vector<std::vector<uint16_t>> quantized(faces.size());
+        bool all_keyframes = true;
+        std::string faces_data;
+        for (size_t face = 0; face < faces.size(); ++face)
+        {
+            const std::vector<float>& coordinates = faces[face];
+            const size_t landmark_count = coordinates.size() / kAxes;
+
+            float min[kAxes], extent[kAxes];
+            uint16_t levels[kAxes];
+            for (int axis = 0; axis < kAxes; ++axis)
+            {
+                float low = 0, high = 0;
+                for (size_t i = 0; i < landmark_count; ++i)
+                {
+                    const float value = coordinates[i * kAxes + axis];
+                    low = i == 0 ? value: std::min(low, value);
+                    high = i == 0 ? value: std::max(high, value);
+                }
+                min[axis] = low;
+                extent[axis] = high - low;
+                // The float extent and decoded values add up to two ulps
+                const double magnitude = std::max(std::abs(low), std::abs(high));
+                const double budget = m_options.max_error - std::ldexp(magnitude, -22);
+                const double needed = budget > 0 ? std::ceil(extent[axis] / (2 * budget)): kMaxLevels;
+                levels[axis] = static_cast<uint16_t>(std::min<double>(std::max(needed, 1.0), kMaxLevels));
+            }
+
+            std::vector<uint16_t>& q = quantized[face];
+            q.resize(landmark_count * kAxes);
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                const int axis = i % kAxes;
+                q[i] = Quantize(coordinates[i], min[axis], extent[axis], levels[axis]);
+            }
+
+            const bool is_key_face = is_keyframe || face >= m_previous.size() || m_previous[face].size() != q.size();
+            all_keyframes &= is_key_face;
+            faces_data.push_back(static_cast<char>(is_key_face ? kLandmarkKeyframe: 0));
+            PutVarint(landmark_count, &faces_data);
+            for (int axis = 0; axis < kAxes; ++axis) { PutFixed(min[axis], &faces_data); }
+            for (int axis = 0; axis < kAxes; ++axis) { PutFixed(extent[axis], &faces_data); }
+            for (int axis = 0; axis < kAxes; ++axis) { PutFixed(levels[axis], &faces_data); }
+            if (is_key_face)
+            {
+                for (uint16_t value: q) { PutFixed(value, &faces_data); }
+            }
+            else
+            {
+                const std::vector<uint16_t>& previous = m_previous[face];
+                for (size_t i = 0; i < q.size(); ++i)
+                {
+                    PutVarint(ZigZagEncode(static_cast<int64_t>(q[i]) - previous[i]), &faces_data);
+                }
+            }
+        }
+
+        out->push_back(static_cast<char>(all_keyframes ? kLandmarkKeyframe: 0));
+        PutVarint(m_sequence++, out);
+        PutVarint(faces.size(), out);
+        out->append(faces_data);
+        m_previous = std::move(quantized);
+    }
+
+    absl::Status LandmarkDecoder::Decode(absl::string_view data, LandmarkFaces* faces)
+    {
+        const uint8_t* cursor = reinterpret_cast<const uint8_t*>(data.data());
+        const uint8_t* end = cursor + data.size();
+        const auto corrupted = [this]()
+        {
+            m_has_keyframe = false;
+            return absl::DataLossError("Corrupted landmark frame");
+        };
+
+        uint64_t sequence = 0, face_count = 0;
+        if (cursor == end) { return corrupted(); }
+        const uint8_t frame_flags = *cursor++;
+        if (!GetVarint(&cursor, end, &sequence) || !GetVarint(&cursor, end, &face_count) ||
+            face_count > data.size())
+        {
+            return corrupted();
+        }
+        if (!(frame_flags & kLandmarkKeyframe) && (!m_has_keyframe || sequence != m_next_sequence))
+        {
+            m_has_keyframe = false;
+            return absl::FailedPreconditionError("Waiting for a landmark keyframe");
+        }
+
+        std::vector<std::vector<uint16_t>> quantized(face_count);
+        faces->assign(face_count, {});
+        for (uint64_t face = 0; face < face_count; ++face)
+        {
+            uint64_t landmark_count = 0;
+            if (cursor == end) { return corrupted(); }
+            const uint8_t face_flags = *cursor++;
+            if (!GetVarint(&cursor, end, &landmark_count) || landmark_count > data.size() ||
+                static_cast<size_t>(end - cursor) < kFaceHeaderBytes)
+            {
+                return corrupted();
+            }
+            float min[kAxes], extent[kAxes];
+            uint16_t levels[kAxes];
+            for (int axis = 0; axis < kAxes; ++axis, cursor += 4) { min[axis] = GetFixed<float>(cursor); }
+            for (int axis = 0; axis < kAxes; ++axis, cursor += 4) { extent[axis] = GetFixed<float>(cursor); }
+            for (int axis = 0; axis < kAxes; ++axis, cursor += 2) { levels[axis] = GetFixed<uint16_t>(cursor); }
+
+            std::vector<uint16_t>& q = quantized[face];
+            q.resize(landmark_count * kAxes);
+            if (face_flags & kLandmarkKeyframe)
+            {
+                if (static_cast<size_t>(end - cursor) < q.size() * 2) { return corrupted(); }
+                for (size_t i = 0; i < q.size(); ++i, cursor += 2) { q[i] = GetFixed<uint16_t>(cursor); }
+            }
+            else
+            {
+                if (face >= m_previous.size() || m_previous[face].size() != q.size()) { return corrupted(); }
+                for (size_t i = 0; i < q.size(); ++i)
+                {
+                    uint64_t delta = 0;
+                    if (!GetVarint(&cursor, end, &delta)) { return corrupted(); }
+                    q[i] = static_cast<uint16_t>(m_previous[face][i] + ZigZagDecode(delta));
+                }
+            }
+
+            std::vector<float>& coordinates = (*faces)[face];
+            coordinates.resize(q.size());
+            for (size_t i = 0; i < q.size(); ++i)
+            {
+                const int axis = i % kAxes;
+                coordinates[i] = Dequantize(q[i], min[axis], extent[axis], levels[axis]);
+            }
+        }
+        if (cursor != end) { return corrupted(); }
+
+        m_previous = std::move(quantized);
+        m_next_sequence = sequence + 1;
+        m_has_keyframe = true;
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
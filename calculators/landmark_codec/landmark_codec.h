@@ -0,0 +1,116 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Quantized delta codec of face landmarks
+#ifndef landmark_codec_h
+#define landmark_codec_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/port/status.h"
+
+/**
+ * Each frame is encoded on its own, as
+ *
+ *      uint8  frame_flags          kLandmarkKeyframe if no face refers to
+ *                                  the previous frame
+ *      varint sequence             Frame number, to detect lost frames
+ *      varint face_count
+ *
+ * followed by, for each face:
+ *
+ *      uint8  face_flags           kLandmarkKeyframe if the face is coded
+ *                                  without the previous frame
+ *      varint landmark_count
+ *      float  min[3]               Bounding box of the landmarks, x y z
+ *      float  extent[3]
+ *      uint16 levels[3]            Quantization levels of each axis
+ *      values                      landmark_count * 3 quantized coordinates,
+ *                                  x y z of each landmark in turn
+ *
+ * A coordinate v is quantized to q = round((v - min) / extent * levels), so
+ * its error is at most extent / (2 * levels), plus the float rounding of
+ * the decoded value. The levels are chosen for both to stay below the
+ * error bound, up to 65535. Keyframe faces store q as
+ * uint16, the others as varint zigzag deltas from the q of the same
+ * landmark of the same face in the previous frame. Since q is relative to
+ * the bounding box, it barely changes when the face moves.
+ */
+
+namespace mediapipe
+{
+    constexpr uint8_t kLandmarkKeyframe = 1;
+
+    // Landmarks of each face, x y z of each landmark in turn
+    using LandmarkFaces = std::vector<std::vector<float>>;
+
+    struct LandmarkCodecOptions
+    {
+        // Largest error of a coordinate, in normalized units
+        double max_error = 0.0002;
+        // Frames between two keyframes, 1 to only code keyframes
+        int keyframe_interval = 30;
+    };
+
+    /**
+     * @brief Encodes a stream of landmark frames
+     */
+    class LandmarkEncoder
+    {
+    private:
+        LandmarkCodecOptions m_options;
+        std::vector<std::vector<uint16_t>> m_previous;
+        uint64_t m_sequence = 0;
+        // -1 until the first keyframe
+        int m_frames_since_keyframe = -1;
+
+    public:
+        explicit LandmarkEncoder(const LandmarkCodecOptions& options);
+
+        // Encode a frame, out is replaced
+        void Encode(const LandmarkFaces& faces, std::string* out);
+        // Encode the next frame as a keyframe, e.g. for a new subscriber
+        void ForceKeyframe() { m_frames_since_keyframe = -1; }
+    };
+
+    /**
+     * @brief Decodes the frames of a LandmarkEncoder, in the same order
+     *
+     * Decoding can start at any keyframe.
+     */
+    class LandmarkDecoder
+    {
+    private:
+        std::vector<std::vector<uint16_t>> m_previous;
+        uint64_t m_next_sequence = 0;
+        bool m_has_keyframe = false;
+
+    public:
+        /**
+         * @brief Decode a frame
+         *
+         * Returns FailedPrecondition for frames referring to a frame that was
+         * not decoded, e.g. before the first keyframe or after a lost frame,
+         * and DataLoss for corrupted frames; the next keyframe recovers from
+         * both.
+         */
+        absl::Status Decode(absl::string_view data, LandmarkFaces* faces);
+    };
+
+} // namespace mediapipe
+
+#endif
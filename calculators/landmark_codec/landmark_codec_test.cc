@@ -0,0 +1,152 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the quantized delta codec of face landmarks
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+
+#include <cmath>
+#include <random>
+#include <string>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr int kLandmarkCount = 478;
+        // Serialized NormalizedLandmark with x, y and z, in a repeated field
+        constexpr int kProtoBytesPerLandmark = 17;
+
+        // A face around (0.5, 0.5), moved by offset and jittered
+        std::vector<float> MakeFace(float offset, float jitter, std::mt19937* random)
+        {
+            std::uniform_real_distribution<float> noise(-jitter, jitter);
+            std::vector<float> face;
+            for (int i = 0; i < kLandmarkCount; i++)
+            {
+                const float angle = i * 0.37f;
+                face.push_back(0.5f + offset + 0.15f * std::cos(angle) * (i % 7) / 7 + noise(*random));
+                face.push_back(0.5f + offset + 0.2f * std::sin(angle) * (i % 5) / 5 + noise(*random));
+                face.push_back(-0.05f + 0.1f * (i % 11) / 11 + noise(*random));
+            }
+            return face;
+        }
+
+        double MaxError(const LandmarkFaces& expected, const LandmarkFaces& actual)
+        {
+            double error = 0;
+            for (size_t face = 0; face < expected.size(); face++)
+            {
+                for (size_t i = 0; i < expected[face].size(); i++)
+                {
+                    error = std::max<double>(error, std::abs(expected[face][i] - actual[face][i]));
+                }
+            }
+            return error;
+        }
+    } // namespace
+
+    TEST(LandmarkCodecTest, KeyframeRoundTrip)
+    {
+        std::mt19937 random(1);
+        LandmarkCodecOptions options;
+        LandmarkEncoder encoder(options);
+        LandmarkDecoder decoder;
+
+        const LandmarkFaces faces = {MakeFace(0, 0, &random), MakeFace(0.2f, 0, &random)};
+        std::string data;
+        encoder.Encode(faces, &data);
+        EXPECT_EQ(static_cast<uint8_t>(data[0]) & kLandmarkKeyframe, kLandmarkKeyframe);
+
+        LandmarkFaces decoded;
+        ASSERT_TRUE(decoder.Decode(data, &decoded).ok());
+        ASSERT_EQ(decoded.size(), faces.size());
+        ASSERT_EQ(decoded[0].size(), faces[0].size());
+        EXPECT_LE(MaxError(faces, decoded), options.max_error);
+    }
+
+    TEST(LandmarkCodecTest, DeltaFramesStayWithinErrorBound)
+    {
+        for (double max_error: {1e-5, 2e-4, 1e-3})
+        {
+            std::mt19937 random(2);
+            LandmarkCodecOptions options;
+            options.max_error = max_error;
+            LandmarkEncoder encoder(options);
+            LandmarkDecoder decoder;
+
+            for (int frame = 0; frame < 10; frame++)
+            {
+                const LandmarkFaces faces = {MakeFace(0.001f * frame, 0.0005f, &random)};
+                std::string data;
+                encoder.Encode(faces, &data);
+                EXPECT_EQ(static_cast<uint8_t>(data[0]) & kLandmarkKeyframe, frame == 0 ? kLandmarkKeyframe: 0);
+
+                LandmarkFaces decoded;
+                ASSERT_TRUE(decoder.Decode(data, &decoded).ok());
+                EXPECT_LE(MaxError(faces, decoded), max_error) << "max_error " << max_error << ", frame " << frame;
+            }
+        }
+    }
+
+    TEST(LandmarkCodecTest, DeltaFramesAreSmallerThanProtos)
+    {
+        std::mt19937 random(3);
+        LandmarkEncoder encoder(LandmarkCodecOptions{});
+
+        std::string keyframe;
+        encoder.Encode({MakeFace(0, 0.0005f, &random)}, &keyframe);
+        std::string delta;
+        encoder.Encode({MakeFace(0.001f, 0.0005f, &random)}, &delta);
+
+        EXPECT_LT(delta.size(), keyframe.size());
+        EXPECT_LT(delta.size() * 5, kLandmarkCount * kProtoBytesPerLandmark);
+    }
+
+    TEST(LandmarkCodecTest, WaitsForKeyframeAfterLostFrame)
+    {
+        std::mt19937 random(4);
+        LandmarkCodecOptions options;
+        options.keyframe_interval = 3;
+        LandmarkEncoder encoder(options);
+        LandmarkDecoder decoder;
+
+        std::vector<std::string> frames(4);
+        for (auto& data: frames)
+        {
+            encoder.Encode({MakeFace(0, 0.0005f, &random)}, &data);
+        }
+
+        LandmarkFaces decoded;
+        ASSERT_TRUE(decoder.Decode(frames[0], &decoded).ok());
+        // frames[1] is lost
+        EXPECT_TRUE(absl::IsFailedPrecondition(decoder.Decode(frames[2], &decoded)));
+        EXPECT_TRUE(decoder.Decode(frames[3], &decoded).ok());
+    }
+
+    TEST(LandmarkCodecTest, RejectsTruncatedFrames)
+    {
+        std::mt19937 random(5);
+        LandmarkEncoder encoder(LandmarkCodecOptions{});
+        LandmarkDecoder decoder;
+
+        std::string data;
+        encoder.Encode({MakeFace(0, 0, &random)}, &data);
+        LandmarkFaces decoded;
+        EXPECT_TRUE(absl::IsDataLoss(decoder.Decode(absl::string_view(data).substr(0, data.size() / 2), &decoded)));
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,116 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to decode face landmarks of the quantized delta codec
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kEncodedTag[]   = "ENCODED";
+        constexpr char kLandmarksTag[] = "LANDMARKS";
+    } // namespace
+
+    /**
+     * @brief Decode the frames of LandmarkDeltaEncoderCalculator
+     *
+     * Frames that cannot be decoded, i.e. before the first keyframe or
+     * after a lost or corrupted frame, are skipped until the next keyframe.
+     *
+     * INPUTS:
+     *      ENCODED - Encoded frame (std::string)
+     * OUTPUTS:
+     *      LANDMARKS - Landmarks of each face (std::vector<NormalizedLandmarkList>)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "LandmarkDeltaDecoderCalculator"
+     *   input_stream: "ENCODED:encoded_face_landmarks"
+     *   output_stream: "LANDMARKS:multi_face_landmarks"
+     * }
+     *
+     */
+    class LandmarkDeltaDecoderCalculator: public CalculatorBase
+    {
+    private:
+        LandmarkDecoder m_decoder;
+        int m_skipped = 0;
+
+    public:
+        LandmarkDeltaDecoderCalculator() = default;
+        ~LandmarkDeltaDecoderCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override { return absl::OkStatus(); }
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(LandmarkDeltaDecoderCalculator);
+
+    absl::Status LandmarkDeltaDecoderCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kEncodedTag).Set<std::string>();
+        cc->Outputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmarkList>>();
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkDeltaDecoderCalculator::Process(CalculatorContext* cc)
+    {
+        LandmarkFaces faces;
+        const absl::Status status = m_decoder.Decode(cc->Inputs().Tag(kEncodedTag).Get<std::string>(), &faces);
+        if (!status.ok())
+        {
+            LOG_IF(WARNING, absl::IsDataLoss(status)) << "LandmarkDeltaDecoderCalculator: " << status.message();
+            ++m_skipped;
+            return absl::OkStatus();
+        }
+
+        auto multi_face_landmarks = absl::make_unique<std::vector<NormalizedLandmarkList>>(faces.size());
+        for (size_t face = 0; face < faces.size(); ++face)
+        {
+            auto& landmarks = (*multi_face_landmarks)[face];
+            for (size_t i = 0; i + 2 < faces[face].size(); i += 3)
+            {
+                auto* landmark = landmarks.add_landmark();
+                landmark->set_x(faces[face][i]);
+                landmark->set_y(faces[face][i + 1]);
+                landmark->set_z(faces[face][i + 2]);
+            }
+        }
+        cc->Outputs().Tag(kLandmarksTag).Add(multi_face_landmarks.release(), cc->InputTimestamp());
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status LandmarkDeltaDecoderCalculator::Close(CalculatorContext* cc)
+    {
+        LOG_IF(INFO, m_skipped > 0) << "LandmarkDeltaDecoderCalculator: skipped " << m_skipped << " frames";
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
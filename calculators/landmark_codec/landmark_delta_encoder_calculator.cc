@@ -0,0 +1,124 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to encode face landmarks with the quantized delta codec
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+#include "mp_proctor/calculators/landmark_codec/landmark_delta_encoder_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kLandmarksTag[] = "LANDMARKS";
+        constexpr char kEncodedTag[]   = "ENCODED";
+    } // namespace
+
+    /**
+     * @brief Encode the landmarks of each frame into a few bytes per landmark
+     *        (see landmark_codec.h), decoded by LandmarkDeltaDecoderCalculator
+     *
+     * Only x, y and z are kept. Frames must be decoded in order, starting
+     * from a keyframe.
+     *
+     * INPUTS:
+     *      LANDMARKS - Landmarks of each face (std::vector<NormalizedLandmarkList>)
+     * OUTPUTS:
+     *      ENCODED - Encoded frame (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "LandmarkDeltaEncoderCalculator"
+     *   input_stream: "LANDMARKS:multi_face_landmarks"
+     *   output_stream: "ENCODED:encoded_face_landmarks"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.LandmarkDeltaEncoderCalculatorOptions] {
+     *       max_error: 0.001
+     *     }
+     *   }
+     * }
+     *
+     */
+    class LandmarkDeltaEncoderCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<LandmarkEncoder> m_encoder;
+
+    public:
+        LandmarkDeltaEncoderCalculator() = default;
+        ~LandmarkDeltaEncoderCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override { return absl::OkStatus(); }
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(LandmarkDeltaEncoderCalculator);
+
+    absl::Status LandmarkDeltaEncoderCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmarkList>>();
+        cc->Outputs().Tag(kEncodedTag).Set<std::string>();
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkDeltaEncoderCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<LandmarkDeltaEncoderCalculatorOptions>();
+        if (options.max_error() <= 0 || options.keyframe_interval() <= 0)
+        {
+            return absl::InvalidArgumentError("LandmarkDeltaEncoderCalculator: max_error and keyframe_interval must be positive!");
+        }
+        LandmarkCodecOptions codec_options;
+        codec_options.max_error = options.max_error();
+        codec_options.keyframe_interval = options.keyframe_interval();
+        m_encoder = absl::make_unique<LandmarkEncoder>(codec_options);
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkDeltaEncoderCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& multi_face_landmarks = cc->Inputs().Tag(kLandmarksTag).Get<std::vector<NormalizedLandmarkList>>();
+        LandmarkFaces faces(multi_face_landmarks.size());
+        for (size_t face = 0; face < faces.size(); ++face)
+        {
+            const auto& landmarks = multi_face_landmarks[face];
+            faces[face].reserve(landmarks.landmark_size() * 3);
+            for (const auto& landmark: landmarks.landmark())
+            {
+                faces[face].push_back(landmark.x());
+                faces[face].push_back(landmark.y());
+                faces[face].push_back(landmark.z());
+            }
+        }
+
+        auto encoded = absl::make_unique<std::string>();
+        m_encoder->Encode(faces, encoded.get());
+        cc->Outputs().Tag(kEncodedTag).Add(encoded.release(), cc->InputTimestamp());
+        return absl::OkStatus();
+    } // Process()
+
+} // namespace mediapipe
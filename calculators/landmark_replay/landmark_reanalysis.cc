@@ -0,0 +1,233 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Parallel re-analysis of recorded face landmarks
+#include "mp_proctor/calculators/landmark_replay/landmark_reanalysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        struct Chunk
+        {
+            // Frames decoded from warmup, reported from begin to end
+            size_t warmup;
+            size_t begin;
+            size_t end;
+
+            std::vector<std::pair<int64_t, std::vector<ProctorResult>>> results;
+            LandmarkReanalysisStats stats;
+            bool finished = false;
+        };
+
+        // Previous frame of a face index
+        struct FaceTrack
+        {
+            FaceCoordinates landmarks;
+            FaceCoordinates std_landmarks;
+            // std_landmarks are not computed yet, e.g. during warmup
+            bool std_pending = false;
+        };
+
+        void AnalyzeFace(const FaceCoordinates& landmarks, FaceTrack* track, ProctorResult* result)
+        {
+            FaceCoordinates std_landmarks;
+            StandardizeLandmarks(landmarks, &std_landmarks);
+            if (track->std_pending)
+            {
+                StandardizeLandmarks(track->landmarks, &track->std_landmarks);
+                track->std_pending = false;
+            }
+
+            std::memset(result, 0, sizeof(*result));
+            const EyeBlinkMetrics blink = ComputeEyeBlink(std_landmarks);
+            result->is_left_eye_blinking = blink.left < blink.threshold;
+            result->is_right_eye_blinking = blink.right < blink.threshold;
+            const FaceOrientationMetrics orientation = ComputeFaceOrientation(std_landmarks);
+            result->horizontal_align = orientation.horizontal_align;
+            result->vertical_align = orientation.vertical_align;
+            result->facial_activity = ComputeFacialActivity(track->std_landmarks, std_landmarks);
+            result->face_movement = ComputeFaceMovement(track->landmarks, landmarks);
+            result->present_fields = PROCTOR_FIELD_BLINK | PROCTOR_FIELD_ORIENTATION |
+                PROCTOR_FIELD_ACTIVITY | PROCTOR_FIELD_MOVEMENT;
+
+            track->landmarks = landmarks;
+            track->std_landmarks = std::move(std_landmarks);
+        }
+
+        void AnalyzeChunk(const LandmarkRecordingReader& reader, Chunk* chunk)
+        {
+            const auto& frames = reader.frames();
+            LandmarkDecoder decoder;
+            LandmarkFaces faces;
+            std::vector<FaceTrack> tracks;
+            for (size_t frame = chunk->warmup; frame < chunk->end; ++frame)
+            {
+                if (!decoder.Decode(reader.FrameData(frame), &faces).ok())
+                {
+                    if (frame >= chunk->begin) { ++chunk->stats.skipped_frames; }
+                    continue;
+                }
+                if (tracks.size() < faces.size()) { tracks.resize(faces.size()); }
+
+                if (frame < chunk->begin)
+                {
+                    ++chunk->stats.warmup_frames;
+                    // Only the last frame of a face before begin is needed
+                    for (size_t face = 0; face < faces.size(); ++face)
+                    {
+                        tracks[face].landmarks.swap(faces[face]);
+                        tracks[face].std_pending = true;
+                    }
+                    continue;
+                }
+
+                ++chunk->stats.frames;
+                if (faces.empty()) { continue; }
+                std::vector<ProctorResult> results(faces.size());
+                for (size_t face = 0; face < faces.size(); ++face)
+                {
+                    AnalyzeFace(faces[face], &tracks[face], &results[face]);
+                }
+                chunk->stats.faces += faces.size();
+                chunk->results.emplace_back(frames[frame].timestamp_us, std::move(results));
+            }
+        }
+
+        /**
+         * @brief Split the reported frames into chunks, each starting its
+         *        warmup early enough for every face it reports to have its
+         *        previous frame
+         */
+        std::vector<Chunk> SplitIntoChunks(
+            const LandmarkRecordingReader& reader, size_t begin, size_t end, size_t frames_per_chunk
+        )
+        {
+            const auto& frames = reader.frames();
+            // Last frame of each face index, -1 if the face was not seen yet
+            std::vector<int64_t> last_seen;
+            for (size_t frame = 0; frame < begin; ++frame)
+            {
+                const size_t faces = frames[frame].face_count;
+                if (last_seen.size() < faces) { last_seen.resize(faces, -1); }
+                std::fill(last_seen.begin(), last_seen.begin() + faces, frame);
+            }
+
+            std::vector<Chunk> chunks;
+            for (size_t chunk_begin = begin; chunk_begin < end; chunk_begin += frames_per_chunk)
+            {
+                Chunk chunk;
+                chunk.begin = chunk_begin;
+                chunk.end = std::min(end, chunk_begin + frames_per_chunk);
+                chunk.warmup = reader.KeyframeAtOrBefore(chunk.begin);
+
+                size_t faces = 0;
+                for (size_t frame = chunk.begin; frame < chunk.end; ++frame)
+                {
+                    faces = std::max<size_t>(faces, frames[frame].face_count);
+                }
+                for (size_t face = 0; face < std::min(faces, last_seen.size()); ++face)
+                {
+                    if (last_seen[face] < 0) { continue; }
+                    chunk.warmup = std::min(chunk.warmup, reader.KeyframeAtOrBefore(last_seen[face]));
+                }
+
+                for (size_t frame = chunk.begin; frame < chunk.end; ++frame)
+                {
+                    const size_t frame_faces = frames[frame].face_count;
+                    if (last_seen.size() < frame_faces) { last_seen.resize(frame_faces, -1); }
+                    std::fill(last_seen.begin(), last_seen.begin() + frame_faces, frame);
+                }
+                chunks.push_back(std::move(chunk));
+            }
+            return chunks;
+        }
+    } // namespace
+
+    absl::StatusOr<LandmarkReanalysisStats> ReanalyzeLandmarkRecording(
+        const LandmarkRecordingReader& reader,
+        const LandmarkReanalysisOptions& options,
+        LandmarkResultsCallback on_results
+    )
+    {
+        if (options.workers <= 0 || options.frames_per_chunk <= 0)
+        {
+            return absl::InvalidArgumentError("workers and frames_per_chunk must be positive");
+        }
+        const auto& frames = reader.frames();
+        const auto before = [&frames](int64_t timestamp_us)
+        {
+            return std::lower_bound(
+                frames.begin(), frames.end(), timestamp_us,
+                [](const LandmarkRecordingFrame& frame, int64_t t) { return frame.timestamp_us < t; }
+            ) - frames.begin();
+        };
+        const size_t begin = before(options.start_us);
+        const size_t end = options.end_us < 0 ? frames.size(): before(options.end_us);
+
+        const absl::Time start = absl::Now();
+        std::vector<Chunk> chunks = SplitIntoChunks(reader, begin, end, options.frames_per_chunk);
+
+        // Chunks are reported in order as soon as they and their predecessors
+        // are finished
+        absl::Mutex mutex;
+        size_t next_report = 0;
+        LandmarkReanalysisStats stats;
+        std::atomic<size_t> next_chunk(0);
+
+        std::vector<std::thread> workers;
+        const int worker_count = std::max(1, std::min<int>(options.workers, chunks.size()));
+        for (int i = 0; i < worker_count; ++i)
+        {
+            workers.emplace_back([&]()
+            {
+                for (size_t chunk = next_chunk++; chunk < chunks.size(); chunk = next_chunk++)
+                {
+                    AnalyzeChunk(reader, &chunks[chunk]);
+
+                    absl::MutexLock lock(&mutex);
+                    chunks[chunk].finished = true;
+                    for (; next_report < chunks.size() && chunks[next_report].finished; ++next_report)
+                    {
+                        Chunk& current = chunks[next_report];
+                        for (const auto& entry: current.results) { on_results(entry.first, entry.second); }
+                        current.results.clear();
+                        current.results.shrink_to_fit();
+                        stats.frames += current.stats.frames;
+                        stats.warmup_frames += current.stats.warmup_frames;
+                        stats.faces += current.stats.faces;
+                        stats.skipped_frames += current.stats.skipped_frames;
+                    }
+                }
+            });
+        }
+        for (auto& worker: workers) { worker.join(); }
+
+        stats.seconds = absl::ToDoubleSeconds(absl::Now() - start);
+        return stats;
+    }
+
+} // namespace mediapipe
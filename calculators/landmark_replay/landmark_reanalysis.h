@@ -0,0 +1,88 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Parallel re-analysis of recorded face landmarks
+#ifndef landmark_reanalysis_h
+#define landmark_reanalysis_h
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_recording.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of ReanalyzeLandmarkRecording()
+     */
+    struct LandmarkReanalysisOptions
+    {
+        // Threads analyzing chunks in parallel
+        int workers = 2;
+        // Frames of a chunk, more chunks than workers balance the load
+        int frames_per_chunk = 9000;
+
+        // Time range to report results for, end_us < 0 for the whole recording
+        int64_t start_us = 0;
+        int64_t end_us = -1;
+    };
+
+    /**
+     * @brief Outcome of ReanalyzeLandmarkRecording()
+     */
+    struct LandmarkReanalysisStats
+    {
+        // Frames reported, without the warmup frames
+        int64_t frames = 0;
+        int64_t warmup_frames = 0;
+        int64_t faces = 0;
+        // Frames that could not be decoded
+        int64_t skipped_frames = 0;
+        double seconds = 0;
+
+        double fps() const { return seconds > 0 ? frames / seconds: 0; }
+    };
+
+    // Called in timestamp order with the results of each frame with faces
+    using LandmarkResultsCallback =
+        std::function<void(int64_t timestamp_us, const std::vector<ProctorResult>& results)>;
+
+    /**
+     * @brief Recompute the landmark based results of a recording (blink,
+     *        orientation, activity and movement) without a graph
+     *
+     * The frames are split into chunks analyzed by parallel workers. The
+     * stateless metrics only need the frame itself. The stateful ones,
+     * activity and movement, compare a face with its previous frame, so they
+     * are tracked per face index: a chunk starts decoding at the keyframe
+     * before the last earlier frame of each of its faces, and discards the
+     * results of those warmup frames. The results are the same as those of
+     * a single pass, and the same as proctor_cpu.pbtxt for a single face;
+     * with several faces, the graph compares each face with the previous
+     * face in the loop instead. on_results is called from the worker
+     * threads, one call at a time and in timestamp order.
+     */
+    absl::StatusOr<LandmarkReanalysisStats> ReanalyzeLandmarkRecording(
+        const LandmarkRecordingReader& reader,
+        const LandmarkReanalysisOptions& options,
+        LandmarkResultsCallback on_results
+    );
+
+} // namespace mediapipe
+
+#endif
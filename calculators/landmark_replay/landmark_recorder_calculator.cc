@@ -0,0 +1,141 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to record face landmarks for replay
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_recorder_calculator.pb.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_recording.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kLandmarksTag[]  = "LANDMARKS";
+        constexpr char kTickTag[]       = "TICK";
+        constexpr char kOutputPathTag[] = "OUTPUT_PATH";
+    } // namespace
+
+    /**
+     * @brief Record the landmarks of each frame with their timestamps (see
+     *        landmark_recording.h), replayed by LandmarkReplayCalculator
+     *
+     * Only x, y and z are kept, quantized within max_error.
+     *
+     * INPUTS:
+     *      LANDMARKS - Landmarks of each face (std::vector<NormalizedLandmarkList>)
+     *      TICK - Optional clock of the analyzed frames (Any); a tick without
+     *             landmarks is recorded as a frame without faces
+     * INPUT SIDE PACKETS:
+     *      OUTPUT_PATH - Optional path of the recording, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "LandmarkRecorderCalculator"
+     *   input_stream: "LANDMARKS:multi_face_landmarks"
+     *   input_stream: "TICK:throttled_input_video"
+     *   input_side_packet: "OUTPUT_PATH:landmark_recording_path"
+     * }
+     *
+     */
+    class LandmarkRecorderCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<LandmarkRecordingWriter> m_writer;
+        LandmarkFaces m_faces;
+
+    public:
+        LandmarkRecorderCalculator() = default;
+        ~LandmarkRecorderCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(LandmarkRecorderCalculator);
+
+    absl::Status LandmarkRecorderCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmarkList>>();
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            cc->Inputs().Tag(kTickTag).SetAny();
+        }
+        if (cc->InputSidePackets().HasTag(kOutputPathTag))
+        {
+            cc->InputSidePackets().Tag(kOutputPathTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkRecorderCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<LandmarkRecorderCalculatorOptions>();
+        if (options.max_error() <= 0 || options.keyframe_interval() <= 0)
+        {
+            return absl::InvalidArgumentError("LandmarkRecorderCalculator: max_error and keyframe_interval must be positive!");
+        }
+        std::string path = options.output_path();
+        if (cc->InputSidePackets().HasTag(kOutputPathTag) &&
+            !cc->InputSidePackets().Tag(kOutputPathTag).IsEmpty())
+        {
+            path = cc->InputSidePackets().Tag(kOutputPathTag).Get<std::string>();
+        }
+        if (path.empty())
+        {
+            return absl::InvalidArgumentError("LandmarkRecorderCalculator: no output path!");
+        }
+
+        LandmarkCodecOptions codec_options;
+        codec_options.max_error = options.max_error();
+        codec_options.keyframe_interval = options.keyframe_interval();
+        ASSIGN_OR_RETURN(m_writer, LandmarkRecordingWriter::Open(path, codec_options));
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkRecorderCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& landmarks_stream = cc->Inputs().Tag(kLandmarksTag);
+        if (landmarks_stream.IsEmpty())
+        {
+            m_faces.clear();
+        }
+        else
+        {
+            const auto& multi_face_landmarks = landmarks_stream.Get<std::vector<NormalizedLandmarkList>>();
+            m_faces.resize(multi_face_landmarks.size());
+            for (size_t face = 0; face < m_faces.size(); ++face)
+            {
+                LandmarksToCoordinates(multi_face_landmarks[face], &m_faces[face]);
+            }
+        }
+        return m_writer->Write(cc->InputTimestamp().Value(), m_faces);
+    } // Process()
+
+    absl::Status LandmarkRecorderCalculator::Close(CalculatorContext* cc)
+    { return m_writer ? m_writer->Close(): absl::OkStatus(); }
+
+} // namespace mediapipe
@@ -0,0 +1,170 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File of recorded face landmarks
+#include "mp_proctor/calculators/landmark_replay/landmark_recording.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+
+namespace mediapipe
+{
+
+    LandmarkRecordingWriter::LandmarkRecordingWriter(const LandmarkCodecOptions& options)
+        : m_encoder(options)
+    {}
+
+    LandmarkRecordingWriter::~LandmarkRecordingWriter()
+    { this->Close().IgnoreError(); }
+
+    absl::StatusOr<std::unique_ptr<LandmarkRecordingWriter>> LandmarkRecordingWriter::Open(
+        const std::string& path, const LandmarkCodecOptions& options
+    )
+    {
+        if (options.max_error <= 0 || options.keyframe_interval <= 0)
+        {
+            return absl::InvalidArgumentError("Invalid landmark codec options");
+        }
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) { return absl::NotFoundError("Could not create " + path); }
+
+        std::unique_ptr<LandmarkRecordingWriter> writer(new LandmarkRecordingWriter(options));
+        writer->m_file = file;
+        std::string header;
+        PutFixed(kLandmarkRecordingMagic, &header);
+        PutFixed(kLandmarkRecordingVersion, &header);
+        PutFixed(uint16_t{0}, &header);
+        PutFixed(static_cast<float>(options.max_error), &header);
+        PutFixed(static_cast<uint32_t>(options.keyframe_interval), &header);
+        if (std::fwrite(header.data(), 1, header.size(), file) != header.size())
+        {
+            return absl::InternalError("Failed to write the landmark recording");
+        }
+        return writer;
+    }
+
+    absl::Status LandmarkRecordingWriter::Write(int64_t timestamp_us, const LandmarkFaces& faces)
+    {
+        RET_CHECK(m_file != nullptr) << "The recording is closed";
+        m_encoder.Encode(faces, &m_frame);
+        m_record.clear();
+        PutVarint(ZigZagEncode(timestamp_us - m_last_timestamp_us), &m_record);
+        PutVarint(m_frame.size(), &m_record);
+        m_record.append(m_frame);
+        m_last_timestamp_us = timestamp_us;
+        if (std::fwrite(m_record.data(), 1, m_record.size(), m_file) != m_record.size())
+        {
+            return absl::InternalError("Failed to write the landmark recording");
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkRecordingWriter::Close()
+    {
+        if (m_file == nullptr) { return absl::OkStatus(); }
+        const bool failed = std::fclose(m_file) != 0;
+        m_file = nullptr;
+        return failed ? absl::InternalError("Failed to write the landmark recording"): absl::OkStatus();
+    }
+
+    LandmarkRecordingReader::~LandmarkRecordingReader()
+    {
+        if (m_data != nullptr) { munmap(const_cast<uint8_t*>(m_data), m_size); }
+    }
+
+    absl::StatusOr<std::unique_ptr<LandmarkRecordingReader>> LandmarkRecordingReader::Open(const std::string& path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return absl::NotFoundError("Could not open " + path); }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kLandmarkRecordingHeaderBytes)
+        {
+            close(fd);
+            return absl::DataLossError(path + " is not a landmark recording");
+        }
+
+        std::unique_ptr<LandmarkRecordingReader> reader(new LandmarkRecordingReader());
+        reader->m_size = info.st_size;
+        void* data = mmap(nullptr, reader->m_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) { return absl::InternalError("Could not map " + path); }
+        reader->m_data = static_cast<const uint8_t*>(data);
+
+        if (GetFixed<uint32_t>(reader->m_data) != kLandmarkRecordingMagic)
+        {
+            return absl::DataLossError(path + " is not a landmark recording");
+        }
+        if (GetFixed<uint16_t>(reader->m_data + 4) != kLandmarkRecordingVersion)
+        {
+            return absl::FailedPreconditionError("Unsupported landmark recording version");
+        }
+        reader->m_options.max_error = GetFixed<float>(reader->m_data + 8);
+        reader->m_options.keyframe_interval = GetFixed<uint32_t>(reader->m_data + 12);
+        reader->IndexFrames();
+        return reader;
+    }
+
+    void LandmarkRecordingReader::IndexFrames()
+    {
+        const uint8_t* cursor = m_data + kLandmarkRecordingHeaderBytes;
+        const uint8_t* const end = m_data + m_size;
+        int64_t timestamp_us = 0;
+        while (cursor < end)
+        {
+            uint64_t delta, size;
+            if (!GetVarint(&cursor, end, &delta) || !GetVarint(&cursor, end, &size) ||
+                size == 0 || size > static_cast<uint64_t>(end - cursor))
+            {
+                break;
+            }
+
+            // Frame header: flags, sequence and face count
+            const uint8_t* frame = cursor;
+            const uint8_t* frame_end = cursor + size;
+            const uint8_t flags = *frame++;
+            uint64_t sequence, face_count;
+            if (!GetVarint(&frame, frame_end, &sequence) || !GetVarint(&frame, frame_end, &face_count))
+            {
+                break;
+            }
+
+            timestamp_us += ZigZagDecode(delta);
+            LandmarkRecordingFrame info;
+            info.timestamp_us = timestamp_us;
+            info.offset = cursor - m_data;
+            info.size = static_cast<uint32_t>(size);
+            info.face_count = static_cast<int>(face_count);
+            info.keyframe = (flags & kLandmarkKeyframe) != 0;
+            m_frames.push_back(info);
+            cursor = frame_end;
+        }
+    }
+
+    absl::string_view LandmarkRecordingReader::FrameData(size_t frame) const
+    {
+        const LandmarkRecordingFrame& info = m_frames[frame];
+        return absl::string_view(reinterpret_cast<const char*>(m_data + info.offset), info.size);
+    }
+
+    size_t LandmarkRecordingReader::KeyframeAtOrBefore(size_t frame) const
+    {
+        while (frame > 0 && !m_frames[frame].keyframe) { --frame; }
+        return frame;
+    }
+
+} // namespace mediapipe
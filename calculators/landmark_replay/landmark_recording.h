@@ -0,0 +1,137 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// File of recorded face landmarks
+#ifndef landmark_recording_h
+#define landmark_recording_h
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+
+/**
+ * A recording starts with a 16 bytes header
+ *
+ *      uint32 magic                "MPLR"
+ *      uint16 version
+ *      uint16 reserved
+ *      float  max_error            Codec options of the frames
+ *      uint32 keyframe_interval
+ *
+ * followed by a record per frame, frames without faces included
+ *
+ *      varint timestamp_delta      zigzag microseconds since the previous
+ *                                  frame, or since 0 for the first one
+ *      varint size
+ *      bytes  frame                Frame of a LandmarkEncoder
+ *
+ * A recording that was not closed is read up to its last complete record.
+ */
+
+namespace mediapipe
+{
+    constexpr uint32_t kLandmarkRecordingMagic   = 0x524c504d; // "MPLR"
+    constexpr uint16_t kLandmarkRecordingVersion = 1;
+    constexpr size_t kLandmarkRecordingHeaderBytes = 16;
+
+    /**
+     * @brief Writes the landmarks of each frame to a recording
+     */
+    class LandmarkRecordingWriter
+    {
+    private:
+        FILE* m_file = nullptr;
+        LandmarkEncoder m_encoder;
+        int64_t m_last_timestamp_us = 0;
+        std::string m_frame;
+        std::string m_record;
+
+        explicit LandmarkRecordingWriter(const LandmarkCodecOptions& options);
+
+    public:
+        ~LandmarkRecordingWriter();
+
+        LandmarkRecordingWriter(const LandmarkRecordingWriter&) = delete;
+        LandmarkRecordingWriter& operator=(const LandmarkRecordingWriter&) = delete;
+
+        // Create the recording, replacing any existing file
+        static absl::StatusOr<std::unique_ptr<LandmarkRecordingWriter>> Open(
+            const std::string& path, const LandmarkCodecOptions& options
+        );
+
+        // Append a frame, empty for a frame without faces
+        absl::Status Write(int64_t timestamp_us, const LandmarkFaces& faces);
+        absl::Status Close();
+    };
+
+    /**
+     * @brief Record of a frame in a recording
+     */
+    struct LandmarkRecordingFrame
+    {
+        int64_t timestamp_us;
+        // Offset and size of the encoded frame in the file
+        uint64_t offset;
+        uint32_t size;
+        int face_count;
+        // Decoding can start at this frame
+        bool keyframe;
+    };
+
+    /**
+     * @brief Memory mapped recording, with the frames indexed on Open
+     *
+     * The frames can be decoded concurrently, each thread with its own
+     * LandmarkDecoder starting at a keyframe.
+     */
+    class LandmarkRecordingReader
+    {
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        LandmarkCodecOptions m_options;
+        std::vector<LandmarkRecordingFrame> m_frames;
+
+        LandmarkRecordingReader() = default;
+
+        void IndexFrames();
+
+    public:
+        ~LandmarkRecordingReader();
+
+        LandmarkRecordingReader(const LandmarkRecordingReader&) = delete;
+        LandmarkRecordingReader& operator=(const LandmarkRecordingReader&) = delete;
+
+        static absl::StatusOr<std::unique_ptr<LandmarkRecordingReader>> Open(const std::string& path);
+
+        const LandmarkCodecOptions& options() const { return m_options; }
+        // Frames in timestamp order
+        const std::vector<LandmarkRecordingFrame>& frames() const { return m_frames; }
+
+        // Encoded frame, for LandmarkDecoder::Decode()
+        absl::string_view FrameData(size_t frame) const;
+        // Last keyframe at or before frame, 0 if there is none
+        size_t KeyframeAtOrBefore(size_t frame) const;
+    };
+
+} // namespace mediapipe
+
+#endif
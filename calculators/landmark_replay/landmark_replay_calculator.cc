@@ -0,0 +1,170 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Source calculator replaying recorded face landmarks
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/tool/status_util.h"
+#include "mp_proctor/calculators/landmark_codec/landmark_codec.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_recording.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_replay_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kLandmarksTag[] = "LANDMARKS";
+        constexpr char kTickTag[]      = "TICK";
+        constexpr char kInputPathTag[] = "INPUT_PATH";
+    } // namespace
+
+    /**
+     * @brief Replay a recording of LandmarkRecorderCalculator at the recorded
+     *        timestamps, as fast as the graph consumes them
+     *
+     * Feeds the analytics half of the graph in place of FaceLandmarkFrontCpu
+     * (see graphs/landmark_replay.pbtxt). Frames that cannot be decoded are
+     * skipped until the next keyframe. The graph is stopped after the last
+     * frame.
+     *
+     * INPUT SIDE PACKETS:
+     *      INPUT_PATH - Optional path of the recording, overriding the options (std::string)
+     * OUTPUTS:
+     *      LANDMARKS - Landmarks of each face, for frames with faces (std::vector<NormalizedLandmarkList>)
+     *      TICK - Optional number of faces of every frame (int)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "LandmarkReplayCalculator"
+     *   input_side_packet: "INPUT_PATH:landmark_recording_path"
+     *   output_stream: "LANDMARKS:multi_face_landmarks"
+     *   output_stream: "TICK:frame_tick"
+     * }
+     *
+     */
+    class LandmarkReplayCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<LandmarkRecordingReader> m_reader;
+        LandmarkDecoder m_decoder;
+        LandmarkFaces m_faces;
+        size_t m_next_frame = 0;
+        int m_frames_per_process = 1;
+        int64_t m_skipped_frames = 0;
+
+    public:
+        LandmarkReplayCalculator() = default;
+        ~LandmarkReplayCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(LandmarkReplayCalculator);
+
+    absl::Status LandmarkReplayCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Outputs().Tag(kLandmarksTag).Set<std::vector<NormalizedLandmarkList>>();
+        if (cc->Outputs().HasTag(kTickTag))
+        {
+            cc->Outputs().Tag(kTickTag).Set<int>();
+        }
+        if (cc->InputSidePackets().HasTag(kInputPathTag))
+        {
+            cc->InputSidePackets().Tag(kInputPathTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkReplayCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<LandmarkReplayCalculatorOptions>();
+        std::string path = options.input_path();
+        if (cc->InputSidePackets().HasTag(kInputPathTag) &&
+            !cc->InputSidePackets().Tag(kInputPathTag).IsEmpty())
+        {
+            path = cc->InputSidePackets().Tag(kInputPathTag).Get<std::string>();
+        }
+        if (path.empty())
+        {
+            return absl::InvalidArgumentError("LandmarkReplayCalculator: no input path!");
+        }
+        ASSIGN_OR_RETURN(m_reader, LandmarkRecordingReader::Open(path));
+        m_frames_per_process = std::max(options.frames_per_process(), 1);
+        return absl::OkStatus();
+    }
+
+    absl::Status LandmarkReplayCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& frames = m_reader->frames();
+        for (int i = 0; i < m_frames_per_process && m_next_frame < frames.size(); ++i, ++m_next_frame)
+        {
+            const Timestamp timestamp(frames[m_next_frame].timestamp_us);
+            const absl::Status status = m_decoder.Decode(m_reader->FrameData(m_next_frame), &m_faces);
+            if (!status.ok())
+            {
+                ++m_skipped_frames;
+                continue;
+            }
+
+            if (cc->Outputs().HasTag(kTickTag))
+            {
+                cc->Outputs().Tag(kTickTag).AddPacket(
+                    MakePacket<int>(static_cast<int>(m_faces.size())).At(timestamp)
+                );
+            }
+            if (m_faces.empty()) { continue; }
+
+            auto multi_face_landmarks = absl::make_unique<std::vector<NormalizedLandmarkList>>(m_faces.size());
+            for (size_t face = 0; face < m_faces.size(); ++face)
+            {
+                const std::vector<float>& coordinates = m_faces[face];
+                NormalizedLandmarkList& landmarks = (*multi_face_landmarks)[face];
+                for (size_t j = 0; j + 2 < coordinates.size(); j += 3)
+                {
+                    NormalizedLandmark* landmark = landmarks.add_landmark();
+                    landmark->set_x(coordinates[j]);
+                    landmark->set_y(coordinates[j + 1]);
+                    landmark->set_z(coordinates[j + 2]);
+                }
+            }
+            cc->Outputs().Tag(kLandmarksTag).Add(multi_face_landmarks.release(), timestamp);
+        }
+
+        if (m_next_frame >= frames.size()) { return tool::StatusStop(); }
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status LandmarkReplayCalculator::Close(CalculatorContext* cc)
+    {
+        LOG_IF(WARNING, m_skipped_frames > 0) << "LandmarkReplayCalculator: skipped "
+            << m_skipped_frames << " frames that could not be decoded";
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
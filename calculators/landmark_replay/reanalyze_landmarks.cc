@@ -0,0 +1,189 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Recomputes the proctoring results of a landmark recording, either with
+// the built-in metrics on all cores, or through a replay graph such as
+// graphs/landmark_replay.pbtxt to evaluate new calculators.
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_reanalysis.h"
+#include "mp_proctor/calculators/landmark_replay/landmark_recording.h"
+#include "mp_proctor/calculators/session_log/session_log_writer.h"
+#include "mp_proctor/offline_processor.h"
+
+constexpr char kRecordingPathSidePacket[] = "landmark_recording_path";
+constexpr char kResultsStream[] = "multi_face_proctor_results";
+
+ABSL_FLAG(std::string, recording_path, "",
+          "Landmark recording of LandmarkRecorderCalculator.");
+ABSL_FLAG(std::string, results_path, "",
+          "Write the results to this CSV file.");
+ABSL_FLAG(std::string, session_log_path, "",
+          "Write the results to this session log.");
+ABSL_FLAG(std::string, calculator_graph_config_file, "",
+          "Replay through this graph instead of the built-in metrics. The "
+          "graph gets the recording as the landmark_recording_path side "
+          "packet and must output multi_face_proctor_results.");
+ABSL_FLAG(int, workers, std::thread::hardware_concurrency(),
+          "Threads of the built-in metrics.");
+ABSL_FLAG(int, frames_per_chunk, 9000,
+          "Frames analyzed by a thread at a time.");
+ABSL_FLAG(double, start_seconds, 0,
+          "Only report the results from this recording timestamp.");
+ABSL_FLAG(double, end_seconds, -1,
+          "Only report the results before this recording timestamp, -1 for "
+          "the whole recording.");
+
+namespace {
+
+// Writes the results to the requested outputs.
+class ResultsOutput {
+ public:
+  absl::Status Open() {
+    const std::string results_path = absl::GetFlag(FLAGS_results_path);
+    if (!results_path.empty()) {
+      MP_RETURN_IF_ERROR(csv_writer_.Open(results_path));
+    }
+    const std::string session_log_path = absl::GetFlag(FLAGS_session_log_path);
+    if (!session_log_path.empty()) {
+      ASSIGN_OR_RETURN(session_log_,
+                       mediapipe::SessionLogWriter::Open(
+                           session_log_path, mediapipe::SessionLogWriterOptions()));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Write(int64_t timestamp_us,
+                     const std::vector<ProctorResult>& results) {
+    csv_writer_.Write(mediapipe::Timestamp(timestamp_us), results);
+    if (session_log_) {
+      return session_log_->Append(timestamp_us, results);
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status Close() {
+    MP_RETURN_IF_ERROR(csv_writer_.Close());
+    return session_log_ ? session_log_->Close() : absl::OkStatus();
+  }
+
+ private:
+  mediapipe::ProctorResultCsvWriter csv_writer_;
+  std::unique_ptr<mediapipe::SessionLogWriter> session_log_;
+};
+
+absl::Status ReplayThroughGraph(ResultsOutput* output) {
+  std::string contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file), &contents));
+  mediapipe::CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+          contents)));
+
+  const int64_t start_us =
+      static_cast<int64_t>(absl::GetFlag(FLAGS_start_seconds) * 1e6);
+  const int64_t end_us =
+      absl::GetFlag(FLAGS_end_seconds) < 0
+          ? INT64_MAX
+          : static_cast<int64_t>(absl::GetFlag(FLAGS_end_seconds) * 1e6);
+  int64_t frames = 0;
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+      kResultsStream, [&](const mediapipe::Packet& packet) {
+        const int64_t timestamp_us = packet.Timestamp().Value();
+        if (timestamp_us < start_us || timestamp_us >= end_us) {
+          return absl::OkStatus();
+        }
+        ++frames;
+        return output->Write(timestamp_us,
+                             packet.Get<std::vector<ProctorResult>>());
+      }));
+
+  const absl::Time start = absl::Now();
+  MP_RETURN_IF_ERROR(graph.StartRun(
+      {{kRecordingPathSidePacket,
+        mediapipe::MakePacket<std::string>(
+            absl::GetFlag(FLAGS_recording_path))}}));
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+  const double seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  LOG(INFO) << "Replayed " << frames << " frames with faces in " << seconds
+            << " s.";
+  return absl::OkStatus();
+}
+
+absl::Status Reanalyze(ResultsOutput* output) {
+  ASSIGN_OR_RETURN(auto reader, mediapipe::LandmarkRecordingReader::Open(
+                                    absl::GetFlag(FLAGS_recording_path)));
+  mediapipe::LandmarkReanalysisOptions options;
+  options.workers = absl::GetFlag(FLAGS_workers);
+  options.frames_per_chunk = absl::GetFlag(FLAGS_frames_per_chunk);
+  options.start_us =
+      static_cast<int64_t>(absl::GetFlag(FLAGS_start_seconds) * 1e6);
+  options.end_us =
+      static_cast<int64_t>(absl::GetFlag(FLAGS_end_seconds) * 1e6);
+
+  absl::Status write_status;
+  ASSIGN_OR_RETURN(
+      auto stats,
+      mediapipe::ReanalyzeLandmarkRecording(
+          *reader, options,
+          [&](int64_t timestamp_us, const std::vector<ProctorResult>& results) {
+            write_status.Update(output->Write(timestamp_us, results));
+          }));
+  MP_RETURN_IF_ERROR(write_status);
+  LOG(INFO) << "Analyzed " << stats.frames << " frames (" << stats.faces
+            << " faces, " << stats.warmup_frames << " warmup frames, "
+            << stats.skipped_frames << " undecodable frames) in "
+            << stats.seconds << " s (" << stats.fps() << " fps).";
+  return absl::OkStatus();
+}
+
+absl::Status Run() {
+  RET_CHECK(!absl::GetFlag(FLAGS_recording_path).empty())
+      << "Missing recording_path.";
+  ResultsOutput output;
+  MP_RETURN_IF_ERROR(output.Open());
+  if (absl::GetFlag(FLAGS_calculator_graph_config_file).empty()) {
+    MP_RETURN_IF_ERROR(Reanalyze(&output));
+  } else {
+    MP_RETURN_IF_ERROR(ReplayThroughGraph(&output));
+  }
+  return output.Close();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  const absl::Status status = Run();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to re-analyze the recording: " << status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
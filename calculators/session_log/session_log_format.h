@@ -0,0 +1,185 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Binary layout of the columnar session log
+#ifndef session_log_format_h
+#define session_log_format_h
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * A session log is a file header followed by blocks of rows, one row per
+ * face and frame, and an index of the blocks once the log is closed. A log
+ * without its index, e.g. after a crash, is read by scanning the blocks.
+ * Integers are little endian.
+ *
+ * File header (16 bytes):
+ *      uint32 magic                kSessionLogMagic
+ *      uint16 version
+ *      uint8  embedding_encoding   SessionLogEmbeddingEncoding
+ *      uint8  top_k_expressions
+ *      uint8  reserved[8]
+ *
+ * Block header (32 bytes), followed by payload_bytes of columns:
+ *      uint32 magic                kSessionLogBlockMagic
+ *      uint32 payload_bytes
+ *      uint32 row_count
+ *      uint32 reserved
+ *      int64  first_timestamp_us
+ *      int64  last_timestamp_us
+ *
+ * Columns of a block, in this order:
+ *      timestamps      varint, zigzag delta from the previous row, starting
+ *                      from first_timestamp_us
+ *      faces           varint, face index within the frame
+ *      present_fields  varint, ProctorResultField flags
+ *      flags           3 bits per row, packed LSB first: is_carried_forward,
+ *                      is_left_eye_blinking, is_right_eye_blinking
+ *      scalars         horizontal_align, vertical_align, facial_activity and
+ *                      face_movement, one column each, in kSessionLogScalarScale
+ *                      units, varint zigzag delta from the previous row
+ *      embeddings      rows with PROCTOR_FIELD_EMBEDDINGS only, int8: a float
+ *                      scale and 128 int8, fp16: 128 halfs
+ *      expressions     rows with PROCTOR_FIELD_EXPRESSIONS only, top_k pairs of
+ *                      uint8 FacialExpressionType and uint8 probability * 255,
+ *                      most probable first
+ *
+ * Index, after the last block:
+ *      repeated { int64 first_timestamp_us, int64 last_timestamp_us,
+ *                 uint64 offset, uint32 row_count, uint32 reserved }
+ *      uint64 index_offset
+ *      uint32 block_count
+ *      uint32 magic                kSessionLogIndexMagic
+ */
+namespace mediapipe
+{
+    constexpr uint32_t kSessionLogMagic      = 0x4c53504d; // "MPSL"
+    constexpr uint32_t kSessionLogBlockMagic = 0x4b4c4253; // "SBLK"
+    constexpr uint32_t kSessionLogIndexMagic = 0x58444953; // "SIDX"
+    constexpr uint16_t kSessionLogVersion    = 1;
+
+    constexpr size_t kSessionLogHeaderBytes      = 16;
+    constexpr size_t kSessionLogBlockHeaderBytes = 32;
+    constexpr size_t kSessionLogIndexEntryBytes  = 32;
+    constexpr size_t kSessionLogTrailerBytes     = 16;
+
+    // Resolution of the scalar columns
+    constexpr double kSessionLogScalarScale = 1e6;
+    constexpr int kSessionLogScalarColumns  = 4;
+    constexpr int kSessionLogFlagBits       = 3;
+    constexpr int kSessionLogEmbeddingSize  = 128;
+    constexpr int kSessionLogExpressionSize = 8;
+
+    enum SessionLogEmbeddingEncoding : uint8_t
+    {
+        kSessionLogNoEmbeddings   = 0,
+        kSessionLogInt8Embeddings = 1,
+        kSessionLogFp16Embeddings = 2
+    };
+
+    struct SessionLogBlockInfo
+    {
+        int64_t first_timestamp_us;
+        int64_t last_timestamp_us;
+        uint64_t offset;
+        uint32_t row_count;
+    };
+
+    inline uint64_t ZigZagEncode(int64_t value)
+    { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+
+    inline int64_t ZigZagDecode(uint64_t value)
+    { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+    inline void PutVarint(uint64_t value, std::string* out)
+    {
+        while (value >= 0x80)
+        {
+            out->push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        out->push_back(static_cast<char>(value));
+    }
+
+    // Returns false if the varint runs past end
+    inline bool GetVarint(const uint8_t** data, const uint8_t* end, uint64_t* value)
+    {
+        *value = 0;
+        for (int shift = 0; shift < 64 && *data < end; shift += 7)
+        {
+            const uint8_t byte = *(*data)++;
+            *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) { return true; }
+        }
+        return false;
+    }
+
+    template<typename T>
+    inline void PutFixed(T value, std::string* out)
+    { out->append(reinterpret_cast<const char*>(&value), sizeof(T)); }
+
+    template<typename T>
+    inline T GetFixed(const uint8_t* data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    // IEEE half precision, rounded to nearest even, small values flushed to 0
+    inline uint16_t FloatToHalf(float value)
+    {
+        const uint32_t bits = GetFixed<uint32_t>(reinterpret_cast<const uint8_t*>(&value));
+        const uint16_t sign = (bits >> 16) & 0x8000;
+        const uint32_t mantissa = bits & 0x7fffff;
+        if (((bits >> 23) & 0xff) == 0xff) { return sign | 0x7c00 | (mantissa ? 0x200: 0); }
+        const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+        if (exponent <= 0) { return sign; }
+        if (exponent >= 31) { return sign | 0x7c00; }
+
+        uint32_t half = (exponent << 10) | (mantissa >> 13);
+        const uint32_t rest = mantissa & 0x1fff;
+        // A carry into the exponent is still the nearest half
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) { ++half; }
+        return sign | half;
+    }
+
+    inline float HalfToFloat(uint16_t half)
+    {
+        const uint32_t sign = static_cast<uint32_t>(half & 0x8000) << 16;
+        const uint32_t exponent = (half >> 10) & 0x1f;
+        const uint32_t mantissa = half & 0x3ff;
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            // Denormals are only read, never written
+            const float value = std::ldexp(static_cast<float>(mantissa), -24);
+            return sign ? -value: value;
+        } else if (exponent == 31)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        } else
+        {
+            bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+        }
+        return GetFixed<float>(reinterpret_cast<const uint8_t*>(&bits));
+    }
+
+} // namespace mediapipe
+
+#endif
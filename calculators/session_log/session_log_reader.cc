@@ -0,0 +1,291 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Reader of the columnar session log
+#include "mp_proctor/calculators/session_log/session_log_reader.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        /**
+         * @brief Bounds checked cursor over a block payload
+         */
+        class PayloadReader
+        {
+        private:
+            const uint8_t* m_data;
+            const uint8_t* const m_end;
+            bool m_ok = true;
+
+        public:
+            PayloadReader(const uint8_t* data, size_t size)
+                : m_data(data), m_end(data + size)
+            {}
+
+            bool ok() const { return m_ok; }
+
+            uint64_t Varint()
+            {
+                uint64_t value = 0;
+                if (m_ok && !GetVarint(&m_data, m_end, &value)) { m_ok = false; }
+                return value;
+            }
+
+            const uint8_t* Bytes(size_t size)
+            {
+                if (!m_ok || static_cast<size_t>(m_end - m_data) < size)
+                {
+                    m_ok = false;
+                    return nullptr;
+                }
+                const uint8_t* bytes = m_data;
+                m_data += size;
+                return bytes;
+            }
+        };
+    } // namespace
+
+    SessionLogReader::~SessionLogReader()
+    {
+        if (m_data != nullptr) { munmap(const_cast<uint8_t*>(m_data), m_size); }
+    }
+
+    absl::StatusOr<std::unique_ptr<SessionLogReader>> SessionLogReader::Open(const std::string& path)
+    {
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) { return absl::NotFoundError("Could not open " + path); }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kSessionLogHeaderBytes)
+        {
+            close(fd);
+            return absl::DataLossError(path + " is not a session log");
+        }
+
+        std::unique_ptr<SessionLogReader> reader(new SessionLogReader());
+        reader->m_size = info.st_size;
+        void* data = mmap(nullptr, reader->m_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) { return absl::InternalError("Could not map " + path); }
+        reader->m_data = static_cast<const uint8_t*>(data);
+
+        if (GetFixed<uint32_t>(reader->m_data) != kSessionLogMagic)
+        {
+            return absl::DataLossError(path + " is not a session log");
+        }
+        if (GetFixed<uint16_t>(reader->m_data + 4) != kSessionLogVersion)
+        {
+            return absl::FailedPreconditionError("Unsupported session log version");
+        }
+        reader->m_embedding_encoding = static_cast<SessionLogEmbeddingEncoding>(reader->m_data[6]);
+        reader->m_top_k_expressions = reader->m_data[7];
+        RET_CHECK_LE(reader->m_top_k_expressions, kSessionLogExpressionSize);
+
+        if (!reader->ReadIndex()) { reader->ScanBlocks(); }
+        return reader;
+    }
+
+    bool SessionLogReader::ReadIndex()
+    {
+        if (m_size < kSessionLogHeaderBytes + kSessionLogTrailerBytes) { return false; }
+        const uint8_t* trailer = m_data + m_size - kSessionLogTrailerBytes;
+        if (GetFixed<uint32_t>(trailer + 12) != kSessionLogIndexMagic) { return false; }
+        const uint64_t index_offset = GetFixed<uint64_t>(trailer);
+        const uint32_t block_count = GetFixed<uint32_t>(trailer + 8);
+        if (index_offset + uint64_t{block_count} * kSessionLogIndexEntryBytes + kSessionLogTrailerBytes != m_size)
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < block_count; ++i)
+        {
+            const uint8_t* entry = m_data + index_offset + i * kSessionLogIndexEntryBytes;
+            SessionLogBlockInfo block;
+            block.first_timestamp_us = GetFixed<int64_t>(entry);
+            block.last_timestamp_us = GetFixed<int64_t>(entry + 8);
+            block.offset = GetFixed<uint64_t>(entry + 16);
+            block.row_count = GetFixed<uint32_t>(entry + 24);
+            if (block.offset + kSessionLogBlockHeaderBytes > index_offset)
+            {
+                m_blocks.clear();
+                return false;
+            }
+            m_blocks.push_back(block);
+        }
+        return true;
+    }
+
+    void SessionLogReader::ScanBlocks()
+    {
+        uint64_t offset = kSessionLogHeaderBytes;
+        while (offset + kSessionLogBlockHeaderBytes <= m_size)
+        {
+            const uint8_t* header = m_data + offset;
+            if (GetFixed<uint32_t>(header) != kSessionLogBlockMagic) { break; }
+            const uint64_t payload_bytes = GetFixed<uint32_t>(header + 4);
+            if (offset + kSessionLogBlockHeaderBytes + payload_bytes > m_size) { break; }
+
+            SessionLogBlockInfo block;
+            block.row_count = GetFixed<uint32_t>(header + 8);
+            block.first_timestamp_us = GetFixed<int64_t>(header + 16);
+            block.last_timestamp_us = GetFixed<int64_t>(header + 24);
+            block.offset = offset;
+            m_blocks.push_back(block);
+            offset += kSessionLogBlockHeaderBytes + payload_bytes;
+        }
+    }
+
+    int64_t SessionLogReader::row_count() const
+    {
+        int64_t count = 0;
+        for (const auto& block: m_blocks) { count += block.row_count; }
+        return count;
+    }
+
+    absl::Status SessionLogReader::ReadBlock(size_t block, std::vector<SessionLogRow>* rows) const
+    {
+        RET_CHECK_LT(block, m_blocks.size());
+        const uint8_t* header = m_data + m_blocks[block].offset;
+        RET_CHECK_EQ(GetFixed<uint32_t>(header), kSessionLogBlockMagic);
+        const uint32_t payload_bytes = GetFixed<uint32_t>(header + 4);
+        const uint32_t row_count = GetFixed<uint32_t>(header + 8);
+        RET_CHECK_LE(m_blocks[block].offset + kSessionLogBlockHeaderBytes + payload_bytes, m_size);
+        // Each row takes at least a varint byte for the timestamp, face,
+        // fields and every scalar column, so a corrupt count cannot blow up
+        // the allocation below
+        RET_CHECK_LE(uint64_t{row_count} * (3 + kSessionLogScalarColumns), payload_bytes)
+            << "Block " << block << " claims more rows than its payload holds";
+        PayloadReader payload(header + kSessionLogBlockHeaderBytes, payload_bytes);
+
+        const size_t first = rows->size();
+        rows->resize(first + row_count);
+        SessionLogRow* block_rows = rows->data() + first;
+
+        int64_t timestamp = GetFixed<int64_t>(header + 16);
+        for (uint32_t i = 0; i < row_count; ++i)
+        {
+            block_rows[i] = SessionLogRow();
+            timestamp += ZigZagDecode(payload.Varint());
+            block_rows[i].timestamp_us = timestamp;
+        }
+        for (uint32_t i = 0; i < row_count; ++i) { block_rows[i].face = payload.Varint(); }
+        for (uint32_t i = 0; i < row_count; ++i) { block_rows[i].result.present_fields = payload.Varint(); }
+
+        const uint8_t* flags = payload.Bytes((uint64_t{row_count} * kSessionLogFlagBits + 7) / 8);
+        for (uint32_t i = 0; flags != nullptr && i < row_count; ++i)
+        {
+            const auto bit = [flags, i](int index)
+            {
+                const size_t position = i * kSessionLogFlagBits + index;
+                return ((flags[position / 8] >> (position % 8)) & 1) != 0;
+            };
+            block_rows[i].result.is_carried_forward = bit(0);
+            block_rows[i].result.is_left_eye_blinking = bit(1);
+            block_rows[i].result.is_right_eye_blinking = bit(2);
+        }
+
+        const auto get_scalars = [&](double ProctorResult::*field)
+        {
+            int64_t value = 0;
+            for (uint32_t i = 0; i < row_count; ++i)
+            {
+                value += ZigZagDecode(payload.Varint());
+                block_rows[i].result.*field = value / kSessionLogScalarScale;
+            }
+        };
+        get_scalars(&ProctorResult::horizontal_align);
+        get_scalars(&ProctorResult::vertical_align);
+        get_scalars(&ProctorResult::facial_activity);
+        get_scalars(&ProctorResult::face_movement);
+
+        for (uint32_t i = 0; i < row_count; ++i)
+        {
+            auto& result = block_rows[i].result;
+            if ((result.present_fields & PROCTOR_FIELD_EMBEDDINGS) == 0) { continue; }
+            if (m_embedding_encoding == kSessionLogFp16Embeddings)
+            {
+                const uint8_t* halfs = payload.Bytes(kSessionLogEmbeddingSize * 2);
+                for (int j = 0; halfs != nullptr && j < kSessionLogEmbeddingSize; ++j)
+                {
+                    result.face_reid_embeddings[j] = HalfToFloat(GetFixed<uint16_t>(halfs + j * 2));
+                }
+            } else if (m_embedding_encoding == kSessionLogInt8Embeddings)
+            {
+                const uint8_t* scale = payload.Bytes(sizeof(float));
+                const uint8_t* values = payload.Bytes(kSessionLogEmbeddingSize);
+                for (int j = 0; values != nullptr && j < kSessionLogEmbeddingSize; ++j)
+                {
+                    result.face_reid_embeddings[j] = static_cast<int8_t>(values[j]) * GetFixed<float>(scale);
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < row_count; ++i)
+        {
+            auto& result = block_rows[i].result;
+            for (int type = 0; type < kSessionLogExpressionSize; ++type)
+            {
+                result.expressions[type].type = static_cast<FacialExpressionType>(type);
+            }
+            if ((result.present_fields & PROCTOR_FIELD_EXPRESSIONS) == 0) { continue; }
+            const uint8_t* pairs = payload.Bytes(m_top_k_expressions * 2);
+            for (int k = 0; pairs != nullptr && k < m_top_k_expressions; ++k)
+            {
+                const int type = pairs[k * 2];
+                if (type < kSessionLogExpressionSize)
+                {
+                    result.expressions[type].probability = pairs[k * 2 + 1] / 255.0f;
+                }
+            }
+        }
+
+        if (!payload.ok())
+        {
+            rows->resize(first);
+            return absl::DataLossError("Corrupt session log block");
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionLogReader::ReadRange(
+        int64_t start_us, int64_t end_us, std::vector<SessionLogRow>* rows
+    ) const
+    {
+        // First block that may hold start_us
+        auto block = std::lower_bound(
+            m_blocks.begin(), m_blocks.end(), start_us,
+            [](const SessionLogBlockInfo& info, int64_t timestamp) { return info.last_timestamp_us < timestamp; }
+        );
+        std::vector<SessionLogRow> block_rows;
+        for (; block != m_blocks.end() && block->first_timestamp_us < end_us; ++block)
+        {
+            block_rows.clear();
+            MP_RETURN_IF_ERROR(this->ReadBlock(block - m_blocks.begin(), &block_rows));
+            for (const auto& row: block_rows)
+            {
+                if (row.timestamp_us >= start_us && row.timestamp_us < end_us) { rows->push_back(row); }
+            }
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
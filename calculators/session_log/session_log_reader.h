@@ -0,0 +1,85 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Reader of the columnar session log
+#ifndef session_log_reader_h
+#define session_log_reader_h
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Result of a face in a frame, as read back from a session log
+     *
+     * Quantized fields are approximate. Expressions hold a probability per
+     * FacialExpressionType in type order, 0 for those not in the top k.
+     */
+    struct SessionLogRow
+    {
+        int64_t timestamp_us;
+        int face;
+        ProctorResult result;
+    };
+
+    /**
+     * @brief Memory mapped session log with random access by time
+     *
+     * Uses the block index of a closed log, or scans the blocks of a log
+     * that was not closed, ignoring a partially written last block.
+     */
+    class SessionLogReader
+    {
+    private:
+        const uint8_t* m_data = nullptr;
+        size_t m_size = 0;
+        SessionLogEmbeddingEncoding m_embedding_encoding = kSessionLogNoEmbeddings;
+        int m_top_k_expressions = 0;
+        std::vector<SessionLogBlockInfo> m_blocks;
+
+        SessionLogReader() = default;
+
+        bool ReadIndex();
+        void ScanBlocks();
+
+    public:
+        ~SessionLogReader();
+
+        SessionLogReader(const SessionLogReader&) = delete;
+        SessionLogReader& operator=(const SessionLogReader&) = delete;
+
+        static absl::StatusOr<std::unique_ptr<SessionLogReader>> Open(const std::string& path);
+
+        // Blocks in timestamp order
+        const std::vector<SessionLogBlockInfo>& blocks() const { return m_blocks; }
+        int64_t row_count() const;
+
+        // Append the rows of a block
+        absl::Status ReadBlock(size_t block, std::vector<SessionLogRow>* rows) const;
+        // Append the rows with start_us <= timestamp < end_us, decoding only
+        // the blocks overlapping the range
+        absl::Status ReadRange(int64_t start_us, int64_t end_us, std::vector<SessionLogRow>* rows) const;
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,146 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the session log writer and reader
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+#include "mp_proctor/calculators/session_log/session_log_reader.h"
+#include "mp_proctor/calculators/session_log/session_log_writer.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        std::string TempPath(const std::string& name)
+        {
+            const char* dir = std::getenv("TEST_TMPDIR");
+            return std::string(dir != nullptr ? dir: "/tmp") + "/" + name;
+        }
+
+        ProctorResult MakeResult(int frame)
+        {
+            ProctorResult result = {};
+            result.is_left_eye_blinking = frame % 2 == 0;
+            result.horizontal_align = 0.01 * frame - 0.2;
+            result.vertical_align = 0.3;
+            result.facial_activity = 0.5 + 0.001 * frame;
+            result.face_movement = 0.002 * frame;
+            for (int i = 0; i < kSessionLogEmbeddingSize; i++)
+            {
+                result.face_reid_embeddings[i] = 0.01f * ((i + frame) % 50) - 0.25f;
+            }
+            for (int i = 0; i < kSessionLogExpressionSize; i++)
+            {
+                result.expressions[i].type = static_cast<FacialExpressionType>(i);
+                result.expressions[i].probability = i == frame % kSessionLogExpressionSize ? 0.9f: 0.1f / 7;
+            }
+            result.present_fields = PROCTOR_FIELD_BLINK | PROCTOR_FIELD_ORIENTATION |
+                PROCTOR_FIELD_ACTIVITY | PROCTOR_FIELD_MOVEMENT |
+                PROCTOR_FIELD_EMBEDDINGS | PROCTOR_FIELD_EXPRESSIONS;
+            return result;
+        }
+
+        // Writes frames 0 to frame_count - 1, at frame * 1000 us
+        void WriteLog(const std::string& path, int frame_count, bool close)
+        {
+            SessionLogWriterOptions options;
+            options.rows_per_block = 4;
+            auto writer = SessionLogWriter::Open(path, options);
+            ASSERT_TRUE(writer.ok()) << writer.status();
+            for (int frame = 0; frame < frame_count; frame++)
+            {
+                ASSERT_TRUE((*writer)->Append(frame * 1000, {MakeResult(frame)}).ok());
+            }
+            ASSERT_TRUE((*writer)->Flush().ok());
+            struct stat blocks_end;
+            ASSERT_EQ(stat(path.c_str(), &blocks_end), 0);
+            ASSERT_TRUE((*writer)->Close().ok());
+            if (!close)
+            {
+                // Left as after a crash, without the index
+                ASSERT_EQ(truncate(path.c_str(), blocks_end.st_size), 0);
+            }
+        }
+    } // namespace
+
+    TEST(SessionLogTest, RoundTrip)
+    {
+        const std::string path = TempPath("round_trip.mpsl");
+        WriteLog(path, 10, true);
+
+        auto reader = SessionLogReader::Open(path);
+        ASSERT_TRUE(reader.ok()) << reader.status();
+        EXPECT_EQ((*reader)->row_count(), 10);
+        ASSERT_EQ((*reader)->blocks().size(), 3);
+
+        std::vector<SessionLogRow> rows;
+        ASSERT_TRUE((*reader)->ReadRange(0, 10000, &rows).ok());
+        ASSERT_EQ(rows.size(), 10);
+        for (int frame = 0; frame < 10; frame++)
+        {
+            const ProctorResult expected = MakeResult(frame);
+            const ProctorResult& actual = rows[frame].result;
+            EXPECT_EQ(rows[frame].timestamp_us, frame * 1000);
+            EXPECT_EQ(rows[frame].face, 0);
+            EXPECT_EQ(actual.present_fields, expected.present_fields);
+            EXPECT_EQ(actual.is_left_eye_blinking, expected.is_left_eye_blinking);
+            EXPECT_NEAR(actual.horizontal_align, expected.horizontal_align, 1 / kSessionLogScalarScale);
+            EXPECT_NEAR(actual.vertical_align, expected.vertical_align, 1 / kSessionLogScalarScale);
+            EXPECT_NEAR(actual.facial_activity, expected.facial_activity, 1 / kSessionLogScalarScale);
+            EXPECT_NEAR(actual.face_movement, expected.face_movement, 1 / kSessionLogScalarScale);
+            for (int i = 0; i < kSessionLogEmbeddingSize; i++)
+            {
+                // int8 with a per-row scale
+                EXPECT_NEAR(actual.face_reid_embeddings[i], expected.face_reid_embeddings[i], 0.25 / 127);
+            }
+            const int top = frame % kSessionLogExpressionSize;
+            EXPECT_NEAR(actual.expressions[top].probability, 0.9, 1.0 / 255);
+        }
+    }
+
+    TEST(SessionLogTest, ReadsOnlyRequestedRange)
+    {
+        const std::string path = TempPath("range.mpsl");
+        WriteLog(path, 10, true);
+
+        auto reader = SessionLogReader::Open(path);
+        ASSERT_TRUE(reader.ok()) << reader.status();
+        std::vector<SessionLogRow> rows;
+        ASSERT_TRUE((*reader)->ReadRange(3000, 7000, &rows).ok());
+        ASSERT_EQ(rows.size(), 4);
+        EXPECT_EQ(rows.front().timestamp_us, 3000);
+        EXPECT_EQ(rows.back().timestamp_us, 6000);
+    }
+
+    TEST(SessionLogTest, ReadsLogWithoutIndex)
+    {
+        const std::string path = TempPath("unclosed.mpsl");
+        WriteLog(path, 10, false);
+
+        auto reader = SessionLogReader::Open(path);
+        ASSERT_TRUE(reader.ok()) << reader.status();
+        EXPECT_EQ((*reader)->row_count(), 10);
+        std::vector<SessionLogRow> rows;
+        ASSERT_TRUE((*reader)->ReadRange(0, 10000, &rows).ok());
+        EXPECT_EQ(rows.size(), 10);
+    }
+
+} // namespace mediapipe
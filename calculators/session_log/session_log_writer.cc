@@ -0,0 +1,252 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Writer of the columnar session log
+#include "mp_proctor/calculators/session_log/session_log_writer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        int64_t Quantize(double value)
+        { return std::llround(value * kSessionLogScalarScale); }
+
+        void PutFlags(const std::vector<bool>& bits, std::string* out)
+        {
+            std::string packed((bits.size() + 7) / 8, '\0');
+            for (size_t i = 0; i < bits.size(); ++i)
+            {
+                if (bits[i]) { packed[i / 8] |= static_cast<char>(1 << (i % 8)); }
+            }
+            out->append(packed);
+        }
+
+        void PutEmbedding(const float* embedding, SessionLogEmbeddingEncoding encoding, std::string* out)
+        {
+            if (encoding == kSessionLogFp16Embeddings)
+            {
+                for (int i = 0; i < kSessionLogEmbeddingSize; ++i) { PutFixed(FloatToHalf(embedding[i]), out); }
+                return;
+            }
+            // Symmetric int8 with a scale per row
+            float max_abs = 0;
+            for (int i = 0; i < kSessionLogEmbeddingSize; ++i) { max_abs = std::max(max_abs, std::fabs(embedding[i])); }
+            const float scale = max_abs > 0 ? max_abs / 127: 1;
+            PutFixed(scale, out);
+            for (int i = 0; i < kSessionLogEmbeddingSize; ++i)
+            {
+                out->push_back(static_cast<char>(static_cast<int8_t>(std::lround(embedding[i] / scale))));
+            }
+        }
+
+        void PutExpressions(const ProctorResult& result, int top_k, std::string* out)
+        {
+            FacialExpression expressions[kSessionLogExpressionSize];
+            std::copy(result.expressions, result.expressions + kSessionLogExpressionSize, expressions);
+            std::partial_sort(
+                expressions, expressions + top_k, expressions + kSessionLogExpressionSize,
+                [](const FacialExpression& a, const FacialExpression& b) { return a.probability > b.probability; }
+            );
+            for (int i = 0; i < top_k; ++i)
+            {
+                const float probability = std::min(1.0f, std::max(0.0f, expressions[i].probability));
+                out->push_back(static_cast<char>(expressions[i].type));
+                out->push_back(static_cast<char>(std::lround(probability * 255)));
+            }
+        }
+    } // namespace
+
+    SessionLogWriter::~SessionLogWriter()
+    { this->Close().IgnoreError(); }
+
+    absl::StatusOr<std::unique_ptr<SessionLogWriter>> SessionLogWriter::Open(
+        const std::string& path, const SessionLogWriterOptions& options
+    )
+    {
+        FILE* file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) { return absl::NotFoundError("Could not create " + path); }
+        return Open(file, options);
+    }
+
+    absl::StatusOr<std::unique_ptr<SessionLogWriter>> SessionLogWriter::Open(
+        FILE* file, const SessionLogWriterOptions& options
+    )
+    {
+        RET_CHECK(file != nullptr);
+        if (options.top_k_expressions < 0 || options.top_k_expressions > kSessionLogExpressionSize ||
+            options.rows_per_block <= 0)
+        {
+            std::fclose(file);
+            return absl::InvalidArgumentError("Invalid session log options");
+        }
+
+        std::unique_ptr<SessionLogWriter> writer(new SessionLogWriter());
+        writer->m_options = options;
+        writer->m_file = file;
+
+        std::string header;
+        PutFixed(kSessionLogMagic, &header);
+        PutFixed(kSessionLogVersion, &header);
+        header.push_back(static_cast<char>(options.embedding_encoding));
+        header.push_back(static_cast<char>(options.top_k_expressions));
+        header.resize(kSessionLogHeaderBytes, '\0');
+        MP_RETURN_IF_ERROR(writer->Write(header));
+        return writer;
+    }
+
+    absl::Status SessionLogWriter::Write(const std::string& bytes)
+    {
+        if (std::fwrite(bytes.data(), 1, bytes.size(), m_file) != bytes.size())
+        {
+            return absl::InternalError("Failed to write the session log");
+        }
+        m_offset += bytes.size();
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionLogWriter::Append(int64_t timestamp_us, const std::vector<ProctorResult>& results)
+    {
+        RET_CHECK(m_file != nullptr) << "The session log is closed";
+        RET_CHECK_GE(timestamp_us, m_last_timestamp_us) << "Timestamps must not decrease";
+        m_last_timestamp_us = timestamp_us;
+        for (size_t face = 0; face < results.size(); ++face)
+        {
+            m_rows.push_back({timestamp_us, static_cast<int>(face), results[face]});
+        }
+        if (static_cast<int>(m_rows.size()) >= m_options.rows_per_block)
+        {
+            return this->Flush();
+        }
+        return absl::OkStatus();
+    }
+
+    void SessionLogWriter::EncodeBlock(std::string* payload) const
+    {
+        int64_t previous = m_rows.front().timestamp_us;
+        for (const auto& row: m_rows)
+        {
+            PutVarint(ZigZagEncode(row.timestamp_us - previous), payload);
+            previous = row.timestamp_us;
+        }
+        for (const auto& row: m_rows) { PutVarint(row.face, payload); }
+
+        // Fields that are not stored are not present when read back
+        unsigned int stored_fields = ~0u;
+        if (m_options.embedding_encoding == kSessionLogNoEmbeddings) { stored_fields &= ~PROCTOR_FIELD_EMBEDDINGS; }
+        if (m_options.top_k_expressions == 0) { stored_fields &= ~PROCTOR_FIELD_EXPRESSIONS; }
+        for (const auto& row: m_rows) { PutVarint(row.result.present_fields & stored_fields, payload); }
+
+        std::vector<bool> flags;
+        flags.reserve(m_rows.size() * kSessionLogFlagBits);
+        for (const auto& row: m_rows)
+        {
+            flags.push_back(row.result.is_carried_forward);
+            flags.push_back(row.result.is_left_eye_blinking);
+            flags.push_back(row.result.is_right_eye_blinking);
+        }
+        PutFlags(flags, payload);
+
+        const auto put_scalars = [this, payload](double ProctorResult::*field)
+        {
+            int64_t previous = 0;
+            for (const auto& row: m_rows)
+            {
+                const int64_t value = Quantize(row.result.*field);
+                PutVarint(ZigZagEncode(value - previous), payload);
+                previous = value;
+            }
+        };
+        put_scalars(&ProctorResult::horizontal_align);
+        put_scalars(&ProctorResult::vertical_align);
+        put_scalars(&ProctorResult::facial_activity);
+        put_scalars(&ProctorResult::face_movement);
+
+        for (const auto& row: m_rows)
+        {
+            if ((row.result.present_fields & stored_fields & PROCTOR_FIELD_EMBEDDINGS) == 0) { continue; }
+            PutEmbedding(row.result.face_reid_embeddings, m_options.embedding_encoding, payload);
+        }
+        for (const auto& row: m_rows)
+        {
+            if ((row.result.present_fields & stored_fields & PROCTOR_FIELD_EXPRESSIONS) == 0) { continue; }
+            PutExpressions(row.result, m_options.top_k_expressions, payload);
+        }
+    }
+
+    absl::Status SessionLogWriter::Flush()
+    {
+        RET_CHECK(m_file != nullptr) << "The session log is closed";
+        if (m_rows.empty()) { return absl::OkStatus(); }
+
+        std::string block;
+        block.resize(kSessionLogBlockHeaderBytes);
+        this->EncodeBlock(&block);
+
+        SessionLogBlockInfo info;
+        info.first_timestamp_us = m_rows.front().timestamp_us;
+        info.last_timestamp_us = m_rows.back().timestamp_us;
+        info.offset = m_offset;
+        info.row_count = m_rows.size();
+
+        std::string header;
+        PutFixed(kSessionLogBlockMagic, &header);
+        PutFixed(static_cast<uint32_t>(block.size() - kSessionLogBlockHeaderBytes), &header);
+        PutFixed(info.row_count, &header);
+        PutFixed(uint32_t{0}, &header);
+        PutFixed(info.first_timestamp_us, &header);
+        PutFixed(info.last_timestamp_us, &header);
+        block.replace(0, kSessionLogBlockHeaderBytes, header);
+
+        MP_RETURN_IF_ERROR(this->Write(block));
+        // Whole blocks reach the file, so that a crash loses at most the buffered rows
+        if (std::fflush(m_file) != 0) { return absl::InternalError("Failed to write the session log"); }
+        m_blocks.push_back(info);
+        m_rows.clear();
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionLogWriter::Close()
+    {
+        if (m_file == nullptr) { return absl::OkStatus(); }
+        absl::Status status = this->Flush();
+        if (status.ok())
+        {
+            std::string index;
+            const uint64_t index_offset = m_offset;
+            for (const auto& block: m_blocks)
+            {
+                PutFixed(block.first_timestamp_us, &index);
+                PutFixed(block.last_timestamp_us, &index);
+                PutFixed(block.offset, &index);
+                PutFixed(block.row_count, &index);
+                PutFixed(uint32_t{0}, &index);
+            }
+            PutFixed(index_offset, &index);
+            PutFixed(static_cast<uint32_t>(m_blocks.size()), &index);
+            PutFixed(kSessionLogIndexMagic, &index);
+            status = this->Write(index);
+        }
+        if (std::fclose(m_file) != 0 && status.ok())
+        {
+            status = absl::InternalError("Failed to write the session log");
+        }
+        m_file = nullptr;
+        return status;
+    }
+
+} // namespace mediapipe
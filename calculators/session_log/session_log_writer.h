@@ -0,0 +1,96 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Writer of the columnar session log
+#ifndef session_log_writer_h
+#define session_log_writer_h
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of SessionLogWriter
+     */
+    struct SessionLogWriterOptions
+    {
+        SessionLogEmbeddingEncoding embedding_encoding = kSessionLogInt8Embeddings;
+        // Expressions kept per row, most probable first
+        int top_k_expressions = 3;
+        // Rows buffered before a block is written
+        int rows_per_block = 1024;
+    };
+
+    /**
+     * @brief Appends ProctorResults to a session log, see session_log_format.h
+     *
+     * Rows are buffered and written a block at a time; the block index is
+     * written by Close(). Timestamps must not decrease.
+     */
+    class SessionLogWriter
+    {
+    private:
+        struct Row
+        {
+            int64_t timestamp_us;
+            int face;
+            ProctorResult result;
+        };
+
+        FILE* m_file = nullptr;
+        SessionLogWriterOptions m_options;
+        std::vector<Row> m_rows;
+        std::vector<SessionLogBlockInfo> m_blocks;
+        uint64_t m_offset = 0;
+        int64_t m_last_timestamp_us = INT64_MIN;
+
+        SessionLogWriter() = default;
+
+        void EncodeBlock(std::string* payload) const;
+        absl::Status Write(const std::string& bytes);
+
+    public:
+        ~SessionLogWriter();
+
+        SessionLogWriter(const SessionLogWriter&) = delete;
+        SessionLogWriter& operator=(const SessionLogWriter&) = delete;
+
+        // Create the log, replacing any existing file
+        static absl::StatusOr<std::unique_ptr<SessionLogWriter>> Open(
+            const std::string& path, const SessionLogWriterOptions& options
+        );
+        // Write the log to an open stream, e.g. open_memstream(), closed by Close()
+        static absl::StatusOr<std::unique_ptr<SessionLogWriter>> Open(
+            FILE* file, const SessionLogWriterOptions& options
+        );
+
+        // Append the results of a frame, one row per face
+        absl::Status Append(int64_t timestamp_us, const std::vector<ProctorResult>& results);
+        // Write the buffered rows as a block
+        absl::Status Flush();
+        // Flush and write the block index
+        absl::Status Close();
+    };
+
+} // namespace mediapipe
+
+#endif
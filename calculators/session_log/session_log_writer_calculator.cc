@@ -0,0 +1,123 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to persist ProctorResults in a columnar session log
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/session_log/session_log_writer.h"
+#include "mp_proctor/calculators/session_log/session_log_writer_calculator.pb.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]    = "RESULTS";
+        constexpr char kOutputPathTag[] = "OUTPUT_PATH";
+    } // namespace
+
+    /**
+     * @brief Append the proctor results to a session log (see
+     *        session_log_format.h), read back with SessionLogReader
+     *
+     * Each result takes a few dozen bytes plus its quantized embedding,
+     * instead of several KB as text.
+     *
+     * INPUTS:
+     *      RESULTS - Results of a frame (std::vector<ProctorResult>)
+     * INPUT SIDE PACKETS:
+     *      OUTPUT_PATH - Optional path of the log, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "SessionLogWriterCalculator"
+     *   input_stream: "RESULTS:multi_face_proctor_results"
+     *   input_side_packet: "OUTPUT_PATH:session_log_path"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.SessionLogWriterCalculatorOptions] {
+     *       embedding_encoding: FP16
+     *     }
+     *   }
+     * }
+     *
+     */
+    class SessionLogWriterCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<SessionLogWriter> m_writer;
+
+    public:
+        SessionLogWriterCalculator() = default;
+        ~SessionLogWriterCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(SessionLogWriterCalculator);
+
+    absl::Status SessionLogWriterCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->InputSidePackets().HasTag(kOutputPathTag))
+        {
+            cc->InputSidePackets().Tag(kOutputPathTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionLogWriterCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<SessionLogWriterCalculatorOptions>();
+        std::string path = options.output_path();
+        if (cc->InputSidePackets().HasTag(kOutputPathTag) &&
+            !cc->InputSidePackets().Tag(kOutputPathTag).IsEmpty())
+        {
+            path = cc->InputSidePackets().Tag(kOutputPathTag).Get<std::string>();
+        }
+        if (path.empty())
+        {
+            return absl::InvalidArgumentError("SessionLogWriterCalculator: no output path!");
+        }
+
+        SessionLogWriterOptions writer_options;
+        writer_options.embedding_encoding = static_cast<SessionLogEmbeddingEncoding>(options.embedding_encoding());
+        writer_options.top_k_expressions = options.top_k_expressions();
+        writer_options.rows_per_block = options.rows_per_block();
+        ASSIGN_OR_RETURN(m_writer, SessionLogWriter::Open(path, writer_options));
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionLogWriterCalculator::Process(CalculatorContext* cc)
+    {
+        return m_writer->Append(
+            cc->InputTimestamp().Value(),
+            cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>()
+        );
+    } // Process()
+
+    absl::Status SessionLogWriterCalculator::Close(CalculatorContext* cc)
+    { return m_writer ? m_writer->Close(): absl::OkStatus(); }
+
+} // namespace mediapipe
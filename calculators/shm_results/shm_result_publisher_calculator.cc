@@ -0,0 +1,131 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to publish ProctorResults into a shared memory ring
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/shm_results/shm_result_publisher_calculator.pb.h"
+#include "mp_proctor/calculators/shm_results/shm_result_ring.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]  = "RESULTS";
+        constexpr char kRingNameTag[] = "RING_NAME";
+    } // namespace
+
+    /**
+     * @brief Publish the proctor results of each frame into a shared memory
+     *        ring, read by other processes with ShmResultReader
+     *
+     * The results are written straight from the input packet into the ring,
+     * and the calculator never waits for the readers.
+     *
+     * INPUTS:
+     *      RESULTS - Results of a frame (std::vector<ProctorResult>)
+     * INPUT SIDE PACKETS:
+     *      RING_NAME - Optional name of the ring, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "ShmResultPublisherCalculator"
+     *   input_stream: "RESULTS:multi_face_proctor_results"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.ShmResultPublisherCalculatorOptions] {
+     *       ring_name: "/exam_room_3"
+     *       max_faces: 2
+     *     }
+     *   }
+     * }
+     *
+     */
+    class ShmResultPublisherCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<ShmResultWriter> m_writer;
+        int m_max_faces = 0;
+
+    public:
+        ShmResultPublisherCalculator() = default;
+        ~ShmResultPublisherCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(ShmResultPublisherCalculator);
+
+    absl::Status ShmResultPublisherCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->InputSidePackets().HasTag(kRingNameTag))
+        {
+            cc->InputSidePackets().Tag(kRingNameTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status ShmResultPublisherCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<ShmResultPublisherCalculatorOptions>();
+        std::string name = options.ring_name();
+        if (cc->InputSidePackets().HasTag(kRingNameTag) &&
+            !cc->InputSidePackets().Tag(kRingNameTag).IsEmpty())
+        {
+            name = cc->InputSidePackets().Tag(kRingNameTag).Get<std::string>();
+        }
+        if (name.empty() || name[0] != '/')
+        {
+            return absl::InvalidArgumentError("ShmResultPublisherCalculator: ring_name must start with '/'!");
+        }
+        if (options.slot_count() <= 0 || options.max_faces() <= 0)
+        {
+            return absl::InvalidArgumentError("ShmResultPublisherCalculator: slot_count and max_faces must be positive!");
+        }
+
+        ASSIGN_OR_RETURN(auto ring, ShmResultRing::Create(name, options.slot_count(), options.max_faces()));
+        m_writer = absl::make_unique<ShmResultWriter>(std::move(ring));
+        m_max_faces = options.max_faces();
+        return absl::OkStatus();
+    }
+
+    absl::Status ShmResultPublisherCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& results = cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>();
+        LOG_IF(WARNING, static_cast<int>(results.size()) > m_max_faces)
+            << "ShmResultPublisherCalculator: dropping " << results.size() - m_max_faces << " faces";
+        m_writer->Write(cc->InputTimestamp().Value(), results.data(), results.size());
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status ShmResultPublisherCalculator::Close(CalculatorContext* cc)
+    {
+        if (m_writer) { m_writer->Close(); }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,267 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Shared memory ring publishing ProctorResults to co-located processes
+#include "mp_proctor/calculators/shm_results/shm_result_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "absl/time/clock.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr uint32 kShmResultRingMagic   = 0x4d505253; // "MPRS"
+        constexpr uint32 kShmResultRingVersion = 1;
+        constexpr size_t kCacheLine            = 64;
+
+        // Busy polls before falling back to sleeping, readers are expected
+        // to be woken up within microseconds of a write
+        constexpr int kSpinCount = 4096;
+        constexpr absl::Duration kPollPeriod = absl::Microseconds(20);
+
+        constexpr size_t RoundUp(size_t size)
+        { return (size + kCacheLine - 1) / kCacheLine * kCacheLine; }
+
+        constexpr size_t kHeaderBytes     = RoundUp(sizeof(ShmResultRingHeader));
+        constexpr size_t kSlotHeaderBytes = RoundUp(sizeof(ShmResultSlotHeader));
+
+        size_t RingSize(uint32 slot_count, uint64 slot_stride)
+        { return kHeaderBytes + slot_count * slot_stride; }
+
+        absl::Status ErrnoError(const std::string& what)
+        { return absl::InternalError(what + ": " + std::strerror(errno)); }
+
+        // Wait until ready() returns true, returns false after timeout
+        template<typename Ready>
+        bool WaitFor(Ready ready, absl::Duration timeout)
+        {
+            const absl::Time deadline = absl::Now() + timeout;
+            for (int spin = 0; !ready(); ++spin)
+            {
+                if (spin < kSpinCount) { continue; }
+                if (absl::Now() >= deadline) { return false; }
+                absl::SleepFor(kPollPeriod);
+            }
+            return true;
+        }
+    } // namespace
+
+    ShmResultRing::~ShmResultRing()
+    {
+        if (m_memory != nullptr) { munmap(m_memory, m_size); }
+        if (m_is_owner) { shm_unlink(m_name.c_str()); }
+    }
+
+    absl::StatusOr<std::shared_ptr<ShmResultRing>> ShmResultRing::Create(
+        const std::string& name, int slot_count, int max_faces
+    )
+    {
+        RET_CHECK_GT(slot_count, 0);
+        RET_CHECK_GT(max_faces, 0);
+        const uint64 slot_stride = kSlotHeaderBytes + RoundUp(max_faces * sizeof(ProctorResult));
+
+        // A crashed writer leaves its ring behind
+        shm_unlink(name.c_str());
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0) { return ErrnoError("shm_open " + name); }
+
+        std::shared_ptr<ShmResultRing> ring(new ShmResultRing());
+        ring->m_name = name;
+        ring->m_is_owner = true;
+        ring->m_size = RingSize(slot_count, slot_stride);
+        if (ftruncate(fd, ring->m_size) != 0)
+        {
+            close(fd);
+            return ErrnoError("ftruncate " + name);
+        }
+        void* memory = mmap(nullptr, ring->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) { return ErrnoError("mmap " + name); }
+        ring->m_memory = memory;
+
+        // The object is zero filled, the atomics only need to be constructed
+        auto* header = new (memory) ShmResultRingHeader();
+        header->version = kShmResultRingVersion;
+        header->slot_count = slot_count;
+        header->max_faces = max_faces;
+        header->result_bytes = sizeof(ProctorResult);
+        header->slot_stride = slot_stride;
+        header->write_position.store(0, std::memory_order_relaxed);
+        header->closed.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < slot_count; ++i)
+        {
+            auto* slot = new (ring->slot(i)) ShmResultSlotHeader();
+            slot->sequence.store(0, std::memory_order_relaxed);
+        }
+        header->magic.store(kShmResultRingMagic, std::memory_order_release);
+        return ring;
+    }
+
+    absl::StatusOr<std::shared_ptr<ShmResultRing>> ShmResultRing::Open(const std::string& name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+        {
+            return errno == ENOENT ?
+                absl::NotFoundError("No result ring named " + name):
+                ErrnoError("shm_open " + name);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kHeaderBytes)
+        {
+            close(fd);
+            return absl::UnavailableError("Result ring " + name + " is not initialized yet");
+        }
+
+        std::shared_ptr<ShmResultRing> ring(new ShmResultRing());
+        ring->m_name = name;
+        ring->m_size = info.st_size;
+        void* memory = mmap(nullptr, ring->m_size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) { return ErrnoError("mmap " + name); }
+        ring->m_memory = memory;
+
+        const ShmResultRingHeader* header = ring->header();
+        if (header->magic.load(std::memory_order_acquire) != kShmResultRingMagic)
+        {
+            return absl::UnavailableError("Result ring " + name + " is not initialized yet");
+        }
+        if (header->version != kShmResultRingVersion)
+        {
+            return absl::FailedPreconditionError("Unsupported result ring version");
+        }
+        if (header->result_bytes != sizeof(ProctorResult))
+        {
+            return absl::FailedPreconditionError("The writer uses another ProctorResult layout");
+        }
+        if (RingSize(header->slot_count, header->slot_stride) > ring->m_size)
+        {
+            return absl::DataLossError("Result ring " + name + " is truncated");
+        }
+        return ring;
+    }
+
+    ShmResultRingHeader* ShmResultRing::header() const
+    { return static_cast<ShmResultRingHeader*>(m_memory); }
+
+    ShmResultSlotHeader* ShmResultRing::slot(uint64 position) const
+    {
+        const ShmResultRingHeader* header = this->header();
+        auto* base = static_cast<uint8*>(m_memory) + kHeaderBytes;
+        return reinterpret_cast<ShmResultSlotHeader*>(base + (position % header->slot_count) * header->slot_stride);
+    }
+
+    ProctorResult* ShmResultRing::slot_results(uint64 position) const
+    { return reinterpret_cast<ProctorResult*>(reinterpret_cast<uint8*>(this->slot(position)) + kSlotHeaderBytes); }
+
+    ShmResultWriter::ShmResultWriter(std::shared_ptr<ShmResultRing> ring)
+        : m_ring(std::move(ring))
+    {}
+
+    ShmResultWriter::~ShmResultWriter()
+    { this->Close(); }
+
+    int ShmResultWriter::Write(int64 timestamp_us, const ProctorResult* results, int count)
+    {
+        ShmResultRingHeader* header = m_ring->header();
+        ShmResultSlotHeader* slot = m_ring->slot(m_position);
+        count = std::min<int>(std::max(count, 0), header->max_faces);
+
+        slot->sequence.store(2 * m_position + 1, std::memory_order_relaxed);
+        // Keeps the slot writes below from becoming visible before the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        slot->timestamp_us = timestamp_us;
+        slot->face_count = count;
+        std::memcpy(m_ring->slot_results(m_position), results, count * sizeof(ProctorResult));
+        slot->sequence.store(2 * m_position + 2, std::memory_order_release);
+
+        ++m_position;
+        header->write_position.store(m_position, std::memory_order_release);
+        return count;
+    }
+
+    void ShmResultWriter::Close()
+    { m_ring->header()->closed.store(1, std::memory_order_release); }
+
+    ShmResultReader::ShmResultReader(std::shared_ptr<ShmResultRing> ring, bool from_oldest)
+        : m_ring(std::move(ring))
+    {
+        const ShmResultRingHeader* header = m_ring->header();
+        m_position = header->write_position.load(std::memory_order_acquire);
+        if (from_oldest) { m_position -= std::min<uint64>(m_position, header->slot_count); }
+    }
+
+    absl::Status ShmResultReader::Read(
+        absl::Duration timeout, int64* timestamp_us, std::vector<ProctorResult>* results
+    )
+    {
+        const ShmResultRingHeader* header = m_ring->header();
+        const absl::Time deadline = absl::Now() + timeout;
+        while (true)
+        {
+            const bool is_ready = WaitFor(
+                [&]()
+                {
+                    return header->write_position.load(std::memory_order_acquire) > m_position ||
+                        header->closed.load(std::memory_order_acquire) != 0;
+                },
+                deadline - absl::Now()
+            );
+            if (!is_ready) { return absl::DeadlineExceededError("No results from the writer"); }
+
+            const uint64 written = header->write_position.load(std::memory_order_acquire);
+            // The last frame is written before the ring is closed
+            if (written <= m_position) { return absl::OutOfRangeError("The writer closed the result ring"); }
+            if (written - m_position > header->slot_count)
+            {
+                m_overruns += written - m_position - header->slot_count;
+                m_position = written - header->slot_count;
+            }
+
+            const ShmResultSlotHeader* slot = m_ring->slot(m_position);
+            const uint64 expected = 2 * m_position + 2;
+            if (slot->sequence.load(std::memory_order_acquire) == expected)
+            {
+                const int64 timestamp = slot->timestamp_us;
+                const uint32 count = std::min(slot->face_count, header->max_faces);
+                const ProctorResult* slot_results = m_ring->slot_results(m_position);
+                results->resize(count);
+                std::memcpy(results->data(), slot_results, count * sizeof(ProctorResult));
+                // Keeps the copy above from being reordered after the check below
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot->sequence.load(std::memory_order_relaxed) == expected)
+                {
+                    ++m_position;
+                    *timestamp_us = timestamp;
+                    return absl::OkStatus();
+                }
+            }
+            // Overwritten while, or before, being copied
+            ++m_overruns;
+            ++m_position;
+        }
+    }
+
+} // namespace mediapipe
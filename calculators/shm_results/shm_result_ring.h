@@ -0,0 +1,165 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Shared memory ring publishing ProctorResults to co-located processes
+#ifndef shm_result_ring_h
+#define shm_result_ring_h
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Header at the start of the shared memory object
+     *
+     * Readers check result_bytes, since the results are stored as raw
+     * ProctorResult structs and both processes must agree on their layout.
+     */
+    struct ShmResultRingHeader
+    {
+        // kShmResultRingMagic once the writer initialized the ring
+        std::atomic<uint32> magic;
+        uint32 version;
+        uint32 slot_count;
+        uint32 max_faces;
+        uint32 result_bytes;
+        // Distance between two slot headers
+        uint64 slot_stride;
+        // Position of the next frame of results to be written
+        alignas(64) std::atomic<uint64> write_position;
+        // Set by the writer after its last frame
+        alignas(64) std::atomic<uint32> closed;
+    };
+
+    /**
+     * @brief Header of a slot, followed by max_faces ProctorResults
+     *
+     * Seqlock of the single writer: writing position p into the slot sets
+     * sequence to 2p + 1 before touching the slot and to 2p + 2 once done.
+     * A reader copying position p is consistent if it saw sequence == 2p + 2
+     * both before and after the copy, and was overrun otherwise.
+     */
+    struct ShmResultSlotHeader
+    {
+        alignas(64) std::atomic<uint64> sequence;
+        int64 timestamp_us;
+        uint32 face_count;
+    };
+
+    static_assert(std::atomic<uint32>::is_always_lock_free, "Shared atomics must be lock free");
+    static_assert(std::atomic<uint64>::is_always_lock_free, "Shared atomics must be lock free");
+
+    /**
+     * @brief Mapping of a single writer multiple reader result ring
+     *
+     * The writer creates the shared memory object and removes it once
+     * destroyed, readers open it read-only and never write to it, so any
+     * number of them can follow the writer without slowing it down.
+     */
+    class ShmResultRing
+    {
+    private:
+        std::string m_name;
+        bool m_is_owner = false;
+        void* m_memory = nullptr;
+        size_t m_size = 0;
+
+        ShmResultRing() = default;
+
+    public:
+        ~ShmResultRing();
+
+        ShmResultRing(const ShmResultRing&) = delete;
+        ShmResultRing& operator=(const ShmResultRing&) = delete;
+
+        // Create the ring, e.g. "/mp_proctor_results", replacing any stale one
+        static absl::StatusOr<std::shared_ptr<ShmResultRing>> Create(
+            const std::string& name, int slot_count, int max_faces
+        );
+        // Open a ring created by a writer
+        static absl::StatusOr<std::shared_ptr<ShmResultRing>> Open(const std::string& name);
+
+        ShmResultRingHeader* header() const;
+        ShmResultSlotHeader* slot(uint64 position) const;
+        ProctorResult* slot_results(uint64 position) const;
+    };
+
+    /**
+     * @brief Publishes the results of each frame into a ShmResultRing
+     *
+     * Never waits for the readers: the oldest slot is always overwritten.
+     */
+    class ShmResultWriter
+    {
+    private:
+        std::shared_ptr<ShmResultRing> m_ring;
+        uint64 m_position = 0;
+
+    public:
+        explicit ShmResultWriter(std::shared_ptr<ShmResultRing> ring);
+        ~ShmResultWriter();
+
+        /**
+         * @brief Write the results of a frame, at most max_faces of them
+         *
+         * Returns the number of results written.
+         */
+        int Write(int64 timestamp_us, const ProctorResult* results, int count);
+        // Tell the readers that no more results follow
+        void Close();
+    };
+
+    /**
+     * @brief Follows the writer of a ShmResultRing
+     *
+     * Frames overwritten before they could be read are skipped and counted
+     * in overruns(), so a slow reader loses the oldest results, never the
+     * latest ones.
+     */
+    class ShmResultReader
+    {
+    private:
+        std::shared_ptr<ShmResultRing> m_ring;
+        uint64 m_position = 0;
+        uint64 m_overruns = 0;
+
+    public:
+        // Start at the next frame written, or at the oldest frame still in the ring
+        explicit ShmResultReader(std::shared_ptr<ShmResultRing> ring, bool from_oldest = false);
+
+        /**
+         * @brief Wait for the next frame of results and copy them out
+         *
+         * Returns DeadlineExceeded after timeout, and OutOfRange once the
+         * writer closed the ring and all frames were read.
+         */
+        absl::Status Read(absl::Duration timeout, int64* timestamp_us, std::vector<ProctorResult>* results);
+
+        // Number of frames lost because the writer overwrote them first
+        uint64 overruns() const { return m_overruns; }
+    };
+
+} // namespace mediapipe
+
+#endif
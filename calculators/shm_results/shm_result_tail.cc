@@ -0,0 +1,89 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Follows a shared memory result ring and prints the results, like an
+// alerting service would read them.
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/shm_results/shm_result_ring.h"
+
+ABSL_FLAG(std::string, ring_name, "/mp_proctor_results",
+          "Name of the shared memory result ring.");
+ABSL_FLAG(bool, from_oldest, false,
+          "Start with the oldest results still in the ring.");
+ABSL_FLAG(double, open_timeout_seconds, 30,
+          "Wait this long for the graph to create the ring.");
+
+absl::Status TailResults() {
+  const std::string name = absl::GetFlag(FLAGS_ring_name);
+  const absl::Time deadline =
+      absl::Now() + absl::Seconds(absl::GetFlag(FLAGS_open_timeout_seconds));
+  absl::StatusOr<std::shared_ptr<mediapipe::ShmResultRing>> ring;
+  while (true) {
+    ring = mediapipe::ShmResultRing::Open(name);
+    if (ring.ok() || absl::Now() >= deadline ||
+        (!absl::IsNotFound(ring.status()) &&
+         !absl::IsUnavailable(ring.status()))) {
+      break;
+    }
+    absl::SleepFor(absl::Milliseconds(100));
+  }
+  MP_RETURN_IF_ERROR(ring.status());
+
+  mediapipe::ShmResultReader reader(*std::move(ring),
+                                    absl::GetFlag(FLAGS_from_oldest));
+  std::vector<ProctorResult> results;
+  int64 timestamp_us = 0;
+  while (true) {
+    const absl::Status status =
+        reader.Read(absl::Seconds(1), &timestamp_us, &results);
+    if (absl::IsDeadlineExceeded(status)) continue;
+    if (absl::IsOutOfRange(status)) break;
+    MP_RETURN_IF_ERROR(status);
+
+    for (size_t i = 0; i < results.size(); ++i) {
+      const ProctorResult& result = results[i];
+      std::cout << absl::StrFormat(
+          "%d face=%d blink=%d/%d align=%.2f/%.2f activity=%.3f "
+          "movement=%.3f overruns=%d\n",
+          timestamp_us, i, result.is_left_eye_blinking,
+          result.is_right_eye_blinking, result.horizontal_align,
+          result.vertical_align, result.facial_activity, result.face_movement,
+          reader.overruns());
+    }
+  }
+  LOG(INFO) << "The graph closed the ring, " << reader.overruns()
+            << " frames were overrun.";
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = TailResults();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to read the results: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,233 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Session summary maintained from the proctoring results in bounded memory
+#include "mp_proctor/calculators/summary/session_summary.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "mp_proctor/calculators/util/proctor_thresholds.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        const char* const kExpressionNames[kSummaryExpressionCount] = {
+            "neutral", "happy", "sad", "surprise", "fear", "anger", "disgust", "contempt"
+        };
+        const char* const kHorizontalNames[kSummaryAlignBuckets] = {"left", "neutral", "right"};
+        const char* const kVerticalNames[kSummaryAlignBuckets] = {"up", "neutral", "down"};
+
+        int HorizontalBucket(double horizontal_align)
+        {
+            return horizontal_align >= kLookRightThreshold ? 2:
+                horizontal_align <= kLookLeftThreshold ? 0: 1;
+        }
+
+        int VerticalBucket(double vertical_align)
+        {
+            return vertical_align >= kLookDownThreshold ? 2:
+                vertical_align <= kLookUpThreshold ? 0: 1;
+        }
+
+        SessionSummaryDistribution Distribution(TDigest* digest)
+        {
+            SessionSummaryDistribution distribution;
+            distribution.count = static_cast<int64_t>(digest->count());
+            if (distribution.count == 0) { return distribution; }
+            distribution.mean = digest->mean();
+            distribution.min = digest->min();
+            distribution.max = digest->max();
+            distribution.p05 = digest->Quantile(0.05);
+            distribution.p25 = digest->Quantile(0.25);
+            distribution.p50 = digest->Quantile(0.5);
+            distribution.p75 = digest->Quantile(0.75);
+            distribution.p95 = digest->Quantile(0.95);
+            distribution.p99 = digest->Quantile(0.99);
+            return distribution;
+        }
+
+        void AppendDistribution(
+            const char* name, const SessionSummaryDistribution& distribution, std::string* json
+        )
+        {
+            absl::StrAppend(json, absl::StrFormat(
+                ",\"%s\":{\"count\":%d,\"mean\":%.6g,\"min\":%.6g,\"max\":%.6g,"
+                "\"p05\":%.6g,\"p25\":%.6g,\"p50\":%.6g,\"p75\":%.6g,\"p95\":%.6g,\"p99\":%.6g}",
+                name, distribution.count, distribution.mean, distribution.min, distribution.max,
+                distribution.p05, distribution.p25, distribution.p50, distribution.p75,
+                distribution.p95, distribution.p99
+            ));
+        }
+    } // namespace
+
+    SessionSummaryAccumulator::SessionSummaryAccumulator(const SessionSummaryOptions& options)
+        : m_options(options),
+          m_facial_activity(options.compression),
+          m_face_movement(options.compression),
+          m_horizontal_align(options.compression),
+          m_vertical_align(options.compression)
+    {}
+
+    void SessionSummaryAccumulator::Update(int64_t timestamp_us, const std::vector<ProctorResult>& results)
+    {
+        if (timestamp_us <= m_last_timestamp_us) { return; }
+
+        // A frame accounts for the time since the previous one
+        int64_t frame_us = 0;
+        if (m_summary.frames == 0)
+        {
+            m_summary.start_us = timestamp_us;
+        }
+        else
+        {
+            frame_us = std::min(timestamp_us - m_last_timestamp_us, m_options.max_frame_us);
+        }
+        m_last_timestamp_us = timestamp_us;
+        m_summary.end_us = timestamp_us;
+        m_summary.frames++;
+        m_summary.face_count_frames[std::min<size_t>(results.size(), kSummaryFaceCountBins - 1)]++;
+
+        if (m_eyes_closed.size() < results.size()) { m_eyes_closed.resize(results.size(), false); }
+        for (size_t face = 0; face < results.size(); ++face)
+        {
+            const ProctorResult& result = results[face];
+            m_summary.face_us += frame_us;
+
+            if (result.present_fields & PROCTOR_FIELD_ORIENTATION)
+            {
+                const int vertical = VerticalBucket(result.vertical_align);
+                const int horizontal = HorizontalBucket(result.horizontal_align);
+                m_summary.orientation_us[vertical][horizontal] += frame_us;
+            }
+            if (result.is_carried_forward) { continue; }
+
+            if (result.present_fields & PROCTOR_FIELD_BLINK)
+            {
+                const bool closed = result.is_left_eye_blinking && result.is_right_eye_blinking;
+                if (closed && !m_eyes_closed[face]) { m_summary.blinks++; }
+                m_eyes_closed[face] = closed;
+            }
+            if (result.present_fields & PROCTOR_FIELD_ORIENTATION)
+            {
+                m_horizontal_align.Add(result.horizontal_align);
+                m_vertical_align.Add(result.vertical_align);
+            }
+            if (result.present_fields & PROCTOR_FIELD_ACTIVITY)
+            {
+                m_facial_activity.Add(result.facial_activity);
+            }
+            if (result.present_fields & PROCTOR_FIELD_MOVEMENT)
+            {
+                m_face_movement.Add(result.face_movement);
+            }
+            if (result.present_fields & PROCTOR_FIELD_EXPRESSIONS)
+            {
+                int top = -1;
+                for (const FacialExpression& expression: result.expressions)
+                {
+                    const int type = expression.type;
+                    if (type < 0 || type >= kSummaryExpressionCount) { continue; }
+                    m_expression_sum[type] += expression.probability;
+                    if (top < 0 || expression.probability > result.expressions[top].probability)
+                    {
+                        top = &expression - result.expressions;
+                    }
+                }
+                if (top >= 0) { m_summary.expression_top[result.expressions[top].type]++; }
+                m_summary.expression_results++;
+            }
+        }
+    }
+
+    SessionSummary SessionSummaryAccumulator::Snapshot()
+    {
+        SessionSummary summary = m_summary;
+        if (summary.face_us > 0)
+        {
+            summary.blinks_per_minute = summary.blinks * 60e6 / summary.face_us;
+        }
+        for (int type = 0; type < kSummaryExpressionCount && summary.expression_results > 0; ++type)
+        {
+            summary.expression_mean[type] = m_expression_sum[type] / summary.expression_results;
+        }
+        summary.facial_activity = Distribution(&m_facial_activity);
+        summary.face_movement = Distribution(&m_face_movement);
+        summary.horizontal_align = Distribution(&m_horizontal_align);
+        summary.vertical_align = Distribution(&m_vertical_align);
+        return summary;
+    }
+
+    std::string SessionSummaryToJson(const SessionSummary& summary)
+    {
+        std::string json = absl::StrFormat(
+            "{\"start_us\":%d,\"end_us\":%d,\"frames\":%d,\"face_us\":%d,\"face_count_frames\":[",
+            summary.start_us, summary.end_us, summary.frames, summary.face_us
+        );
+        for (int bin = 0; bin < kSummaryFaceCountBins; ++bin)
+        {
+            absl::StrAppend(&json, bin > 0 ? ",": "", summary.face_count_frames[bin]);
+        }
+        absl::StrAppend(&json, absl::StrFormat(
+            "],\"blinks\":%d,\"blinks_per_minute\":%.6g,\"orientation_us\":{",
+            summary.blinks, summary.blinks_per_minute
+        ));
+        for (int vertical = 0; vertical < kSummaryAlignBuckets; ++vertical)
+        {
+            for (int horizontal = 0; horizontal < kSummaryAlignBuckets; ++horizontal)
+            {
+                absl::StrAppend(
+                    &json, vertical + horizontal > 0 ? ",": "", "\"", kVerticalNames[vertical], "_",
+                    kHorizontalNames[horizontal], "\":", summary.orientation_us[vertical][horizontal]
+                );
+            }
+        }
+        absl::StrAppend(&json, "},\"expression_results\":", summary.expression_results, ",\"expressions\":{");
+        for (int type = 0; type < kSummaryExpressionCount; ++type)
+        {
+            absl::StrAppend(&json, absl::StrFormat(
+                "%s\"%s\":{\"top\":%d,\"mean\":%.6g}", type > 0 ? ",": "", kExpressionNames[type],
+                summary.expression_top[type], summary.expression_mean[type]
+            ));
+        }
+        absl::StrAppend(&json, "}");
+        AppendDistribution("facial_activity", summary.facial_activity, &json);
+        AppendDistribution("face_movement", summary.face_movement, &json);
+        AppendDistribution("horizontal_align", summary.horizontal_align, &json);
+        AppendDistribution("vertical_align", summary.vertical_align, &json);
+        absl::StrAppend(&json, "}\n");
+        return json;
+    }
+
+    absl::Status WriteSessionSummary(const SessionSummary& summary, const std::string& path)
+    {
+        const std::string json = SessionSummaryToJson(summary);
+        const std::string temporary_path = path + ".tmp";
+        FILE* file = std::fopen(temporary_path.c_str(), "w");
+        if (file == nullptr) { return absl::NotFoundError("Could not create " + temporary_path); }
+        bool failed = std::fwrite(json.data(), 1, json.size(), file) != json.size();
+        failed |= std::fclose(file) != 0;
+        if (failed || std::rename(temporary_path.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary_path.c_str());
+            return absl::InternalError("Failed to write the session summary " + path);
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,129 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Session summary maintained from the proctoring results in bounded memory
+#ifndef session_summary_h
+#define session_summary_h
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/summary/t_digest.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    // Bins of the face count histogram, the last one counts this many faces
+    // or more
+    constexpr int kSummaryFaceCountBins = 4;
+    // Orientation buckets per axis, indexed Left/Up, Neutral, Right/Down
+    constexpr int kSummaryAlignBuckets = 3;
+    constexpr int kSummaryExpressionCount = 8;
+
+    // Estimated distribution of a continuous field
+    struct SessionSummaryDistribution
+    {
+        int64_t count = 0;
+        double mean = 0;
+        double min = 0;
+        double max = 0;
+        double p05 = 0;
+        double p25 = 0;
+        double p50 = 0;
+        double p75 = 0;
+        double p95 = 0;
+        double p99 = 0;
+    };
+
+    struct SessionSummary
+    {
+        // Stream time of the first and the latest frame
+        int64_t start_us = 0;
+        int64_t end_us = 0;
+        int64_t frames = 0;
+        int64_t face_count_frames[kSummaryFaceCountBins] = {};
+        // Time the faces were seen, summed over the faces
+        int64_t face_us = 0;
+
+        // Onsets of both eyes closing, per minute of face time
+        int64_t blinks = 0;
+        double blinks_per_minute = 0;
+
+        // Face time per orientation bucket, [vertical][horizontal]
+        int64_t orientation_us[kSummaryAlignBuckets][kSummaryAlignBuckets] = {};
+
+        // Results on which each expression is the most probable, and its mean
+        // probability over the results with expressions
+        int64_t expression_results = 0;
+        int64_t expression_top[kSummaryExpressionCount] = {};
+        double expression_mean[kSummaryExpressionCount] = {};
+
+        SessionSummaryDistribution facial_activity;
+        SessionSummaryDistribution face_movement;
+        SessionSummaryDistribution horizontal_align;
+        SessionSummaryDistribution vertical_align;
+    };
+
+    struct SessionSummaryOptions
+    {
+        // Centroid budget of the quantile sketches
+        double compression = 100;
+        // Longest time a frame accounts for, so that gaps in the stream do
+        // not count as face time
+        int64_t max_frame_us = 500000;
+    };
+
+    /**
+     * @brief Fold the results of each frame into a SessionSummary
+     *
+     * Counters and histograms are exact, the distributions are estimated by
+     * t-digests, so that the memory stays flat however long the session
+     * runs. Carried forward results count towards the time of the session
+     * but not towards the distributions and the blinks.
+     */
+    class SessionSummaryAccumulator
+    {
+    private:
+        SessionSummaryOptions m_options;
+        SessionSummary m_summary;
+        double m_expression_sum[kSummaryExpressionCount] = {};
+        TDigest m_facial_activity;
+        TDigest m_face_movement;
+        TDigest m_horizontal_align;
+        TDigest m_vertical_align;
+        // Eyes closed on the previous result, per face
+        std::vector<bool> m_eyes_closed;
+        int64_t m_last_timestamp_us = INT64_MIN;
+
+    public:
+        explicit SessionSummaryAccumulator(const SessionSummaryOptions& options = SessionSummaryOptions());
+
+        // Fold a frame, an empty results for a frame without faces
+        void Update(int64_t timestamp_us, const std::vector<ProctorResult>& results);
+
+        // Summary of the frames so far
+        SessionSummary Snapshot();
+    };
+
+    // Summary as a JSON object
+    std::string SessionSummaryToJson(const SessionSummary& summary);
+
+    // Write the JSON summary to path, through a temporary file
+    absl::Status WriteSessionSummary(const SessionSummary& summary, const std::string& path);
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,176 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to summarize a session incrementally
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/summary/session_summary.h"
+#include "mp_proctor/calculators/summary/session_summary_calculator.pb.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]    = "RESULTS";
+        constexpr char kTickTag[]       = "TICK";
+        constexpr char kTriggerTag[]    = "TRIGGER";
+        constexpr char kSummaryTag[]    = "SUMMARY";
+        constexpr char kOutputPathTag[] = "OUTPUT_PATH";
+    } // namespace
+
+    /**
+     * @brief Maintain the summary of the session (blink rate, time per
+     *        orientation, expression mix and distributions of the continuous
+     *        fields) in constant memory, see session_summary.h
+     *
+     * A snapshot is output for each TRIGGER packet and once more on Close,
+     * when the summary is also written to the output path if any.
+     *
+     * INPUTS:
+     *      RESULTS - Results of the faces of a frame (std::vector<ProctorResult>)
+     *      TICK - Optional clock of the analyzed frames (Any), frames without
+     *             results count as frames without faces
+     *      TRIGGER - Optional request of a snapshot (Any)
+     * OUTPUTS:
+     *      SUMMARY - Optional snapshots of the summary (SessionSummary)
+     * INPUT SIDE PACKETS:
+     *      OUTPUT_PATH - Optional path of the JSON summary, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "SessionSummaryCalculator"
+     *   input_stream: "RESULTS:proctor_results"
+     *   input_stream: "TICK:throttled_input_video"
+     *   input_stream: "TRIGGER:summary_request"
+     *   output_stream: "SUMMARY:session_summary"
+     *   input_side_packet: "OUTPUT_PATH:session_summary_path"
+     * }
+     *
+     */
+    class SessionSummaryCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<SessionSummaryAccumulator> m_accumulator;
+        std::string m_path;
+        Timestamp m_last_timestamp = Timestamp::Unset();
+
+    public:
+        SessionSummaryCalculator() = default;
+        ~SessionSummaryCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(SessionSummaryCalculator);
+
+    absl::Status SessionSummaryCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            cc->Inputs().Tag(kTickTag).SetAny();
+        }
+        if (cc->Inputs().HasTag(kTriggerTag))
+        {
+            cc->Inputs().Tag(kTriggerTag).SetAny();
+        }
+        if (cc->Outputs().HasTag(kSummaryTag))
+        {
+            cc->Outputs().Tag(kSummaryTag).Set<SessionSummary>();
+        }
+        if (cc->InputSidePackets().HasTag(kOutputPathTag))
+        {
+            cc->InputSidePackets().Tag(kOutputPathTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionSummaryCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<SessionSummaryCalculatorOptions>();
+        if (options.compression() < 10 || options.max_frame_us() <= 0)
+        {
+            return absl::InvalidArgumentError("SessionSummaryCalculator: compression must be at least 10 and max_frame_us positive!");
+        }
+        m_path = options.output_path();
+        if (cc->InputSidePackets().HasTag(kOutputPathTag) &&
+            !cc->InputSidePackets().Tag(kOutputPathTag).IsEmpty())
+        {
+            m_path = cc->InputSidePackets().Tag(kOutputPathTag).Get<std::string>();
+        }
+        if (m_path.empty() && !cc->Outputs().HasTag(kSummaryTag))
+        {
+            return absl::InvalidArgumentError("SessionSummaryCalculator: neither a SUMMARY stream nor an output path!");
+        }
+
+        SessionSummaryOptions summary_options;
+        summary_options.compression = options.compression();
+        summary_options.max_frame_us = options.max_frame_us();
+        m_accumulator = absl::make_unique<SessionSummaryAccumulator>(summary_options);
+        return absl::OkStatus();
+    }
+
+    absl::Status SessionSummaryCalculator::Process(CalculatorContext* cc)
+    {
+        m_last_timestamp = cc->InputTimestamp();
+        const bool has_tick = cc->Inputs().HasTag(kTickTag) && !cc->Inputs().Tag(kTickTag).IsEmpty();
+        if (!cc->Inputs().Tag(kResultsTag).IsEmpty())
+        {
+            m_accumulator->Update(
+                cc->InputTimestamp().Value(),
+                cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>()
+            );
+        }
+        else if (has_tick)
+        {
+            m_accumulator->Update(cc->InputTimestamp().Value(), {});
+        }
+
+        if (cc->Inputs().HasTag(kTriggerTag) && !cc->Inputs().Tag(kTriggerTag).IsEmpty() &&
+            cc->Outputs().HasTag(kSummaryTag))
+        {
+            cc->Outputs().Tag(kSummaryTag).AddPacket(
+                MakePacket<SessionSummary>(m_accumulator->Snapshot()).At(cc->InputTimestamp())
+            );
+        }
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status SessionSummaryCalculator::Close(CalculatorContext* cc)
+    {
+        if (!m_accumulator) { return absl::OkStatus(); }
+        const SessionSummary summary = m_accumulator->Snapshot();
+        if (cc->Outputs().HasTag(kSummaryTag) && m_last_timestamp != Timestamp::Unset())
+        {
+            cc->Outputs().Tag(kSummaryTag).AddPacket(
+                MakePacket<SessionSummary>(summary).At(m_last_timestamp.NextAllowedInStream())
+            );
+        }
+        return m_path.empty() ? absl::OkStatus(): WriteSessionSummary(summary, m_path);
+    }
+
+} // namespace mediapipe
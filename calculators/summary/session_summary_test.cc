@@ -0,0 +1,102 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the streaming session summary
+#include "mp_proctor/calculators/summary/session_summary.h"
+
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        ProctorResult MakeResult(double horizontal_align, double facial_activity, bool eyes_closed)
+        {
+            ProctorResult result = {};
+            result.horizontal_align = horizontal_align;
+            result.vertical_align = 0.1;
+            result.facial_activity = facial_activity;
+            result.is_left_eye_blinking = result.is_right_eye_blinking = eyes_closed;
+            result.present_fields = PROCTOR_FIELD_BLINK | PROCTOR_FIELD_ORIENTATION | PROCTOR_FIELD_ACTIVITY;
+            return result;
+        }
+
+        // One face at 10 fps for a second, looking right for the last half
+        // and closing the eyes on frames 2, 3 and 6, then a frame without
+        // faces after a gap
+        SessionSummaryAccumulator MakeSession()
+        {
+            SessionSummaryAccumulator accumulator;
+            for (int frame = 0; frame < 10; frame++)
+            {
+                const bool eyes_closed = frame == 2 || frame == 3 || frame == 6;
+                accumulator.Update(frame * 100000, {MakeResult(frame < 5 ? 0: 0.5, frame * 0.1, eyes_closed)});
+            }
+            accumulator.Update(6000000, {});
+            return accumulator;
+        }
+    } // namespace
+
+    TEST(SessionSummaryTest, CountsFramesAndFaceTime)
+    {
+        SessionSummaryAccumulator accumulator = MakeSession();
+        // Out of order, ignored
+        accumulator.Update(5000000, {MakeResult(0, 0, false)});
+        const SessionSummary summary = accumulator.Snapshot();
+
+        EXPECT_EQ(summary.start_us, 0);
+        EXPECT_EQ(summary.end_us, 6000000);
+        EXPECT_EQ(summary.frames, 11);
+        EXPECT_EQ(summary.face_count_frames[0], 1);
+        EXPECT_EQ(summary.face_count_frames[1], 10);
+        // The first frame accounts for no time, the gap is not face time
+        EXPECT_EQ(summary.face_us, 900000);
+        EXPECT_EQ(summary.orientation_us[1][1], 400000);
+        EXPECT_EQ(summary.orientation_us[1][2], 500000);
+        EXPECT_EQ(summary.blinks, 2);
+        EXPECT_DOUBLE_EQ(summary.blinks_per_minute, 2 * 60e6 / 900000);
+    }
+
+    TEST(SessionSummaryTest, LeavesCarriedForwardResultsOutOfDistributions)
+    {
+        SessionSummaryAccumulator accumulator = MakeSession();
+        ProctorResult carried = MakeResult(0, 100, true);
+        carried.is_carried_forward = true;
+        accumulator.Update(6100000, {carried});
+        const SessionSummary summary = accumulator.Snapshot();
+
+        EXPECT_EQ(summary.face_us, 1000000);
+        EXPECT_EQ(summary.blinks, 2);
+        EXPECT_EQ(summary.facial_activity.count, 10);
+        EXPECT_DOUBLE_EQ(summary.facial_activity.min, 0);
+        EXPECT_DOUBLE_EQ(summary.facial_activity.max, 0.9);
+        EXPECT_NEAR(summary.facial_activity.mean, 0.45, 1e-9);
+        EXPECT_EQ(summary.face_movement.count, 0);
+    }
+
+    TEST(SessionSummaryTest, WritesJson)
+    {
+        const std::string json = SessionSummaryToJson(MakeSession().Snapshot());
+        EXPECT_EQ(json.front(), '{');
+        EXPECT_NE(json.find("\"frames\":11,"), std::string::npos);
+        EXPECT_NE(json.find("\"face_count_frames\":[1,10,0,0]"), std::string::npos);
+        EXPECT_NE(json.find("\"neutral_right\":500000"), std::string::npos);
+        EXPECT_NE(json.find("\"facial_activity\":{\"count\":10,"), std::string::npos);
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,140 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Quantile sketch of a stream of values
+#include "mp_proctor/calculators/summary/t_digest.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr double kPi = 3.14159265358979323846;
+
+        // Scale function k1 and its inverse
+        double ScaleOf(double q, double compression)
+        { return compression / (2 * kPi) * std::asin(2 * q - 1); }
+
+        double QuantileOf(double k, double compression)
+        { return (std::sin(k * 2 * kPi / compression) + 1) / 2; }
+    } // namespace
+
+    TDigest::TDigest(double compression)
+        : m_compression(std::max(compression, 10.0)),
+          m_buffer_limit(static_cast<size_t>(5 * m_compression))
+    {}
+
+    void TDigest::Add(double value, double weight)
+    {
+        if (!(weight > 0) || std::isnan(value)) { return; }
+        if (m_total_weight == 0)
+        {
+            m_min = m_max = value;
+        }
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+        m_total_weight += weight;
+        m_sum += value * weight;
+        m_buffer.push_back({value, weight});
+        if (m_buffer.size() >= m_buffer_limit) { this->Compress(); }
+    }
+
+    void TDigest::Merge(const TDigest& other)
+    {
+        if (other.m_total_weight == 0) { return; }
+        if (m_total_weight == 0)
+        {
+            m_min = other.m_min;
+            m_max = other.m_max;
+        }
+        m_min = std::min(m_min, other.m_min);
+        m_max = std::max(m_max, other.m_max);
+        m_total_weight += other.m_total_weight;
+        m_sum += other.m_sum;
+        for (const auto* centroids: {&other.m_centroids, &other.m_buffer})
+        {
+            for (const Centroid& centroid: *centroids)
+            {
+                m_buffer.push_back(centroid);
+                if (m_buffer.size() >= m_buffer_limit) { this->Compress(); }
+            }
+        }
+    }
+
+    void TDigest::Compress()
+    {
+        if (m_buffer.empty()) { return; }
+        m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+        std::sort(m_buffer.begin(), m_buffer.end(), [](const Centroid& a, const Centroid& b)
+        { return a.mean < b.mean; });
+
+        // Grow each centroid while it spans at most one unit of the scale
+        m_centroids.clear();
+        Centroid current = m_buffer.front();
+        double weight_before = 0;
+        double limit = m_total_weight * QuantileOf(ScaleOf(0, m_compression) + 1, m_compression);
+        for (size_t i = 1; i < m_buffer.size(); ++i)
+        {
+            const Centroid& next = m_buffer[i];
+            if (weight_before + current.weight + next.weight <= limit)
+            {
+                current.weight += next.weight;
+                current.mean += (next.mean - current.mean) * next.weight / current.weight;
+                continue;
+            }
+            weight_before += current.weight;
+            m_centroids.push_back(current);
+            const double q = std::min(weight_before / m_total_weight, 1.0);
+            limit = m_total_weight * QuantileOf(std::min(ScaleOf(q, m_compression) + 1, m_compression / 4), m_compression);
+            current = next;
+        }
+        m_centroids.push_back(current);
+        m_buffer.clear();
+    }
+
+    double TDigest::Quantile(double q)
+    {
+        this->Compress();
+        if (m_centroids.empty()) { return 0; }
+        q = std::min(std::max(q, 0.0), 1.0);
+        if (m_centroids.size() == 1) { return m_centroids.front().mean; }
+
+        // Interpolate between the centers of the centroids, and between the
+        // extremes and the outer centers
+        const double index = q * m_total_weight;
+        const Centroid& first = m_centroids.front();
+        if (index < first.weight / 2)
+        {
+            return m_min + (first.mean - m_min) * index / (first.weight / 2);
+        }
+        double cumulative = first.weight / 2;
+        for (size_t i = 0; i + 1 < m_centroids.size(); ++i)
+        {
+            const double step = (m_centroids[i].weight + m_centroids[i + 1].weight) / 2;
+            if (cumulative + step > index)
+            {
+                const double t = (index - cumulative) / step;
+                return m_centroids[i].mean + t * (m_centroids[i + 1].mean - m_centroids[i].mean);
+            }
+            cumulative += step;
+        }
+        const Centroid& last = m_centroids.back();
+        const double t = std::min((index - cumulative) / (last.weight / 2), 1.0);
+        return last.mean + t * (m_max - last.mean);
+    }
+
+} // namespace mediapipe
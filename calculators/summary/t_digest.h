@@ -0,0 +1,72 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Quantile sketch of a stream of values
+#ifndef t_digest_h
+#define t_digest_h
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mediapipe
+{
+    /**
+     * @brief Merging t-digest (Dunning and Ertl), estimating quantiles of a
+     *        stream in constant memory
+     *
+     * Values are buffered and merged into at most about compression
+     * centroids, sized by the arcsine scale function so that the tails are
+     * kept with a finer resolution than the median.
+     */
+    class TDigest
+    {
+    private:
+        struct Centroid
+        {
+            double mean;
+            double weight;
+        };
+
+        double m_compression;
+        size_t m_buffer_limit;
+        std::vector<Centroid> m_centroids;
+        std::vector<Centroid> m_buffer;
+        double m_total_weight = 0;
+        double m_sum = 0;
+        double m_min = 0;
+        double m_max = 0;
+
+        void Compress();
+
+    public:
+        explicit TDigest(double compression = 100);
+
+        void Add(double value, double weight = 1);
+        // Add the values of another digest
+        void Merge(const TDigest& other);
+
+        // Estimated value at quantile q in [0, 1], 0 if empty
+        double Quantile(double q);
+
+        double count() const { return m_total_weight; }
+        double mean() const { return m_total_weight > 0 ? m_sum / m_total_weight: 0; }
+        double min() const { return m_min; }
+        double max() const { return m_max; }
+        size_t centroid_count() const { return m_centroids.size(); }
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,103 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of the t-digest quantile sketch
+#include "mp_proctor/calculators/summary/t_digest.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "mediapipe/framework/port/gtest.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        // Exact quantile of sorted values
+        double ExactQuantile(const std::vector<double>& sorted, double q)
+        {
+            return sorted[std::min<size_t>(q * sorted.size(), sorted.size() - 1)];
+        }
+    } // namespace
+
+    TEST(TDigestTest, EmptyDigest)
+    {
+        TDigest digest;
+        EXPECT_EQ(digest.count(), 0);
+        EXPECT_EQ(digest.mean(), 0);
+        EXPECT_EQ(digest.Quantile(0.5), 0);
+    }
+
+    TEST(TDigestTest, EstimatesQuantilesInBoundedMemory)
+    {
+        std::mt19937 random(1);
+        std::normal_distribution<double> normal(0, 1);
+        TDigest digest(100);
+        std::vector<double> values;
+        for (int i = 0; i < 100000; i++)
+        {
+            values.push_back(normal(random));
+            digest.Add(values.back());
+        }
+        std::sort(values.begin(), values.end());
+
+        EXPECT_EQ(digest.count(), values.size());
+        EXPECT_EQ(digest.min(), values.front());
+        EXPECT_EQ(digest.max(), values.back());
+        EXPECT_EQ(digest.Quantile(0), values.front());
+        EXPECT_EQ(digest.Quantile(1), values.back());
+        EXPECT_LE(digest.centroid_count(), 200);
+        // Finer in the tails than around the median
+        EXPECT_NEAR(digest.Quantile(0.5), ExactQuantile(values, 0.5), 0.02);
+        for (double q: {0.01, 0.05, 0.95, 0.99})
+        {
+            EXPECT_NEAR(digest.Quantile(q), ExactQuantile(values, q), 0.01) << "q " << q;
+        }
+    }
+
+    TEST(TDigestTest, MergeMatchesSingleDigest)
+    {
+        std::mt19937 random(2);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        TDigest left;
+        TDigest right;
+        for (int i = 0; i < 20000; i++)
+        {
+            // Each digest sees one half of the values
+            const double value = uniform(random);
+            (value < 0.5 ? left: right).Add(value);
+        }
+        left.Merge(right);
+
+        EXPECT_EQ(left.count(), 20000);
+        EXPECT_NEAR(left.mean(), 0.5, 0.01);
+        for (double q: {0.05, 0.25, 0.5, 0.75, 0.95})
+        {
+            EXPECT_NEAR(left.Quantile(q), q, 0.01) << "q " << q;
+        }
+    }
+
+    TEST(TDigestTest, WeightsValues)
+    {
+        TDigest digest;
+        digest.Add(1, 3);
+        digest.Add(5, 1);
+        EXPECT_EQ(digest.count(), 4);
+        EXPECT_EQ(digest.mean(), 2);
+        EXPECT_LT(digest.Quantile(0.25), digest.Quantile(0.9));
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,199 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Stand-in for the result collector: accepts the batches of UplinkSink and
+// stores them as session logs, <output_dir>/<session id>/<batch id>.mpsl.
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/session_log/session_log_reader.h"
+#include "mp_proctor/calculators/uplink/uplink_http.h"
+#include "mp_proctor/ingest/frame_protocol.h"
+
+ABSL_FLAG(int, port, 8080, "Port to listen on.");
+ABSL_FLAG(std::string, output_dir, "/tmp/uplink_batches",
+          "Directory receiving the session logs.");
+ABSL_FLAG(double, failure_rate, 0,
+          "Fraction of the requests answered with 503, to exercise the "
+          "spool and the retries of the sender.");
+
+constexpr size_t kMaxHeaderBytes = 16 << 10;
+constexpr size_t kMaxBodyBytes = 64 << 20;
+
+struct Request {
+  std::map<std::string, std::string> headers;
+  std::string body;
+};
+
+void Respond(int fd, int status, const std::string& reason) {
+  const std::string response = absl::StrCat(
+      "HTTP/1.1 ", status, " ", reason,
+      "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+  mediapipe::WriteFully(fd, response.data(), response.size());
+}
+
+absl::StatusOr<Request> ReadRequest(int fd) {
+  std::string data;
+  size_t header_end = std::string::npos;
+  char buffer[4096];
+  while ((header_end = data.find("\r\n\r\n")) == std::string::npos) {
+    RET_CHECK_LT(data.size(), kMaxHeaderBytes) << "Headers too large.";
+    const ssize_t count = read(fd, buffer, sizeof(buffer));
+    RET_CHECK_GT(count, 0) << "Connection closed.";
+    data.append(buffer, count);
+  }
+
+  Request request;
+  std::vector<std::string> lines =
+      absl::StrSplit(data.substr(0, header_end), "\r\n");
+  RET_CHECK(!lines.empty() && absl::StartsWith(lines[0], "POST "))
+      << "Only POST is supported.";
+  for (size_t i = 1; i < lines.size(); ++i) {
+    const size_t colon = lines[i].find(':');
+    if (colon == std::string::npos) continue;
+    request.headers[absl::AsciiStrToLower(lines[i].substr(0, colon))] =
+        std::string(absl::StripAsciiWhitespace(lines[i].substr(colon + 1)));
+  }
+
+  size_t content_length = 0;
+  RET_CHECK(absl::SimpleAtoi(request.headers["content-length"],
+                             &content_length) &&
+            content_length <= kMaxBodyBytes)
+      << "Missing or invalid Content-Length.";
+  request.body = data.substr(header_end + 4);
+  RET_CHECK_LE(request.body.size(), content_length);
+  const size_t received = request.body.size();
+  request.body.resize(content_length);
+  RET_CHECK(mediapipe::ReadFully(fd, &request.body[received],
+                                 content_length - received))
+      << "Connection closed.";
+  return request;
+}
+
+// Keeps the ids usable as file names.
+std::string SafeName(const std::string& name) {
+  std::string safe = name.empty() ? "unknown" : name;
+  for (char& c : safe) {
+    if (!absl::ascii_isalnum(c) && c != '-' && c != '_') c = '_';
+  }
+  return safe;
+}
+
+absl::Status StoreBatch(Request& request) {
+  uLongf raw_size = 0;
+  RET_CHECK(absl::SimpleAtoi(
+      request.headers[absl::AsciiStrToLower(mediapipe::kUplinkRawLengthHeader)],
+      &raw_size) && raw_size <= kMaxBodyBytes)
+      << "Missing or invalid raw length.";
+  std::string log(raw_size, '\0');
+  RET_CHECK_EQ(uncompress(reinterpret_cast<Bytef*>(&log[0]), &raw_size,
+                          reinterpret_cast<const Bytef*>(request.body.data()),
+                          request.body.size()),
+               Z_OK)
+      << "Could not decompress the batch.";
+  log.resize(raw_size);
+
+  const std::string dir = absl::StrCat(
+      absl::GetFlag(FLAGS_output_dir), "/",
+      SafeName(request.headers[absl::AsciiStrToLower(
+          mediapipe::kUplinkSessionHeader)]));
+  mkdir(absl::GetFlag(FLAGS_output_dir).c_str(), 0755);
+  mkdir(dir.c_str(), 0755);
+  const std::string path = absl::StrCat(
+      dir, "/",
+      SafeName(request.headers[absl::AsciiStrToLower(
+          mediapipe::kUplinkBatchHeader)]),
+      ".mpsl");
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(log.data(), log.size());
+    RET_CHECK(file.flush()) << "Could not write " << path;
+  }
+
+  ASSIGN_OR_RETURN(auto reader, mediapipe::SessionLogReader::Open(path));
+  LOG(INFO) << "Stored " << reader->row_count() << " results in " << path
+            << " (" << request.body.size() << " bytes compressed, "
+            << log.size() << " bytes raw).";
+  return absl::OkStatus();
+}
+
+absl::Status RunCollector() {
+  const int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  RET_CHECK_GE(listen_fd, 0);
+  int enable = 1;
+  setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(absl::GetFlag(FLAGS_port));
+  RET_CHECK(bind(listen_fd, reinterpret_cast<sockaddr*>(&address),
+                 sizeof(address)) == 0 &&
+            listen(listen_fd, SOMAXCONN) == 0)
+      << "Could not listen on port " << absl::GetFlag(FLAGS_port);
+  LOG(INFO) << "Collector listening on port " << absl::GetFlag(FLAGS_port);
+
+  std::mt19937 random(std::random_device{}());
+  std::uniform_real_distribution<double> uniform(0, 1);
+  while (true) {
+    const int fd = accept(listen_fd, nullptr, nullptr);
+    if (fd < 0) continue;
+    auto request = ReadRequest(fd);
+    if (!request.ok()) {
+      LOG(WARNING) << "Bad request: " << request.status();
+      Respond(fd, 400, "Bad Request");
+    } else if (uniform(random) < absl::GetFlag(FLAGS_failure_rate)) {
+      Respond(fd, 503, "Service Unavailable");
+    } else {
+      const absl::Status status = StoreBatch(*request);
+      if (status.ok()) {
+        Respond(fd, 200, "OK");
+      } else {
+        LOG(WARNING) << "Rejected batch: " << status;
+        Respond(fd, 400, "Bad Request");
+      }
+    }
+    close(fd);
+  }
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = RunCollector();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the collector: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
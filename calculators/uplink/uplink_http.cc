@@ -0,0 +1,179 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Minimal HTTP/1.1 client posting result batches to a collector
+#include "mp_proctor/calculators/uplink/uplink_http.h"
+
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        // Headers of the response beyond this size are ignored
+        constexpr size_t kMaxResponseBytes = 4096;
+
+        // Connects to the collector, the timeout applies to each send and receive
+        absl::StatusOr<int> Connect(const CollectorAddress& address, absl::Duration timeout)
+        {
+            addrinfo hints;
+            std::memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* addresses = nullptr;
+            const std::string port = absl::StrCat(address.port);
+            const int error = getaddrinfo(address.host.c_str(), port.c_str(), &hints, &addresses);
+            if (error != 0)
+            {
+                return absl::UnavailableError(absl::StrCat("Could not resolve ", address.host, ": ", gai_strerror(error)));
+            }
+
+            timeval timeout_value = absl::ToTimeval(timeout);
+            int fd = -1;
+            for (addrinfo* entry = addresses; entry != nullptr && fd < 0; entry = entry->ai_next)
+            {
+                fd = socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+                if (fd < 0) { continue; }
+                // Linux applies the send timeout to connect() as well
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout_value, sizeof(timeout_value));
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout_value, sizeof(timeout_value));
+                if (connect(fd, entry->ai_addr, entry->ai_addrlen) != 0)
+                {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+            freeaddrinfo(addresses);
+            if (fd < 0)
+            {
+                return absl::UnavailableError(absl::StrCat(
+                    "Could not connect to ", address.host, ":", address.port, ": ", std::strerror(errno)
+                ));
+            }
+            return fd;
+        }
+
+        // Unlike write(), a connection reset by the collector fails with
+        // EPIPE instead of raising SIGPIPE
+        bool SendFully(int fd, const char* data, size_t size)
+        {
+            while (size > 0)
+            {
+                const ssize_t count = send(fd, data, size, MSG_NOSIGNAL);
+                if (count < 0 && errno == EINTR) { continue; }
+                if (count <= 0) { return false; }
+                data += count;
+                size -= count;
+            }
+            return true;
+        }
+
+        // Client errors the collector gives the same answer to on a retry
+        bool IsPermanentStatus(int status)
+        { return status >= 400 && status < 500 && status != 408 && status != 429; }
+    } // namespace
+
+    absl::StatusOr<CollectorAddress> ParseCollectorUrl(const std::string& url)
+    {
+        constexpr char kScheme[] = "http://";
+        if (!absl::StartsWith(url, kScheme))
+        {
+            return absl::InvalidArgumentError("Only http:// collector URLs are supported: " + url);
+        }
+        CollectorAddress address;
+        std::string rest = url.substr(std::strlen(kScheme));
+        const size_t slash = rest.find('/');
+        if (slash != std::string::npos)
+        {
+            address.path = rest.substr(slash);
+            rest.resize(slash);
+        }
+        const size_t colon = rest.rfind(':');
+        if (colon != std::string::npos)
+        {
+            if (!absl::SimpleAtoi(rest.substr(colon + 1), &address.port) || address.port <= 0 || address.port > 65535)
+            {
+                return absl::InvalidArgumentError("Invalid port in " + url);
+            }
+            rest.resize(colon);
+        }
+        if (rest.empty()) { return absl::InvalidArgumentError("No host in " + url); }
+        address.host = rest;
+        return address;
+    }
+
+    absl::Status HttpPost(
+        const CollectorAddress& address, const std::map<std::string, std::string>& headers,
+        const std::string& body, absl::Duration timeout
+    )
+    {
+        ASSIGN_OR_RETURN(const int fd, Connect(address, timeout));
+
+        std::string request = absl::StrCat(
+            "POST ", address.path, " HTTP/1.1\r\n",
+            "Host: ", address.host, ":", address.port, "\r\n",
+            "Content-Length: ", body.size(), "\r\n",
+            "Connection: close\r\n"
+        );
+        for (const auto& header: headers) { absl::StrAppend(&request, header.first, ": ", header.second, "\r\n"); }
+        request += "\r\n";
+
+        if (!SendFully(fd, request.data(), request.size()) || !SendFully(fd, body.data(), body.size()))
+        {
+            close(fd);
+            return absl::UnavailableError("The collector closed the connection");
+        }
+
+        // Only the status line matters
+        std::string response;
+        char buffer[512];
+        while (response.find("\r\n") == std::string::npos && response.size() < kMaxResponseBytes)
+        {
+            const ssize_t count = read(fd, buffer, sizeof(buffer));
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { break; }
+            response.append(buffer, count);
+        }
+        close(fd);
+
+        int status = 0;
+        const size_t space = response.find(' ');
+        if (!absl::StartsWith(response, "HTTP/1.") || space == std::string::npos ||
+            !absl::SimpleAtoi(response.substr(space + 1, 3), &status))
+        {
+            return absl::UnavailableError("No response from the collector");
+        }
+        if (IsPermanentStatus(status))
+        {
+            return absl::InvalidArgumentError(absl::StrCat("The collector rejected the request with ", status));
+        }
+        if (status < 200 || status >= 300)
+        {
+            return absl::UnavailableError(absl::StrCat("The collector answered ", status));
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
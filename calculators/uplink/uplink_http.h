@@ -0,0 +1,63 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Minimal HTTP/1.1 client posting result batches to a collector
+#ifndef uplink_http_h
+#define uplink_http_h
+
+#include <map>
+#include <string>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe
+{
+    /**
+     * A batch is posted as a session log (session_log_format.h) compressed
+     * with zlib, i.e. "Content-Encoding: deflate", along with these headers.
+     */
+    constexpr char kUplinkContentType[]     = "application/x-mp-proctor-session-log";
+    constexpr char kUplinkSessionHeader[]   = "X-Session-Id";
+    constexpr char kUplinkBatchHeader[]     = "X-Batch-Id";
+    // Size of the session log before compression
+    constexpr char kUplinkRawLengthHeader[] = "X-Raw-Length";
+
+    struct CollectorAddress
+    {
+        std::string host;
+        int port = 80;
+        std::string path = "/";
+    };
+
+    // Parse "http://host[:port][/path]"
+    absl::StatusOr<CollectorAddress> ParseCollectorUrl(const std::string& url);
+
+    /**
+     * @brief POST body to the collector, failing if it does not answer with
+     *        a 2xx status within timeout
+     *
+     * Returns InvalidArgumentError if the collector rejected the request for
+     * good, i.e. with a 4xx status other than 408 and 429, and
+     * UnavailableError for failures worth a retry.
+     */
+    absl::Status HttpPost(
+        const CollectorAddress& address, const std::map<std::string, std::string>& headers,
+        const std::string& body, absl::Duration timeout
+    );
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,369 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Batched, compressed result uplink with a disk spool
+#include "mp_proctor/calculators/uplink/uplink_sink.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/time/clock.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mp_proctor/calculators/session_log/session_log_format.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        /**
+         * A spooled batch is stored as
+         *
+         *      fixed32 magic           kSpoolMagic
+         *      fixed64 raw_bytes
+         *      fixed64 closed_at_us
+         *      fixed32 session_id_size
+         *      bytes   session_id
+         *      bytes   body            Compressed session log
+         *
+         * in <spool_dir>/<batch id>.batch, the batch ids sorting by age.
+         */
+        constexpr uint32_t kSpoolMagic = 0x4255504d; // "MPUB"
+        constexpr char kSpoolExtension[] = ".batch";
+        constexpr char kTemporaryExtension[] = ".tmp";
+
+        // Wait of the worker while it has nothing to do
+        constexpr absl::Duration kIdleWait = absl::Milliseconds(500);
+
+        std::string SpoolPath(const std::string& dir, const std::string& id)
+        { return dir + "/" + id + kSpoolExtension; }
+
+        uint64_t FileSize(const std::string& path)
+        {
+            struct stat info;
+            return stat(path.c_str(), &info) == 0 ? info.st_size: 0;
+        }
+
+        absl::StatusOr<std::string> ReadFile(const std::string& path)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file) { return absl::NotFoundError("Could not read " + path); }
+            return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        bool ParseSpooledBatch(const std::string& bytes, std::string* session_id, uint64_t* raw_bytes, int64_t* closed_at_us, std::string* body)
+        {
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes.data());
+            constexpr size_t kFixedBytes = 4 + 8 + 8 + 4;
+            if (bytes.size() < kFixedBytes || GetFixed<uint32_t>(data) != kSpoolMagic) { return false; }
+            *raw_bytes = GetFixed<uint64_t>(data + 4);
+            *closed_at_us = GetFixed<int64_t>(data + 12);
+            const uint32_t session_size = GetFixed<uint32_t>(data + 20);
+            if (bytes.size() < kFixedBytes + session_size) { return false; }
+            session_id->assign(bytes, kFixedBytes, session_size);
+            body->assign(bytes, kFixedBytes + session_size, std::string::npos);
+            return true;
+        }
+    } // namespace
+
+    UplinkSink::UplinkSink(const UplinkSinkOptions& options, const CollectorAddress& address)
+        : m_options(options), m_address(address),
+          m_queue(options.queue_size, DropPolicy::kDropOldest), m_backoff(options.min_backoff)
+    {}
+
+    UplinkSink::~UplinkSink()
+    { this->Close(); }
+
+    absl::StatusOr<std::unique_ptr<UplinkSink>> UplinkSink::Create(const UplinkSinkOptions& options)
+    {
+        ASSIGN_OR_RETURN(const CollectorAddress address, ParseCollectorUrl(options.collector_url));
+        RET_CHECK_GT(options.max_batch_rows, 0);
+        RET_CHECK_GT(options.queue_size, 0);
+        RET_CHECK(options.compression_level >= 1 && options.compression_level <= 9);
+
+        std::unique_ptr<UplinkSink> sink(new UplinkSink(options, address));
+        if (!options.spool_dir.empty())
+        {
+            mkdir(options.spool_dir.c_str(), 0755);
+            DIR* dir = opendir(options.spool_dir.c_str());
+            if (dir == nullptr) { return absl::NotFoundError("Could not open the spool " + options.spool_dir); }
+            for (dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+            {
+                const std::string name = entry->d_name;
+                const std::string path = options.spool_dir + "/" + name;
+                // Left by a crash while spooling
+                if (absl::EndsWith(name, kTemporaryExtension)) { std::remove(path.c_str()); }
+                if (!absl::EndsWith(name, kSpoolExtension)) { continue; }
+                sink->m_spool_files.push_back(name.substr(0, name.size() - std::strlen(kSpoolExtension)));
+            }
+            closedir(dir);
+            std::sort(sink->m_spool_files.begin(), sink->m_spool_files.end());
+
+            absl::MutexLock lock(&sink->m_mutex);
+            for (const auto& id: sink->m_spool_files)
+            {
+                sink->m_metrics.spool_bytes += FileSize(SpoolPath(options.spool_dir, id));
+            }
+            sink->m_metrics.spool_batches = sink->m_spool_files.size();
+        }
+        sink->m_worker = std::thread(&UplinkSink::Run, sink.get());
+        return sink;
+    }
+
+    bool UplinkSink::Add(int64_t timestamp_us, std::vector<ProctorResult> results)
+    { return m_queue.Push({timestamp_us, std::move(results)}); }
+
+    UplinkMetrics UplinkSink::metrics() const
+    {
+        absl::MutexLock lock(&m_mutex);
+        UplinkMetrics metrics = m_metrics;
+        metrics.frames_dropped = m_queue.dropped();
+        return metrics;
+    }
+
+    void UplinkSink::Close()
+    {
+        m_queue.Close();
+        if (m_worker.joinable()) { m_worker.join(); }
+    }
+
+    absl::StatusOr<UplinkSink::Batch> UplinkSink::Encode(const std::vector<Frame>& frames)
+    {
+        char* buffer = nullptr;
+        size_t size = 0;
+        FILE* stream = open_memstream(&buffer, &size);
+        if (stream == nullptr) { return absl::InternalError("open_memstream failed"); }
+        absl::Status status;
+        {
+            auto writer = SessionLogWriter::Open(stream, m_options.log_options);
+            if (!writer.ok())
+            {
+                std::free(buffer);
+                return writer.status();
+            }
+            for (const auto& frame: frames)
+            {
+                if (status.ok()) { status = (*writer)->Append(frame.timestamp_us, frame.results); }
+            }
+            // Closes the stream, which sets buffer and size
+            const absl::Status close_status = (*writer)->Close();
+            if (status.ok()) { status = close_status; }
+        }
+        const std::string log(buffer, size);
+        std::free(buffer);
+        MP_RETURN_IF_ERROR(status);
+
+        Batch batch;
+        batch.session_id = m_options.session_id;
+        batch.closed_at_us = absl::ToUnixMicros(absl::Now());
+        batch.id = absl::StrFormat("%016x-%06d", batch.closed_at_us, m_batch_sequence++ % 1000000);
+        batch.raw_bytes = log.size();
+        uLongf compressed_size = compressBound(log.size());
+        batch.body.resize(compressed_size);
+        const int result = compress2(
+            reinterpret_cast<Bytef*>(&batch.body[0]), &compressed_size,
+            reinterpret_cast<const Bytef*>(log.data()), log.size(), m_options.compression_level
+        );
+        if (result != Z_OK) { return absl::InternalError(absl::StrCat("zlib error ", result)); }
+        batch.body.resize(compressed_size);
+        return batch;
+    }
+
+    absl::Status UplinkSink::Send(const Batch& batch)
+    {
+        const std::map<std::string, std::string> headers = {
+            {"Content-Type", kUplinkContentType},
+            {"Content-Encoding", "deflate"},
+            {kUplinkSessionHeader, batch.session_id},
+            {kUplinkBatchHeader, batch.id},
+            {kUplinkRawLengthHeader, absl::StrCat(batch.raw_bytes)},
+        };
+        const absl::Status status = HttpPost(m_address, headers, batch.body, m_options.timeout);
+        absl::MutexLock lock(&m_mutex);
+        if (!status.ok())
+        {
+            ++m_metrics.failed_requests;
+            return status;
+        }
+        m_metrics.bytes_sent += batch.body.size();
+        m_metrics.raw_bytes_sent += batch.raw_bytes;
+        m_metrics.batches_sent += 1;
+        m_metrics.last_batch_latency_ms = (absl::ToUnixMicros(absl::Now()) - batch.closed_at_us) / 1000.0;
+        m_metrics.max_batch_latency_ms = std::max(m_metrics.max_batch_latency_ms, m_metrics.last_batch_latency_ms);
+        return absl::OkStatus();
+    }
+
+    void UplinkSink::Spool(const Batch& batch)
+    {
+        if (m_options.spool_dir.empty())
+        {
+            absl::MutexLock lock(&m_mutex);
+            ++m_metrics.batches_dropped;
+            return;
+        }
+
+        std::string bytes;
+        PutFixed(kSpoolMagic, &bytes);
+        PutFixed(batch.raw_bytes, &bytes);
+        PutFixed(batch.closed_at_us, &bytes);
+        PutFixed(static_cast<uint32_t>(batch.session_id.size()), &bytes);
+        bytes += batch.session_id;
+        bytes += batch.body;
+
+        // Written aside first, so that a crash never leaves a partial batch
+        const std::string path = SpoolPath(m_options.spool_dir, batch.id);
+        const std::string temporary_path = path + kTemporaryExtension;
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), bytes.size());
+            if (!file.flush())
+            {
+                LOG(ERROR) << "Could not spool batch " << batch.id;
+                std::remove(temporary_path.c_str());
+                absl::MutexLock lock(&m_mutex);
+                ++m_metrics.batches_dropped;
+                return;
+            }
+        }
+        std::rename(temporary_path.c_str(), path.c_str());
+        m_spool_files.push_back(batch.id);
+
+        absl::MutexLock lock(&m_mutex);
+        m_metrics.spool_bytes += bytes.size();
+        while (m_metrics.spool_bytes > m_options.max_spool_bytes && m_spool_files.size() > 1)
+        {
+            const std::string oldest = SpoolPath(m_options.spool_dir, m_spool_files.front());
+            m_metrics.spool_bytes -= std::min(m_metrics.spool_bytes, FileSize(oldest));
+            std::remove(oldest.c_str());
+            m_spool_files.pop_front();
+            ++m_metrics.batches_dropped;
+        }
+        m_metrics.spool_batches = m_spool_files.size();
+    }
+
+    void UplinkSink::Drop(const Batch& batch, const absl::Status& status)
+    {
+        LOG(ERROR) << "Dropping batch " << batch.id << ": " << status.message();
+        absl::MutexLock lock(&m_mutex);
+        ++m_metrics.batches_dropped;
+    }
+
+    absl::Status UplinkSink::SendSpooled()
+    {
+        while (!m_spool_files.empty())
+        {
+            const std::string path = SpoolPath(m_options.spool_dir, m_spool_files.front());
+            const uint64_t size = FileSize(path);
+            auto bytes = ReadFile(path);
+            Batch batch;
+            batch.id = m_spool_files.front();
+            if (bytes.ok() &&
+                !ParseSpooledBatch(*bytes, &batch.session_id, &batch.raw_bytes, &batch.closed_at_us, &batch.body))
+            {
+                LOG(ERROR) << "Dropping the corrupted spooled batch " << path;
+                bytes = absl::DataLossError(path);
+            }
+            if (bytes.ok())
+            {
+                const absl::Status status = this->Send(batch);
+                if (absl::IsInvalidArgument(status)) { this->Drop(batch, status); }
+                else { MP_RETURN_IF_ERROR(status); }
+            }
+
+            std::remove(path.c_str());
+            m_spool_files.pop_front();
+            absl::MutexLock lock(&m_mutex);
+            m_metrics.spool_bytes -= std::min(m_metrics.spool_bytes, size);
+            m_metrics.spool_batches = m_spool_files.size();
+        }
+        return absl::OkStatus();
+    }
+
+    void UplinkSink::OnFailure()
+    {
+        m_next_attempt = absl::Now() + m_backoff;
+        m_backoff = std::min(m_backoff * 2, m_options.max_backoff);
+    }
+
+    void UplinkSink::Run()
+    {
+        std::vector<Frame> frames;
+        int rows = 0;
+        absl::Time deadline = absl::InfiniteFuture();
+        while (true)
+        {
+            const absl::Time now = absl::Now();
+            absl::Time wake_up = std::min(deadline, now + kIdleWait);
+            if (!m_spool_files.empty()) { wake_up = std::min(wake_up, m_next_attempt); }
+
+            Frame frame;
+            const bool has_frame = m_queue.PopFor(&frame, std::max(wake_up - now, absl::ZeroDuration()));
+            const bool is_closing = !has_frame && m_queue.closed();
+            if (has_frame)
+            {
+                if (frames.empty()) { deadline = absl::Now() + m_options.max_batch_delay; }
+                rows += frame.results.size();
+                frames.push_back(std::move(frame));
+            }
+
+            const bool is_due = rows >= m_options.max_batch_rows || absl::Now() >= deadline || is_closing;
+            if (!frames.empty() && is_due)
+            {
+                // Frames without faces add no rows, and batches without rows are not sent
+                auto batch = rows > 0 ? this->Encode(frames): absl::StatusOr<Batch>(absl::CancelledError());
+                frames.clear();
+                rows = 0;
+                deadline = absl::InfiniteFuture();
+
+                if (!batch.ok())
+                {
+                    LOG_IF(ERROR, !absl::IsCancelled(batch.status())) << "Could not encode a batch: " << batch.status();
+                }
+                // Older spooled batches go first
+                else if (!m_spool_files.empty() || absl::Now() < m_next_attempt) { this->Spool(*batch); }
+                else
+                {
+                    const absl::Status status = this->Send(*batch);
+                    if (status.ok()) { m_backoff = m_options.min_backoff; }
+                    else if (absl::IsInvalidArgument(status)) { this->Drop(*batch, status); }
+                    else
+                    {
+                        this->OnFailure();
+                        this->Spool(*batch);
+                    }
+                }
+            }
+
+            if (!m_spool_files.empty() && absl::Now() >= m_next_attempt)
+            {
+                if (this->SendSpooled().ok()) { m_backoff = m_options.min_backoff; }
+                else { this->OnFailure(); }
+            }
+            if (is_closing) { break; }
+        }
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,165 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Batched, compressed result uplink with a disk spool
+#ifndef uplink_sink_h
+#define uplink_sink_h
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/bounded_queue.h"
+#include "mp_proctor/calculators/session_log/session_log_writer.h"
+#include "mp_proctor/calculators/uplink/uplink_http.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of UplinkSink
+     */
+    struct UplinkSinkOptions
+    {
+        // e.g. "http://collector:8080/results"
+        std::string collector_url;
+        std::string session_id;
+
+        // A batch is sent once it holds max_batch_rows results, or once its
+        // first result is max_batch_delay old
+        int max_batch_rows = 1024;
+        absl::Duration max_batch_delay = absl::Seconds(5);
+        // Frames waiting for the worker, the oldest are dropped beyond it
+        int queue_size = 300;
+        // zlib level, 1 (fastest) to 9 (smallest)
+        int compression_level = 6;
+        // Encoding of the results in the batches
+        SessionLogWriterOptions log_options;
+
+        // Directory keeping the batches the collector did not take, empty
+        // to drop them. The oldest batches are dropped beyond max_spool_bytes.
+        std::string spool_dir;
+        uint64_t max_spool_bytes = 64 << 20;
+
+        // Timeout of each send and receive of a request
+        absl::Duration timeout = absl::Seconds(5);
+        // Wait after a failed request, doubled after each further failure
+        absl::Duration min_backoff = absl::Seconds(1);
+        absl::Duration max_backoff = absl::Seconds(60);
+    };
+
+    /**
+     * @brief Counters of UplinkSink
+     */
+    struct UplinkMetrics
+    {
+        // Compressed bytes and batches taken by the collector
+        uint64_t bytes_sent = 0;
+        uint64_t batches_sent = 0;
+        // Session log bytes of these batches, before compression
+        uint64_t raw_bytes_sent = 0;
+        uint64_t failed_requests = 0;
+        // Batches dropped because the spool was full or disabled, or because
+        // the collector rejected them
+        uint64_t batches_dropped = 0;
+        // Frames dropped because the worker fell behind
+        uint64_t frames_dropped = 0;
+        // Time from closing a batch to the collector taking it
+        double last_batch_latency_ms = 0;
+        double max_batch_latency_ms = 0;
+        // Batches and bytes waiting in the spool
+        uint64_t spool_batches = 0;
+        uint64_t spool_bytes = 0;
+    };
+
+    /**
+     * @brief Sends the results to an HTTP collector in compressed batches
+     *
+     * A worker thread batches, compresses and posts the results; Add() only
+     * queues them and never blocks. While the collector is unreachable, the
+     * batches are kept in the spool and retried oldest first with an
+     * exponential backoff. Spooled batches left by an earlier run are sent
+     * as well. Batches the collector rejects for good, e.g. with a 400, are
+     * dropped rather than retried, so they never hold back the spool.
+     */
+    class UplinkSink
+    {
+    private:
+        struct Frame
+        {
+            int64_t timestamp_us;
+            std::vector<ProctorResult> results;
+        };
+        struct Batch
+        {
+            std::string id;
+            std::string session_id;
+            // Wall time the batch was closed
+            int64_t closed_at_us;
+            uint64_t raw_bytes;
+            std::string body;
+        };
+
+        UplinkSinkOptions m_options;
+        CollectorAddress m_address;
+        BoundedQueue<Frame> m_queue;
+        std::thread m_worker;
+
+        // Owned by the worker
+        std::deque<std::string> m_spool_files;
+        absl::Time m_next_attempt = absl::InfinitePast();
+        absl::Duration m_backoff;
+        uint64_t m_batch_sequence = 0;
+
+        mutable absl::Mutex m_mutex;
+        UplinkMetrics m_metrics ABSL_GUARDED_BY(m_mutex);
+
+        UplinkSink(const UplinkSinkOptions& options, const CollectorAddress& address);
+
+        void Run();
+        absl::StatusOr<Batch> Encode(const std::vector<Frame>& frames);
+        absl::Status Send(const Batch& batch);
+        void Spool(const Batch& batch);
+        void Drop(const Batch& batch, const absl::Status& status);
+        absl::Status SendSpooled();
+        void OnFailure();
+
+    public:
+        ~UplinkSink();
+
+        UplinkSink(const UplinkSink&) = delete;
+        UplinkSink& operator=(const UplinkSink&) = delete;
+
+        static absl::StatusOr<std::unique_ptr<UplinkSink>> Create(const UplinkSinkOptions& options);
+
+        // Queue the results of a frame, returns false if a frame was dropped
+        bool Add(int64_t timestamp_us, std::vector<ProctorResult> results);
+
+        UplinkMetrics metrics() const;
+
+        // Send or spool the queued results and stop the worker
+        void Close();
+    };
+
+} // namespace mediapipe
+
+#endif
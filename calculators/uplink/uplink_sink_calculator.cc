@@ -0,0 +1,167 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to ship ProctorResults to a collector in compressed batches
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/calculators/uplink/uplink_sink.h"
+#include "mp_proctor/calculators/uplink/uplink_sink_calculator.pb.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]   = "RESULTS";
+        constexpr char kMetricsTag[]   = "METRICS";
+        constexpr char kSessionIdTag[] = "SESSION_ID";
+    } // namespace
+
+    /**
+     * @brief Send the proctor results to an HTTP collector in batches of
+     *        zlib compressed session logs (see session_log_format.h)
+     *
+     * Batching, compression and requests run on a worker thread, Process()
+     * only queues the results and never blocks. While the collector is
+     * unreachable, the batches are kept in spool_dir and retried.
+     *
+     * INPUTS:
+     *      RESULTS - Results of a frame (std::vector<ProctorResult>)
+     * OUTPUTS:
+     *      METRICS - Optional counters of the uplink every metrics_interval_ms (UplinkMetrics)
+     * INPUT SIDE PACKETS:
+     *      SESSION_ID - Optional session id, overriding the options (std::string)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "UplinkSinkCalculator"
+     *   input_stream: "RESULTS:multi_face_proctor_results"
+     *   input_side_packet: "SESSION_ID:session_id"
+     *   node_options: {
+     *     [type.googleapis.com/mediapipe.UplinkSinkCalculatorOptions] {
+     *       collector_url: "http://collector:8080/results"
+     *       spool_dir: "/var/spool/mp_proctor"
+     *     }
+     *   }
+     * }
+     *
+     */
+    class UplinkSinkCalculator: public CalculatorBase
+    {
+    private:
+        std::unique_ptr<UplinkSink> m_sink;
+        int64 m_metrics_interval_us = 0;
+        Timestamp m_last_metrics = Timestamp::Unset();
+
+    public:
+        UplinkSinkCalculator() = default;
+        ~UplinkSinkCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(UplinkSinkCalculator);
+
+    absl::Status UplinkSinkCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->Outputs().HasTag(kMetricsTag))
+        {
+            cc->Outputs().Tag(kMetricsTag).Set<UplinkMetrics>();
+        }
+        if (cc->InputSidePackets().HasTag(kSessionIdTag))
+        {
+            cc->InputSidePackets().Tag(kSessionIdTag).Set<std::string>().Optional();
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status UplinkSinkCalculator::Open(CalculatorContext* cc)
+    {
+        const auto& options = cc->Options<UplinkSinkCalculatorOptions>();
+        if (options.max_batch_delay_ms() <= 0 || options.timeout_ms() <= 0 || options.max_spool_mb() < 0)
+        {
+            return absl::InvalidArgumentError("UplinkSinkCalculator: invalid delays or spool size!");
+        }
+        if (options.min_backoff_ms() <= 0 || options.max_backoff_ms() < options.min_backoff_ms())
+        {
+            return absl::InvalidArgumentError("UplinkSinkCalculator: invalid backoff!");
+        }
+
+        UplinkSinkOptions sink_options;
+        sink_options.collector_url = options.collector_url();
+        sink_options.session_id = options.session_id();
+        if (cc->InputSidePackets().HasTag(kSessionIdTag) &&
+            !cc->InputSidePackets().Tag(kSessionIdTag).IsEmpty())
+        {
+            sink_options.session_id = cc->InputSidePackets().Tag(kSessionIdTag).Get<std::string>();
+        }
+        sink_options.max_batch_rows = options.max_batch_rows();
+        sink_options.max_batch_delay = absl::Milliseconds(options.max_batch_delay_ms());
+        sink_options.queue_size = options.queue_size();
+        sink_options.compression_level = options.compression_level();
+        sink_options.log_options.embedding_encoding = static_cast<SessionLogEmbeddingEncoding>(options.embedding_encoding());
+        sink_options.log_options.top_k_expressions = options.top_k_expressions();
+        sink_options.spool_dir = options.spool_dir();
+        sink_options.max_spool_bytes = static_cast<uint64_t>(options.max_spool_mb()) << 20;
+        sink_options.timeout = absl::Milliseconds(options.timeout_ms());
+        sink_options.min_backoff = absl::Milliseconds(options.min_backoff_ms());
+        sink_options.max_backoff = absl::Milliseconds(options.max_backoff_ms());
+        ASSIGN_OR_RETURN(m_sink, UplinkSink::Create(sink_options));
+
+        m_metrics_interval_us = static_cast<int64>(options.metrics_interval_ms()) * 1000;
+        return absl::OkStatus();
+    }
+
+    absl::Status UplinkSinkCalculator::Process(CalculatorContext* cc)
+    {
+        m_sink->Add(
+            cc->InputTimestamp().Value(),
+            cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>()
+        );
+
+        if (cc->Outputs().HasTag(kMetricsTag) &&
+            (m_last_metrics == Timestamp::Unset() ||
+             (cc->InputTimestamp() - m_last_metrics).Value() >= m_metrics_interval_us))
+        {
+            m_last_metrics = cc->InputTimestamp();
+            cc->Outputs().Tag(kMetricsTag).AddPacket(MakePacket<UplinkMetrics>(m_sink->metrics()).At(cc->InputTimestamp()));
+        }
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status UplinkSinkCalculator::Close(CalculatorContext* cc)
+    {
+        if (!m_sink) { return absl::OkStatus(); }
+        m_sink->Close();
+        const UplinkMetrics metrics = m_sink->metrics();
+        LOG(INFO) << "Uplink: " << metrics.batches_sent << " batches, " << metrics.bytes_sent << " bytes sent, "
+            << metrics.spool_batches << " batches spooled, " << metrics.batches_dropped << " batches and "
+            << metrics.frames_dropped << " frames dropped";
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
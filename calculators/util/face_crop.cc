@@ -0,0 +1,83 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Face alignment to the crop of the face re-identification
+#include "mp_proctor/calculators/util/face_crop.h"
+
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+#include "face_align.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        // Iris, nose tip and mouth corner landmarks of face mesh
+        constexpr int kAlignmentLandmarkCount = 478;
+
+        cv::Point2f IrisCenter(const NormalizedLandmarkList& landmarks, int first, int width, int height)
+        {
+            float x = 0, y = 0;
+            for (int i = first; i < first + 4; ++i)
+            {
+                x += landmarks.landmark(i).x();
+                y += landmarks.landmark(i).y();
+            }
+            return cv::Point2f(x * width / 4, y * height / 4);
+        }
+    } // namespace
+
+    bool FaceAlignmentTransform(
+        const NormalizedLandmarkList& landmarks, int width, int height, cv::Mat* transform
+    )
+    {
+        if (landmarks.landmark_size() < kAlignmentLandmarkCount) { return false; }
+
+        const cv::Point2f left_eye = IrisCenter(landmarks, 469, width, height);
+        const cv::Point2f right_eye = IrisCenter(landmarks, 474, width, height);
+        float facial_points[5][2] = {
+            {left_eye.x, left_eye.y},
+            {right_eye.x, right_eye.y},
+            {landmarks.landmark(1).x() * width, landmarks.landmark(1).y() * height},
+            {landmarks.landmark(61).x() * width, landmarks.landmark(61).y() * height},
+            {landmarks.landmark(291).x() * width, landmarks.landmark(291).y() * height}
+        };
+        cv::Mat facial_transform(5, 2, CV_32F, facial_points);
+        // Reference points of the 112x112 crop
+        float reference_points[5][2] = {
+            {38.29459953, 51.69630051}, // left eye
+            {73.53179932, 51.50139999}, // right eye
+            {56.02519989, 71.73660278}, // nose
+            {41.54930115, 92.3655014 }, // left mouth
+            {70.72990036, 92.20410156}  // right mouth
+        };
+        cv::Mat reference_transform(5, 2, CV_32F, reference_points);
+        *transform = FacePreprocess::similarTransform(facial_transform, reference_transform)(cv::Rect(0, 0, 3, 2)).clone();
+        return true;
+    }
+
+    bool AlignedFaceCrop(
+        const cv::Mat& image, const NormalizedLandmarkList& landmarks, int size, cv::Mat* crop
+    )
+    {
+        cv::Mat transform;
+        if (!FaceAlignmentTransform(landmarks, image.cols, image.rows, &transform)) { return false; }
+        // The reference points are those of the 112x112 crop
+        transform *= static_cast<float>(size) / kAlignedFaceSize;
+        cv::warpAffine(image, *crop, transform, cv::Size(size, size), cv::INTER_LINEAR, cv::BORDER_CONSTANT);
+        return true;
+    }
+
+} // namespace mediapipe
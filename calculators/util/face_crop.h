@@ -0,0 +1,49 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Face alignment to the crop of the face re-identification
+#ifndef face_crop_h
+#define face_crop_h
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe
+{
+    // Side of the aligned crop of face_reid_cpu.pbtxt
+    constexpr int kAlignedFaceSize = 112;
+
+    /**
+     * @brief Similarity transform (2x3 CV_32F) from the pixels of a width x
+     *        height image to the kAlignedFaceSize aligned crop, mapping the
+     *        irises, nose tip and mouth corners to their reference points
+     *
+     * Returns false without the iris landmarks (478 landmarks).
+     */
+    bool FaceAlignmentTransform(
+        const NormalizedLandmarkList& landmarks, int width, int height, cv::Mat* transform
+    );
+
+    /**
+     * @brief Aligned size x size crop of the face, as produced by
+     *        SimilarityTransformCalculator and WarpAffineCalculatorCpu for
+     *        size kAlignedFaceSize
+     */
+    bool AlignedFaceCrop(
+        const cv::Mat& image, const NormalizedLandmarkList& landmarks, int size, cv::Mat* crop
+    );
+
+} // namespace mediapipe
+
+#endif
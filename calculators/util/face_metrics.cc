@@ -0,0 +1,119 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Facial metrics computed from the landmarks of a face
+#include "mp_proctor/calculators/util/face_metrics.h"
+
+#include <cmath>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr int kAxes = 3;
+
+        // Landmarks used by the metrics
+        constexpr int kUpperLip         = 0;
+        constexpr int kNoseTip          = 1;
+        constexpr int kRightUpperEyelid = 386;
+        constexpr int kRightLowerEyelid = 374;
+        constexpr int kLeftUpperEyelid  = 159;
+        constexpr int kLeftLowerEyelid  = 145;
+
+        double PlanarDistance(const FaceCoordinates& landmarks, int a, int b)
+        {
+            const double dx = static_cast<double>(landmarks[a * kAxes]) - landmarks[b * kAxes];
+            const double dy = static_cast<double>(landmarks[a * kAxes + 1]) - landmarks[b * kAxes + 1];
+            return std::sqrt(dx * dx + dy * dy);
+        }
+    } // namespace
+
+    void LandmarksToCoordinates(const NormalizedLandmarkList& landmarks, FaceCoordinates* coordinates)
+    {
+        coordinates->clear();
+        coordinates->reserve(landmarks.landmark_size() * kAxes);
+        for (const auto& landmark: landmarks.landmark())
+        {
+            coordinates->push_back(landmark.x());
+            coordinates->push_back(landmark.y());
+            coordinates->push_back(landmark.z());
+        }
+    }
+
+    void StandardizeLandmarks(const FaceCoordinates& landmarks, FaceCoordinates* standardized)
+    {
+        const size_t count = landmarks.size() / kAxes;
+        standardized->resize(count * kAxes);
+        for (int axis = 0; axis < kAxes; ++axis)
+        {
+            double sum = 0;
+            for (size_t i = 0; i < count; ++i) { sum += landmarks[i * kAxes + axis]; }
+            const double mean = sum / count;
+            double square_sum = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                const double deviation = landmarks[i * kAxes + axis] - mean;
+                square_sum += deviation * deviation;
+            }
+            // Population standard deviation, as cv::meanStdDev
+            const double std = std::sqrt(square_sum / count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                (*standardized)[i * kAxes + axis] = static_cast<float>((landmarks[i * kAxes + axis] - mean) / std);
+            }
+        }
+    }
+
+    FaceOrientationMetrics ComputeFaceOrientation(const FaceCoordinates& std_landmarks)
+    {
+        return {std_landmarks[kNoseTip * kAxes], std_landmarks[kNoseTip * kAxes + 1]};
+    }
+
+    EyeBlinkMetrics ComputeEyeBlink(const FaceCoordinates& std_landmarks)
+    {
+        const double x = std_landmarks[kNoseTip * kAxes];
+        const double y = std_landmarks[kNoseTip * kAxes + 1];
+        EyeBlinkMetrics blink;
+        blink.left = PlanarDistance(std_landmarks, kLeftUpperEyelid, kLeftLowerEyelid);
+        blink.right = PlanarDistance(std_landmarks, kRightUpperEyelid, kRightLowerEyelid);
+        blink.threshold = (-0.0228 * x) + (0.0162 * y) + (0.0792 * std::exp(y * y));
+        return blink;
+    }
+
+    double ComputeFaceMovement(const FaceCoordinates& previous, const FaceCoordinates& landmarks)
+    {
+        double square_sum = 0;
+        for (int axis = 0; axis < kAxes; ++axis)
+        {
+            const float from = previous.empty() ? 0.0f: previous[kUpperLip * kAxes + axis];
+            const double delta = landmarks[kUpperLip * kAxes + axis] - from;
+            square_sum += delta * delta;
+        }
+        return std::sqrt(square_sum);
+    }
+
+    double ComputeFacialActivity(const FaceCoordinates& previous_std, const FaceCoordinates& std_landmarks)
+    {
+        if (previous_std.size() != std_landmarks.size()) { return 0; }
+        double square_sum = 0;
+        for (size_t i = 0; i < std_landmarks.size(); ++i)
+        {
+            const double delta = static_cast<double>(std_landmarks[i]) - previous_std[i];
+            square_sum += delta * delta;
+        }
+        return std::sqrt(square_sum);
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,76 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Facial metrics computed from the landmarks of a face
+#ifndef face_metrics_h
+#define face_metrics_h
+
+#include <vector>
+
+#include "mediapipe/framework/formats/landmark.pb.h"
+
+namespace mediapipe
+{
+    // Landmarks of a face, x y z of each landmark in turn, as stored in
+    // LandmarkFaces (landmark_codec.h)
+    using FaceCoordinates = std::vector<float>;
+
+    struct FaceOrientationMetrics
+    {
+        double horizontal_align;
+        double vertical_align;
+    };
+
+    struct EyeBlinkMetrics
+    {
+        // Lower values mean the eye is closing
+        double left;
+        double right;
+        // An eye is blinking if its value is below the threshold
+        double threshold;
+    };
+
+    void LandmarksToCoordinates(const NormalizedLandmarkList& landmarks, FaceCoordinates* coordinates);
+
+    /**
+     * @brief z-score standardize each axis over the landmarks of a face
+     *        (LandmarkStandardizationCalculator)
+     */
+    void StandardizeLandmarks(const FaceCoordinates& landmarks, FaceCoordinates* standardized);
+
+    // Orientation from the standardized landmarks (FaceOrientationCalculator)
+    FaceOrientationMetrics ComputeFaceOrientation(const FaceCoordinates& std_landmarks);
+
+    // Eye openness from the standardized landmarks (EyeBlinkCalculator)
+    EyeBlinkMetrics ComputeEyeBlink(const FaceCoordinates& std_landmarks);
+
+    /**
+     * @brief Displacement of the upper lip since the previous frame of the
+     *        face (FaceMovementCalculator)
+     *
+     * An empty previous frame stands for the origin.
+     */
+    double ComputeFaceMovement(const FaceCoordinates& previous, const FaceCoordinates& landmarks);
+
+    /**
+     * @brief L2 norm of the change of the standardized landmarks since the
+     *        previous frame of the face (FaceActivityCalculator)
+     *
+     * 0 for an empty previous frame or a different landmark count.
+     */
+    double ComputeFacialActivity(const FaceCoordinates& previous_std, const FaceCoordinates& std_landmarks);
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,242 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to skip unchanged frames and report frozen feeds
+#include <deque>
+#include <unordered_map>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/timestamp.h"
+#include "mp_proctor/calculators/util/frame_change_gate_calculator.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kImageTag[]    = "IMAGE";
+        constexpr char kSkipTag[]     = "SKIP";
+        constexpr char kFrozenTag[]   = "FROZEN";
+
+        // FNV-1a over the thumbnail bytes
+        uint64 HashThumbnail(const cv::Mat& thumbnail)
+        {
+            uint64 hash = 14695981039346656037ULL;
+            for (int row = 0; row < thumbnail.rows; row++)
+            {
+                const uint8* data = thumbnail.ptr<uint8>(row);
+                for (int col = 0; col < thumbnail.cols; col++)
+                {
+                    hash ^= data[col];
+                    hash *= 1099511628211ULL;
+                }
+            }
+            return hash;
+        }
+    } // namespace
+
+    /**
+     * @brief Skip frames that are identical or nearly identical to the last
+     *        analyzed frame, before any face detection runs
+     *
+     * Frames are compared on a downsampled luma thumbnail, first by hash and
+     * then by mean absolute difference. Unchanged frames are answered with a
+     * SKIP tick, so that ProctorResultCarryForwardCalculator can reuse the
+     * previous results. Thumbnails repeating recently seen content, e.g. a
+     * frozen webcam or a looping virtual camera, are reported on FROZEN once
+     * the repetition lasts longer than frozen_seconds.
+     *
+     * Place it after FlowLimiterCalculator, so that every forwarded frame is
+     * analyzed and becomes the reference, and merge SKIP into the FINISHED
+     * back edge of the limiter with FrameFinishedCalculator, since
+     * unchanged frames never reach the end of the graph.
+     *
+     * INPUTS:
+     *      IMAGE - Input frame (ImageFrame)
+     * OUTPUTS:
+     *      IMAGE - Changed frames (ImageFrame)
+     *      SKIP - Timestamps of the unchanged frames (bool)
+     *      FROZEN - Optional, true when a frozen feed starts, false when it ends (bool)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "FrameChangeGateCalculator"
+     *   input_stream: "IMAGE:limited_input_video"
+     *   output_stream: "IMAGE:throttled_input_video"
+     *   output_stream: "SKIP:unchanged_frame"
+     *   output_stream: "FROZEN:frozen_feed"
+     * }
+     *
+     */
+    class FrameChangeGateCalculator: public CalculatorBase
+    {
+    private:
+        FrameChangeGateCalculatorOptions m_options;
+
+        // Thumbnail of the last forwarded frame
+        cv::Mat m_reference;
+        uint64 m_reference_hash = 0;
+
+        std::deque<uint64> m_hashes;
+        std::unordered_map<uint64, int> m_hash_counts;
+
+        Timestamp m_repeat_start = Timestamp::Unset();
+        bool m_is_frozen = false;
+
+        cv::Mat MakeThumbnail(const ImageFrame& frame) const;
+        bool IsRepeated(uint64 hash);
+        void UpdateFrozen(CalculatorContext* cc, bool is_repeated);
+
+    public:
+        FrameChangeGateCalculator() = default;
+        ~FrameChangeGateCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(FrameChangeGateCalculator);
+
+    absl::Status FrameChangeGateCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kImageTag).Set<ImageFrame>();
+        cc->Outputs().Tag(kImageTag).Set<ImageFrame>();
+        cc->Outputs().Tag(kSkipTag).Set<bool>();
+        if (cc->Outputs().HasTag(kFrozenTag))
+        {
+            cc->Outputs().Tag(kFrozenTag).Set<bool>();
+        }
+
+        // Skipped frames still advance the bound of the forwarded frames
+        cc->SetTimestampOffset(TimestampDiff(0));
+        return absl::OkStatus();
+    }
+
+    absl::Status FrameChangeGateCalculator::Open(CalculatorContext* cc)
+    {
+        m_options = cc->Options<FrameChangeGateCalculatorOptions>();
+        if (m_options.thumbnail_width() <= 0 || m_options.thumbnail_height() <= 0)
+        {
+            return absl::InvalidArgumentError("FrameChangeGateCalculator: Invalid thumbnail size!");
+        }
+        return absl::OkStatus();
+    }
+
+    cv::Mat FrameChangeGateCalculator::MakeThumbnail(const ImageFrame& frame) const
+    {
+        const cv::Mat frame_mat = formats::MatView(&frame);
+        cv::Mat small, thumbnail;
+        cv::resize(
+            frame_mat, small,
+            cv::Size(m_options.thumbnail_width(), m_options.thumbnail_height()),
+            0, 0, cv::INTER_AREA
+        );
+        switch (frame.NumberOfChannels())
+        {
+        case 1:
+            thumbnail = small;
+            break;
+        case 4:
+            cv::cvtColor(small, thumbnail, cv::COLOR_RGBA2GRAY);
+            break;
+        default:
+            cv::cvtColor(small, thumbnail, cv::COLOR_RGB2GRAY);
+            break;
+        }
+        return thumbnail;
+    }
+
+    bool FrameChangeGateCalculator::IsRepeated(uint64 hash)
+    {
+        const bool is_repeated = m_hash_counts.count(hash) > 0;
+
+        m_hashes.push_back(hash);
+        m_hash_counts[hash]++;
+        while (static_cast<int>(m_hashes.size()) > m_options.hash_history())
+        {
+            auto it = m_hash_counts.find(m_hashes.front());
+            if (--it->second == 0) { m_hash_counts.erase(it); }
+            m_hashes.pop_front();
+        }
+        return is_repeated;
+    }
+
+    void FrameChangeGateCalculator::UpdateFrozen(CalculatorContext* cc, bool is_repeated)
+    {
+        const Timestamp timestamp = cc->InputTimestamp();
+        bool is_frozen = false;
+        if (is_repeated)
+        {
+            if (m_repeat_start == Timestamp::Unset()) { m_repeat_start = timestamp; }
+            is_frozen = (timestamp - m_repeat_start).Seconds() >= m_options.frozen_seconds();
+        } else
+        {
+            m_repeat_start = Timestamp::Unset();
+        }
+
+        if (is_frozen == m_is_frozen) { return; }
+        m_is_frozen = is_frozen;
+        LOG(INFO) << "FrameChangeGateCalculator: Frozen feed " << (is_frozen ? "started": "ended") << " at " << timestamp;
+        if (cc->Outputs().HasTag(kFrozenTag))
+        {
+            cc->Outputs().Tag(kFrozenTag).AddPacket(MakePacket<bool>(is_frozen).At(timestamp));
+        }
+    }
+
+    absl::Status FrameChangeGateCalculator::Process(CalculatorContext* cc)
+    {
+        const auto& frame = cc->Inputs().Tag(kImageTag).Get<ImageFrame>();
+        cv::Mat thumbnail = this->MakeThumbnail(frame);
+        const uint64 hash = HashThumbnail(thumbnail);
+        this->UpdateFrozen(cc, this->IsRepeated(hash));
+
+        bool is_unchanged = false;
+        if (!m_reference.empty())
+        {
+            is_unchanged = hash == m_reference_hash;
+            if (!is_unchanged)
+            {
+                const double mad = cv::norm(thumbnail, m_reference, cv::NORM_L1) / thumbnail.total();
+                is_unchanged = mad < m_options.mad_threshold();
+            }
+        }
+
+        if (!is_unchanged)
+        {
+            m_reference = thumbnail;
+            m_reference_hash = hash;
+            cc->Outputs().Tag(kImageTag).AddPacket(cc->Inputs().Tag(kImageTag).Value());
+        } else
+        {
+            cc->Outputs().Tag(kSkipTag).AddPacket(MakePacket<bool>(true).At(cc->InputTimestamp()));
+        }
+
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status FrameChangeGateCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
@@ -0,0 +1,140 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to merge the signals that a frame left the graph
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kTickTag[]     = "TICK";
+        constexpr char kDoneTag[]     = "DONE";
+        constexpr char kFinishedTag[] = "FINISHED";
+    } // namespace
+
+    /**
+     * @brief Emit a FINISHED tick for every frame that left the graph
+     *
+     * Without TICK, a frame is finished as soon as any of the DONE inputs has
+     * a packet. Frames leave the graph along different paths, e.g. analyzed
+     * frames are rendered while unchanged frames end at
+     * FrameChangeGateCalculator, and the packets may differ in type. Each
+     * timestamp is reported once, in increasing order, for the FINISHED back
+     * edge of FlowLimiterCalculator.
+     *
+     * With TICK, a frame is finished at each TICK timestamp once all of the
+     * DONE inputs settled, whether they have a packet or not, just like a
+     * renderer consuming them. This covers streams that skip frames, e.g. the
+     * results of a frame without faces.
+     *
+     * INPUTS:
+     *      TICK - Optional, frames entering the analysis (Any)
+     *      DONE:[0-N] - Any packet marking a frame as finished (Any)
+     * OUTPUTS:
+     *      FINISHED - Timestamps of the finished frames (bool)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "FrameFinishedCalculator"
+     *   input_stream: "DONE:0:output_video"
+     *   input_stream: "DONE:1:unchanged_frame"
+     *   output_stream: "FINISHED:finished_frame"
+     * }
+     *
+     * node {
+     *   calculator: "FrameFinishedCalculator"
+     *   input_stream: "TICK:throttled_input_video"
+     *   input_stream: "DONE:0:analyzed_proctor_results"
+     *   output_stream: "FINISHED:analyzed_frame"
+     * }
+     *
+     */
+    class FrameFinishedCalculator: public CalculatorBase
+    {
+    private:
+        Timestamp m_last_finished = Timestamp::Unset();
+
+    public:
+        FrameFinishedCalculator() = default;
+        ~FrameFinishedCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(FrameFinishedCalculator);
+
+    absl::Status FrameFinishedCalculator::GetContract(CalculatorContract* cc)
+    {
+        RET_CHECK(cc->Inputs().NumEntries(kDoneTag) > 0);
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            cc->Inputs().Tag(kTickTag).SetAny();
+        }
+        for (int i = 0; i < cc->Inputs().NumEntries(kDoneTag); i++)
+        {
+            cc->Inputs().Get(kDoneTag, i).SetAny();
+        }
+        cc->Outputs().Tag(kFinishedTag).Set<bool>();
+
+        // A path must not wait for the frames ending on another one, while
+        // ticks wait for the DONE inputs to settle
+        if (!cc->Inputs().HasTag(kTickTag))
+        {
+            cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+        }
+        return absl::OkStatus();
+    }
+
+    absl::Status FrameFinishedCalculator::Open(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+    absl::Status FrameFinishedCalculator::Process(CalculatorContext* cc)
+    {
+        bool is_finished = false;
+        if (cc->Inputs().HasTag(kTickTag))
+        {
+            is_finished = !cc->Inputs().Tag(kTickTag).IsEmpty();
+        } else
+        {
+            for (int i = 0; i < cc->Inputs().NumEntries(kDoneTag); i++)
+            {
+                is_finished |= !cc->Inputs().Get(kDoneTag, i).IsEmpty();
+            }
+        }
+        if (!is_finished) { return absl::OkStatus(); }
+        if (m_last_finished != Timestamp::Unset() && cc->InputTimestamp() <= m_last_finished)
+        {
+            return absl::OkStatus();
+        }
+
+        m_last_finished = cc->InputTimestamp();
+        cc->Outputs().Tag(kFinishedTag).AddPacket(MakePacket<bool>(true).At(m_last_finished));
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status FrameFinishedCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
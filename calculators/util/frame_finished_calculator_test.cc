@@ -0,0 +1,85 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of FrameFinishedCalculator
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        void AddPacket(CalculatorRunner& runner, const std::string& tag, int index, Packet packet)
+        {
+            runner.MutableInputs()->Get(tag, index).packets.push_back(std::move(packet));
+        }
+
+        std::vector<Timestamp> FinishedTimestamps(const CalculatorRunner& runner)
+        {
+            std::vector<Timestamp> timestamps;
+            for (const auto& packet: runner.Outputs().Tag("FINISHED").packets)
+            {
+                timestamps.push_back(packet.Timestamp());
+            }
+            return timestamps;
+        }
+    } // namespace
+
+    TEST(FrameFinishedCalculatorTest, MergesPathsOfDifferentTypes)
+    {
+        CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+            calculator: "FrameFinishedCalculator"
+            input_stream: "DONE:0:output_video"
+            input_stream: "DONE:1:unchanged_frame"
+            output_stream: "FINISHED:finished_frame"
+        )pb"));
+        AddPacket(runner, "DONE", 0, MakePacket<std::string>("rendered").At(Timestamp(1)));
+        AddPacket(runner, "DONE", 1, MakePacket<bool>(true).At(Timestamp(2)));
+        AddPacket(runner, "DONE", 0, MakePacket<std::string>("rendered").At(Timestamp(3)));
+        // Reported once, whichever path it took
+        AddPacket(runner, "DONE", 1, MakePacket<bool>(true).At(Timestamp(3)));
+        MP_ASSERT_OK(runner.Run());
+
+        EXPECT_EQ(FinishedTimestamps(runner),
+                  std::vector<Timestamp>({Timestamp(1), Timestamp(2), Timestamp(3)}));
+    }
+
+    TEST(FrameFinishedCalculatorTest, TicksWithoutDonePackets)
+    {
+        CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(R"pb(
+            calculator: "FrameFinishedCalculator"
+            input_stream: "TICK:throttled_input_video"
+            input_stream: "DONE:0:analyzed_proctor_results"
+            output_stream: "FINISHED:analyzed_frame"
+        )pb"));
+        for (int64 timestamp: {1, 2, 3})
+        {
+            AddPacket(runner, "TICK", 0, MakePacket<bool>(true).At(Timestamp(timestamp)));
+        }
+        // Only the frame at 2 has faces
+        AddPacket(runner, "DONE", 0, MakePacket<int>(1).At(Timestamp(2)));
+        MP_ASSERT_OK(runner.Run());
+
+        EXPECT_EQ(FinishedTimestamps(runner),
+                  std::vector<Timestamp>({Timestamp(1), Timestamp(2), Timestamp(3)}));
+    }
+
+} // namespace mediapipe
@@ -20,7 +20,7 @@
 #include "mediapipe/framework/port/status.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 #include "mediapipe/framework/formats/detection.pb.h"
-#include "mediapipe/framework/port/opencv_core_inc.h"
+#include "mp_proctor/calculators/util/face_metrics.h"
 
 namespace mediapipe
 {
@@ -72,28 +72,17 @@ namespace mediapipe
 
     absl::Status LandmarkStandardizationCalculator::Process(CalculatorContext* cc)
     {
-        auto landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
-        cv::Mat mat(landmarks.landmark_size(), 3, CV_64FC1);
-        cv::Mat norm_mat(landmarks.landmark_size(), 3, CV_64FC1);
-        cv::Mat mean_mat, std_mat;
-
-        for (int i = 0; i < landmarks.landmark_size(); ++i) {
-            mat.at<double>(i, 0) = landmarks.landmark(i).x();
-            mat.at<double>(i, 1) = landmarks.landmark(i).y();
-            mat.at<double>(i, 2) = landmarks.landmark(i).z();
-        }
-
-        for (int i = 0; i < mat.cols; i++) {
-            cv::meanStdDev(mat.col(i), mean_mat, std_mat);
-            norm_mat.col(i) = (mat.col(i) - mean_mat.at<double>(0, 0)) / std_mat.at<double>(0, 0);
-        }
+        const auto& landmarks = cc->Inputs().Index(0).Get<NormalizedLandmarkList>();
+        FaceCoordinates coordinates, standardized;
+        LandmarksToCoordinates(landmarks, &coordinates);
+        StandardizeLandmarks(coordinates, &standardized);
 
         NormalizedLandmarkList norm_landmarks;
-        for (int i = 0; i < landmarks.landmark_size(); ++i) {
+        for (size_t i = 0; i + 2 < standardized.size(); i += 3) {
             NormalizedLandmark* landmark = norm_landmarks.add_landmark();
-            landmark->set_x(norm_mat.at<double>(i, 0));
-            landmark->set_y(norm_mat.at<double>(i, 1));
-            landmark->set_z(norm_mat.at<double>(i, 2));
+            landmark->set_x(standardized[i]);
+            landmark->set_y(standardized[i + 1]);
+            landmark->set_z(standardized[i + 2]);
         }
 
         Packet packet = MakePacket<decltype(norm_landmarks)>(norm_landmarks).At(cc->InputTimestamp());
@@ -16,6 +16,11 @@
 #ifndef proctor_result_h
 #define proctor_result_h 
 
+// Plain C, shared with the C API of the engine
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
 enum FacialExpressionType
 {
     neutral,
@@ -34,6 +39,17 @@ struct FacialExpression
     float probability;
 };
 
+// Bit flags of ProctorResult::present_fields
+enum ProctorResultField
+{
+    PROCTOR_FIELD_BLINK         = 1 << 0,
+    PROCTOR_FIELD_ORIENTATION   = 1 << 1,
+    PROCTOR_FIELD_ACTIVITY      = 1 << 2,
+    PROCTOR_FIELD_MOVEMENT      = 1 << 3,
+    PROCTOR_FIELD_EMBEDDINGS    = 1 << 4,
+    PROCTOR_FIELD_EXPRESSIONS   = 1 << 5
+};
+
 struct ProctorResult
 {
     bool is_left_eye_blinking;
@@ -44,6 +60,12 @@ struct ProctorResult
     double face_movement;
     float face_reid_embeddings[128];
     struct FacialExpression expressions[8];
+    // True if the frame was not analyzed and the result is a copy of the
+    // latest analyzed result
+    bool is_carried_forward;
+    // Fields computed for this result (ProctorResultField), disabled modules
+    // leave their fields zeroed and absent
+    unsigned int present_fields;
 };
 
 #endif
\ No newline at end of file
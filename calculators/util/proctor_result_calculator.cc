@@ -16,6 +16,7 @@
 #include <vector>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
 
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/port/status.h"
@@ -29,6 +30,17 @@ namespace mediapipe
     /**
      * @brief Proctor Result Calculator
      * 
+     * All inputs are optional. Fields of inputs that are not connected, e.g.
+     * because the module was disabled, are marked absent in present_fields
+     * instead of being waited for.
+     * 
+     * INPUTS:
+     *      ORIENT - Face orientation data (std::map<std::string, double>)
+     *      BLINK - Eye blink data (std::map<std::string, double>)
+     *      ACTIVE - Facial activity delta (double)
+     *      MOVE - Face position delta (double)
+     *      EMBED - Face embeddings (std::vector<float>)
+     *      EXP - Facial expressions (ClassificationList)
      * OUTPUTS:
      *      RESULT - Proctoring Result <ProctorResult>
      * 
@@ -65,12 +77,30 @@ namespace mediapipe
 
     absl::Status ProctorResultCalculator::GetContract(CalculatorContract* cc)
     {
-        cc->Inputs().Tag("ORIENT").Set<std::map<std::string, double>>();
-        cc->Inputs().Tag("BLINK").Set<std::map<std::string, double>>();
-        cc->Inputs().Tag("ACTIVE").Set<double>();
-        cc->Inputs().Tag("MOVE").Set<double>();
-        cc->Inputs().Tag("EMBED").Set<std::vector<float>>();
-        cc->Inputs().Tag("EXP").Set<ClassificationList>();
+        if (cc->Inputs().HasTag("ORIENT"))
+        {
+            cc->Inputs().Tag("ORIENT").Set<std::map<std::string, double>>();
+        }
+        if (cc->Inputs().HasTag("BLINK"))
+        {
+            cc->Inputs().Tag("BLINK").Set<std::map<std::string, double>>();
+        }
+        if (cc->Inputs().HasTag("ACTIVE"))
+        {
+            cc->Inputs().Tag("ACTIVE").Set<double>();
+        }
+        if (cc->Inputs().HasTag("MOVE"))
+        {
+            cc->Inputs().Tag("MOVE").Set<double>();
+        }
+        if (cc->Inputs().HasTag("EMBED"))
+        {
+            cc->Inputs().Tag("EMBED").Set<std::vector<float>>();
+        }
+        if (cc->Inputs().HasTag("EXP"))
+        {
+            cc->Inputs().Tag("EXP").Set<ClassificationList>();
+        }
         
         cc->Outputs().Tag("RESULT").Set<ProctorResult>();
 
@@ -86,32 +116,62 @@ namespace mediapipe
     {
 
         ProctorResult result;
-        auto blink = cc->Inputs().Tag("BLINK").Get<std::map<std::string, double>>();
-        auto threshold = blink.at("threshold");
-        result.is_left_eye_blinking = blink.at("left") < threshold;
-        result.is_right_eye_blinking = blink.at("right") < threshold;
+        std::memset(&result, 0, sizeof(result));
+
+        auto is_present = [cc](const char* tag) {
+            return cc->Inputs().HasTag(tag) && !cc->Inputs().Tag(tag).IsEmpty();
+        };
+
+        if (is_present("BLINK"))
+        {
+            auto blink = cc->Inputs().Tag("BLINK").Get<std::map<std::string, double>>();
+            auto threshold = blink.at("threshold");
+            result.is_left_eye_blinking = blink.at("left") < threshold;
+            result.is_right_eye_blinking = blink.at("right") < threshold;
+            result.present_fields |= PROCTOR_FIELD_BLINK;
+        }
         
-        auto orientation = cc->Inputs().Tag("ORIENT").Get<std::map<std::string, double>>();
-        result.horizontal_align = orientation.at("horizontal_align");
-        result.vertical_align   = orientation.at("vertical_align");
+        if (is_present("ORIENT"))
+        {
+            auto orientation = cc->Inputs().Tag("ORIENT").Get<std::map<std::string, double>>();
+            result.horizontal_align = orientation.at("horizontal_align");
+            result.vertical_align   = orientation.at("vertical_align");
+            result.present_fields |= PROCTOR_FIELD_ORIENTATION;
+        }
             
-        result.facial_activity = cc->Inputs().Tag("ACTIVE").Get<double>();
-        result.face_movement = cc->Inputs().Tag("MOVE").Get<double>();
-
-        const auto& face_reid_embeddings = cc->Inputs().Tag("EMBED").Get<std::vector<float>>();
-        std::memcpy(result.face_reid_embeddings, face_reid_embeddings.data(), 128 * sizeof(float));
+        if (is_present("ACTIVE"))
+        {
+            result.facial_activity = cc->Inputs().Tag("ACTIVE").Get<double>();
+            result.present_fields |= PROCTOR_FIELD_ACTIVITY;
+        }
+        if (is_present("MOVE"))
+        {
+            result.face_movement = cc->Inputs().Tag("MOVE").Get<double>();
+            result.present_fields |= PROCTOR_FIELD_MOVEMENT;
+        }
 
-        auto expressions = cc->Inputs().Tag("EXP").Get<ClassificationList>();
-        auto raw_expressions = expressions.mutable_classification();
-        std::sort(raw_expressions->begin(), raw_expressions->end(),
-                [](const Classification a, const Classification b) {
-                return a.score() > b.score();
-                });
+        if (is_present("EMBED"))
+        {
+            const auto& face_reid_embeddings = cc->Inputs().Tag("EMBED").Get<std::vector<float>>();
+            std::memcpy(result.face_reid_embeddings, face_reid_embeddings.data(), 128 * sizeof(float));
+            result.present_fields |= PROCTOR_FIELD_EMBEDDINGS;
+        }
 
-        for (int i = 0; i < raw_expressions->size(); i++)
+        if (is_present("EXP"))
         {
-            result.expressions[i].type = static_cast<FacialExpressionType>(raw_expressions->at(i).index());
-            result.expressions[i].probability = raw_expressions->at(i).score();
+            auto expressions = cc->Inputs().Tag("EXP").Get<ClassificationList>();
+            auto raw_expressions = expressions.mutable_classification();
+            std::sort(raw_expressions->begin(), raw_expressions->end(),
+                    [](const Classification a, const Classification b) {
+                    return a.score() > b.score();
+                    });
+
+            for (int i = 0; i < raw_expressions->size(); i++)
+            {
+                result.expressions[i].type = static_cast<FacialExpressionType>(raw_expressions->at(i).index());
+                result.expressions[i].probability = raw_expressions->at(i).score();
+            }
+            result.present_fields |= PROCTOR_FIELD_EXPRESSIONS;
         }
         
         Packet packet = MakePacket<decltype(result)>(result).At(cc->InputTimestamp()); 
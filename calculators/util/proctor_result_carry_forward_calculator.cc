@@ -0,0 +1,165 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Calculator to fill the skipped frames with the latest proctoring results
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/timestamp.h"
+#include "proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kResultsTag[]  = "RESULTS";
+        constexpr char kAnalyzedTag[] = "ANALYZED";
+        constexpr char kSkipTag[]     = "SKIP";
+    } // namespace
+
+    /**
+     * @brief Merge the analyzed results with copies of the latest analyzed
+     *        results at the timestamps of the skipped frames
+     *
+     * The copies are marked with is_carried_forward. Skip ticks must only be
+     * emitted once all earlier frames are analyzed, so that the output stays
+     * in timestamp order.
+     *
+     * Frames without faces have no RESULTS packet. An ANALYZED tick without
+     * RESULTS at the same timestamp clears the latest results, so that a face
+     * leaving the frame is not carried forward to the following skipped
+     * frames. The tick must follow the RESULTS of its frame, e.g. a
+     * FrameFinishedCalculator waiting for them.
+     *
+     * INPUTS:
+     *      RESULTS - Analyzed results (std::vector<ProctorResult>)
+     *      ANALYZED - Optional, timestamps of the analyzed frames, with or without faces (Any)
+     *      SKIP:[0-N] - Timestamps of the skipped frames (Any)
+     * OUTPUTS:
+     *      RESULTS - Analyzed and carried forward results (std::vector<ProctorResult>)
+     *
+     * Example:
+     *
+     * node {
+     *   calculator: "ProctorResultCarryForwardCalculator"
+     *   input_stream: "RESULTS:analyzed_proctor_results"
+     *   input_stream: "ANALYZED:analyzed_frame"
+     *   input_stream: "SKIP:0:skipped_frame"
+     *   output_stream: "RESULTS:multi_face_proctor_results"
+     * }
+     *
+     */
+    class ProctorResultCarryForwardCalculator: public CalculatorBase
+    {
+    private:
+        std::vector<ProctorResult> m_last_results;
+        Timestamp m_last_analyzed = Timestamp::Unset();
+        Timestamp m_last_output = Timestamp::Unset();
+
+        void Output(CalculatorContext* cc, const std::vector<ProctorResult>& results, Timestamp timestamp);
+
+    public:
+        ProctorResultCarryForwardCalculator() = default;
+        ~ProctorResultCarryForwardCalculator() override = default;
+
+        static absl::Status GetContract(CalculatorContract* cc);
+
+        absl::Status Open(CalculatorContext* cc) override;
+        absl::Status Process(CalculatorContext* cc) override;
+        absl::Status Close(CalculatorContext* cc) override;
+    };
+
+    // Register the calculator to be used in the graph
+    REGISTER_CALCULATOR(ProctorResultCarryForwardCalculator);
+
+    absl::Status ProctorResultCarryForwardCalculator::GetContract(CalculatorContract* cc)
+    {
+        cc->Inputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+        if (cc->Inputs().HasTag(kAnalyzedTag))
+        {
+            cc->Inputs().Tag(kAnalyzedTag).SetAny();
+        }
+        for (int i = 0; i < cc->Inputs().NumEntries(kSkipTag); i++)
+        {
+            cc->Inputs().Get(kSkipTag, i).SetAny();
+        }
+        cc->Outputs().Tag(kResultsTag).Set<std::vector<ProctorResult>>();
+
+        // Skip ticks arrive while no frame is analyzed
+        cc->SetInputStreamHandler("ImmediateInputStreamHandler");
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorResultCarryForwardCalculator::Open(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+    void ProctorResultCarryForwardCalculator::Output(
+        CalculatorContext* cc,
+        const std::vector<ProctorResult>& results,
+        Timestamp timestamp
+    )
+    {
+        if (m_last_output != Timestamp::Unset() && timestamp <= m_last_output)
+        {
+            LOG(WARNING) << "ProctorResultCarryForwardCalculator: Dropping out-of-order results at " << timestamp;
+            return;
+        }
+        m_last_output = timestamp;
+        cc->Outputs().Tag(kResultsTag).AddPacket(
+            MakePacket<std::vector<ProctorResult>>(results).At(timestamp)
+        );
+    }
+
+    absl::Status ProctorResultCarryForwardCalculator::Process(CalculatorContext* cc)
+    {
+        if (!cc->Inputs().Tag(kResultsTag).IsEmpty())
+        {
+            m_last_results = cc->Inputs().Tag(kResultsTag).Get<std::vector<ProctorResult>>();
+            m_last_analyzed = cc->InputTimestamp();
+            this->Output(cc, m_last_results, cc->InputTimestamp());
+            return absl::OkStatus();
+        }
+        // Analyzed without faces
+        if (cc->Inputs().HasTag(kAnalyzedTag) && !cc->Inputs().Tag(kAnalyzedTag).IsEmpty() &&
+            cc->InputTimestamp() != m_last_analyzed)
+        {
+            m_last_results.clear();
+            m_last_analyzed = cc->InputTimestamp();
+            return absl::OkStatus();
+        }
+
+        bool is_skipped = false;
+        for (int i = 0; i < cc->Inputs().NumEntries(kSkipTag); i++)
+        {
+            is_skipped |= !cc->Inputs().Get(kSkipTag, i).IsEmpty();
+        }
+        if (!is_skipped || m_last_results.empty()) { return absl::OkStatus(); }
+
+        auto results = m_last_results;
+        for (auto& result: results)
+        {
+            result.is_carried_forward = true;
+        }
+        this->Output(cc, results, cc->InputTimestamp());
+
+        return absl::OkStatus();
+    } // Process()
+
+    absl::Status ProctorResultCarryForwardCalculator::Close(CalculatorContext* cc)
+    { return absl::OkStatus(); }
+
+} // namespace mediapipe
@@ -0,0 +1,110 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Tests of ProctorResultCarryForwardCalculator
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/calculator_runner.h"
+#include "mediapipe/framework/port/gtest.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status_matchers.h"
+#include "proctor_result.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kConfig[] = R"pb(
+            calculator: "ProctorResultCarryForwardCalculator"
+            input_stream: "RESULTS:analyzed_proctor_results"
+            input_stream: "ANALYZED:analyzed_frame"
+            input_stream: "SKIP:0:skipped_frame"
+            output_stream: "RESULTS:multi_face_proctor_results"
+        )pb";
+
+        std::vector<ProctorResult> OneFace()
+        {
+            ProctorResult result = {};
+            result.face_movement = 0.5;
+            result.present_fields = PROCTOR_FIELD_MOVEMENT;
+            return {result};
+        }
+
+        void AddResults(CalculatorRunner& runner, int64 timestamp)
+        {
+            runner.MutableInputs()->Tag("RESULTS").packets.push_back(
+                MakePacket<std::vector<ProctorResult>>(OneFace()).At(Timestamp(timestamp))
+            );
+        }
+
+        void AddAnalyzed(CalculatorRunner& runner, int64 timestamp)
+        {
+            runner.MutableInputs()->Tag("ANALYZED").packets.push_back(
+                MakePacket<bool>(true).At(Timestamp(timestamp))
+            );
+        }
+
+        void AddSkip(CalculatorRunner& runner, int64 timestamp)
+        {
+            runner.MutableInputs()->Get("SKIP", 0).packets.push_back(
+                MakePacket<bool>(true).At(Timestamp(timestamp))
+            );
+        }
+    } // namespace
+
+    TEST(ProctorResultCarryForwardCalculatorTest, CarriesLatestResultsForward)
+    {
+        CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(kConfig));
+        AddResults(runner, 1);
+        AddAnalyzed(runner, 1);
+        AddSkip(runner, 2);
+        MP_ASSERT_OK(runner.Run());
+
+        const auto& packets = runner.Outputs().Tag("RESULTS").packets;
+        ASSERT_EQ(packets.size(), 2);
+        EXPECT_EQ(packets[0].Timestamp(), Timestamp(1));
+        EXPECT_FALSE(packets[0].Get<std::vector<ProctorResult>>()[0].is_carried_forward);
+        EXPECT_EQ(packets[1].Timestamp(), Timestamp(2));
+        const auto& carried = packets[1].Get<std::vector<ProctorResult>>();
+        ASSERT_EQ(carried.size(), 1);
+        EXPECT_TRUE(carried[0].is_carried_forward);
+        EXPECT_DOUBLE_EQ(carried[0].face_movement, 0.5);
+    }
+
+    TEST(ProctorResultCarryForwardCalculatorTest, ForgetsFaceThatLeftTheFrame)
+    {
+        CalculatorRunner runner(ParseTextProtoOrDie<CalculatorGraphConfig::Node>(kConfig));
+        AddResults(runner, 1);
+        AddAnalyzed(runner, 1);
+        AddSkip(runner, 2);
+        // Analyzed without faces, nothing to carry forward afterwards
+        AddAnalyzed(runner, 3);
+        AddSkip(runner, 4);
+        AddResults(runner, 5);
+        AddAnalyzed(runner, 5);
+        AddSkip(runner, 6);
+        MP_ASSERT_OK(runner.Run());
+
+        const auto& packets = runner.Outputs().Tag("RESULTS").packets;
+        ASSERT_EQ(packets.size(), 4);
+        EXPECT_EQ(packets[0].Timestamp(), Timestamp(1));
+        EXPECT_EQ(packets[1].Timestamp(), Timestamp(2));
+        EXPECT_EQ(packets[2].Timestamp(), Timestamp(5));
+        EXPECT_EQ(packets[3].Timestamp(), Timestamp(6));
+        EXPECT_TRUE(packets[3].Get<std::vector<ProctorResult>>()[0].is_carried_forward);
+    }
+
+} // namespace mediapipe
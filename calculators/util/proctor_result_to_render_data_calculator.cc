@@ -25,6 +25,7 @@
 #include "mediapipe/util/color.pb.h"
 #include "mediapipe/util/render_data.pb.h"
 #include "mp_proctor/calculators/util/proctor_result.h"
+#include "mp_proctor/calculators/util/proctor_thresholds.h"
 
 namespace mediapipe
 {
@@ -201,19 +202,24 @@ namespace mediapipe
 
         auto result = cc->Inputs().Tag(kResultStreamTag).Get<ProctorResult>();
         
-        this->AnnotateBlink(render_data, result.is_left_eye_blinking, 0.08);
-        this->AnnotateBlink(render_data, result.is_right_eye_blinking, 0.64);
-
-        std::string hor_align = result.horizontal_align >= 0.3 ? "Right":
-                                result.horizontal_align <= -0.3 ? "Left":
-                                "Neutral";
-        std::string ver_align = result.vertical_align >= 0.6 ? "Down":
-                                result.vertical_align <= -0.05 ? "Up":
-                                "Neutral";
-        this->AnnotateOrientation(render_data, hor_align, 0.05);
-        this->AnnotateOrientation(render_data, ver_align, 0.6);
-
-        this->AnnotateExpressions(render_data, result.expressions);
+        if (result.present_fields & PROCTOR_FIELD_BLINK)
+        {
+            this->AnnotateBlink(render_data, result.is_left_eye_blinking, 0.08);
+            this->AnnotateBlink(render_data, result.is_right_eye_blinking, 0.64);
+        }
+
+        if (result.present_fields & PROCTOR_FIELD_ORIENTATION)
+        {
+            std::string hor_align = HorizontalAlignLabel(result.horizontal_align);
+            std::string ver_align = VerticalAlignLabel(result.vertical_align);
+            this->AnnotateOrientation(render_data, hor_align, 0.05);
+            this->AnnotateOrientation(render_data, ver_align, 0.6);
+        }
+
+        if (result.present_fields & PROCTOR_FIELD_EXPRESSIONS)
+        {
+            this->AnnotateExpressions(render_data, result.expressions);
+        }
         
         Packet packet = MakePacket<decltype(render_data)>(render_data).At(cc->InputTimestamp());
         cc->Outputs().Tag(kRenderDataStreamTag).AddPacket(packet);
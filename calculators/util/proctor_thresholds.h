@@ -0,0 +1,44 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Thresholds shared by the annotations and the proctoring events
+#ifndef proctor_thresholds_h
+#define proctor_thresholds_h
+
+namespace mediapipe
+{
+    // Horizontal align beyond which the face looks right or left
+    constexpr double kLookRightThreshold = 0.3;
+    constexpr double kLookLeftThreshold  = -0.3;
+    // Vertical align beyond which the face looks down or up
+    constexpr double kLookDownThreshold  = 0.6;
+    constexpr double kLookUpThreshold    = -0.05;
+
+    inline const char* HorizontalAlignLabel(double horizontal_align)
+    {
+        return horizontal_align >= kLookRightThreshold ? "Right":
+            horizontal_align <= kLookLeftThreshold ? "Left":
+            "Neutral";
+    }
+
+    inline const char* VerticalAlignLabel(double vertical_align)
+    {
+        return vertical_align >= kLookDownThreshold ? "Down":
+            vertical_align <= kLookUpThreshold ? "Up":
+            "Neutral";
+    }
+
+} // namespace mediapipe
+
+#endif
@@ -19,7 +19,7 @@
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 
-#include "face_align.h"
+#include "mp_proctor/calculators/util/face_crop.h"
 
 namespace mediapipe {
 
@@ -99,24 +99,11 @@ absl::Status SimilarityTransformCalculator::Process(CalculatorContext* cc)
     
     int width = input_frame_size.first, height = input_frame_size.second;
     
-    float facial_points[5][2] = {
-        {((landmarks.landmark(469).x() + landmarks.landmark(470).x() + landmarks.landmark(471).x() + landmarks.landmark(472).x()) * width) / 4, ((landmarks.landmark(469).y() + landmarks.landmark(470).y() + landmarks.landmark(471).y() + landmarks.landmark(472).y()) * height) / 4},
-        {((landmarks.landmark(474).x() + landmarks.landmark(475).x() + landmarks.landmark(476).x() + landmarks.landmark(477).x()) * width) / 4, ((landmarks.landmark(474).y() + landmarks.landmark(475).y() + landmarks.landmark(476).y() + landmarks.landmark(477).y()) * height) / 4},
-        {landmarks.landmark(1).x() * width, landmarks.landmark(1).y() * height},
-        {landmarks.landmark(61).x() * width, landmarks.landmark(61).y() * height},
-        {landmarks.landmark(291).x() * width, landmarks.landmark(291).y() * height}
-    };
-    
-    cv::Mat facial_transform (5, 2, CV_32F, facial_points);
-    float reference_points[5][2] = {
-        {38.29459953, 51.69630051}, // left eye
-        {73.53179932, 51.50139999}, // right eye
-        {56.02519989, 71.73660278}, // nose
-        {41.54930115, 92.3655014 }, // left mouth
-        {70.72990036, 92.20410156} // right mouth
-    };
-    cv::Mat reference_transform(5, 2, CV_32F, reference_points);
-    auto transform = FacePreprocess::similarTransform(facial_transform, reference_transform)(cv::Rect(0, 0, 3, 2));
+    cv::Mat transform;
+    if(!FaceAlignmentTransform(landmarks, width, height, &transform))
+    {
+        return absl::FailedPreconditionError("SimilarityTransformCalculator: Landmarks without the irises!");
+    }
     
     cv::Mat transform3D = cv::Mat::eye(4, 4, CV_32F);
     transform3D.at<float>(0, 0) = transform.at<float>(0, 0);
@@ -14,25 +14,43 @@
 // limitations under the License.
 //
 // An example of sending OpenCV webcam frames into a MediaPipe graph.
+#include <algorithm>
 #include <cstdlib>
+#include <deque>
+#include <thread>
 
 #include "absl/flags/flag.h"
 #include "absl/flags/parse.h"
+#include "absl/strings/match.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/time.h"
+#include "libyuv/video_common.h"
 #include "mediapipe/framework/calculator_framework.h"
 #include "mediapipe/framework/formats/image_frame.h"
 #include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/formats/yuv_image.h"
 #include "mediapipe/framework/port/file_helpers.h"
 #include "mediapipe/framework/port/opencv_highgui_inc.h"
 #include "mediapipe/framework/port/opencv_imgproc_inc.h"
 #include "mediapipe/framework/port/opencv_video_inc.h"
 #include "mediapipe/framework/port/parse_text_proto.h"
 #include "mediapipe/framework/port/status.h"
+#include "mp_proctor/bounded_queue.h"
 #include "mp_proctor/calculators/util/proctor_result.h"
+#include "mp_proctor/image_frame_pool.h"
+#include "mp_proctor/ingest/shm_frame_ring.h"
+#include "mp_proctor/offline_processor.h"
+#include "mp_proctor/graphs/executor_presets.h"
+#include "mp_proctor/graphs/module_toggles.h"
+#include "mp_proctor/graphs/proctor_graph_builder.h"
 // #include "mp_proctor/calculators/util/face_align.h"
 #include "mediapipe/framework/formats/landmark.pb.h"
 
 constexpr char kInputStream[] = "input_video";
+constexpr char kYuvInputStream[] = "input_yuv";
 constexpr char kOutputStream[] = "output_video";
+constexpr char kResultsStream[] = "multi_face_proctor_results";
+constexpr char kDetectionWidthSidePacket[] = "detection_width";
 constexpr char kWindowName[] = "MediaPipe";
 
 ABSL_FLAG(std::string, calculator_graph_config_file, "",
@@ -43,31 +61,324 @@ ABSL_FLAG(std::string, input_video_path, "",
 ABSL_FLAG(std::string, output_video_path, "",
           "Full path of where to save result (.mp4 only). "
           "If not provided, show result in a window.");
+ABSL_FLAG(std::string, graph_outputs, "",
+          "Comma separated outputs to build a minimal graph for, e.g. "
+          "\"blink,orientation\", \"embeddings\" or \"results,video\". "
+          "If provided, calculator_graph_config_file is ignored.");
+ABSL_FLAG(int, detection_width, 0,
+          "Downscale the frames to this width for face detection and "
+          "landmarks, while re-id crops from the full resolution. 0 keeps "
+          "the full resolution.");
+ABSL_FLAG(bool, yuv_input, false,
+          "Send I420 frames to the graph's input_yuv stream, e.g. with "
+          "mp_proctor/graphs/proctor_yuv_cpu.pbtxt.");
+ABSL_FLAG(std::string, shm_input, "",
+          "Name of a shared memory frame ring to read the frames from, e.g. "
+          "\"/mp_proctor_frames\", instead of the webcam or video.");
+ABSL_FLAG(int, queue_size, 2,
+          "Capacity of the queues between the capture, graph and output "
+          "threads.");
+ABSL_FLAG(std::string, drop_policy, "",
+          "What to do with frames that do not fit in the queues: block, "
+          "drop_oldest or drop_newest. Defaults to block for video files and "
+          "drop_oldest for the webcam.");
+ABSL_FLAG(bool, enable_reid, true,
+          "Run face re-identification. Disabling it disables face affect too.");
+ABSL_FLAG(bool, enable_affect, true, "Run facial expression recognition.");
+ABSL_FLAG(bool, enable_render, true, "Render the results onto the video.");
+ABSL_FLAG(bool, offline, false,
+          "Analyze every frame of input_video_path as fast as possible, with "
+          "the container timestamps and without rendering.");
+ABSL_FLAG(std::string, results_path, "",
+          "CSV file to write the results to in offline mode.");
+ABSL_FLAG(int, offline_workers, 1,
+          "Graph instances analyzing time chunks of the video in parallel in "
+          "offline mode.");
+ABSL_FLAG(double, chunk_seconds, 600,
+          "Length of the chunks analyzed by the offline workers.");
+ABSL_FLAG(double, chunk_overlap_seconds, 1,
+          "Video analyzed before each chunk to prime the temporal state, "
+          "e.g. face movement and activity.");
+ABSL_FLAG(std::string, executor_preset, "default",
+          "Executor topology: default, split_inference or pinned.");
+ABSL_FLAG(int, inference_threads, 1,
+          "Threads of the inference executor (split_inference, pinned).");
+ABSL_FLAG(int, light_threads, 1,
+          "Threads of the light calculator executor (split_inference, pinned).");
+ABSL_FLAG(int, xnnpack_threads, 1,
+          "XNNPACK threads per inference calculator, -1 for the model default "
+          "(split_inference, pinned).");
+ABSL_FLAG(std::string, inference_cpus, "",
+          "CPUs of the inference executor, e.g. \"2-3\" (pinned).");
+ABSL_FLAG(std::string, light_cpus, "",
+          "CPUs of the light calculator executor, e.g. \"1\" (pinned).");
+
+absl::StatusOr<mediapipe::CalculatorGraphConfig> LoadGraphConfig() {
+  if (!absl::GetFlag(FLAGS_graph_outputs).empty()) {
+    ASSIGN_OR_RETURN(auto request, mediapipe::ParseProctorGraphRequest(
+                                       absl::GetFlag(FLAGS_graph_outputs)));
+    request.detection_width = absl::GetFlag(FLAGS_detection_width);
+    ASSIGN_OR_RETURN(auto config, mediapipe::BuildProctorGraph(request));
+    LOG(INFO) << "Built calculator graph config: " << config.DebugString();
+    return config;
+  }
 
-absl::Status RunMPPGraph() {
   std::string calculator_graph_config_contents;
   MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
       absl::GetFlag(FLAGS_calculator_graph_config_file),
       &calculator_graph_config_contents));
   LOG(INFO) << "Get calculator graph config contents: "
             << calculator_graph_config_contents;
-  mediapipe::CalculatorGraphConfig config =
-      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
-          calculator_graph_config_contents);
+  return mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+      calculator_graph_config_contents);
+}
+
+absl::StatusOr<mediapipe::ExecutorPresetOptions> GetExecutorPresetOptions() {
+  mediapipe::ExecutorPresetOptions options;
+  options.inference_threads = absl::GetFlag(FLAGS_inference_threads);
+  options.light_threads = absl::GetFlag(FLAGS_light_threads);
+  options.xnnpack_threads = absl::GetFlag(FLAGS_xnnpack_threads);
+  ASSIGN_OR_RETURN(options.inference_cpus,
+                   mediapipe::ParseCpuList(absl::GetFlag(FLAGS_inference_cpus)));
+  ASSIGN_OR_RETURN(options.light_cpus,
+                   mediapipe::ParseCpuList(absl::GetFlag(FLAGS_light_cpus)));
+  return options;
+}
+
+// Returns true if the graph declares the given output stream.
+bool HasOutputStream(const mediapipe::CalculatorGraphConfig& config,
+                     const std::string& name) {
+  for (const auto& entry : config.output_stream()) {
+    if (entry == name || absl::EndsWith(entry, ":" + name)) return true;
+  }
+  return false;
+}
+
+// Converts a BGR frame into a packed I420 YUVImage, like a YUV camera would
+// deliver it. Odd rows and columns are cropped.
+std::unique_ptr<mediapipe::YUVImage> MakeYuvImage(const cv::Mat& bgr) {
+  const int width = bgr.cols & ~1, height = bgr.rows & ~1;
+  auto i420 = std::make_shared<cv::Mat>();
+  cv::cvtColor(bgr(cv::Rect(0, 0, width, height)), *i420,
+               cv::COLOR_BGR2YUV_I420);
+  uint8* y = i420->data;
+  uint8* u = y + width * height;
+  uint8* v = u + (width / 2) * (height / 2);
+  auto yuv_image = absl::make_unique<mediapipe::YUVImage>();
+  yuv_image->Initialize(libyuv::FOURCC_I420, [i420]() {}, y, width, u,
+                        width / 2, v, width / 2, width, height);
+  return yuv_image;
+}
+
+// Grabs the frames and converts them into pooled ImageFrame packets, or
+// YUVImage packets if yuv is set.
+void CaptureFrames(cv::VideoCapture* capture, bool load_video, bool yuv,
+                   mediapipe::BoundedQueue<mediapipe::Packet>* frames) {
+  mediapipe::ImageFramePool pool;
+  cv::Mat camera_frame_raw;
+  while (!frames->closed()) {
+    // Capture opencv camera or video frame.
+    *capture >> camera_frame_raw;
+    if (camera_frame_raw.empty()) {
+      if (!load_video) {
+        LOG(INFO) << "Ignore empty frames from camera.";
+        continue;
+      }
+      LOG(INFO) << "Empty frame, end of video reached.";
+      break;
+    }
+
+    size_t frame_timestamp_us =
+        (double)cv::getTickCount() / (double)cv::getTickFrequency() * 1e6;
+    const mediapipe::Timestamp timestamp(frame_timestamp_us);
+    if (yuv) {
+      if (!load_video) {
+        cv::flip(camera_frame_raw, camera_frame_raw, /*flipcode=HORIZONTAL*/ 1);
+      }
+      frames->Push(
+          mediapipe::Adopt(MakeYuvImage(camera_frame_raw).release())
+              .At(timestamp));
+      continue;
+    }
+
+    // Convert and mirror the webcam frame straight into the ImageFrame.
+    auto input_frame = pool.Acquire(mediapipe::ImageFormat::SRGB,
+                                    camera_frame_raw.cols,
+                                    camera_frame_raw.rows);
+    mediapipe::ConvertBgrToRgb(camera_frame_raw, /*mirror=*/!load_video,
+                               input_frame.get());
+    frames->Push(mediapipe::Adopt(input_frame.release()).At(timestamp));
+  }
+  LOG(INFO) << "Allocated " << pool.allocated() << " input frames.";
+  frames->Close();
+}
+
+// Wraps the frames another process publishes into the shared memory ring
+// as packets, without copying them.
+void ReceiveFrames(mediapipe::ShmFrameConsumer* consumer,
+                   mediapipe::BoundedQueue<mediapipe::Packet>* frames) {
+  int64 last_timestamp_us = -1;
+  while (!frames->closed()) {
+    int64 timestamp_us = 0;
+    auto frame = consumer->Read(absl::Milliseconds(100), &timestamp_us);
+    if (absl::IsDeadlineExceeded(frame.status())) continue;
+    if (absl::IsDataLoss(frame.status())) {
+      LOG(WARNING) << frame.status().message();
+      continue;
+    }
+    if (!frame.ok()) {
+      LOG(INFO) << frame.status().message();
+      break;
+    }
+    timestamp_us = std::max(timestamp_us, last_timestamp_us + 1);
+    last_timestamp_us = timestamp_us;
+    frames->Push(mediapipe::Adopt(frame->release())
+                     .At(mediapipe::Timestamp(timestamp_us)));
+  }
+  frames->Close();
+}
+
+// Timestamps of the frames sent into the graph, so that the saved video
+// keeps one frame per input frame.
+class SentFrames {
+ public:
+  void Add(mediapipe::Timestamp timestamp) {
+    absl::MutexLock lock(&mutex_);
+    timestamps_.push_back(timestamp);
+  }
+
+  // Removes the frames sent up to timestamp and returns their number.
+  int TakeUntil(mediapipe::Timestamp timestamp) {
+    absl::MutexLock lock(&mutex_);
+    int count = 0;
+    while (!timestamps_.empty() && timestamps_.front() <= timestamp) {
+      timestamps_.pop_front();
+      ++count;
+    }
+    return count;
+  }
+
+  int TakeAll() {
+    absl::MutexLock lock(&mutex_);
+    const int count = timestamps_.size();
+    timestamps_.clear();
+    return count;
+  }
+
+ private:
+  absl::Mutex mutex_;
+  std::deque<mediapipe::Timestamp> timestamps_ ABSL_GUARDED_BY(mutex_);
+};
+
+// Sends the captured frames into the graph until the capture ends, and
+// records them in sent if not null.
+absl::Status ProcessFrames(
+    mediapipe::CalculatorGraph* graph, const std::string& input_stream,
+    bool render,
+    mediapipe::BoundedQueue<mediapipe::Packet>* frames,
+    mediapipe::BoundedQueue<mediapipe::Packet>* output_frames,
+    SentFrames* sent) {
+  mediapipe::Packet packet;
+  while (frames->Pop(&packet)) {
+    if (sent) sent->Add(packet.Timestamp());
+    MP_RETURN_IF_ERROR(graph->AddPacketToInputStream(input_stream, packet));
+    // Show the input as is if nothing is rendered.
+    if (!render) output_frames->Push(packet);
+  }
+  MP_RETURN_IF_ERROR(graph->CloseInputStream(input_stream));
+  return graph->WaitUntilDone();
+}
+
+// Analyzes the whole video without dropping frames and reports the
+// throughput.
+absl::Status RunOffline(
+    const mediapipe::CalculatorGraphConfig& config,
+    const std::map<std::string, mediapipe::Packet>& side_packets) {
+  RET_CHECK(!absl::GetFlag(FLAGS_input_video_path).empty())
+      << "Offline mode needs input_video_path.";
+  RET_CHECK(HasOutputStream(config, kResultsStream))
+      << "Offline mode needs a graph emitting " << kResultsStream << ".";
+
+  mediapipe::ProctorResultCsvWriter csv_writer;
+  const std::string results_path = absl::GetFlag(FLAGS_results_path);
+  if (!results_path.empty()) {
+    MP_RETURN_IF_ERROR(csv_writer.Open(results_path));
+  }
+
+  mediapipe::OfflineVideoOptions options;
+  options.input_video_path = absl::GetFlag(FLAGS_input_video_path);
+  options.max_queue_size = std::max(1, absl::GetFlag(FLAGS_queue_size));
+  auto on_results = [&csv_writer](mediapipe::Timestamp timestamp,
+                                  const std::vector<ProctorResult>& results) {
+    csv_writer.Write(timestamp, results);
+  };
+  mediapipe::OfflineVideoStats stats;
+  if (absl::GetFlag(FLAGS_offline_workers) > 1) {
+    mediapipe::ChunkedVideoOptions chunk_options;
+    chunk_options.workers = absl::GetFlag(FLAGS_offline_workers);
+    chunk_options.chunk_us =
+        static_cast<int64>(absl::GetFlag(FLAGS_chunk_seconds) * 1e6);
+    chunk_options.overlap_us =
+        static_cast<int64>(absl::GetFlag(FLAGS_chunk_overlap_seconds) * 1e6);
+    ASSIGN_OR_RETURN(stats, mediapipe::ProcessVideoInChunks(
+                                config, options, chunk_options, side_packets,
+                                on_results));
+  } else {
+    ASSIGN_OR_RETURN(stats, mediapipe::ProcessVideoOffline(
+                                config, options, side_packets, on_results));
+  }
+  MP_RETURN_IF_ERROR(csv_writer.Close());
+  LOG(INFO) << "Analyzed " << stats.frames << " frames in " << stats.seconds
+            << " s (" << stats.fps() << " fps).";
+  return absl::OkStatus();
+}
+
+absl::Status RunMPPGraph() {
+  ASSIGN_OR_RETURN(mediapipe::CalculatorGraphConfig config, LoadGraphConfig());
+  const bool offline = absl::GetFlag(FLAGS_offline);
+
+  std::map<std::string, mediapipe::Packet> side_packets = {
+      {mediapipe::kEnableReidSidePacket,
+       mediapipe::MakePacket<bool>(absl::GetFlag(FLAGS_enable_reid))},
+      {mediapipe::kEnableAffectSidePacket,
+       mediapipe::MakePacket<bool>(absl::GetFlag(FLAGS_enable_affect))},
+      {mediapipe::kEnableRenderSidePacket,
+       mediapipe::MakePacket<bool>(absl::GetFlag(FLAGS_enable_render) &&
+                                   !offline)},
+  };
+  if (absl::GetFlag(FLAGS_detection_width) > 0) {
+    side_packets[kDetectionWidthSidePacket] =
+        mediapipe::MakePacket<int>(absl::GetFlag(FLAGS_detection_width));
+  }
+  MP_RETURN_IF_ERROR(mediapipe::ApplyModuleToggles(side_packets, &config));
+  ASSIGN_OR_RETURN(auto executor_options, GetExecutorPresetOptions());
+  MP_RETURN_IF_ERROR(mediapipe::ApplyExecutorPreset(
+      absl::GetFlag(FLAGS_executor_preset), executor_options, &config));
+  if (offline) return RunOffline(config, side_packets);
 
   LOG(INFO) << "Initialize the calculator graph.";
   mediapipe::CalculatorGraph graph;
   MP_RETURN_IF_ERROR(graph.Initialize(config));
 
-  LOG(INFO) << "Initialize the camera or load the video.";
   cv::VideoCapture capture;
+  std::unique_ptr<mediapipe::ShmFrameConsumer> shm_consumer;
   const bool load_video = !absl::GetFlag(FLAGS_input_video_path).empty();
-  if (load_video) {
-    capture.open(absl::GetFlag(FLAGS_input_video_path));
+  const bool yuv = absl::GetFlag(FLAGS_yuv_input);
+  if (!absl::GetFlag(FLAGS_shm_input).empty()) {
+    RET_CHECK(!yuv) << "The frame ring carries ImageFrames only.";
+    LOG(INFO) << "Open the shared memory frame ring.";
+    ASSIGN_OR_RETURN(auto ring, mediapipe::ShmFrameRing::Open(
+                                    absl::GetFlag(FLAGS_shm_input)));
+    shm_consumer = absl::make_unique<mediapipe::ShmFrameConsumer>(ring);
   } else {
-    capture.open(0);
+    LOG(INFO) << "Initialize the camera or load the video.";
+    if (load_video) {
+      capture.open(absl::GetFlag(FLAGS_input_video_path));
+    } else {
+      capture.open(0);
+    }
+    RET_CHECK(capture.isOpened());
   }
-  RET_CHECK(capture.isOpened());
 
   cv::VideoWriter writer;
   const bool save_video = !absl::GetFlag(FLAGS_output_video_path).empty();
@@ -79,109 +390,123 @@ absl::Status RunMPPGraph() {
     capture.set(cv::CAP_PROP_FPS, 30);
 #endif
   }
+  const double capture_fps =
+      shm_consumer ? 30 : capture.get(cv::CAP_PROP_FPS);
 
-  LOG(INFO) << "Start running the calculator graph.";
-  ASSIGN_OR_RETURN(mediapipe::OutputStreamPoller poller,
-                   graph.AddOutputStreamPoller(kOutputStream));
-
-  ASSIGN_OR_RETURN(mediapipe::OutputStreamPoller results_poller,
-                   graph.AddOutputStreamPoller("multi_face_proctor_results"));
+  // Files are transcoded without losing frames, live frames are dropped
+  // rather than delayed.
+  std::string drop_policy_name = absl::GetFlag(FLAGS_drop_policy);
+  if (drop_policy_name.empty()) {
+    drop_policy_name = load_video ? "block" : "drop_oldest";
+  }
+  ASSIGN_OR_RETURN(auto drop_policy,
+                   mediapipe::ParseDropPolicy(drop_policy_name));
+  const int queue_size = absl::GetFlag(FLAGS_queue_size);
+  mediapipe::BoundedQueue<mediapipe::Packet> frames(queue_size, drop_policy);
+  mediapipe::BoundedQueue<mediapipe::Packet> output_frames(queue_size,
+                                                           drop_policy);
 
-  // ASSIGN_OR_RETURN(mediapipe::OutputStreamPoller landmarks_poller,
-  //                  graph.AddOutputStreamPoller("image_size"));
+  LOG(INFO) << "Start running the calculator graph.";
+  const bool render = HasOutputStream(config, kOutputStream);
+  if (render) {
+    MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+        kOutputStream, [&output_frames](const mediapipe::Packet& packet) {
+          output_frames.Push(packet);
+          return absl::OkStatus();
+        }));
+  }
+  if (HasOutputStream(config, kResultsStream)) {
+    MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+        kResultsStream, [](const mediapipe::Packet& packet) {
+          const auto& results = packet.Get<std::vector<ProctorResult>>();
+          VLOG(1) << packet.Timestamp() << ": " << results.size()
+                  << " face(s)";
+          return absl::OkStatus();
+        }));
+  }
 
-  MP_RETURN_IF_ERROR(graph.StartRun({}));
+  MP_RETURN_IF_ERROR(graph.StartRun(side_packets));
 
   LOG(INFO) << "Start grabbing and processing frames.";
-  
-  bool grab_frames = true;
-  int timeout = 0;
-  while (grab_frames) {
-    // Capture opencv camera or video frame.
-    cv::Mat camera_frame_raw;
-    capture >> camera_frame_raw;
-    if (camera_frame_raw.empty()) {
-      if (!load_video) {
-        LOG(INFO) << "Ignore empty frames from camera.";
-        continue;
-      }
-      LOG(INFO) << "Empty frame, end of video reached.";
-      break;
-    }
-    cv::Mat camera_frame;
-    cv::cvtColor(camera_frame_raw, camera_frame, cv::COLOR_BGR2RGB);
-    if (!load_video) {
-      cv::flip(camera_frame, camera_frame, /*flipcode=HORIZONTAL*/ 1);
-    }
-
-    // Wrap Mat into an ImageFrame.
-    auto input_frame = absl::make_unique<mediapipe::ImageFrame>(
-        mediapipe::ImageFormat::SRGB, camera_frame.cols, camera_frame.rows,
-        mediapipe::ImageFrame::kDefaultorientationBoundary);
-    cv::Mat input_frame_mat = mediapipe::formats::MatView(input_frame.get());
-    camera_frame.copyTo(input_frame_mat);
-
-    // Send image packet into the graph.
-    size_t frame_timestamp_us =
-        (double)cv::getTickCount() / (double)cv::getTickFrequency() * 1e6;
-    MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
-        kInputStream, mediapipe::Adopt(input_frame.release())
-                          .At(mediapipe::Timestamp(frame_timestamp_us))));
-
-    mediapipe::Packet results_packet;
-    if (results_poller.QueueSize() > 0 && results_poller.Next(&results_packet))
-    {
-      auto& results = results_packet.Get<std::vector<ProctorResult>>();
-      for (auto& result: results)
-      { 
-        // std::cout << frame_timestamp_us << std::endl;
-      }
-      timeout = 0;
-    } else if(timeout < 20)
-    {
-      timeout++;
-      continue;
-    }
-
-    cv::Mat output_frame_mat;
-    if(poller.QueueSize() > 0)
-    {
-      mediapipe::Packet packet;
-      if(!poller.Next(&packet)) { break; }
-      auto& output_frame = packet.Get<mediapipe::ImageFrame>();
-      output_frame_mat = mediapipe::formats::MatView(&output_frame);
-    } else
-    {
-      auto output_frame = absl::make_unique<mediapipe::ImageFrame>(
-        mediapipe::ImageFormat::SRGB, camera_frame.cols, camera_frame.rows,
-        mediapipe::ImageFrame::kDefaultorientationBoundary);
-      output_frame_mat = mediapipe::formats::MatView(output_frame.get());
-      camera_frame.copyTo(output_frame_mat);
-    }
+  std::thread capture_thread;
+  if (shm_consumer) {
+    capture_thread =
+        std::thread(ReceiveFrames, shm_consumer.get(), &frames);
+  } else {
+    capture_thread =
+        std::thread(CaptureFrames, &capture, load_video, yuv, &frames);
+  }
+  absl::Status process_status;
+  SentFrames sent;
+  std::thread process_thread([&]() {
+    process_status =
+        ProcessFrames(&graph, yuv ? kYuvInputStream : kInputStream, render,
+                      &frames, &output_frames, save_video ? &sent : nullptr);
+    output_frames.Close();
+  });
 
+  // Display stays on the main thread, as HighGUI expects.
+  bool writer_failed = false;
+  mediapipe::Packet packet;
+  cv::Mat output_frame_mat;
+  cv::Mat last_frame_mat;
+  while (output_frames.Pop(&packet)) {
     // Convert back to opencv for display or saving.
-    cv::cvtColor(output_frame_mat, output_frame_mat, cv::COLOR_RGB2BGR);
+    if (packet.ValidateAsType<mediapipe::YUVImage>().ok()) {
+      // Unrendered input, packed by MakeYuvImage().
+      const auto& yuv_frame = packet.Get<mediapipe::YUVImage>();
+      cv::Mat i420(yuv_frame.height() * 3 / 2, yuv_frame.width(), CV_8UC1,
+                   const_cast<uint8*>(yuv_frame.data(0)));
+      cv::cvtColor(i420, output_frame_mat, cv::COLOR_YUV2BGR_I420);
+    } else {
+      const auto& output_frame = packet.Get<mediapipe::ImageFrame>();
+      cv::cvtColor(mediapipe::formats::MatView(&output_frame),
+                   output_frame_mat, cv::COLOR_RGB2BGR);
+    }
     if (save_video) {
       if (!writer.isOpened()) {
         LOG(INFO) << "Prepare video writer.";
         writer.open(absl::GetFlag(FLAGS_output_video_path),
                     mediapipe::fourcc('a', 'v', 'c', '1'),  // .mp4
-                    capture.get(cv::CAP_PROP_FPS), output_frame_mat.size());
-        RET_CHECK(writer.isOpened());
+                    capture_fps, output_frame_mat.size());
+        if (!writer.isOpened()) {
+          writer_failed = true;
+          break;
+        }
+      }
+      // Frames dropped by the flow limiter or the output queue, or skipped
+      // by the gate or the sampler, repeat the previous frame, so that the
+      // video keeps the duration of the capture.
+      const int missing = sent.TakeUntil(packet.Timestamp()) - 1;
+      for (int i = 0; i < missing; ++i) {
+        writer.write(last_frame_mat.empty() ? output_frame_mat
+                                            : last_frame_mat);
       }
       writer.write(output_frame_mat);
+      cv::swap(last_frame_mat, output_frame_mat);
     } else {
       cv::imshow(kWindowName, output_frame_mat);
       // Press any key to exit.
       const int pressed_key = cv::waitKey(5);
-      if (pressed_key >= 0 && pressed_key != 255) grab_frames = false;
+      if (pressed_key >= 0 && pressed_key != 255) break;
     }
   }
 
   LOG(INFO) << "Shutting down.";
+  frames.Close();
+  output_frames.Close();
+  capture_thread.join();
+  process_thread.join();
+  if (writer.isOpened() && !last_frame_mat.empty()) {
+    // The frames after the last rendered one.
+    for (int i = sent.TakeAll(); i > 0; --i) writer.write(last_frame_mat);
+  }
+  LOG(INFO) << "Dropped " << frames.dropped() << " captured and "
+            << output_frames.dropped() << " output frames.";
   if (writer.isOpened()) writer.release();
-  MP_RETURN_IF_ERROR(graph.CloseInputStream(kInputStream));
-  return graph.WaitUntilDone();
+  MP_RETURN_IF_ERROR(process_status);
+  RET_CHECK(!writer_failed) << "Could not open the video writer.";
+  return absl::OkStatus();
 }
 
 int main(int argc, char** argv) {
@@ -0,0 +1,196 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Embeddable proctoring engine
+#include "mp_proctor/engine/proctor_engine.h"
+
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "mp_proctor/graphs/module_toggles.h"
+#include "mp_proctor/graphs/proctor_graph_builder.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        bool HasOutputStream(const CalculatorGraphConfig& config, const std::string& name)
+        {
+            for (const auto& entry: config.output_stream())
+            {
+                if (entry == name || absl::EndsWith(entry, ":" + name)) { return true; }
+            }
+            return false;
+        }
+    } // namespace
+
+    ProctorEngine::ProctorEngine(const ProctorEngineOptions& options)
+        : m_frames(options.max_queue_size, options.drop_policy)
+    {}
+
+    ProctorEngine::~ProctorEngine()
+    { this->Close().IgnoreError(); }
+
+    absl::StatusOr<std::unique_ptr<ProctorEngine>> ProctorEngine::Create(
+        const ProctorEngineOptions& options,
+        EngineResultsCallback on_results,
+        EngineFrameCallback on_frame
+    )
+    {
+        RET_CHECK(on_results || on_frame) << "ProctorEngine needs a callback";
+        CalculatorGraphConfig config = options.config;
+        if (config.node_size() == 0)
+        {
+            // Only the nodes the callbacks need
+            std::string outputs = on_results ? "results": "";
+            if (on_frame) { outputs += on_results ? ",video": "video"; }
+            ASSIGN_OR_RETURN(auto request, ParseProctorGraphRequest(outputs));
+            ASSIGN_OR_RETURN(config, BuildProctorGraph(request));
+        }
+        MP_RETURN_IF_ERROR(ApplyModuleToggles(options.side_packets, &config));
+
+        std::unique_ptr<ProctorEngine> engine(new ProctorEngine(options));
+        MP_RETURN_IF_ERROR(engine->Start(
+            std::move(config), options.side_packets, std::move(on_results), std::move(on_frame)
+        ));
+        return engine;
+    }
+
+    absl::Status ProctorEngine::Start(
+        CalculatorGraphConfig config,
+        const std::map<std::string, Packet>& side_packets,
+        EngineResultsCallback on_results,
+        EngineFrameCallback on_frame
+    )
+    {
+        MP_RETURN_IF_ERROR(m_graph.Initialize(config));
+        if (on_results)
+        {
+            RET_CHECK(HasOutputStream(config, kProctorResultsStream))
+                << "The graph has no " << kProctorResultsStream << " output";
+            MP_RETURN_IF_ERROR(m_graph.ObserveOutputStream(
+                kProctorResultsStream,
+                [on_results](const Packet& packet)
+                {
+                    on_results(packet.Timestamp(), packet.Get<std::vector<ProctorResult>>());
+                    return absl::OkStatus();
+                }
+            ));
+        }
+        if (on_frame)
+        {
+            RET_CHECK(HasOutputStream(config, kProctorOutputStream))
+                << "The graph has no " << kProctorOutputStream << " output";
+            MP_RETURN_IF_ERROR(m_graph.ObserveOutputStream(
+                kProctorOutputStream,
+                [on_frame](const Packet& packet)
+                {
+                    on_frame(packet.Timestamp(), packet.Get<ImageFrame>());
+                    return absl::OkStatus();
+                }
+            ));
+        }
+        MP_RETURN_IF_ERROR(m_graph.StartRun(side_packets));
+        m_feeder = std::thread(&ProctorEngine::FeedGraph, this);
+        return absl::OkStatus();
+    }
+
+    void ProctorEngine::FeedGraph()
+    {
+        Packet packet;
+        while (m_frames.Pop(&packet))
+        {
+            absl::Status status = m_graph.AddPacketToInputStream(kProctorInputStream, std::move(packet));
+            if (!status.ok())
+            {
+                absl::MutexLock lock(&m_mutex);
+                m_feed_status = status;
+                m_frames.Close();
+                break;
+            }
+        }
+    }
+
+    absl::Status ProctorEngine::Enqueue(Packet packet, int64 timestamp_us)
+    {
+        // Concurrent submissions are queued in the order they were checked,
+        // without holding m_mutex while a blocking push waits for the feeder
+        absl::MutexLock submit_lock(&m_submit_mutex);
+        {
+            absl::MutexLock lock(&m_mutex);
+            if (m_closed) { return absl::FailedPreconditionError("The engine is closed"); }
+            MP_RETURN_IF_ERROR(m_feed_status);
+            if (timestamp_us <= m_last_timestamp_us)
+            {
+                return absl::InvalidArgumentError("Frame timestamps must increase");
+            }
+            m_last_timestamp_us = timestamp_us;
+        }
+        // A dropped frame is released right away
+        m_frames.Push(std::move(packet).At(Timestamp(timestamp_us)));
+        return absl::OkStatus();
+    }
+
+    absl::Status ProctorEngine::Submit(
+        ImageFormat::Format format, int width, int height, int width_step,
+        const uint8* pixels, int64 timestamp_us, std::function<void()> release
+    )
+    {
+        // The caller's pixels are released on every error path as well
+        const bool is_valid = pixels != nullptr && width > 0 && height > 0 &&
+            width_step >= width * ImageFrame::NumberOfChannelsForFormat(format) *
+                ImageFrame::ByteDepthForFormat(format);
+        if (!is_valid)
+        {
+            if (release) { release(); }
+            return absl::InvalidArgumentError("ProctorEngine: Invalid frame pixels, size or width_step");
+        }
+        // The graph only reads its input frames
+        auto frame = absl::make_unique<ImageFrame>(
+            format, width, height, width_step, const_cast<uint8*>(pixels),
+            [release = std::move(release)](uint8*) { if (release) { release(); } }
+        );
+        return this->Enqueue(Adopt(frame.release()), timestamp_us);
+    }
+
+    absl::Status ProctorEngine::Submit(std::unique_ptr<ImageFrame> frame, int64 timestamp_us)
+    {
+        RET_CHECK(frame != nullptr);
+        return this->Enqueue(Adopt(frame.release()), timestamp_us);
+    }
+
+    absl::Status ProctorEngine::Close()
+    {
+        {
+            absl::MutexLock lock(&m_mutex);
+            if (m_closed) { return absl::OkStatus(); }
+            m_closed = true;
+        }
+        // The queued frames are still fed
+        m_frames.Close();
+        if (m_feeder.joinable()) { m_feeder.join(); }
+
+        absl::Status status;
+        {
+            absl::MutexLock lock(&m_mutex);
+            status = m_feed_status;
+        }
+        status.Update(m_graph.CloseAllInputStreams());
+        status.Update(m_graph.WaitUntilDone());
+        return status;
+    }
+
+} // namespace mediapipe
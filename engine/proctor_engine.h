@@ -0,0 +1,140 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Embeddable proctoring engine
+#ifndef proctor_engine_h
+#define proctor_engine_h
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/bounded_queue.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    // Called from a graph thread with the results of each frame with faces
+    using EngineResultsCallback =
+        std::function<void(Timestamp timestamp, const std::vector<ProctorResult>& results)>;
+    // Called from a graph thread with each annotated frame, which is only
+    // valid during the call
+    using EngineFrameCallback =
+        std::function<void(Timestamp timestamp, const ImageFrame& frame)>;
+
+    /**
+     * @brief Options of ProctorEngine
+     */
+    struct ProctorEngineOptions
+    {
+        // Graph taking input_video, see proctor_cpu.pbtxt. Empty to build a
+        // graph for the given callbacks (see BuildProctorGraph()).
+        CalculatorGraphConfig config;
+        // Side packets of the graph, e.g. the module toggles
+        std::map<std::string, Packet> side_packets;
+
+        // Frames waiting in front of the graph
+        int max_queue_size = 2;
+        // What Submit() does when the queue is full
+        DropPolicy drop_policy = DropPolicy::kDropOldest;
+    };
+
+    /**
+     * @brief Runs a proctoring graph on frames submitted by the host
+     *        application, and reports back through callbacks
+     *
+     * Example:
+     *
+     * ProctorEngineOptions options;
+     * auto engine = ProctorEngine::Create(options, on_results, nullptr);
+     * (*engine)->Submit(ImageFormat::SRGB, width, height, width_step, pixels,
+     *                   timestamp_us, [buffer]() { buffer->Unlock(); });
+     * (*engine)->Close();
+     */
+    class ProctorEngine
+    {
+    private:
+        CalculatorGraph m_graph;
+        BoundedQueue<Packet> m_frames;
+        std::thread m_feeder;
+
+        // Serializes Enqueue, from the timestamp check to the push
+        absl::Mutex m_submit_mutex;
+        absl::Mutex m_mutex;
+        int64 m_last_timestamp_us ABSL_GUARDED_BY(m_mutex) = -1;
+        bool m_closed ABSL_GUARDED_BY(m_mutex) = false;
+        absl::Status m_feed_status ABSL_GUARDED_BY(m_mutex);
+
+        explicit ProctorEngine(const ProctorEngineOptions& options);
+
+        absl::Status Start(
+            CalculatorGraphConfig config,
+            const std::map<std::string, Packet>& side_packets,
+            EngineResultsCallback on_results,
+            EngineFrameCallback on_frame
+        );
+        void FeedGraph();
+        absl::Status Enqueue(Packet packet, int64 timestamp_us);
+
+    public:
+        ~ProctorEngine();
+
+        ProctorEngine(const ProctorEngine&) = delete;
+        ProctorEngine& operator=(const ProctorEngine&) = delete;
+
+        // Either callback may be null
+        static absl::StatusOr<std::unique_ptr<ProctorEngine>> Create(
+            const ProctorEngineOptions& options,
+            EngineResultsCallback on_results,
+            EngineFrameCallback on_frame
+        );
+
+        /**
+         * @brief Submit a frame without copying it
+         *
+         * The pixels must stay valid and unchanged until release is called,
+         * once the graph is done with the frame or the frame is dropped.
+         * release is also called if the frame is rejected with an error.
+         * Timestamps must increase. Submit may be called from several
+         * threads, the frames are queued in the order of their timestamps.
+         */
+        absl::Status Submit(
+            ImageFormat::Format format, int width, int height, int width_step,
+            const uint8* pixels, int64 timestamp_us, std::function<void()> release
+        );
+        // Submit a frame owned by the engine
+        absl::Status Submit(std::unique_ptr<ImageFrame> frame, int64 timestamp_us);
+
+        /**
+         * @brief Process the queued frames, wait for their callbacks and stop
+         *
+         * Further submissions fail.
+         */
+        absl::Status Close();
+
+        // Frames dropped by the queue so far
+        size_t dropped() const { return m_frames.dropped(); }
+    };
+
+} // namespace mediapipe
+
+#endif
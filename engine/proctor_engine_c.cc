@@ -0,0 +1,162 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// C API of ProctorEngine for FFI users
+#include "mp_proctor/engine/proctor_engine_c.h"
+
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mp_proctor/engine/proctor_engine.h"
+#include "mp_proctor/graphs/module_toggles.h"
+
+struct proctor_engine
+{
+    std::unique_ptr<mediapipe::ProctorEngine> engine;
+};
+
+namespace
+{
+    thread_local std::string last_error;
+
+    int ToCode(const absl::Status& status)
+    {
+        if (!status.ok()) { last_error = std::string(status.message()); }
+        return static_cast<int>(status.code());
+    }
+
+    bool IsSupportedFormat(proctor_image_format format)
+    {
+        return format == PROCTOR_FORMAT_SRGB || format == PROCTOR_FORMAT_SRGBA ||
+            format == PROCTOR_FORMAT_GRAY8;
+    }
+} // namespace
+
+void proctor_engine_options_init(proctor_engine_options* options)
+{
+    options->max_queue_size = 2;
+    options->drop_policy = PROCTOR_DROP_OLDEST;
+    options->enable_reid = true;
+    options->enable_affect = true;
+    options->enable_render = true;
+}
+
+int proctor_engine_create(
+    const char* graph_config, const proctor_engine_options* options,
+    proctor_results_callback on_results, proctor_frame_callback on_frame,
+    void* user_data, proctor_engine** engine)
+{
+    if (engine == nullptr) { return ToCode(absl::InvalidArgumentError("engine is NULL")); }
+    *engine = nullptr;
+    proctor_engine_options defaults;
+    proctor_engine_options_init(&defaults);
+    if (options == nullptr) { options = &defaults; }
+
+    mediapipe::ProctorEngineOptions engine_options;
+    if (graph_config != nullptr &&
+        !mediapipe::ParseTextProto<mediapipe::CalculatorGraphConfig>(graph_config, &engine_options.config))
+    {
+        return ToCode(absl::InvalidArgumentError("Could not parse the graph config"));
+    }
+    engine_options.max_queue_size = options->max_queue_size;
+    switch (options->drop_policy)
+    {
+        case PROCTOR_DROP_BLOCK:  engine_options.drop_policy = mediapipe::DropPolicy::kBlock; break;
+        case PROCTOR_DROP_NEWEST: engine_options.drop_policy = mediapipe::DropPolicy::kDropNewest; break;
+        default:                  engine_options.drop_policy = mediapipe::DropPolicy::kDropOldest; break;
+    }
+    // Without on_frame the renderer is cut off, the toggles keep FINISHED ticking
+    engine_options.side_packets = {
+        {mediapipe::kEnableReidSidePacket, mediapipe::MakePacket<bool>(options->enable_reid)},
+        {mediapipe::kEnableAffectSidePacket, mediapipe::MakePacket<bool>(options->enable_affect)},
+        {mediapipe::kEnableRenderSidePacket, mediapipe::MakePacket<bool>(options->enable_render && on_frame != nullptr)},
+    };
+
+    mediapipe::EngineResultsCallback results_callback;
+    if (on_results != nullptr)
+    {
+        results_callback = [on_results, user_data](
+            mediapipe::Timestamp timestamp, const std::vector<ProctorResult>& results)
+        { on_results(user_data, timestamp.Value(), results.data(), results.size()); };
+    }
+    mediapipe::EngineFrameCallback frame_callback;
+    if (on_frame != nullptr)
+    {
+        frame_callback = [on_frame, user_data](mediapipe::Timestamp timestamp, const mediapipe::ImageFrame& frame)
+        {
+            on_frame(user_data, timestamp.Value(), frame.PixelData(), frame.Width(), frame.Height(), frame.WidthStep());
+        };
+    }
+
+    auto created = mediapipe::ProctorEngine::Create(engine_options, results_callback, frame_callback);
+    if (!created.ok()) { return ToCode(created.status()); }
+    *engine = new proctor_engine{std::move(created).value()};
+    return PROCTOR_OK;
+}
+
+int proctor_engine_submit(
+    proctor_engine* engine, proctor_image_format format, int width, int height, int width_step,
+    const uint8_t* pixels, int64_t timestamp_us,
+    proctor_release_callback release, void* release_data)
+{
+    // The caller's pixels are released on every error path as well
+    auto reject = [release, release_data, pixels](const absl::Status& status)
+    {
+        if (release != nullptr) { release(release_data, pixels); }
+        return ToCode(status);
+    };
+    if (engine == nullptr || pixels == nullptr)
+    {
+        return reject(absl::InvalidArgumentError("engine or pixels is NULL"));
+    }
+    if (!IsSupportedFormat(format) || width <= 0 || height <= 0)
+    {
+        return reject(absl::InvalidArgumentError("Unsupported frame format or size"));
+    }
+    const auto image_format = static_cast<mediapipe::ImageFormat::Format>(format);
+    if (release != nullptr)
+    {
+        return ToCode(engine->engine->Submit(
+            image_format, width, height, width_step, pixels, timestamp_us,
+            [release, release_data, pixels]() { release(release_data, pixels); }
+        ));
+    }
+
+    const int row_bytes = width * mediapipe::ImageFrame::NumberOfChannelsForFormat(image_format);
+    if (width_step < row_bytes) { return ToCode(absl::InvalidArgumentError("width_step is too small")); }
+    auto frame = absl::make_unique<mediapipe::ImageFrame>(
+        image_format, width, height, mediapipe::ImageFrame::kDefaultAlignmentBoundary
+    );
+    for (int row = 0; row < height; ++row)
+    {
+        std::memcpy(frame->MutablePixelData() + row * frame->WidthStep(), pixels + row * width_step, row_bytes);
+    }
+    return ToCode(engine->engine->Submit(std::move(frame), timestamp_us));
+}
+
+int proctor_engine_close(proctor_engine* engine)
+{
+    if (engine == nullptr) { return ToCode(absl::InvalidArgumentError("engine is NULL")); }
+    return ToCode(engine->engine->Close());
+}
+
+void proctor_engine_destroy(proctor_engine* engine)
+{ delete engine; }
+
+const char* proctor_last_error(void)
+{ return last_error.c_str(); }
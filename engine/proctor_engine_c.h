@@ -0,0 +1,103 @@
+/* Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * C API of ProctorEngine for FFI users
+ */
+#ifndef proctor_engine_c_h
+#define proctor_engine_c_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct proctor_engine proctor_engine;
+
+/* Same values as mediapipe::ImageFormat */
+typedef enum
+{
+    PROCTOR_FORMAT_SRGB  = 1,
+    PROCTOR_FORMAT_SRGBA = 2,
+    PROCTOR_FORMAT_GRAY8 = 3
+} proctor_image_format;
+
+typedef enum
+{
+    PROCTOR_DROP_BLOCK,
+    PROCTOR_DROP_OLDEST,
+    PROCTOR_DROP_NEWEST
+} proctor_drop_policy;
+
+typedef struct
+{
+    /* Frames waiting in front of the graph */
+    int max_queue_size;
+    proctor_drop_policy drop_policy;
+    bool enable_reid;
+    bool enable_affect;
+    bool enable_render;
+} proctor_engine_options;
+
+/* Called from a graph thread with the results of a frame with faces */
+typedef void (*proctor_results_callback)(
+    void* user_data, int64_t timestamp_us, const struct ProctorResult* results, size_t count);
+/* Called from a graph thread with an annotated SRGB frame, valid during the call */
+typedef void (*proctor_frame_callback)(
+    void* user_data, int64_t timestamp_us, const uint8_t* pixels, int width, int height, int width_step);
+/* Called once the engine no longer needs a submitted frame */
+typedef void (*proctor_release_callback)(void* release_data, const uint8_t* pixels);
+
+/* Status codes are absl::StatusCode values, 0 on success */
+#define PROCTOR_OK 0
+
+void proctor_engine_options_init(proctor_engine_options* options);
+
+/*
+ * Create an engine running the text format graph config, or a graph built
+ * for the given callbacks if graph_config is NULL. Either callback may be NULL.
+ */
+int proctor_engine_create(
+    const char* graph_config, const proctor_engine_options* options,
+    proctor_results_callback on_results, proctor_frame_callback on_frame,
+    void* user_data, proctor_engine** engine);
+
+/*
+ * Submit a frame. With a release callback the pixels are used in place and
+ * must stay valid until it is called, otherwise they are copied. The release
+ * callback is also called if the frame is rejected with an error. Timestamps
+ * must increase; concurrent calls are queued in timestamp order.
+ */
+int proctor_engine_submit(
+    proctor_engine* engine, proctor_image_format format, int width, int height, int width_step,
+    const uint8_t* pixels, int64_t timestamp_us,
+    proctor_release_callback release, void* release_data);
+
+/* Process the queued frames and wait for their callbacks */
+int proctor_engine_close(proctor_engine* engine);
+
+/* Close and free the engine */
+void proctor_engine_destroy(proctor_engine* engine);
+
+/* Message of the last failed call on this thread */
+const char* proctor_last_error(void);
+
+#ifdef __cplusplus
+}  /* extern "C" */
+#endif
+
+#endif
@@ -0,0 +1,234 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Compares the executor presets on a recorded clip.
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/graphs/executor_presets.h"
+#include "mp_proctor/graphs/module_toggles.h"
+
+constexpr char kInputStream[] = "input_video";
+constexpr char kOutputStream[] = "output_video";
+constexpr char kResultsStream[] = "multi_face_proctor_results";
+
+ABSL_FLAG(std::string, calculator_graph_config_file,
+          "mp_proctor/graphs/proctor_cpu.pbtxt",
+          "Name of file containing text format CalculatorGraphConfig proto.");
+ABSL_FLAG(std::string, input_video_path, "",
+          "Full path of the clip to benchmark on.");
+ABSL_FLAG(std::string, presets, "default,split_inference,pinned",
+          "Comma separated executor presets to compare.");
+ABSL_FLAG(int, inference_threads, 1, "Threads of the inference executor.");
+ABSL_FLAG(int, light_threads, 1, "Threads of the light calculator executor.");
+ABSL_FLAG(int, xnnpack_threads, 1,
+          "XNNPACK threads per inference calculator, -1 for the model default.");
+ABSL_FLAG(std::string, inference_cpus, "",
+          "CPUs of the inference executor of the pinned preset, e.g. \"2-3\".");
+ABSL_FLAG(std::string, light_cpus, "",
+          "CPUs of the light calculator executor of the pinned preset.");
+ABSL_FLAG(bool, realtime, true,
+          "Feed the frames at the clip frame rate like a camera would, "
+          "otherwise as fast as possible.");
+ABSL_FLAG(int, max_frames, 0, "Number of frames to use, 0 for the whole clip.");
+
+struct BenchmarkResult {
+  int sent_frames = 0;
+  int analyzed_frames = 0;
+  double seconds = 0;
+  double mean_latency_ms = 0;
+  double p50_latency_ms = 0;
+  double p95_latency_ms = 0;
+};
+
+// Decodes the whole clip up front, so decoding is not part of the benchmark.
+absl::Status LoadClip(std::vector<cv::Mat>* frames, double* fps) {
+  cv::VideoCapture capture(absl::GetFlag(FLAGS_input_video_path));
+  RET_CHECK(capture.isOpened());
+  *fps = capture.get(cv::CAP_PROP_FPS);
+  if (*fps <= 0) *fps = 30;
+
+  const int max_frames = absl::GetFlag(FLAGS_max_frames);
+  cv::Mat frame;
+  while (capture.read(frame)) {
+    cv::Mat rgb;
+    cv::cvtColor(frame, rgb, cv::COLOR_BGR2RGB);
+    frames->push_back(rgb);
+    if (max_frames > 0 && static_cast<int>(frames->size()) >= max_frames) break;
+  }
+  RET_CHECK(!frames->empty()) << "No frames in the clip.";
+  return absl::OkStatus();
+}
+
+// Returns true if the graph declares the given output stream.
+bool HasOutputStream(const mediapipe::CalculatorGraphConfig& config,
+                     const std::string& name) {
+  for (const auto& entry : config.output_stream()) {
+    if (entry == name || absl::EndsWith(entry, ":" + name)) return true;
+  }
+  return false;
+}
+
+double Percentile(const std::vector<double>& sorted, double q) {
+  if (sorted.empty()) return 0;
+  return sorted[std::min(sorted.size() - 1,
+                         static_cast<size_t>(q * sorted.size()))];
+}
+
+absl::StatusOr<BenchmarkResult> RunPreset(
+    const mediapipe::CalculatorGraphConfig& base_config,
+    const std::string& preset,
+    const mediapipe::ExecutorPresetOptions& options,
+    const std::vector<cv::Mat>& frames, double fps) {
+  mediapipe::CalculatorGraphConfig config = base_config;
+  // Which frames the gate and the sampler skip depends on timing, so every
+  // preset would be measured on a different set of analyzed frames.
+  MP_RETURN_IF_ERROR(mediapipe::BypassCalculators(
+      {"FrameChangeGateCalculator", "AdaptiveFrameSamplerCalculator"},
+      &config));
+  MP_RETURN_IF_ERROR(mediapipe::ApplyExecutorPreset(preset, options, &config));
+
+  mediapipe::CalculatorGraph graph;
+  MP_RETURN_IF_ERROR(graph.Initialize(config));
+
+  // A frame counts as analyzed once it is rendered, or once its results are
+  // out if the graph does not render.
+  const std::string done_stream =
+      HasOutputStream(config, kOutputStream) ? kOutputStream : kResultsStream;
+  absl::Mutex mutex;
+  std::map<int64, absl::Time> sent_at;
+  std::vector<double> latencies_ms;
+  MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+      done_stream, [&](const mediapipe::Packet& packet) {
+        const absl::Time now = absl::Now();
+        absl::MutexLock lock(&mutex);
+        auto it = sent_at.find(packet.Timestamp().Value());
+        if (it != sent_at.end()) {
+          latencies_ms.push_back(absl::ToDoubleMilliseconds(now - it->second));
+          sent_at.erase(sent_at.begin(), std::next(it));
+        }
+        return absl::OkStatus();
+      }));
+  MP_RETURN_IF_ERROR(graph.StartRun({}));
+
+  const absl::Duration period = absl::Seconds(1.0 / fps);
+  const absl::Time start = absl::Now();
+  for (size_t i = 0; i < frames.size(); ++i) {
+    if (absl::GetFlag(FLAGS_realtime)) {
+      const absl::Time deadline = start + period * static_cast<int64>(i);
+      if (deadline > absl::Now()) absl::SleepFor(deadline - absl::Now());
+    }
+
+    auto input_frame = absl::make_unique<mediapipe::ImageFrame>(
+        mediapipe::ImageFormat::SRGB, frames[i].cols, frames[i].rows,
+        mediapipe::ImageFrame::kDefaultAlignmentBoundary);
+    frames[i].copyTo(mediapipe::formats::MatView(input_frame.get()));
+
+    const mediapipe::Timestamp timestamp(
+        static_cast<int64>(i * absl::ToInt64Microseconds(period)));
+    {
+      absl::MutexLock lock(&mutex);
+      sent_at[timestamp.Value()] = absl::Now();
+    }
+    MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+        kInputStream, mediapipe::Adopt(input_frame.release()).At(timestamp)));
+  }
+  MP_RETURN_IF_ERROR(graph.CloseAllInputStreams());
+  MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+
+  BenchmarkResult result;
+  result.sent_frames = frames.size();
+  result.seconds = absl::ToDoubleSeconds(absl::Now() - start);
+  absl::MutexLock lock(&mutex);
+  result.analyzed_frames = latencies_ms.size();
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  for (double latency : latencies_ms) result.mean_latency_ms += latency;
+  if (!latencies_ms.empty()) result.mean_latency_ms /= latencies_ms.size();
+  result.p50_latency_ms = Percentile(latencies_ms, 0.50);
+  result.p95_latency_ms = Percentile(latencies_ms, 0.95);
+  return result;
+}
+
+absl::Status RunBenchmark() {
+  std::string calculator_graph_config_contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file),
+      &calculator_graph_config_contents));
+  const auto config =
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+
+  mediapipe::ExecutorPresetOptions options;
+  options.inference_threads = absl::GetFlag(FLAGS_inference_threads);
+  options.light_threads = absl::GetFlag(FLAGS_light_threads);
+  options.xnnpack_threads = absl::GetFlag(FLAGS_xnnpack_threads);
+  ASSIGN_OR_RETURN(options.inference_cpus,
+                   mediapipe::ParseCpuList(absl::GetFlag(FLAGS_inference_cpus)));
+  ASSIGN_OR_RETURN(options.light_cpus,
+                   mediapipe::ParseCpuList(absl::GetFlag(FLAGS_light_cpus)));
+
+  std::vector<cv::Mat> frames;
+  double fps = 0;
+  MP_RETURN_IF_ERROR(LoadClip(&frames, &fps));
+  LOG(INFO) << "Loaded " << frames.size() << " frames at " << fps << " fps.";
+
+  std::cout << absl::StrFormat("%-16s %8s %8s %8s %10s %10s %10s\n", "preset",
+                               "sent", "analyzed", "fps", "mean_ms",
+                               "p50_ms", "p95_ms");
+  for (const auto& preset :
+       absl::StrSplit(absl::GetFlag(FLAGS_presets), ',', absl::SkipEmpty())) {
+    const std::string name(preset);
+    if (name == mediapipe::kPinnedExecutorPreset &&
+        (options.inference_cpus.empty() || options.light_cpus.empty())) {
+      LOG(WARNING) << "Skipping the pinned preset, no CPUs given.";
+      continue;
+    }
+    ASSIGN_OR_RETURN(auto result, RunPreset(config, name, options, frames, fps));
+    std::cout << absl::StrFormat(
+        "%-16s %8d %8d %8.1f %10.1f %10.1f %10.1f\n", name, result.sent_frames,
+        result.analyzed_frames, result.analyzed_frames / result.seconds,
+        result.mean_latency_ms, result.p50_latency_ms, result.p95_latency_ms);
+  }
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = RunBenchmark();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the benchmark: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,157 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Named executor topologies for the proctoring graph
+#include "mp_proctor/graphs/executor_presets.h"
+
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+#include "mediapipe/calculators/tensor/inference_calculator.pb.h"
+#include "mediapipe/calculators/tflite/tflite_inference_calculator.pb.h"
+#include "mediapipe/framework/thread_pool_executor.pb.h"
+#include "mediapipe/framework/tool/subgraph_expansion.h"
+#include "mp_proctor/graphs/pinned_thread_pool_executor.pb.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kThreadPoolExecutorType[]       = "ThreadPoolExecutor";
+        constexpr char kPinnedThreadPoolExecutorType[] = "PinnedThreadPoolExecutor";
+
+        // InferenceCalculator expands to InferenceCalculatorCpu and the like
+        bool IsInference(const CalculatorGraphConfig::Node& node)
+        {
+            return absl::StartsWith(node.calculator(), "InferenceCalculator") ||
+                node.calculator() == "TfLiteInferenceCalculator";
+        }
+
+        void LimitXnnpackThreads(int num_threads, CalculatorGraphConfig::Node* node)
+        {
+            auto* options = node->mutable_options();
+            if (options->HasExtension(InferenceCalculatorOptions::ext))
+            {
+                auto* delegate = options->MutableExtension(InferenceCalculatorOptions::ext)->mutable_delegate();
+                if (delegate->has_xnnpack()) { delegate->mutable_xnnpack()->set_num_threads(num_threads); }
+            }
+            if (options->HasExtension(TfLiteInferenceCalculatorOptions::ext))
+            {
+                auto* delegate = options->MutableExtension(TfLiteInferenceCalculatorOptions::ext)->mutable_delegate();
+                if (delegate->has_xnnpack()) { delegate->mutable_xnnpack()->set_num_threads(num_threads); }
+            }
+        }
+
+        void AddThreadPoolExecutor(const std::string& name, int num_threads, CalculatorGraphConfig* config)
+        {
+            auto* executor = config->add_executor();
+            executor->set_name(name);
+            executor->set_type(kThreadPoolExecutorType);
+            auto* options = executor->mutable_options()->MutableExtension(ThreadPoolExecutorOptions::ext);
+            options->set_num_threads(num_threads);
+            options->set_thread_name_prefix(absl::StrCat("mp_", name));
+        }
+
+        void AddPinnedExecutor(
+            const std::string& name,
+            int num_threads,
+            const std::set<int>& cpus,
+            CalculatorGraphConfig* config
+        )
+        {
+            auto* executor = config->add_executor();
+            executor->set_name(name);
+            executor->set_type(kPinnedThreadPoolExecutorType);
+            auto* options = executor->mutable_options()->MutableExtension(PinnedThreadPoolExecutorOptions::ext);
+            options->set_num_threads(num_threads);
+            options->set_thread_name_prefix(absl::StrCat("mp_", name));
+            for (int cpu: cpus) { options->add_cpu_ids(cpu); }
+        }
+    } // namespace
+
+    absl::StatusOr<std::set<int>> ParseCpuList(const std::string& cpus)
+    {
+        std::set<int> cpu_set;
+        for (absl::string_view range: absl::StrSplit(cpus, ',', absl::SkipWhitespace()))
+        {
+            std::vector<absl::string_view> bounds = absl::StrSplit(range, '-');
+            int first = 0, last = 0;
+            if (bounds.size() > 2 || !absl::SimpleAtoi(bounds.front(), &first) ||
+                !absl::SimpleAtoi(bounds.back(), &last) || first < 0 || last < first)
+            {
+                return absl::InvalidArgumentError(absl::StrCat("Invalid CPU range: ", range));
+            }
+            for (int cpu = first; cpu <= last; ++cpu) { cpu_set.insert(cpu); }
+        }
+        return cpu_set;
+    }
+
+    absl::Status ApplyExecutorPreset(
+        const std::string& preset,
+        const ExecutorPresetOptions& options,
+        CalculatorGraphConfig* config
+    )
+    {
+        if (preset == kDefaultExecutorPreset) { return absl::OkStatus(); }
+
+        const bool pinned = preset == kPinnedExecutorPreset;
+        if (!pinned && preset != kSplitInferenceExecutorPreset)
+        {
+            return absl::InvalidArgumentError(absl::StrCat("Unknown executor preset: ", preset));
+        }
+        if (options.inference_threads <= 0 || options.light_threads <= 0)
+        {
+            return absl::InvalidArgumentError("Executor presets need at least one thread per executor!");
+        }
+        if (pinned && (options.inference_cpus.empty() || options.light_cpus.empty()))
+        {
+            return absl::InvalidArgumentError("The pinned executor preset needs inference and light CPUs!");
+        }
+        for (const auto& executor: config->executor())
+        {
+            if (executor.name() == kInferenceExecutor || executor.name() == kLightExecutor)
+            {
+                return absl::AlreadyExistsError(absl::StrCat("Executor already defined: ", executor.name()));
+            }
+        }
+
+        MP_RETURN_IF_ERROR(tool::ExpandSubgraphs(config));
+
+        for (auto& node: *config->mutable_node())
+        {
+            const bool is_inference = IsInference(node);
+            if (is_inference && options.xnnpack_threads > 0)
+            {
+                LimitXnnpackThreads(options.xnnpack_threads, &node);
+            }
+            // Keep the executors assigned by the graph itself
+            if (!node.executor().empty()) { continue; }
+            node.set_executor(is_inference ? kInferenceExecutor: kLightExecutor);
+        }
+
+        if (pinned)
+        {
+            AddPinnedExecutor(kInferenceExecutor, options.inference_threads, options.inference_cpus, config);
+            AddPinnedExecutor(kLightExecutor, options.light_threads, options.light_cpus, config);
+        } else
+        {
+            AddThreadPoolExecutor(kInferenceExecutor, options.inference_threads, config);
+            AddThreadPoolExecutor(kLightExecutor, options.light_threads, config);
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,87 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Named executor topologies for the proctoring graph
+#ifndef executor_presets_h
+#define executor_presets_h
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe
+{
+    // Preset names
+    constexpr char kDefaultExecutorPreset[]        = "default";
+    constexpr char kSplitInferenceExecutorPreset[] = "split_inference";
+    constexpr char kPinnedExecutorPreset[]         = "pinned";
+
+    // Executors added by the split_inference and pinned presets
+    constexpr char kInferenceExecutor[] = "inference";
+    constexpr char kLightExecutor[]     = "light";
+
+    /**
+     * @brief Parameters of the executor presets
+     */
+    struct ExecutorPresetOptions
+    {
+        // Threads running the inference calculators
+        int inference_threads = 1;
+        // Threads running all the other calculators
+        int light_threads = 1;
+        // XNNPACK threads of each inference calculator, -1 keeps the model default
+        int xnnpack_threads = 1;
+
+        // CPUs of the pinned preset, should not overlap
+        std::set<int> inference_cpus;
+        std::set<int> light_cpus;
+    };
+
+    /**
+     * @brief Parse a CPU list such as "0-3,6"
+     */
+    absl::StatusOr<std::set<int>> ParseCpuList(const std::string& cpus);
+
+    /**
+     * @brief Assign the nodes of the graph to the executors of a preset
+     *
+     * default          - Leave the graph on MediaPipe's default executor.
+     * split_inference  - Run the TFLite inference calculators on the
+     *                    "inference" executor and everything else on the
+     *                    "light" executor, so landmark calculators do not
+     *                    queue behind inference calls.
+     * pinned           - Same as split_inference, with both executors pinned
+     *                    to inference_cpus and light_cpus respectively.
+     *
+     * Subgraphs are expanded in place, since the inference calculators live
+     * inside FaceLandmarkFrontCpu, FaceReidentificationCpu and FaceAffectCpu.
+     * The XNNPACK delegate of each inference calculator is limited to
+     * xnnpack_threads, so it does not compete with the scheduler threads.
+     *
+     * Must be called after ApplyModuleToggles(), which matches the subgraphs
+     * by name, and before CalculatorGraph::Initialize().
+     */
+    absl::Status ApplyExecutorPreset(
+        const std::string& preset,
+        const ExecutorPresetOptions& options,
+        CalculatorGraphConfig* config
+    );
+
+} // namespace mediapipe
+
+#endif
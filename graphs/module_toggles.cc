@@ -0,0 +1,394 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Runtime module toggles for the proctoring graph
+#include "mp_proctor/graphs/module_toggles.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kReidCalculator[]     = "FaceReidentificationCpu";
+        constexpr char kReidYuvCalculator[]  = "FaceReidentificationYuvCpu";
+        constexpr char kAffectCalculator[]   = "FaceAffectCpu";
+        constexpr char kRendererCalculator[] = "FaceRendererCpu";
+        constexpr char kFinishedCalculator[] = "FrameFinishedCalculator";
+
+        // "TAG:0:name" -> "name"
+        std::string StreamName(const std::string& entry)
+        {
+            auto pos = entry.rfind(':');
+            return pos == std::string::npos ? entry: entry.substr(pos + 1);
+        }
+
+        // "TAG:0:name" -> "TAG:0", "TAG:name" -> "TAG"
+        std::string TagIndex(const std::string& entry)
+        {
+            auto pos = entry.rfind(':');
+            return pos == std::string::npos ? "": entry.substr(0, pos);
+        }
+
+        // Streams read by the nodes or declared as graph outputs
+        std::set<std::string> ConsumedStreams(
+            const std::vector<CalculatorGraphConfig::Node>& nodes,
+            const CalculatorGraphConfig& config
+        )
+        {
+            std::set<std::string> consumed;
+            for (const auto& entry: config.output_stream()) { consumed.insert(StreamName(entry)); }
+            for (const auto& node: nodes)
+            {
+                for (const auto& entry: node.input_stream()) { consumed.insert(StreamName(entry)); }
+            }
+            return consumed;
+        }
+
+        // True if every output of the node was read before and nobody reads it now
+        bool IsDead(
+            const CalculatorGraphConfig::Node& node,
+            const std::set<std::string>& consumed_before,
+            const std::set<std::string>& consumed
+        )
+        {
+            if (node.output_stream_size() == 0 || node.output_side_packet_size() > 0) { return false; }
+            for (const auto& entry: node.output_stream())
+            {
+                const auto name = StreamName(entry);
+                if (!consumed_before.count(name) || consumed.count(name)) { return false; }
+            }
+            return true;
+        }
+
+        // "TAG:0:name", "other" -> "TAG:0:other"
+        std::string Renamed(const std::string& entry, const std::string& name)
+        {
+            const auto tag_index = TagIndex(entry);
+            return tag_index.empty() ? name: tag_index + ":" + name;
+        }
+
+        bool IsBackEdge(const CalculatorGraphConfig::Node& node, const std::string& entry)
+        {
+            for (const auto& info: node.input_stream_info())
+            {
+                if (info.back_edge() && info.tag_index() == TagIndex(entry)) { return true; }
+            }
+            return false;
+        }
+
+        absl::StatusOr<bool> IsEnabled(
+            const std::map<std::string, Packet>& side_packets,
+            const std::string& name
+        )
+        {
+            auto it = side_packets.find(name);
+            if (it == side_packets.end()) { return true; }
+            MP_RETURN_IF_ERROR(it->second.ValidateAsType<bool>());
+            return it->second.Get<bool>();
+        }
+
+        // Rewires the inputs of a node, returns false if the node lost all of its inputs
+        bool RewireInputs(
+            const std::set<std::string>& produced,
+            const std::map<std::string, std::string>& back_edge_aliases,
+            CalculatorGraphConfig::Node* node,
+            bool* changed
+        )
+        {
+            if (node->input_stream_size() == 0) { return true; }
+
+            std::vector<std::string> inputs;
+            std::set<std::string> dropped_tags;
+            for (const auto& entry: node->input_stream())
+            {
+                const auto name = StreamName(entry);
+                if (produced.count(name))
+                {
+                    inputs.push_back(entry);
+                    continue;
+                }
+                auto alias = back_edge_aliases.find(name);
+                if (IsBackEdge(*node, entry) && alias != back_edge_aliases.end() && produced.count(alias->second))
+                {
+                    inputs.push_back(Renamed(entry, alias->second));
+                } else
+                {
+                    dropped_tags.insert(TagIndex(entry));
+                }
+                *changed = true;
+            }
+
+            node->clear_input_stream();
+            for (const auto& entry: inputs) { node->add_input_stream(entry); }
+
+            std::vector<InputStreamInfo> infos;
+            for (const auto& info: node->input_stream_info())
+            {
+                if (!dropped_tags.count(info.tag_index())) { infos.push_back(info); }
+            }
+            node->clear_input_stream_info();
+            for (const auto& info: infos) { *node->add_input_stream_info() = info; }
+
+            return !inputs.empty();
+        }
+
+        std::set<std::string> ProducedStreams(const CalculatorGraphConfig& config)
+        {
+            std::set<std::string> produced;
+            for (const auto& entry: config.input_stream()) { produced.insert(StreamName(entry)); }
+            for (const auto& node: config.node())
+            {
+                for (const auto& entry: node.output_stream()) { produced.insert(StreamName(entry)); }
+            }
+            return produced;
+        }
+
+        // Walks up the producers that would be removed, e.g. a converter
+        // feeding only the renderer, to a stream that is still produced
+        std::string KeptSource(
+            const CalculatorGraphConfig& config,
+            const std::set<std::string>& kept,
+            std::string name
+        )
+        {
+            for (int depth = 0; depth < config.node_size() && !kept.count(name); depth++)
+            {
+                const CalculatorGraphConfig::Node* producer = nullptr;
+                for (const auto& node: config.node())
+                {
+                    for (const auto& entry: node.output_stream())
+                    {
+                        if (StreamName(entry) == name) { producer = &node; }
+                    }
+                }
+                if (producer == nullptr || producer->input_stream_size() == 0) { return ""; }
+                name = StreamName(producer->input_stream(0));
+            }
+            return kept.count(name) ? name: "";
+        }
+
+        // True if the input only uses the packets to learn that a frame finished
+        bool IsFinishSignal(const CalculatorGraphConfig::Node& node, const std::string& entry)
+        {
+            return IsBackEdge(node, entry) || node.calculator() == kFinishedCalculator;
+        }
+
+        // Replaces the rendered frames signaling finished frames, e.g. on the
+        // FINISHED back edge of FlowLimiterCalculator, with a
+        // FrameFinishedCalculator ticking at every frame reaching the
+        // renderer, including the frames without faces, which have no results
+        absl::Status SignalFinishedFrames(
+            const std::vector<std::string>& disabled,
+            CalculatorGraphConfig* config
+        )
+        {
+            CalculatorGraphConfig pruned = *config;
+            MP_RETURN_IF_ERROR(RemoveCalculators(disabled, {}, &pruned));
+            const auto kept = ProducedStreams(pruned);
+
+            std::map<std::string, std::string> replaced;
+            std::vector<CalculatorGraphConfig::Node> added;
+            for (const auto& node: config->node())
+            {
+                if (node.calculator() != kRendererCalculator) { continue; }
+                std::string image, results, rendered;
+                for (const auto& entry: node.input_stream())
+                {
+                    if (TagIndex(entry) == "IMAGE") { image = StreamName(entry); }
+                    if (TagIndex(entry) == "RESULT") { results = StreamName(entry); }
+                }
+                for (const auto& entry: node.output_stream())
+                {
+                    if (TagIndex(entry) == "IMAGE") { rendered = StreamName(entry); }
+                }
+
+                const auto tick = KeptSource(*config, kept, image);
+                if (rendered.empty() || tick.empty() || !kept.count(results)) { continue; }
+                CalculatorGraphConfig::Node finished;
+                finished.set_calculator(kFinishedCalculator);
+                finished.add_input_stream("TICK:" + tick);
+                finished.add_input_stream("DONE:0:" + results);
+                finished.add_output_stream("FINISHED:" + rendered + "_finished");
+                replaced[rendered] = rendered + "_finished";
+                added.push_back(finished);
+            }
+
+            bool is_used = false;
+            for (auto& node: *config->mutable_node())
+            {
+                for (auto& entry: *node.mutable_input_stream())
+                {
+                    auto it = replaced.find(StreamName(entry));
+                    if (it == replaced.end() || !IsFinishSignal(node, entry)) { continue; }
+                    entry = Renamed(entry, it->second);
+                    is_used = true;
+                }
+            }
+            if (!is_used) { return absl::OkStatus(); }
+            for (const auto& node: added) { *config->add_node() = node; }
+            return absl::OkStatus();
+        }
+    } // namespace
+
+    absl::Status RemoveCalculators(
+        const std::vector<std::string>& calculators,
+        const std::map<std::string, std::string>& back_edge_aliases,
+        CalculatorGraphConfig* config
+    )
+    {
+        const std::set<std::string> removed(calculators.begin(), calculators.end());
+        const std::vector<CalculatorGraphConfig::Node> all_nodes(config->node().begin(), config->node().end());
+        const auto consumed_before = ConsumedStreams(all_nodes, *config);
+        std::vector<CalculatorGraphConfig::Node> nodes;
+        for (const auto& node: all_nodes)
+        {
+            if (!removed.count(node.calculator())) { nodes.push_back(node); }
+        }
+
+        // Removing a node may leave its consumers without inputs, and its
+        // producers without consumers
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            std::set<std::string> produced;
+            for (const auto& entry: config->input_stream()) { produced.insert(StreamName(entry)); }
+            for (const auto& node: nodes)
+            {
+                for (const auto& entry: node.output_stream()) { produced.insert(StreamName(entry)); }
+            }
+
+            std::vector<CalculatorGraphConfig::Node> kept;
+            for (auto& node: nodes)
+            {
+                if (RewireInputs(produced, back_edge_aliases, &node, &changed))
+                {
+                    kept.push_back(node);
+                } else
+                {
+                    changed = true;
+                }
+            }
+            nodes.swap(kept);
+
+            const auto consumed = ConsumedStreams(nodes, *config);
+            kept.clear();
+            for (const auto& node: nodes)
+            {
+                if (IsDead(node, consumed_before, consumed))
+                {
+                    changed = true;
+                } else
+                {
+                    kept.push_back(node);
+                }
+            }
+            nodes.swap(kept);
+        }
+
+        std::set<std::string> produced;
+        for (const auto& entry: config->input_stream()) { produced.insert(StreamName(entry)); }
+        for (const auto& node: nodes)
+        {
+            for (const auto& entry: node.output_stream()) { produced.insert(StreamName(entry)); }
+        }
+        std::vector<std::string> outputs;
+        for (const auto& entry: config->output_stream())
+        {
+            if (produced.count(StreamName(entry))) { outputs.push_back(entry); }
+        }
+
+        config->clear_node();
+        for (const auto& node: nodes) { *config->add_node() = node; }
+        config->clear_output_stream();
+        for (const auto& entry: outputs) { config->add_output_stream(entry); }
+
+        return absl::OkStatus();
+    }
+
+    absl::Status BypassCalculators(
+        const std::vector<std::string>& calculators,
+        CalculatorGraphConfig* config
+    )
+    {
+        const std::set<std::string> bypassed(calculators.begin(), calculators.end());
+
+        // Outputs forwarding the input of the same tag and index
+        std::map<std::string, std::string> forwarded;
+        for (const auto& node: config->node())
+        {
+            if (!bypassed.count(node.calculator())) { continue; }
+            for (const auto& output: node.output_stream())
+            {
+                for (const auto& input: node.input_stream())
+                {
+                    if (TagIndex(input) == TagIndex(output) && !IsBackEdge(node, input))
+                    {
+                        forwarded[StreamName(output)] = StreamName(input);
+                    }
+                }
+            }
+        }
+
+        for (auto& node: *config->mutable_node())
+        {
+            if (bypassed.count(node.calculator())) { continue; }
+            for (auto& entry: *node.mutable_input_stream())
+            {
+                // Bypassed nodes may be chained
+                std::string name = StreamName(entry);
+                for (auto it = forwarded.find(name); it != forwarded.end(); it = forwarded.find(name))
+                {
+                    name = it->second;
+                }
+                entry = Renamed(entry, name);
+            }
+        }
+
+        return RemoveCalculators(calculators, {}, config);
+    }
+
+    absl::Status ApplyModuleToggles(
+        const std::map<std::string, Packet>& side_packets,
+        CalculatorGraphConfig* config
+    )
+    {
+        ASSIGN_OR_RETURN(bool enable_reid, IsEnabled(side_packets, kEnableReidSidePacket));
+        ASSIGN_OR_RETURN(bool enable_affect, IsEnabled(side_packets, kEnableAffectSidePacket));
+        ASSIGN_OR_RETURN(bool enable_render, IsEnabled(side_packets, kEnableRenderSidePacket));
+
+        std::vector<std::string> disabled;
+        if (!enable_reid)
+        {
+            disabled.push_back(kReidCalculator);
+            disabled.push_back(kReidYuvCalculator);
+        }
+        if (!enable_reid || !enable_affect) { disabled.push_back(kAffectCalculator); }
+
+        if (!enable_render)
+        {
+            disabled.push_back(kRendererCalculator);
+            MP_RETURN_IF_ERROR(SignalFinishedFrames(disabled, config));
+        }
+        if (disabled.empty()) { return absl::OkStatus(); }
+
+        return RemoveCalculators(disabled, {}, config);
+    }
+
+} // namespace mediapipe
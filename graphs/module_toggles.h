@@ -0,0 +1,89 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Runtime module toggles for the proctoring graph
+#ifndef module_toggles_h
+#define module_toggles_h
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+
+namespace mediapipe
+{
+    // Side packet names of the module toggles (bool, enabled if absent)
+    constexpr char kEnableReidSidePacket[]   = "enable_reid";
+    constexpr char kEnableAffectSidePacket[] = "enable_affect";
+    constexpr char kEnableRenderSidePacket[] = "enable_render";
+
+    /**
+     * @brief Cut the branches of the disabled modules off the graph
+     *
+     * Reads the enable_reid, enable_affect and enable_render side packets and
+     * removes FaceReidentificationCpu (or FaceReidentificationYuvCpu),
+     * FaceAffectCpu and FaceRendererCpu accordingly, so disabled branches run
+     * no nodes and load no models. FaceAffectCpu is removed together with
+     * the re-id subgraph since it consumes the re-id intermediate tensor.
+     * Nodes left without any input or consumer are removed as well, and
+     * inputs of removed streams are disconnected, e.g.
+     * ProctorResultCalculator marks EMBED and EXP as absent. Back edges
+     * and FrameFinishedCalculator inputs reading the rendered output_video
+     * are fed by a FrameFinishedCalculator instead, ticking at every frame
+     * the renderer would have drawn, with or without faces.
+     *
+     * Must be called before CalculatorGraph::Initialize(), with the same side
+     * packets passed to CalculatorGraph::StartRun().
+     */
+    absl::Status ApplyModuleToggles(
+        const std::map<std::string, Packet>& side_packets,
+        CalculatorGraphConfig* config
+    );
+
+    /**
+     * @brief Remove the nodes running any of the given calculators
+     *
+     * Streams produced only by the removed nodes are disconnected from their
+     * consumers, and consumers left without inputs are removed in turn.
+     * Likewise, producers whose outputs are no longer read by any node or
+     * graph output are removed, e.g. a converter feeding only the renderer.
+     * Back edges consuming a removed stream are redirected according to
+     * back_edge_aliases if an alias is given.
+     */
+    absl::Status RemoveCalculators(
+        const std::vector<std::string>& calculators,
+        const std::map<std::string, std::string>& back_edge_aliases,
+        CalculatorGraphConfig* config
+    );
+
+    /**
+     * @brief Remove the nodes running any of the given calculators, and
+     *        connect the consumers of their pass-through outputs to the
+     *        corresponding inputs
+     *
+     * An output is a pass-through of the input with the same tag and index,
+     * e.g. IMAGE of FrameChangeGateCalculator or the untagged stream of
+     * FlowLimiterCalculator. Consumers of the other outputs are disconnected
+     * as in RemoveCalculators().
+     */
+    absl::Status BypassCalculators(
+        const std::vector<std::string>& calculators,
+        CalculatorGraphConfig* config
+    );
+
+} // namespace mediapipe
+
+#endif
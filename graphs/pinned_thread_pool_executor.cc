@@ -0,0 +1,98 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Thread pool executor whose threads are pinned to a set of CPUs
+#include <functional>
+#include <set>
+
+#include "mediapipe/framework/deps/thread_options.h"
+#include "mediapipe/framework/executor.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mp_proctor/graphs/pinned_thread_pool_executor.pb.h"
+
+namespace mediapipe
+{
+
+    /**
+     * @brief ThreadPoolExecutor counterpart pinning its workers to the
+     *        given CPUs
+     *
+     * Used by the "pinned" executor preset, so that several graphs can share
+     * a host without their threads migrating across each other's cores.
+     *
+     * Example:
+     *
+     * executor {
+     *   name: "inference"
+     *   type: "PinnedThreadPoolExecutor"
+     *   options {
+     *     [mediapipe.PinnedThreadPoolExecutorOptions.ext] {
+     *       num_threads: 2
+     *       cpu_ids: [2, 3]
+     *     }
+     *   }
+     * }
+     *
+     */
+    class PinnedThreadPoolExecutor: public Executor
+    {
+    private:
+        ThreadPool m_thread_pool;
+
+        PinnedThreadPoolExecutor(const ThreadOptions& thread_options, const std::string& name_prefix, int num_threads)
+            : m_thread_pool(thread_options, name_prefix, num_threads)
+        { m_thread_pool.StartWorkers(); }
+
+    public:
+        ~PinnedThreadPoolExecutor() override = default;
+
+        static absl::StatusOr<Executor*> Create(const MediaPipeOptions& extendable_options);
+
+        void Schedule(std::function<void()> task) override
+        { m_thread_pool.Schedule(std::move(task)); }
+    };
+
+    // Register the executor to be used in the graph
+    REGISTER_EXECUTOR(PinnedThreadPoolExecutor);
+
+    absl::StatusOr<Executor*> PinnedThreadPoolExecutor::Create(const MediaPipeOptions& extendable_options)
+    {
+        const auto& options = extendable_options.GetExtension(PinnedThreadPoolExecutorOptions::ext);
+        if (options.num_threads() <= 0)
+        {
+            return absl::InvalidArgumentError("PinnedThreadPoolExecutor: num_threads must be positive!");
+        }
+        if (options.cpu_ids_size() == 0)
+        {
+            return absl::InvalidArgumentError("PinnedThreadPoolExecutor: no cpu_ids given!");
+        }
+
+        std::set<int> cpu_set;
+        for (int cpu_id: options.cpu_ids())
+        {
+            if (cpu_id < 0)
+            {
+                return absl::InvalidArgumentError("PinnedThreadPoolExecutor: cpu_ids must not be negative!");
+            }
+            cpu_set.insert(cpu_id);
+        }
+
+        ThreadOptions thread_options;
+        thread_options.set_cpu_set(cpu_set);
+        return new PinnedThreadPoolExecutor(thread_options, options.thread_name_prefix(), options.num_threads());
+    }
+
+} // namespace mediapipe
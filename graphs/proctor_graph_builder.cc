@@ -0,0 +1,626 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Builder of output-driven proctoring graphs
+#include "mp_proctor/graphs/proctor_graph_builder.h"
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "mediapipe/calculators/core/constant_side_packet_calculator.pb.h"
+#include "mediapipe/framework/api2/builder.h"
+#include "mediapipe/framework/api2/node.h"
+#include "mediapipe/framework/api2/port.h"
+#include "mediapipe/framework/formats/classification.pb.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/formats/landmark.pb.h"
+#include "mediapipe/framework/formats/rect.pb.h"
+#include "mp_proctor/calculators/image/downscale_image_calculator.pb.h"
+#include "tensorflow/lite/c/common.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        using api2::Input;
+        using api2::Optional;
+        using api2::Output;
+        using api2::SideInput;
+        using api2::builder::Graph;
+        using api2::builder::SideSource;
+        using api2::builder::Source;
+
+        using FaceLandmarks = NormalizedLandmarkList;
+        using MultiFaceLandmarks = std::vector<NormalizedLandmarkList>;
+        using FaceRects = std::vector<NormalizedRect>;
+        using FaceMetrics = std::map<std::string, double>;
+        using Tensors = std::vector<TfLiteTensor>;
+        using ProctorResults = std::vector<ProctorResult>;
+
+        constexpr char kAnalyzedResultsStream[] = "analyzed_proctor_results";
+        constexpr char kFrozenFeedStream[] = "frozen_feed";
+
+        constexpr unsigned int kStandardizedFields =
+            PROCTOR_FIELD_BLINK | PROCTOR_FIELD_ORIENTATION | PROCTOR_FIELD_ACTIVITY;
+        constexpr unsigned int kReidFields =
+            PROCTOR_FIELD_EMBEDDINGS | PROCTOR_FIELD_EXPRESSIONS;
+        constexpr unsigned int kAllFields = kStandardizedFields | kReidFields | PROCTOR_FIELD_MOVEMENT;
+
+        // Ports of the nodes as this graph uses them. Connecting a stream of
+        // another type fails to compile. Ports the calculators declare as Any
+        // get the type of the stream the graph connects to them.
+        struct AdaptiveFrameSamplerNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr Input<ProctorResults> kFeedback{"FEEDBACK"};
+            static constexpr Input<bool> kFinished{"FINISHED"};
+            static constexpr Optional<Input<bool>> kSkipped{"SKIPPED"};
+            static constexpr Optional<Input<bool>> kAllow{"ALLOW"};
+            static constexpr Output<ImageFrame> kSampled{"IMAGE"};
+            static constexpr Output<bool> kSkip{"SKIP"};
+            MEDIAPIPE_NODE_INTERFACE(AdaptiveFrameSamplerCalculator,
+                kImage, kFeedback, kFinished, kSkipped, kAllow, kSampled, kSkip);
+        };
+
+        struct FlowLimiterNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kIn{""};
+            static constexpr Input<bool> kFinished{"FINISHED"};
+            static constexpr Output<ImageFrame> kOut{""};
+            static constexpr Optional<Output<bool>> kAllow{"ALLOW"};
+            MEDIAPIPE_NODE_INTERFACE(FlowLimiterCalculator, kIn, kFinished, kOut, kAllow);
+        };
+
+        struct FrameChangeGateNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr Output<ImageFrame> kChanged{"IMAGE"};
+            static constexpr Output<bool> kSkip{"SKIP"};
+            static constexpr Optional<Output<bool>> kFrozen{"FROZEN"};
+            MEDIAPIPE_NODE_INTERFACE(FrameChangeGateCalculator, kImage, kChanged, kSkip, kFrozen);
+        };
+
+        struct DownscaleImageNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr Output<ImageFrame> kDownscaled{"IMAGE"};
+            MEDIAPIPE_NODE_INTERFACE(DownscaleImageCalculator, kImage, kDownscaled);
+        };
+
+        struct FaceLandmarkFrontNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr SideInput<int> kNumFaces{"NUM_FACES"};
+            static constexpr SideInput<bool> kWithAttention{"WITH_ATTENTION"};
+            static constexpr Output<MultiFaceLandmarks> kLandmarks{"LANDMARKS"};
+            static constexpr Output<FaceRects> kRects{"ROIS_FROM_LANDMARKS"};
+            MEDIAPIPE_NODE_INTERFACE(FaceLandmarkFrontCpu,
+                kImage, kNumFaces, kWithAttention, kLandmarks, kRects);
+        };
+
+        struct BeginFaceLoopNode: public api2::NodeIntf
+        {
+            static constexpr Input<MultiFaceLandmarks> kIterable{"ITERABLE"};
+            static constexpr Input<ImageFrame>::Multiple kClone{"CLONE"};
+            static constexpr Output<FaceLandmarks> kItem{"ITEM"};
+            static constexpr Output<ImageFrame>::Multiple kCloned{"CLONE"};
+            static constexpr Output<Timestamp> kBatchEnd{"BATCH_END"};
+            MEDIAPIPE_NODE_INTERFACE(BeginLoopNormalizedLandmarkListVectorCalculator,
+                kIterable, kClone, kItem, kCloned, kBatchEnd);
+        };
+
+        // Calculators from one face's landmarks to one untagged output
+        template <typename T>
+        struct FaceLandmarksNode: public api2::NodeIntf
+        {
+            static constexpr Input<FaceLandmarks> kIn{""};
+            static constexpr Output<T> kOut{""};
+        };
+
+        struct LandmarkStandardizationNode: public FaceLandmarksNode<FaceLandmarks>
+        { MEDIAPIPE_NODE_INTERFACE(LandmarkStandardizationCalculator, kIn, kOut); };
+        struct FaceMovementNode: public FaceLandmarksNode<double>
+        { MEDIAPIPE_NODE_INTERFACE(FaceMovementCalculator, kIn, kOut); };
+        struct FaceActivityNode: public FaceLandmarksNode<double>
+        { MEDIAPIPE_NODE_INTERFACE(FaceActivityCalculator, kIn, kOut); };
+        struct FaceOrientationNode: public FaceLandmarksNode<FaceMetrics>
+        { MEDIAPIPE_NODE_INTERFACE(FaceOrientationCalculator, kIn, kOut); };
+        struct EyeBlinkNode: public FaceLandmarksNode<FaceMetrics>
+        { MEDIAPIPE_NODE_INTERFACE(EyeBlinkCalculator, kIn, kOut); };
+
+        struct FaceReidentificationNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr Input<FaceLandmarks> kLandmarks{"LANDMARKS"};
+            static constexpr Output<std::vector<float>> kEmbeddings{"EMBED"};
+            static constexpr Output<Tensors> kIntermediate{"INTER"};
+            MEDIAPIPE_NODE_INTERFACE(FaceReidentificationCpu,
+                kImage, kLandmarks, kEmbeddings, kIntermediate);
+        };
+
+        struct FaceAffectNode: public api2::NodeIntf
+        {
+            static constexpr Input<Tensors> kIntermediate{"INTER"};
+            static constexpr Output<ClassificationList> kExpressions{"EXP"};
+            MEDIAPIPE_NODE_INTERFACE(FaceAffectCpu, kIntermediate, kExpressions);
+        };
+
+        struct ProctorResultNode: public api2::NodeIntf
+        {
+            static constexpr Optional<Input<FaceMetrics>> kOrientation{"ORIENT"};
+            static constexpr Optional<Input<FaceMetrics>> kBlink{"BLINK"};
+            static constexpr Optional<Input<double>> kActivity{"ACTIVE"};
+            static constexpr Optional<Input<double>> kMovement{"MOVE"};
+            static constexpr Optional<Input<std::vector<float>>> kEmbeddings{"EMBED"};
+            static constexpr Optional<Input<ClassificationList>> kExpressions{"EXP"};
+            static constexpr Output<ProctorResult> kResult{"RESULT"};
+            MEDIAPIPE_NODE_INTERFACE(ProctorResultCalculator,
+                kOrientation, kBlink, kActivity, kMovement, kEmbeddings, kExpressions, kResult);
+        };
+
+        struct EndResultLoopNode: public api2::NodeIntf
+        {
+            static constexpr Input<ProctorResult> kItem{"ITEM"};
+            static constexpr Input<Timestamp> kBatchEnd{"BATCH_END"};
+            static constexpr Output<ProctorResults> kIterable{"ITERABLE"};
+            MEDIAPIPE_NODE_INTERFACE(EndLoopProctorResultVectorCalculator, kItem, kBatchEnd, kIterable);
+        };
+
+        struct CarryForwardNode: public api2::NodeIntf
+        {
+            static constexpr Input<ProctorResults> kResults{"RESULTS"};
+            static constexpr Optional<Input<bool>> kAnalyzed{"ANALYZED"};
+            static constexpr Input<bool>::Multiple kSkip{"SKIP"};
+            static constexpr Output<ProctorResults> kAllResults{"RESULTS"};
+            MEDIAPIPE_NODE_INTERFACE(ProctorResultCarryForwardCalculator,
+                kResults, kAnalyzed, kSkip, kAllResults);
+        };
+
+        struct FaceRendererNode: public api2::NodeIntf
+        {
+            static constexpr Input<ImageFrame> kImage{"IMAGE"};
+            static constexpr Input<FaceRects> kRects{"NORM_RECTS"};
+            static constexpr Input<ProctorResults> kResults{"RESULT"};
+            static constexpr Output<ImageFrame> kRendered{"IMAGE"};
+            MEDIAPIPE_NODE_INTERFACE(FaceRendererCpu, kImage, kRects, kResults, kRendered);
+        };
+
+        struct GatedFrames
+        {
+            Source<ImageFrame> image;
+            Source<bool> skip;
+        };
+
+        struct FaceLandmarkFrontOutputs
+        {
+            Source<MultiFaceLandmarks> landmarks;
+            Source<FaceRects> rects;
+        };
+
+        struct FaceLoopOutputs
+        {
+            Source<FaceLandmarks> landmarks;
+            std::optional<Source<ImageFrame>> image;
+            Source<Timestamp> batch_end;
+        };
+
+        struct ReidOutputs
+        {
+            Source<std::vector<float>> embeddings;
+            Source<Tensors> intermediate;
+        };
+
+        struct ResultInputs
+        {
+            std::optional<Source<FaceMetrics>> orientation;
+            std::optional<Source<FaceMetrics>> blink;
+            std::optional<Source<double>> activity;
+            std::optional<Source<double>> movement;
+            std::optional<Source<std::vector<float>>> embeddings;
+            std::optional<Source<ClassificationList>> expressions;
+        };
+
+        // Nodes waiting for a back edge, connected once the stream exists
+        struct BackEdges
+        {
+            api2::builder::Node<FlowLimiterNode>* limiter = nullptr;
+            api2::builder::Node<AdaptiveFrameSamplerNode>* sampler = nullptr;
+        };
+
+        GatedFrames FrameChangeGate(Source<ImageFrame> image, Graph& graph)
+        {
+            auto& node = graph.AddNode<FrameChangeGateNode>();
+            image >> node[FrameChangeGateNode::kImage];
+            node[FrameChangeGateNode::kFrozen].SetName(kFrozenFeedStream) >> graph.Out("FROZEN");
+            return {
+                node[FrameChangeGateNode::kChanged],
+                node[FrameChangeGateNode::kSkip]
+            };
+        }
+
+        GatedFrames AdaptiveFrameSampler(Source<ImageFrame> image, BackEdges& back_edges, Graph& graph)
+        {
+            auto& node = graph.AddNode<AdaptiveFrameSamplerNode>();
+            image >> node[AdaptiveFrameSamplerNode::kImage];
+            back_edges.sampler = &node;
+            return {
+                node[AdaptiveFrameSamplerNode::kSampled],
+                node[AdaptiveFrameSamplerNode::kSkip]
+            };
+        }
+
+        Source<ImageFrame> FlowLimiter(Source<ImageFrame> image, BackEdges& back_edges, Graph& graph)
+        {
+            auto& node = graph.AddNode<FlowLimiterNode>();
+            image >> node[FlowLimiterNode::kIn];
+            back_edges.limiter = &node;
+            // Frames dropped here are not in flight for the sampler anymore
+            if (back_edges.sampler)
+            {
+                node[FlowLimiterNode::kAllow].SetName("allowed_frame") >>
+                    (*back_edges.sampler)[AdaptiveFrameSamplerNode::kAllow];
+            }
+            return node[FlowLimiterNode::kOut];
+        }
+
+        // Ticks at every analyzed frame once done settled, with or without
+        // faces. DONE takes packets of any type, so the node stays untyped.
+        template <typename T>
+        Source<bool> AnalysisFinished(Source<ImageFrame> tick, Source<T> done, Graph& graph)
+        {
+            auto& node = graph.AddNode("FrameFinishedCalculator");
+            tick >> node.In("TICK");
+            done >> node.In("DONE")[0];
+            return node.Out("FINISHED").SetName("analyzed_frame").Cast<bool>();
+        }
+
+        template <typename T>
+        Source<bool> FrameFinished(Source<T> done, Source<bool> skip, Graph& graph)
+        {
+            auto& node = graph.AddNode("FrameFinishedCalculator");
+            done >> node.In("DONE")[0];
+            skip >> node.In("DONE")[1];
+            return node.Out("FINISHED").SetName("finished_frame").Cast<bool>();
+        }
+
+        Source<ImageFrame> DownscaleImage(Source<ImageFrame> image, int width, Graph& graph)
+        {
+            auto& node = graph.AddNode<DownscaleImageNode>();
+            node.GetOptions<DownscaleImageCalculatorOptions>().set_target_width(width);
+            image >> node[DownscaleImageNode::kImage];
+            return node[DownscaleImageNode::kDownscaled].SetName("detection_input_video");
+        }
+
+        FaceLandmarkFrontOutputs FaceLandmarkFront(Source<ImageFrame> image, int num_faces, Graph& graph)
+        {
+            // Its PACKET outputs differ in type, so it stays untyped
+            auto& constants = graph.AddNode("ConstantSidePacketCalculator");
+            auto& options = constants.GetOptions<ConstantSidePacketCalculatorOptions>();
+            options.add_packet()->set_int_value(num_faces);
+            options.add_packet()->set_bool_value(true);
+            SideSource<int> num_faces_packet =
+                constants.SideOut("PACKET")[0].SetName("num_faces").Cast<int>();
+            SideSource<bool> with_attention =
+                constants.SideOut("PACKET")[1].SetName("with_attention").Cast<bool>();
+
+            auto& node = graph.AddNode<FaceLandmarkFrontNode>();
+            image >> node[FaceLandmarkFrontNode::kImage];
+            num_faces_packet >> node[FaceLandmarkFrontNode::kNumFaces];
+            with_attention >> node[FaceLandmarkFrontNode::kWithAttention];
+            return {
+                node[FaceLandmarkFrontNode::kLandmarks].SetName(kProctorLandmarksStream),
+                node[FaceLandmarkFrontNode::kRects].SetName("face_rects_from_landmarks")
+            };
+        }
+
+        FaceLoopOutputs BeginFaceLoop(
+            Source<MultiFaceLandmarks> landmarks,
+            std::optional<Source<ImageFrame>> image,
+            Graph& graph
+        )
+        {
+            auto& node = graph.AddNode<BeginFaceLoopNode>();
+            landmarks >> node[BeginFaceLoopNode::kIterable];
+            FaceLoopOutputs outputs = {
+                node[BeginFaceLoopNode::kItem].SetName("face_landmarks"),
+                std::nullopt,
+                node[BeginFaceLoopNode::kBatchEnd].SetName("landmark_timestamp")
+            };
+            if (image)
+            {
+                *image >> node[BeginFaceLoopNode::kClone][0];
+                outputs.image = node[BeginFaceLoopNode::kCloned][0];
+            }
+            return outputs;
+        }
+
+        template <typename Node, typename T>
+        Source<T> FaceLandmarksCalculator(Source<FaceLandmarks> landmarks, const std::string& name, Graph& graph)
+        {
+            auto& node = graph.AddNode<Node>();
+            landmarks >> node[Node::kIn];
+            return node[Node::kOut].SetName(name);
+        }
+
+        Source<FaceLandmarks> StandardizeLandmarks(Source<FaceLandmarks> landmarks, Graph& graph)
+        { return FaceLandmarksCalculator<LandmarkStandardizationNode, FaceLandmarks>(landmarks, "face_std_landmarks", graph); }
+
+        Source<double> FaceMovement(Source<FaceLandmarks> landmarks, Graph& graph)
+        { return FaceLandmarksCalculator<FaceMovementNode, double>(landmarks, "face_movement", graph); }
+
+        Source<double> FaceActivity(Source<FaceLandmarks> std_landmarks, Graph& graph)
+        { return FaceLandmarksCalculator<FaceActivityNode, double>(std_landmarks, "face_activity", graph); }
+
+        Source<FaceMetrics> FaceOrientation(Source<FaceLandmarks> std_landmarks, Graph& graph)
+        { return FaceLandmarksCalculator<FaceOrientationNode, FaceMetrics>(std_landmarks, "face_orientations", graph); }
+
+        Source<FaceMetrics> EyeBlink(Source<FaceLandmarks> std_landmarks, Graph& graph)
+        { return FaceLandmarksCalculator<EyeBlinkNode, FaceMetrics>(std_landmarks, "face_blinks", graph); }
+
+        ReidOutputs FaceReidentification(Source<ImageFrame> image, Source<FaceLandmarks> landmarks, Graph& graph)
+        {
+            auto& node = graph.AddNode<FaceReidentificationNode>();
+            image >> node[FaceReidentificationNode::kImage];
+            landmarks >> node[FaceReidentificationNode::kLandmarks];
+            return {
+                node[FaceReidentificationNode::kEmbeddings].SetName("embeddings"),
+                node[FaceReidentificationNode::kIntermediate].SetName("intermediate_tensor")
+            };
+        }
+
+        Source<ClassificationList> FaceAffect(Source<Tensors> intermediate, Graph& graph)
+        {
+            auto& node = graph.AddNode<FaceAffectNode>();
+            intermediate >> node[FaceAffectNode::kIntermediate];
+            return node[FaceAffectNode::kExpressions].SetName("expressions");
+        }
+
+        Source<ProctorResult> AggregateResult(ResultInputs inputs, Graph& graph)
+        {
+            auto& node = graph.AddNode<ProctorResultNode>();
+            if (inputs.orientation) { *inputs.orientation >> node[ProctorResultNode::kOrientation]; }
+            if (inputs.blink) { *inputs.blink >> node[ProctorResultNode::kBlink]; }
+            if (inputs.activity) { *inputs.activity >> node[ProctorResultNode::kActivity]; }
+            if (inputs.movement) { *inputs.movement >> node[ProctorResultNode::kMovement]; }
+            if (inputs.embeddings) { *inputs.embeddings >> node[ProctorResultNode::kEmbeddings]; }
+            if (inputs.expressions) { *inputs.expressions >> node[ProctorResultNode::kExpressions]; }
+            return node[ProctorResultNode::kResult].SetName("face_proctor_result");
+        }
+
+        Source<ProctorResults> EndResultLoop(Source<ProctorResult> result, Source<Timestamp> batch_end, Graph& graph)
+        {
+            auto& node = graph.AddNode<EndResultLoopNode>();
+            result >> node[EndResultLoopNode::kItem];
+            batch_end >> node[EndResultLoopNode::kBatchEnd];
+            return node[EndResultLoopNode::kIterable];
+        }
+
+        Source<ProctorResults> CarryForward(
+            Source<ProctorResults> results,
+            Source<bool> analyzed_frame,
+            std::vector<Source<bool>> skips,
+            Graph& graph
+        )
+        {
+            auto& node = graph.AddNode<CarryForwardNode>();
+            results >> node[CarryForwardNode::kResults];
+            analyzed_frame >> node[CarryForwardNode::kAnalyzed];
+            for (int i = 0; i < static_cast<int>(skips.size()); i++)
+            {
+                skips[i] >> node[CarryForwardNode::kSkip][i];
+            }
+            return node[CarryForwardNode::kAllResults];
+        }
+
+        Source<ImageFrame> RenderFaces(
+            Source<ImageFrame> image,
+            Source<FaceRects> rects,
+            Source<ProctorResults> results,
+            Graph& graph
+        )
+        {
+            auto& node = graph.AddNode<FaceRendererNode>();
+            image >> node[FaceRendererNode::kImage];
+            rects >> node[FaceRendererNode::kRects];
+            results >> node[FaceRendererNode::kResults];
+            return node[FaceRendererNode::kRendered];
+        }
+
+        void MarkBackEdge(CalculatorGraphConfig* config, const std::string& calculator, const std::string& tag)
+        {
+            for (auto& node: *config->mutable_node())
+            {
+                if (node.calculator() != calculator) { continue; }
+                // Optional inputs may be left unconnected
+                bool is_connected = false;
+                for (const auto& entry: node.input_stream())
+                {
+                    is_connected |= absl::StartsWith(entry, tag + ":");
+                }
+                if (!is_connected) { continue; }
+                auto* info = node.add_input_stream_info();
+                info->set_tag_index(tag);
+                info->set_back_edge(true);
+            }
+        }
+    } // namespace
+
+    absl::StatusOr<ProctorGraphRequest> ParseProctorGraphRequest(const std::string& outputs)
+    {
+        static const std::map<std::string, unsigned int> kFields = {
+            {"blink", PROCTOR_FIELD_BLINK},
+            {"orientation", PROCTOR_FIELD_ORIENTATION},
+            {"activity", PROCTOR_FIELD_ACTIVITY},
+            {"movement", PROCTOR_FIELD_MOVEMENT},
+            {"embeddings", PROCTOR_FIELD_EMBEDDINGS},
+            {"expressions", PROCTOR_FIELD_EXPRESSIONS},
+            {"results", kAllFields},
+        };
+
+        ProctorGraphRequest request;
+        for (absl::string_view output: absl::StrSplit(outputs, ',', absl::SkipWhitespace()))
+        {
+            const std::string name(output);
+            auto field = kFields.find(name);
+            if (field != kFields.end())
+            {
+                request.result_fields |= field->second;
+            } else if (name == "landmarks")
+            {
+                request.landmarks = true;
+            } else if (name == "video")
+            {
+                request.annotated_video = true;
+            } else
+            {
+                return absl::InvalidArgumentError("Unknown proctor graph output: " + name);
+            }
+        }
+        return request;
+    }
+
+    absl::StatusOr<CalculatorGraphConfig> BuildProctorGraph(const ProctorGraphRequest& request)
+    {
+        if (request.result_fields == 0 && !request.landmarks && !request.annotated_video)
+        {
+            return absl::InvalidArgumentError("BuildProctorGraph: No output requested!");
+        }
+
+        unsigned int fields = request.result_fields;
+        // The sampler decides on the movement and activity of the results
+        if (request.adaptive_rate) { fields |= PROCTOR_FIELD_MOVEMENT | PROCTOR_FIELD_ACTIVITY; }
+        const bool need_results = fields != 0 || request.annotated_video;
+
+        Graph graph;
+        BackEdges back_edges;
+        std::vector<Source<bool>> skips;
+
+        Source<ImageFrame> image = graph.In("IMAGE").SetName(kProctorInputStream).Cast<ImageFrame>();
+        Source<ImageFrame> sampled = image;
+        if (request.adaptive_rate)
+        {
+            auto gated = AdaptiveFrameSampler(sampled, back_edges, graph);
+            sampled = gated.image;
+            skips.push_back(gated.skip);
+        }
+        Source<ImageFrame> throttled = FlowLimiter(sampled, back_edges, graph);
+        // Unchanged frames end at the gate, after the limiter let them in
+        std::optional<Source<bool>> unchanged;
+        if (request.change_gate)
+        {
+            throttled.SetName("limited_input_video");
+            auto gated = FrameChangeGate(throttled, graph);
+            throttled = gated.image;
+            unchanged = gated.skip;
+            skips.push_back(gated.skip);
+        }
+        throttled.SetName("throttled_input_video");
+
+        Source<ImageFrame> detection_input = throttled;
+        if (request.detection_width > 0)
+        {
+            detection_input = DownscaleImage(throttled, request.detection_width, graph);
+        }
+        auto faces = FaceLandmarkFront(detection_input, request.num_faces, graph);
+        if (request.landmarks)
+        {
+            faces.landmarks >> graph.Out("LANDMARKS");
+        }
+
+        // Connects the signal that a frame went through the whole graph. The
+        // sampler reads frames finished without analysis as frames without
+        // faces, so it gets the unchanged frames apart.
+        auto connect_finished = [&back_edges, &unchanged, &graph](Source<bool> analyzed_frame) {
+            if (back_edges.sampler)
+            {
+                auto& sampler = *back_edges.sampler;
+                analyzed_frame >> sampler[AdaptiveFrameSamplerNode::kFinished];
+                if (unchanged) { *unchanged >> sampler[AdaptiveFrameSamplerNode::kSkipped]; }
+            }
+            if (unchanged)
+            {
+                FrameFinished(analyzed_frame, *unchanged, graph) >>
+                    (*back_edges.limiter)[FlowLimiterNode::kFinished];
+            } else
+            {
+                analyzed_frame >> (*back_edges.limiter)[FlowLimiterNode::kFinished];
+            }
+        };
+
+        if (!need_results)
+        {
+            connect_finished(AnalysisFinished(throttled, faces.landmarks, graph));
+        } else
+        {
+            std::optional<Source<ImageFrame>> loop_image;
+            if (fields & kReidFields) { loop_image = throttled; }
+            auto loop = BeginFaceLoop(faces.landmarks, loop_image, graph);
+
+            ResultInputs inputs;
+            if (fields & kStandardizedFields)
+            {
+                auto std_landmarks = StandardizeLandmarks(loop.landmarks, graph);
+                if (fields & PROCTOR_FIELD_ORIENTATION) { inputs.orientation = FaceOrientation(std_landmarks, graph); }
+                if (fields & PROCTOR_FIELD_BLINK) { inputs.blink = EyeBlink(std_landmarks, graph); }
+                if (fields & PROCTOR_FIELD_ACTIVITY) { inputs.activity = FaceActivity(std_landmarks, graph); }
+            }
+            if (fields & PROCTOR_FIELD_MOVEMENT) { inputs.movement = FaceMovement(loop.landmarks, graph); }
+            if (fields & kReidFields)
+            {
+                auto reid = FaceReidentification(*loop.image, loop.landmarks, graph);
+                if (fields & PROCTOR_FIELD_EMBEDDINGS) { inputs.embeddings = reid.embeddings; }
+                if (fields & PROCTOR_FIELD_EXPRESSIONS) { inputs.expressions = FaceAffect(reid.intermediate, graph); }
+            }
+
+            auto result = AggregateResult(inputs, graph);
+            auto analyzed = EndResultLoop(result, loop.batch_end, graph);
+
+            std::optional<Source<ImageFrame>> video;
+            if (request.annotated_video)
+            {
+                video = RenderFaces(throttled, faces.rects, analyzed, graph);
+                video->SetName(kProctorOutputStream) >> graph.Out("IMAGE");
+            }
+            // Every analyzed frame, once rendered if the video is requested
+            Source<bool> analyzed_frame = video
+                ? AnalysisFinished(throttled, *video, graph)
+                : AnalysisFinished(throttled, analyzed, graph);
+            connect_finished(analyzed_frame);
+
+            auto results = analyzed;
+            if (!skips.empty())
+            {
+                analyzed.SetName(kAnalyzedResultsStream);
+                results = CarryForward(analyzed, analyzed_frame, skips, graph);
+            }
+            results.SetName(kProctorResultsStream);
+            if (fields != 0) { results >> graph.Out("RESULTS"); }
+            if (back_edges.sampler) { analyzed >> (*back_edges.sampler)[AdaptiveFrameSamplerNode::kFeedback]; }
+        }
+
+        CalculatorGraphConfig config = graph.GetConfig();
+        MarkBackEdge(&config, "FlowLimiterCalculator", "FINISHED");
+        MarkBackEdge(&config, "AdaptiveFrameSamplerCalculator", "FINISHED");
+        MarkBackEdge(&config, "AdaptiveFrameSamplerCalculator", "SKIPPED");
+        MarkBackEdge(&config, "AdaptiveFrameSamplerCalculator", "FEEDBACK");
+        MarkBackEdge(&config, "AdaptiveFrameSamplerCalculator", "ALLOW");
+        return config;
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,80 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Builder of output-driven proctoring graphs
+#ifndef proctor_graph_builder_h
+#define proctor_graph_builder_h
+
+#include <string>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    // Stream names of the built graph, same as proctor_cpu.pbtxt
+    constexpr char kProctorInputStream[]     = "input_video";
+    constexpr char kProctorOutputStream[]    = "output_video";
+    constexpr char kProctorResultsStream[]   = "multi_face_proctor_results";
+    constexpr char kProctorLandmarksStream[] = "multi_face_landmarks";
+
+    /**
+     * @brief Outputs requested from the proctoring graph
+     */
+    struct ProctorGraphRequest
+    {
+        // Result fields to compute (ProctorResultField flags). The results
+        // are emitted on multi_face_proctor_results if any field is requested.
+        unsigned int result_fields = 0;
+        // Emit multi_face_landmarks
+        bool landmarks = false;
+        // Emit the annotated output_video
+        bool annotated_video = false;
+
+        // Maximum number of faces to detect
+        int num_faces = 1;
+        // Width of the frames used for face detection and landmarks, 0 for
+        // the input width. Re-id and rendering keep the input resolution.
+        int detection_width = 0;
+        // Skip unchanged frames (FrameChangeGateCalculator)
+        bool change_gate = false;
+        // Lower the frame rate of still faces (AdaptiveFrameSamplerCalculator)
+        bool adaptive_rate = false;
+    };
+
+    /**
+     * @brief Parse a comma separated list of outputs, e.g. "blink,orientation"
+     *
+     * Accepts blink, orientation, activity, movement, embeddings,
+     * expressions, results (all result fields), landmarks and video.
+     */
+    absl::StatusOr<ProctorGraphRequest> ParseProctorGraphRequest(const std::string& outputs);
+
+    /**
+     * @brief Build a CalculatorGraphConfig containing only the nodes needed
+     *        for the requested outputs
+     *
+     * The FINISHED back edges tick at every analyzed frame, including the
+     * frames without faces. Nodes are connected through typed ports, so
+     * connecting streams of mismatched packet types fails to compile, except
+     * for the ports taking packets of any type, e.g. DONE of
+     * FrameFinishedCalculator.
+     */
+    absl::StatusOr<CalculatorGraphConfig> BuildProctorGraph(const ProctorGraphRequest& request);
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,153 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Recycled ImageFrame buffers for frame ingestion
+#include "mp_proctor/image_frame_pool.h"
+
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/formats/image_frame_opencv.h"
+#include "mediapipe/framework/port/aligned_malloc_and_free.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+
+namespace mediapipe
+{
+
+    struct ImageFramePool::Buffers
+    {
+        const size_t max_free;
+
+        absl::Mutex mutex;
+        ImageFormat::Format format ABSL_GUARDED_BY(mutex) = ImageFormat::UNKNOWN;
+        int width ABSL_GUARDED_BY(mutex) = 0;
+        int height ABSL_GUARDED_BY(mutex) = 0;
+        int width_step ABSL_GUARDED_BY(mutex) = 0;
+        std::vector<uint8*> free_buffers ABSL_GUARDED_BY(mutex);
+        size_t allocated ABSL_GUARDED_BY(mutex) = 0;
+
+        explicit Buffers(size_t max_free): max_free(max_free) {}
+
+        ~Buffers()
+        {
+            for (auto* buffer: free_buffers) { aligned_free(buffer); }
+        }
+
+        void Release(uint8* buffer, int buffer_width_step, int buffer_height)
+        {
+            absl::MutexLock lock(&mutex);
+            // Buffers of a previous frame size are not reused
+            if (buffer_width_step != width_step || buffer_height != height || free_buffers.size() >= max_free)
+            {
+                aligned_free(buffer);
+                return;
+            }
+            free_buffers.push_back(buffer);
+        }
+    };
+
+    ImageFramePool::ImageFramePool(size_t max_free_frames)
+        : m_buffers(std::make_shared<Buffers>(max_free_frames))
+    {}
+
+    std::unique_ptr<ImageFrame> ImageFramePool::Acquire(ImageFormat::Format format, int width, int height)
+    {
+        uint8* buffer = nullptr;
+        int width_step = 0;
+        {
+            absl::MutexLock lock(&m_buffers->mutex);
+            if (format != m_buffers->format || width != m_buffers->width || height != m_buffers->height)
+            {
+                for (auto* free_buffer: m_buffers->free_buffers) { aligned_free(free_buffer); }
+                m_buffers->free_buffers.clear();
+                m_buffers->format = format;
+                m_buffers->width = width;
+                m_buffers->height = height;
+                // Same row alignment as ImageFrame's own allocations
+                const int row_bytes = width * ImageFrame::NumberOfChannelsForFormat(format) *
+                    ImageFrame::ByteDepthForFormat(format);
+                const int alignment = ImageFrame::kDefaultAlignmentBoundary;
+                m_buffers->width_step = (row_bytes + alignment - 1) / alignment * alignment;
+            }
+            width_step = m_buffers->width_step;
+            if (!m_buffers->free_buffers.empty())
+            {
+                buffer = m_buffers->free_buffers.back();
+                m_buffers->free_buffers.pop_back();
+            } else
+            {
+                ++m_buffers->allocated;
+            }
+        }
+        if (buffer == nullptr)
+        {
+            buffer = static_cast<uint8*>(aligned_malloc(
+                static_cast<size_t>(width_step) * height, ImageFrame::kDefaultAlignmentBoundary));
+            CHECK(buffer) << "Failed to allocate an image frame buffer";
+        }
+
+        std::weak_ptr<Buffers> weak_buffers = m_buffers;
+        return absl::make_unique<ImageFrame>(
+            format, width, height, width_step, buffer,
+            [weak_buffers, width_step, height](uint8* pixels)
+            {
+                if (auto buffers = weak_buffers.lock())
+                {
+                    buffers->Release(pixels, width_step, height);
+                } else
+                {
+                    aligned_free(pixels);
+                }
+            }
+        );
+    }
+
+    size_t ImageFramePool::allocated() const
+    {
+        absl::MutexLock lock(&m_buffers->mutex);
+        return m_buffers->allocated;
+    }
+
+    void ConvertBgrToRgb(const cv::Mat& bgr, bool mirror, ImageFrame* rgb_frame)
+    {
+        CHECK_EQ(bgr.type(), CV_8UC3);
+        CHECK_EQ(rgb_frame->Format(), ImageFormat::SRGB);
+        CHECK_EQ(rgb_frame->Width(), bgr.cols);
+        CHECK_EQ(rgb_frame->Height(), bgr.rows);
+
+        cv::Mat rgb = formats::MatView(rgb_frame);
+        if (!mirror)
+        {
+            cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+            return;
+        }
+
+        // Swap the channels while reading the row backwards
+        const int width = bgr.cols;
+        for (int y = 0; y < bgr.rows; ++y)
+        {
+            const uint8* src = bgr.ptr<uint8>(y) + 3 * (width - 1);
+            uint8* dst = rgb.ptr<uint8>(y);
+            for (int x = 0; x < width; ++x, src -= 3, dst += 3)
+            {
+                dst[0] = src[2];
+                dst[1] = src[1];
+                dst[2] = src[0];
+            }
+        }
+    }
+
+} // namespace mediapipe
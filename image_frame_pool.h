@@ -0,0 +1,59 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Recycled ImageFrame buffers for frame ingestion
+#ifndef image_frame_pool_h
+#define image_frame_pool_h
+
+#include <cstddef>
+#include <memory>
+
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/opencv_core_inc.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Pool of ImageFrame pixel buffers
+     *
+     * The frames handed out return their buffer to the pool once deleted,
+     * e.g. when the last packet holding them is released by the graph.
+     * Frames still in use when the pool is destroyed free their own buffer.
+     * Changing the frame size or format discards the free buffers.
+     */
+    class ImageFramePool
+    {
+    private:
+        struct Buffers;
+        std::shared_ptr<Buffers> m_buffers;
+
+    public:
+        // Keeps at most max_free_frames unused buffers around
+        explicit ImageFramePool(size_t max_free_frames = 4);
+
+        std::unique_ptr<ImageFrame> Acquire(ImageFormat::Format format, int width, int height);
+
+        // Number of buffers allocated so far
+        size_t allocated() const;
+    };
+
+    /**
+     * @brief Convert a BGR frame into an SRGB ImageFrame of the same size in
+     *        a single pass, optionally mirroring it horizontally
+     */
+    void ConvertBgrToRgb(const cv::Mat& bgr, bool mirror, ImageFrame* rgb_frame);
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,121 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Streams a video as JPEG frames to the ingest server, standing in for one
+// or more cameras.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/ingest/frame_protocol.h"
+
+ABSL_FLAG(std::string, host, "127.0.0.1", "Address of the ingest server.");
+ABSL_FLAG(int, port, 9000, "Port of the ingest server.");
+ABSL_FLAG(std::string, input_video_path, "",
+          "Full path of the video to stream.");
+ABSL_FLAG(int, sessions, 1, "Number of cameras to simulate.");
+ABSL_FLAG(int, jpeg_quality, 90, "JPEG quality of the frames.");
+ABSL_FLAG(bool, realtime, true,
+          "Send the frames at the video frame rate, otherwise as fast as the "
+          "server reads them.");
+
+absl::Status StreamVideo(int session) {
+  cv::VideoCapture capture(absl::GetFlag(FLAGS_input_video_path));
+  RET_CHECK(capture.isOpened());
+  double fps = capture.get(cv::CAP_PROP_FPS);
+  if (fps <= 0) fps = 30;
+
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  RET_CHECK_GE(fd, 0);
+  const int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  sockaddr_in address;
+  std::memset(&address, 0, sizeof(address));
+  address.sin_family = AF_INET;
+  address.sin_port = htons(absl::GetFlag(FLAGS_port));
+  RET_CHECK_EQ(inet_pton(AF_INET, absl::GetFlag(FLAGS_host).c_str(),
+                         &address.sin_addr), 1);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) !=
+      0) {
+    close(fd);
+    return absl::UnavailableError("Could not connect to the server.");
+  }
+
+  const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY,
+                                   absl::GetFlag(FLAGS_jpeg_quality)};
+  const absl::Duration period = absl::Seconds(1.0 / fps);
+  const absl::Time start = absl::Now();
+  std::vector<uchar> jpeg;
+  uint8 header_bytes[mediapipe::kFrameHeaderBytes];
+  cv::Mat frame;
+  int64 sent = 0;
+  bool failed = false;
+  while (capture.read(frame)) {
+    if (absl::GetFlag(FLAGS_realtime)) {
+      const absl::Time deadline = start + period * sent;
+      if (deadline > absl::Now()) absl::SleepFor(deadline - absl::Now());
+    }
+    cv::imencode(".jpg", frame, jpeg, params);
+    mediapipe::FrameHeader header;
+    header.codec = mediapipe::FrameCodec::kJpeg;
+    header.timestamp_us = absl::ToInt64Microseconds(period * sent);
+    header.payload_bytes = jpeg.size();
+    mediapipe::EncodeFrameHeader(header, header_bytes);
+    if (!mediapipe::WriteFully(fd, header_bytes, sizeof(header_bytes)) ||
+        !mediapipe::WriteFully(fd, jpeg.data(), jpeg.size())) {
+      failed = true;
+      break;
+    }
+    ++sent;
+  }
+  close(fd);
+  LOG(INFO) << "Session " << session << " sent " << sent << " frames in "
+            << absl::ToDoubleSeconds(absl::Now() - start) << " s.";
+  RET_CHECK(!failed) << "The server closed the connection.";
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  std::vector<std::thread> sessions;
+  std::vector<absl::Status> statuses(absl::GetFlag(FLAGS_sessions));
+  for (size_t i = 0; i < statuses.size(); ++i) {
+    sessions.emplace_back([i, &statuses]() { statuses[i] = StreamVideo(i); });
+  }
+  for (auto& session : sessions) session.join();
+
+  int exit_code = EXIT_SUCCESS;
+  for (const auto& status : statuses) {
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to stream the video: " << status.message();
+      exit_code = EXIT_FAILURE;
+    }
+  }
+  return exit_code;
+}
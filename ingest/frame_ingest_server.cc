@@ -0,0 +1,368 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TCP server feeding compressed client frames into per-session graphs
+#include "mp_proctor/ingest/frame_ingest_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/str_cat.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_imgcodecs_inc.h"
+#include "mp_proctor/image_frame_pool.h"
+#include "mp_proctor/ingest/frame_protocol.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kInputStream[]   = "input_video";
+        constexpr char kResultsStream[] = "multi_face_proctor_results";
+
+        bool HasOutputStream(const CalculatorGraphConfig& config, const std::string& name)
+        {
+            for (const auto& entry: config.output_stream())
+            {
+                if (entry == name || absl::EndsWith(entry, ":" + name)) { return true; }
+            }
+            return false;
+        }
+
+        // Read the frame size from the SOF segment of a JPEG
+        bool ReadJpegSize(const std::vector<uint8>& jpeg, int* width, int* height)
+        {
+            const uint8* data = jpeg.data();
+            const size_t size = jpeg.size();
+            if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) { return false; }
+            size_t pos = 2;
+            while (pos + 4 <= size)
+            {
+                if (data[pos] != 0xFF) { return false; }
+                const uint8 marker = data[pos + 1];
+                // Fill byte
+                if (marker == 0xFF) { ++pos; continue; }
+                // SOF0 to SOF15, except DHT, JPG and DAC
+                if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC)
+                {
+                    if (pos + 9 > size) { return false; }
+                    *height = (data[pos + 5] << 8) | data[pos + 6];
+                    *width = (data[pos + 7] << 8) | data[pos + 8];
+                    return true;
+                }
+                pos += 2 + ((data[pos + 2] << 8) | data[pos + 3]);
+            }
+            return false;
+        }
+
+        // Decode at the smallest DCT scale still at least target_width wide,
+        // which skips most of the IDCT work for the discarded resolution
+        int JpegReadFlags(const std::vector<uint8>& jpeg, int target_width)
+        {
+            int width = 0, height = 0;
+            if (target_width <= 0 || !ReadJpegSize(jpeg, &width, &height)) { return cv::IMREAD_COLOR; }
+            if (width / 8 >= target_width) { return cv::IMREAD_REDUCED_COLOR_8; }
+            if (width / 4 >= target_width) { return cv::IMREAD_REDUCED_COLOR_4; }
+            if (width / 2 >= target_width) { return cv::IMREAD_REDUCED_COLOR_2; }
+            return cv::IMREAD_COLOR;
+        }
+
+        // Returns null if the JPEG could not be decoded
+        std::unique_ptr<ImageFrame> DecodeJpeg(
+            const std::vector<uint8>& jpeg, int target_width, ImageFramePool* pool
+        )
+        {
+            const cv::Mat encoded(1, jpeg.size(), CV_8UC1, const_cast<uint8*>(jpeg.data()));
+            const cv::Mat bgr = cv::imdecode(encoded, JpegReadFlags(jpeg, target_width));
+            if (bgr.empty()) { return nullptr; }
+            auto frame = pool->Acquire(ImageFormat::SRGB, bgr.cols, bgr.rows);
+            ConvertBgrToRgb(bgr, /*mirror=*/false, frame.get());
+            return frame;
+        }
+    } // namespace
+
+    /**
+     * @brief Graph of a client connection, receiving the decoded frames in
+     *        the order they were sent
+     */
+    class FrameIngestServer::Session
+    {
+    private:
+        const int m_id;
+        const uint64 m_max_pending;
+
+        absl::Mutex m_mutex;
+        uint64 m_reserved ABSL_GUARDED_BY(m_mutex) = 0;
+        uint64 m_delivered ABSL_GUARDED_BY(m_mutex) = 0;
+        // Frames decoded ahead of an earlier one, by sequence number
+        std::map<uint64, std::pair<int64, std::unique_ptr<ImageFrame>>> m_decoded ABSL_GUARDED_BY(m_mutex);
+        int64 m_last_timestamp_us ABSL_GUARDED_BY(m_mutex) = -1;
+        absl::Status m_status ABSL_GUARDED_BY(m_mutex);
+
+    public:
+        CalculatorGraph graph;
+        ImageFramePool pool;
+
+        Session(int id, int max_pending)
+            : m_id(id), m_max_pending(std::max(1, max_pending))
+        {}
+
+        absl::Status Start(
+            const CalculatorGraphConfig& config,
+            const std::map<std::string, Packet>& side_packets,
+            const IngestResultsCallback& on_results
+        )
+        {
+            MP_RETURN_IF_ERROR(graph.Initialize(config));
+            if (on_results && HasOutputStream(config, kResultsStream))
+            {
+                MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+                    kResultsStream,
+                    [id = m_id, on_results](const Packet& packet)
+                    {
+                        on_results(id, packet.Timestamp(), packet.Get<std::vector<ProctorResult>>());
+                        return absl::OkStatus();
+                    }
+                ));
+            }
+            return graph.StartRun(side_packets);
+        }
+
+        // Wait until fewer than max_pending frames are in flight, and return
+        // the sequence number of the next frame
+        uint64 Reserve()
+        {
+            absl::MutexLock lock(&m_mutex);
+            auto has_room = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+            { return m_reserved - m_delivered < m_max_pending; };
+            m_mutex.Await(absl::Condition(&has_room));
+            return m_reserved++;
+        }
+
+        // Send the frame once all earlier frames are sent, frame is null if
+        // it could not be decoded
+        void Deliver(uint64 sequence, int64 timestamp_us, std::unique_ptr<ImageFrame> frame)
+        {
+            absl::MutexLock lock(&m_mutex);
+            m_decoded.emplace(sequence, std::make_pair(timestamp_us, std::move(frame)));
+            for (auto it = m_decoded.begin(); it != m_decoded.end() && it->first == m_delivered;
+                 it = m_decoded.erase(it), ++m_delivered)
+            {
+                if (it->second.second == nullptr)
+                {
+                    LOG(WARNING) << "Session " << m_id << ": dropped an undecodable frame";
+                    continue;
+                }
+                // The graph needs increasing timestamps, whatever the client sends
+                const int64 timestamp = std::max(it->second.first, m_last_timestamp_us + 1);
+                m_last_timestamp_us = timestamp;
+                if (!m_status.ok()) { continue; }
+                m_status = graph.AddPacketToInputStream(
+                    kInputStream, Adopt(it->second.second.release()).At(Timestamp(timestamp))
+                );
+            }
+        }
+
+        // Wait for the frames in flight and the graph
+        absl::Status Finish()
+        {
+            absl::Status status;
+            {
+                absl::MutexLock lock(&m_mutex);
+                auto is_idle = [this]() ABSL_EXCLUSIVE_LOCKS_REQUIRED(m_mutex)
+                { return m_delivered == m_reserved; };
+                m_mutex.Await(absl::Condition(&is_idle));
+                status = m_status;
+            }
+            status.Update(graph.CloseAllInputStreams());
+            status.Update(graph.WaitUntilDone());
+            return status;
+        }
+    };
+
+    FrameIngestServer::FrameIngestServer(
+        CalculatorGraphConfig config,
+        std::map<std::string, Packet> side_packets,
+        FrameIngestServerOptions options,
+        IngestResultsCallback on_results
+    )
+        : m_config(std::move(config)), m_side_packets(std::move(side_packets)),
+          m_options(options), m_on_results(std::move(on_results))
+    {}
+
+    FrameIngestServer::~FrameIngestServer()
+    { this->Stop(); }
+
+    absl::Status FrameIngestServer::Start()
+    {
+        RET_CHECK_EQ(m_listen_fd, -1) << "The server is already running";
+        m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listen_fd < 0) { return absl::InternalError(absl::StrCat("socket: ", std::strerror(errno))); }
+        const int enable = 1;
+        setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+        sockaddr_in address;
+        std::memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(m_options.port);
+        socklen_t length = sizeof(address);
+        if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(m_listen_fd, SOMAXCONN) != 0 ||
+            getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address), &length) != 0)
+        {
+            const std::string error = std::strerror(errno);
+            close(m_listen_fd);
+            m_listen_fd = -1;
+            return absl::UnavailableError(absl::StrCat("Could not listen on port ", m_options.port, ": ", error));
+        }
+        m_port = ntohs(address.sin_port);
+
+        m_decode_pool = absl::make_unique<ThreadPool>("ingest_decode", std::max(1, m_options.decode_threads));
+        m_decode_pool->StartWorkers();
+        m_stopping = false;
+        m_accept_thread = std::thread(&FrameIngestServer::AcceptConnections, this);
+        LOG(INFO) << "Ingest server listening on port " << m_port;
+        return absl::OkStatus();
+    }
+
+    void FrameIngestServer::Stop()
+    {
+        if (m_listen_fd < 0) { return; }
+        m_stopping = true;
+        // Wakes up accept()
+        shutdown(m_listen_fd, SHUT_RDWR);
+        m_accept_thread.join();
+        close(m_listen_fd);
+        m_listen_fd = -1;
+
+        std::vector<std::thread> threads;
+        {
+            absl::MutexLock lock(&m_mutex);
+            for (auto& session: m_sessions)
+            {
+                // Ends the session as if the client disconnected
+                if (session.second.fd >= 0) { shutdown(session.second.fd, SHUT_RDWR); }
+                threads.push_back(std::move(session.second.thread));
+            }
+            m_sessions.clear();
+            m_finished.clear();
+        }
+        for (auto& thread: threads) { thread.join(); }
+        // Finishes the remaining decode tasks
+        m_decode_pool.reset();
+    }
+
+    void FrameIngestServer::AcceptConnections()
+    {
+        while (!m_stopping)
+        {
+            const int fd = accept(m_listen_fd, nullptr, nullptr);
+            this->JoinFinishedSessions();
+            if (fd < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED) { continue; }
+                if (!m_stopping) { LOG(ERROR) << "accept: " << std::strerror(errno); }
+                break;
+            }
+            const int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+            absl::MutexLock lock(&m_mutex);
+            const int id = m_next_session++;
+            m_sessions[id] = SessionThread{fd, std::thread(&FrameIngestServer::RunSession, this, id, fd)};
+        }
+    }
+
+    void FrameIngestServer::JoinFinishedSessions()
+    {
+        std::vector<std::thread> threads;
+        {
+            absl::MutexLock lock(&m_mutex);
+            for (int id: m_finished)
+            {
+                threads.push_back(std::move(m_sessions[id].thread));
+                m_sessions.erase(id);
+            }
+            m_finished.clear();
+        }
+        for (auto& thread: threads) { thread.join(); }
+    }
+
+    void FrameIngestServer::RunSession(int session_id, int fd)
+    {
+        LOG(INFO) << "Session " << session_id << " connected";
+        auto session = std::make_shared<Session>(session_id, m_options.max_pending_frames);
+        absl::Status status = session->Start(m_config, m_side_packets, m_on_results);
+
+        uint8 header_bytes[kFrameHeaderBytes];
+        FrameHeader header;
+        while (status.ok() && ReadFully(fd, header_bytes, kFrameHeaderBytes))
+        {
+            if (!DecodeFrameHeader(header_bytes, &header))
+            {
+                status = absl::InvalidArgumentError("Malformed frame header");
+                break;
+            }
+            if (header.codec != FrameCodec::kJpeg)
+            {
+                status = absl::UnimplementedError("Only JPEG frames are supported");
+                break;
+            }
+            auto payload = std::make_shared<std::vector<uint8>>(header.payload_bytes);
+            if (!ReadFully(fd, payload->data(), payload->size())) { break; }
+
+            // Blocks while the session has too many frames in flight, which
+            // leaves the rest in the socket buffers
+            const uint64 sequence = session->Reserve();
+            m_decode_pool->Schedule(
+                [session, sequence, payload, timestamp_us = header.timestamp_us,
+                 target_width = m_options.target_width]()
+                {
+                    session->Deliver(
+                        sequence, timestamp_us, DecodeJpeg(*payload, target_width, &session->pool)
+                    );
+                }
+            );
+        }
+        status.Update(session->Finish());
+        if (status.ok())
+        {
+            LOG(INFO) << "Session " << session_id << " disconnected";
+        } else
+        {
+            LOG(WARNING) << "Session " << session_id << " ended: " << status.message();
+        }
+
+        absl::MutexLock lock(&m_mutex);
+        close(fd);
+        auto it = m_sessions.find(session_id);
+        if (it != m_sessions.end())
+        {
+            it->second.fd = -1;
+            m_finished.push_back(session_id);
+        }
+    }
+
+} // namespace mediapipe
@@ -0,0 +1,125 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// TCP server feeding compressed client frames into per-session graphs
+#ifndef frame_ingest_server_h
+#define frame_ingest_server_h
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/threadpool.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of FrameIngestServer
+     */
+    struct FrameIngestServerOptions
+    {
+        // 0 picks a free port, see FrameIngestServer::port()
+        int port = 9000;
+        // Threads decoding the frames of all sessions
+        int decode_threads = 4;
+        // Frames of a session being decoded before the server stops reading
+        // from its connection
+        int max_pending_frames = 4;
+        // Width the graph needs, JPEGs are decoded at the smallest 1/2, 1/4 or
+        // 1/8 scale at least this wide. 0 decodes at full resolution.
+        int target_width = 0;
+    };
+
+    // Called from the graph threads with the results of a session
+    using IngestResultsCallback = std::function<
+        void(int session, Timestamp timestamp, const std::vector<ProctorResult>& results)
+    >;
+
+    /**
+     * @brief Accept client connections streaming compressed frames (see
+     *        frame_protocol.h), and run a graph instance per connection
+     *
+     * The frames are decoded on a thread pool shared by all sessions and
+     * sent to the input_video stream of the session graph in their original
+     * order. Once max_pending_frames frames of a session are being decoded,
+     * its connection is no longer read, so a fast client is slowed down by
+     * TCP flow control instead of growing the server queues.
+     *
+     * Only JPEG frames are supported; a session sending H.264 is closed.
+     */
+    class FrameIngestServer
+    {
+    private:
+        class Session;
+
+        const CalculatorGraphConfig m_config;
+        const std::map<std::string, Packet> m_side_packets;
+        const FrameIngestServerOptions m_options;
+        const IngestResultsCallback m_on_results;
+
+        std::unique_ptr<ThreadPool> m_decode_pool;
+        int m_listen_fd = -1;
+        int m_port = 0;
+        std::atomic<bool> m_stopping{false};
+        std::thread m_accept_thread;
+
+        struct SessionThread
+        {
+            // Connection, -1 once closed by the session
+            int fd;
+            std::thread thread;
+        };
+
+        absl::Mutex m_mutex;
+        std::map<int, SessionThread> m_sessions ABSL_GUARDED_BY(m_mutex);
+        // Sessions whose thread is done and can be joined
+        std::vector<int> m_finished ABSL_GUARDED_BY(m_mutex);
+        int m_next_session ABSL_GUARDED_BY(m_mutex) = 0;
+
+        void AcceptConnections();
+        void RunSession(int session_id, int fd);
+        void JoinFinishedSessions();
+
+    public:
+        FrameIngestServer(
+            CalculatorGraphConfig config,
+            std::map<std::string, Packet> side_packets,
+            FrameIngestServerOptions options,
+            IngestResultsCallback on_results
+        );
+        ~FrameIngestServer();
+
+        FrameIngestServer(const FrameIngestServer&) = delete;
+        FrameIngestServer& operator=(const FrameIngestServer&) = delete;
+
+        // Listen on the configured port and start accepting clients
+        absl::Status Start();
+        // Disconnect all clients and wait for their graphs to finish
+        void Stop();
+
+        // Port the server listens on
+        int port() const { return m_port; }
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,75 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Runs a proctoring graph for every client streaming frames over TCP.
+#include <cstdlib>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/file_helpers.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/ingest/frame_ingest_server.h"
+
+ABSL_FLAG(std::string, calculator_graph_config_file,
+          "mp_proctor/graphs/proctor_cpu.pbtxt",
+          "Name of file containing text format CalculatorGraphConfig proto.");
+ABSL_FLAG(int, port, 9000, "TCP port to accept clients on.");
+ABSL_FLAG(int, decode_threads, 4, "Threads decoding the frames of all clients.");
+ABSL_FLAG(int, max_pending_frames, 4,
+          "Frames of a client being decoded before the server stops reading "
+          "from it.");
+ABSL_FLAG(int, target_width, 640,
+          "Decode JPEGs at the smallest 1/2, 1/4 or 1/8 scale at least this "
+          "wide, 0 for full resolution.");
+
+absl::Status RunServer() {
+  std::string calculator_graph_config_contents;
+  MP_RETURN_IF_ERROR(mediapipe::file::GetContents(
+      absl::GetFlag(FLAGS_calculator_graph_config_file),
+      &calculator_graph_config_contents));
+  auto config =
+      mediapipe::ParseTextProtoOrDie<mediapipe::CalculatorGraphConfig>(
+          calculator_graph_config_contents);
+
+  mediapipe::FrameIngestServerOptions options;
+  options.port = absl::GetFlag(FLAGS_port);
+  options.decode_threads = absl::GetFlag(FLAGS_decode_threads);
+  options.max_pending_frames = absl::GetFlag(FLAGS_max_pending_frames);
+  options.target_width = absl::GetFlag(FLAGS_target_width);
+  mediapipe::FrameIngestServer server(
+      config, {}, options,
+      [](int session, mediapipe::Timestamp timestamp,
+         const std::vector<ProctorResult>& results) {
+        VLOG(1) << "Session " << session << " at " << timestamp << ": "
+                << results.size() << " face(s)";
+      });
+  MP_RETURN_IF_ERROR(server.Start());
+  // Serve until killed.
+  while (true) absl::SleepFor(absl::Hours(1));
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = RunServer();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to run the server: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
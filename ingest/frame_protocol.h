@@ -0,0 +1,109 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Wire format of the compressed frame ingest connections
+#ifndef frame_protocol_h
+#define frame_protocol_h
+
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include "mediapipe/framework/port/integral_types.h"
+
+namespace mediapipe
+{
+    /**
+     * Each frame is sent as a header followed by payload_bytes of compressed
+     * data. Fields are little endian.
+     *
+     *      uint32 magic            kFrameMagic
+     *      uint32 codec            FrameCodec
+     *      int64  timestamp_us     Capture time
+     *      uint32 payload_bytes
+     */
+    constexpr uint32 kFrameMagic            = 0x5246504d; // "MPFR"
+    constexpr size_t kFrameHeaderBytes      = 20;
+    constexpr uint32 kMaxFramePayloadBytes  = 16 << 20;
+
+    enum class FrameCodec : uint32
+    {
+        kJpeg = 1,
+        kH264 = 2
+    };
+
+    struct FrameHeader
+    {
+        FrameCodec codec;
+        int64 timestamp_us;
+        uint32 payload_bytes;
+    };
+
+    // The supported hosts are little endian, fields are copied as is
+    inline void EncodeFrameHeader(const FrameHeader& header, uint8* bytes)
+    {
+        const uint32 codec = static_cast<uint32>(header.codec);
+        std::memcpy(bytes, &kFrameMagic, 4);
+        std::memcpy(bytes + 4, &codec, 4);
+        std::memcpy(bytes + 8, &header.timestamp_us, 8);
+        std::memcpy(bytes + 16, &header.payload_bytes, 4);
+    }
+
+    // Returns false if the bytes are not a frame header
+    inline bool DecodeFrameHeader(const uint8* bytes, FrameHeader* header)
+    {
+        uint32 magic, codec;
+        std::memcpy(&magic, bytes, 4);
+        std::memcpy(&codec, bytes + 4, 4);
+        std::memcpy(&header->timestamp_us, bytes + 8, 8);
+        std::memcpy(&header->payload_bytes, bytes + 16, 4);
+        header->codec = static_cast<FrameCodec>(codec);
+        return magic == kFrameMagic && header->payload_bytes <= kMaxFramePayloadBytes;
+    }
+
+    // Read exactly size bytes, returns false on error or end of stream
+    inline bool ReadFully(int fd, void* data, size_t size)
+    {
+        auto* bytes = static_cast<uint8*>(data);
+        while (size > 0)
+        {
+            const ssize_t count = read(fd, bytes, size);
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { return false; }
+            bytes += count;
+            size -= count;
+        }
+        return true;
+    }
+
+    // Write exactly size bytes, returns false on error
+    inline bool WriteFully(int fd, const void* data, size_t size)
+    {
+        const auto* bytes = static_cast<const uint8*>(data);
+        while (size > 0)
+        {
+            const ssize_t count = write(fd, bytes, size);
+            if (count < 0 && errno == EINTR) { continue; }
+            if (count <= 0) { return false; }
+            bytes += count;
+            size -= count;
+        }
+        return true;
+    }
+
+} // namespace mediapipe
+
+#endif
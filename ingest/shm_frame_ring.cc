@@ -0,0 +1,273 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Shared memory frame ring between a capture process and the graph
+#include "mp_proctor/ingest/shm_frame_ring.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include "absl/memory/memory.h"
+#include "absl/time/clock.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr uint32 kShmRingMagic   = 0x4d50524e; // "MPRN"
+        constexpr uint32 kShmRingVersion = 1;
+        constexpr size_t kCacheLine      = 64;
+
+        // Busy polls before falling back to sleeping
+        constexpr int kSpinCount = 64;
+        constexpr absl::Duration kPollPeriod = absl::Microseconds(100);
+
+        constexpr size_t RoundUp(size_t size)
+        { return (size + kCacheLine - 1) / kCacheLine * kCacheLine; }
+
+        constexpr size_t kHeaderBytes     = RoundUp(sizeof(ShmRingHeader));
+        constexpr size_t kSlotHeaderBytes = RoundUp(sizeof(ShmSlotHeader));
+
+        size_t RingSize(uint32 slot_count, uint64 slot_stride)
+        { return kHeaderBytes + slot_count * slot_stride; }
+
+        absl::Status ErrnoError(const std::string& what)
+        { return absl::InternalError(what + ": " + std::strerror(errno)); }
+
+        // Wait until ready() returns true, returns false after timeout
+        template<typename Ready>
+        bool WaitFor(Ready ready, absl::Duration timeout)
+        {
+            const absl::Time deadline = absl::Now() + timeout;
+            for (int spin = 0; !ready(); ++spin)
+            {
+                if (spin < kSpinCount) { continue; }
+                if (absl::Now() >= deadline) { return false; }
+                absl::SleepFor(kPollPeriod);
+            }
+            return true;
+        }
+
+        bool IsSupportedFormat(int32 format)
+        {
+            return format == ImageFormat::SRGB || format == ImageFormat::SRGBA ||
+                format == ImageFormat::GRAY8;
+        }
+    } // namespace
+
+    ShmFrameRing::~ShmFrameRing()
+    {
+        if (m_memory != nullptr) { munmap(m_memory, m_size); }
+        if (m_is_owner) { shm_unlink(m_name.c_str()); }
+    }
+
+    absl::StatusOr<std::shared_ptr<ShmFrameRing>> ShmFrameRing::Create(
+        const std::string& name, int slot_count, size_t slot_bytes
+    )
+    {
+        RET_CHECK_GT(slot_count, 0);
+        RET_CHECK_GT(slot_bytes, 0);
+        const uint64 slot_stride = kSlotHeaderBytes + RoundUp(slot_bytes);
+
+        // A crashed producer leaves its ring behind
+        shm_unlink(name.c_str());
+        const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) { return ErrnoError("shm_open " + name); }
+
+        std::shared_ptr<ShmFrameRing> ring(new ShmFrameRing());
+        ring->m_name = name;
+        ring->m_is_owner = true;
+        ring->m_size = RingSize(slot_count, slot_stride);
+        if (ftruncate(fd, ring->m_size) != 0)
+        {
+            close(fd);
+            return ErrnoError("ftruncate " + name);
+        }
+        void* memory = mmap(nullptr, ring->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) { return ErrnoError("mmap " + name); }
+        ring->m_memory = memory;
+
+        // The object is zero filled, the atomics only need to be constructed
+        auto* header = new (memory) ShmRingHeader();
+        header->version = kShmRingVersion;
+        header->slot_count = slot_count;
+        header->slot_bytes = slot_bytes;
+        header->slot_stride = slot_stride;
+        header->closed.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < slot_count; ++i)
+        {
+            auto* slot = new (ring->slot(i)) ShmSlotHeader();
+            slot->sequence.store(i, std::memory_order_relaxed);
+        }
+        header->magic.store(kShmRingMagic, std::memory_order_release);
+        return ring;
+    }
+
+    absl::StatusOr<std::shared_ptr<ShmFrameRing>> ShmFrameRing::Open(const std::string& name)
+    {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0)
+        {
+            return errno == ENOENT ?
+                absl::NotFoundError("No frame ring named " + name):
+                ErrnoError("shm_open " + name);
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < kHeaderBytes)
+        {
+            close(fd);
+            return absl::UnavailableError("Frame ring " + name + " is not initialized yet");
+        }
+
+        std::shared_ptr<ShmFrameRing> ring(new ShmFrameRing());
+        ring->m_name = name;
+        ring->m_size = info.st_size;
+        void* memory = mmap(nullptr, ring->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED) { return ErrnoError("mmap " + name); }
+        ring->m_memory = memory;
+
+        const ShmRingHeader* header = ring->header();
+        if (header->magic.load(std::memory_order_acquire) != kShmRingMagic)
+        {
+            return absl::UnavailableError("Frame ring " + name + " is not initialized yet");
+        }
+        if (header->version != kShmRingVersion)
+        {
+            return absl::FailedPreconditionError("Unsupported frame ring version");
+        }
+        if (RingSize(header->slot_count, header->slot_stride) > ring->m_size)
+        {
+            return absl::DataLossError("Frame ring " + name + " is truncated");
+        }
+        return ring;
+    }
+
+    ShmRingHeader* ShmFrameRing::header() const
+    { return static_cast<ShmRingHeader*>(m_memory); }
+
+    ShmSlotHeader* ShmFrameRing::slot(uint64 position) const
+    {
+        const ShmRingHeader* header = this->header();
+        auto* base = static_cast<uint8*>(m_memory) + kHeaderBytes;
+        return reinterpret_cast<ShmSlotHeader*>(base + (position % header->slot_count) * header->slot_stride);
+    }
+
+    uint8* ShmFrameRing::slot_pixels(uint64 position) const
+    { return reinterpret_cast<uint8*>(this->slot(position)) + kSlotHeaderBytes; }
+
+    ShmFrameProducer::ShmFrameProducer(std::shared_ptr<ShmFrameRing> ring)
+        : m_ring(std::move(ring))
+    {}
+
+    ShmFrameProducer::~ShmFrameProducer()
+    { this->Close(); }
+
+    absl::StatusOr<uint8*> ShmFrameProducer::Acquire(absl::Duration timeout)
+    {
+        ShmSlotHeader* slot = m_ring->slot(m_position);
+        const uint64 position = m_position;
+        const bool is_free = WaitFor(
+            [slot, position]() { return slot->sequence.load(std::memory_order_acquire) == position; },
+            timeout
+        );
+        if (!is_free) { return absl::DeadlineExceededError("The consumer still holds the next slot"); }
+        m_acquired = true;
+        return m_ring->slot_pixels(m_position);
+    }
+
+    absl::Status ShmFrameProducer::Publish(
+        ImageFormat::Format format, int width, int height, int width_step, int64 timestamp_us
+    )
+    {
+        RET_CHECK(m_acquired) << "Publish() without Acquire()";
+        RET_CHECK(IsSupportedFormat(format));
+        RET_CHECK_LE(static_cast<uint64>(width_step) * height, m_ring->header()->slot_bytes);
+
+        ShmSlotHeader* slot = m_ring->slot(m_position);
+        slot->format = format;
+        slot->width = width;
+        slot->height = height;
+        slot->width_step = width_step;
+        slot->timestamp_us = timestamp_us;
+        slot->sequence.store(m_position + 1, std::memory_order_release);
+        ++m_position;
+        m_acquired = false;
+        return absl::OkStatus();
+    }
+
+    absl::Status ShmFrameProducer::Write(
+        ImageFormat::Format format, int width, int height, int width_step,
+        const uint8* pixels, int64 timestamp_us, absl::Duration timeout
+    )
+    {
+        RET_CHECK_LE(static_cast<uint64>(width_step) * height, m_ring->header()->slot_bytes);
+        ASSIGN_OR_RETURN(uint8* slot_pixels, this->Acquire(timeout));
+        std::memcpy(slot_pixels, pixels, static_cast<size_t>(width_step) * height);
+        return this->Publish(format, width, height, width_step, timestamp_us);
+    }
+
+    void ShmFrameProducer::Close()
+    { m_ring->header()->closed.store(1, std::memory_order_release); }
+
+    ShmFrameConsumer::ShmFrameConsumer(std::shared_ptr<ShmFrameRing> ring)
+        : m_ring(std::move(ring))
+    {}
+
+    absl::StatusOr<std::unique_ptr<ImageFrame>> ShmFrameConsumer::Read(absl::Duration timeout, int64* timestamp_us)
+    {
+        const ShmRingHeader* header = m_ring->header();
+        ShmSlotHeader* slot = m_ring->slot(m_position);
+        const uint64 position = m_position;
+        auto is_published = [slot, position]()
+        { return slot->sequence.load(std::memory_order_acquire) == position + 1; };
+
+        const bool is_ready = WaitFor(
+            [&]() { return is_published() || header->closed.load(std::memory_order_acquire) != 0; },
+            timeout
+        );
+        if (!is_ready) { return absl::DeadlineExceededError("No frame from the producer"); }
+        // The last frame is published before the ring is closed
+        if (!is_published()) { return absl::OutOfRangeError("The producer closed the frame ring"); }
+        ++m_position;
+
+        // Hands the slot back to the producer, keeping the mapping alive
+        auto release = [ring = m_ring, slot, next = position + header->slot_count](uint8*)
+        { slot->sequence.store(next, std::memory_order_release); };
+
+        const int32 format = slot->format, width = slot->width, height = slot->height;
+        const int32 width_step = slot->width_step;
+        if (!IsSupportedFormat(format) || width <= 0 || height <= 0 ||
+            width_step < width * ImageFrame::NumberOfChannelsForFormat(static_cast<ImageFormat::Format>(format)) ||
+            static_cast<uint64>(width_step) * height > header->slot_bytes)
+        {
+            release(nullptr);
+            return absl::DataLossError("Invalid frame in the frame ring");
+        }
+        *timestamp_us = slot->timestamp_us;
+        return absl::make_unique<ImageFrame>(
+            static_cast<ImageFormat::Format>(format), width, height, width_step,
+            m_ring->slot_pixels(position), release
+        );
+    }
+
+} // namespace mediapipe
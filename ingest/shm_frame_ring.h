@@ -0,0 +1,164 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Shared memory frame ring between a capture process and the graph
+#ifndef shm_frame_ring_h
+#define shm_frame_ring_h
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "absl/time/time.h"
+#include "mediapipe/framework/formats/image_frame.h"
+#include "mediapipe/framework/port/integral_types.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Header at the start of the shared memory object
+     */
+    struct ShmRingHeader
+    {
+        // kShmRingMagic once the producer initialized the ring
+        std::atomic<uint32> magic;
+        uint32 version;
+        uint32 slot_count;
+        uint32 slot_bytes;
+        // Distance between two slot headers
+        uint64 slot_stride;
+        // Set by the producer after its last frame
+        alignas(64) std::atomic<uint32> closed;
+    };
+
+    /**
+     * @brief Header of a slot, followed by slot_bytes of pixels
+     *
+     * The slot at position p (p % slot_count) is free for the producer while
+     * sequence == p, and holds a frame for the consumer once sequence == p + 1.
+     * Releasing the frame sets sequence to p + slot_count, the next position
+     * of the producer using the slot.
+     */
+    struct ShmSlotHeader
+    {
+        alignas(64) std::atomic<uint64> sequence;
+        // ImageFormat::Format
+        int32 format;
+        int32 width;
+        int32 height;
+        int32 width_step;
+        int64 timestamp_us;
+    };
+
+    static_assert(std::atomic<uint32>::is_always_lock_free, "Shared atomics must be lock free");
+    static_assert(std::atomic<uint64>::is_always_lock_free, "Shared atomics must be lock free");
+
+    /**
+     * @brief Mapping of a single producer single consumer frame ring
+     *
+     * The producer creates the shared memory object and removes it once
+     * destroyed, the consumer opens it.
+     */
+    class ShmFrameRing
+    {
+    private:
+        std::string m_name;
+        bool m_is_owner = false;
+        void* m_memory = nullptr;
+        size_t m_size = 0;
+
+        ShmFrameRing() = default;
+
+    public:
+        ~ShmFrameRing();
+
+        ShmFrameRing(const ShmFrameRing&) = delete;
+        ShmFrameRing& operator=(const ShmFrameRing&) = delete;
+
+        // Create the ring, e.g. "/mp_proctor_frames", replacing any stale one
+        static absl::StatusOr<std::shared_ptr<ShmFrameRing>> Create(
+            const std::string& name, int slot_count, size_t slot_bytes
+        );
+        // Open a ring created by a producer
+        static absl::StatusOr<std::shared_ptr<ShmFrameRing>> Open(const std::string& name);
+
+        ShmRingHeader* header() const;
+        ShmSlotHeader* slot(uint64 position) const;
+        uint8* slot_pixels(uint64 position) const;
+    };
+
+    /**
+     * @brief Writes frames into a ShmFrameRing
+     */
+    class ShmFrameProducer
+    {
+    private:
+        std::shared_ptr<ShmFrameRing> m_ring;
+        uint64 m_position = 0;
+        bool m_acquired = false;
+
+    public:
+        explicit ShmFrameProducer(std::shared_ptr<ShmFrameRing> ring);
+        ~ShmFrameProducer();
+
+        /**
+         * @brief Wait for the next slot to be released by the consumer and
+         *        return its pixel buffer of slot_bytes
+         *
+         * Returns DeadlineExceeded if the slot is still in use after timeout.
+         */
+        absl::StatusOr<uint8*> Acquire(absl::Duration timeout);
+        // Hand the acquired slot over to the consumer
+        absl::Status Publish(ImageFormat::Format format, int width, int height, int width_step, int64 timestamp_us);
+        // Copy a frame into the next slot and publish it
+        absl::Status Write(
+            ImageFormat::Format format, int width, int height, int width_step,
+            const uint8* pixels, int64 timestamp_us, absl::Duration timeout
+        );
+        // Tell the consumer that no more frames follow
+        void Close();
+    };
+
+    /**
+     * @brief Reads frames from a ShmFrameRing without copying them
+     *
+     * The returned ImageFrames point into the shared memory, and their slot
+     * goes back to the producer once they are deleted, e.g. when the graph
+     * releases the last packet holding them. Frames may be released in any
+     * order, but the producer stalls on a slot that is still held.
+     */
+    class ShmFrameConsumer
+    {
+    private:
+        std::shared_ptr<ShmFrameRing> m_ring;
+        uint64 m_position = 0;
+
+    public:
+        explicit ShmFrameConsumer(std::shared_ptr<ShmFrameRing> ring);
+
+        /**
+         * @brief Wait for the next frame
+         *
+         * Returns DeadlineExceeded after timeout, and OutOfRange once the
+         * producer closed the ring and all frames were read.
+         */
+        absl::StatusOr<std::unique_ptr<ImageFrame>> Read(absl::Duration timeout, int64* timestamp_us);
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Publishes webcam or video frames into a shared memory frame ring, like a
+// capture daemon would.
+#include <cstdlib>
+
+#include "absl/flags/flag.h"
+#include "absl/flags/parse.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/opencv_imgproc_inc.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mediapipe/framework/port/status.h"
+#include "mp_proctor/ingest/shm_frame_ring.h"
+
+ABSL_FLAG(std::string, ring_name, "/mp_proctor_frames",
+          "Name of the shared memory frame ring.");
+ABSL_FLAG(std::string, input_video_path, "",
+          "Full path of video to send. If not provided, use a webcam.");
+ABSL_FLAG(int, slots, 4, "Number of frames in the ring.");
+ABSL_FLAG(double, timeout_seconds, 5,
+          "Give up if the consumer holds the next slot for this long.");
+
+absl::Status SendFrames() {
+  cv::VideoCapture capture;
+  const bool load_video = !absl::GetFlag(FLAGS_input_video_path).empty();
+  if (load_video) {
+    capture.open(absl::GetFlag(FLAGS_input_video_path));
+  } else {
+    capture.open(0);
+  }
+  RET_CHECK(capture.isOpened());
+  double fps = capture.get(cv::CAP_PROP_FPS);
+  if (fps <= 0) fps = 30;
+
+  cv::Mat frame;
+  RET_CHECK(capture.read(frame)) << "No frames to send.";
+  // Rows padded to 16 bytes, like ImageFrame::kDefaultAlignmentBoundary.
+  const int width_step = (frame.cols * 3 + 15) / 16 * 16;
+  ASSIGN_OR_RETURN(auto ring, mediapipe::ShmFrameRing::Create(
+                                  absl::GetFlag(FLAGS_ring_name),
+                                  absl::GetFlag(FLAGS_slots),
+                                  width_step * frame.rows));
+  mediapipe::ShmFrameProducer producer(ring);
+  LOG(INFO) << "Sending " << frame.cols << "x" << frame.rows << " frames to "
+            << absl::GetFlag(FLAGS_ring_name);
+
+  const absl::Duration timeout =
+      absl::Seconds(absl::GetFlag(FLAGS_timeout_seconds));
+  const absl::Duration period = absl::Seconds(1.0 / fps);
+  const cv::Size size = frame.size();
+  const absl::Time start = absl::Now();
+  int64 sent = 0;
+  do {
+    if (frame.size() != size) {
+      LOG(WARNING) << "The frame size changed, stopping.";
+      break;
+    }
+    // Video files are paced like a camera would deliver them.
+    if (load_video) {
+      const absl::Time deadline = start + period * sent;
+      if (deadline > absl::Now()) absl::SleepFor(deadline - absl::Now());
+    }
+    ASSIGN_OR_RETURN(uint8* pixels, producer.Acquire(timeout));
+    cv::Mat slot(frame.rows, frame.cols, CV_8UC3, pixels, width_step);
+    cv::cvtColor(frame, slot, cv::COLOR_BGR2RGB);
+    MP_RETURN_IF_ERROR(producer.Publish(
+        mediapipe::ImageFormat::SRGB, frame.cols, frame.rows, width_step,
+        absl::ToUnixMicros(absl::Now())));
+    ++sent;
+  } while (capture.read(frame));
+
+  producer.Close();
+  // The consumer keeps its mapping once the ring is removed.
+  LOG(INFO) << "Sent " << sent << " frames.";
+  return absl::OkStatus();
+}
+
+int main(int argc, char** argv) {
+  google::InitGoogleLogging(argv[0]);
+  absl::ParseCommandLine(argc, argv);
+  absl::Status run_status = SendFrames();
+  if (!run_status.ok()) {
+    LOG(ERROR) << "Failed to send the frames: " << run_status.message();
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,330 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Deterministic offline processing of recorded videos
+#include "mp_proctor/offline_processor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cinttypes>
+#include <thread>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "mediapipe/framework/port/logging.h"
+#include "mediapipe/framework/port/opencv_video_inc.h"
+#include "mp_proctor/graphs/module_toggles.h"
+#include "mp_proctor/image_frame_pool.h"
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr char kInputStream[]   = "input_video";
+        constexpr char kResultsStream[] = "multi_face_proctor_results";
+
+        constexpr int kEmbeddingSize  = 128;
+        constexpr int kExpressionSize = 8;
+
+        /**
+         * @brief Forwards the results of consecutive chunks in chunk order
+         *
+         * Results of the earliest unfinished chunk are forwarded right away,
+         * those of later chunks are held back until it finishes.
+         */
+        class OrderedResultsMerger
+        {
+        private:
+            struct Chunk
+            {
+                std::vector<std::pair<Timestamp, std::vector<ProctorResult>>> pending;
+                bool finished = false;
+            };
+
+            absl::Mutex m_mutex;
+            std::vector<Chunk> m_chunks ABSL_GUARDED_BY(m_mutex);
+            size_t m_current ABSL_GUARDED_BY(m_mutex) = 0;
+            const OfflineResultsCallback m_on_results;
+
+        public:
+            OrderedResultsMerger(size_t chunk_count, OfflineResultsCallback on_results)
+                : m_chunks(chunk_count), m_on_results(std::move(on_results))
+            {}
+
+            void Add(size_t chunk, Timestamp timestamp, const std::vector<ProctorResult>& results)
+            {
+                absl::MutexLock lock(&m_mutex);
+                if (chunk == m_current)
+                {
+                    m_on_results(timestamp, results);
+                } else
+                {
+                    m_chunks[chunk].pending.emplace_back(timestamp, results);
+                }
+            }
+
+            void Finish(size_t chunk)
+            {
+                absl::MutexLock lock(&m_mutex);
+                m_chunks[chunk].finished = true;
+                while (m_current < m_chunks.size())
+                {
+                    auto& current = m_chunks[m_current];
+                    for (const auto& entry: current.pending)
+                    {
+                        m_on_results(entry.first, entry.second);
+                    }
+                    current.pending.clear();
+                    if (!current.finished) { break; }
+                    ++m_current;
+                }
+            }
+        };
+    } // namespace
+
+    absl::Status MakeOffline(CalculatorGraphConfig* config)
+    {
+        return BypassCalculators(
+            {"FlowLimiterCalculator", "FrameChangeGateCalculator", "AdaptiveFrameSamplerCalculator"},
+            config
+        );
+    }
+
+    absl::StatusOr<OfflineVideoStats> ProcessVideoOffline(
+        CalculatorGraphConfig config,
+        const OfflineVideoOptions& options,
+        const std::map<std::string, Packet>& side_packets,
+        OfflineResultsCallback on_results
+    )
+    {
+        MP_RETURN_IF_ERROR(MakeOffline(&config));
+        config.set_max_queue_size(options.max_queue_size);
+
+        cv::VideoCapture capture(options.input_video_path);
+        RET_CHECK(capture.isOpened()) << "Could not open " << options.input_video_path;
+        double fps = capture.get(cv::CAP_PROP_FPS);
+        if (fps <= 0) { fps = 30; }
+        const int64 warmup_start_us = std::max<int64>(0, options.start_us - options.warmup_us);
+        if (warmup_start_us > 0)
+        {
+            // Decodes from the preceding keyframe up to the requested time
+            capture.set(cv::CAP_PROP_POS_MSEC, warmup_start_us / 1000.0);
+        }
+
+        CalculatorGraph graph;
+        MP_RETURN_IF_ERROR(graph.Initialize(config));
+        // Backpressure instead of dropping frames
+        graph.SetGraphInputStreamAddMode(CalculatorGraph::GraphInputStreamAddMode::WAIT_TILL_NOT_FULL);
+        MP_RETURN_IF_ERROR(graph.ObserveOutputStream(
+            kResultsStream,
+            [&on_results, &options](const Packet& packet)
+            {
+                if (packet.Timestamp().Value() < options.start_us) { return absl::OkStatus(); }
+                on_results(packet.Timestamp(), packet.Get<std::vector<ProctorResult>>());
+                return absl::OkStatus();
+            }
+        ));
+        MP_RETURN_IF_ERROR(graph.StartRun(side_packets));
+
+        OfflineVideoStats stats;
+        ImageFramePool pool;
+        cv::Mat frame;
+        int64 last_timestamp_us = -1;
+        const absl::Time start = absl::Now();
+        while (capture.read(frame))
+        {
+            // Container timestamps, falling back to the frame rate if the
+            // container has none or they do not increase
+            int64 timestamp_us = static_cast<int64>(capture.get(cv::CAP_PROP_POS_MSEC) * 1000);
+            if (timestamp_us <= last_timestamp_us)
+            {
+                const double frame_index = capture.get(cv::CAP_PROP_POS_FRAMES) - 1;
+                timestamp_us = std::max(
+                    last_timestamp_us + 1,
+                    static_cast<int64>(frame_index * 1e6 / fps)
+                );
+            }
+            if (timestamp_us < warmup_start_us) { continue; }
+            if (options.end_us >= 0 && timestamp_us >= options.end_us) { break; }
+            last_timestamp_us = timestamp_us;
+
+            auto input_frame = pool.Acquire(ImageFormat::SRGB, frame.cols, frame.rows);
+            ConvertBgrToRgb(frame, /*mirror=*/false, input_frame.get());
+            MP_RETURN_IF_ERROR(graph.AddPacketToInputStream(
+                kInputStream, Adopt(input_frame.release()).At(Timestamp(timestamp_us))
+            ));
+            if (timestamp_us < options.start_us)
+            {
+                ++stats.warmup_frames;
+            } else
+            {
+                ++stats.frames;
+            }
+        }
+        MP_RETURN_IF_ERROR(graph.CloseAllInputStreams());
+        MP_RETURN_IF_ERROR(graph.WaitUntilDone());
+        stats.seconds = absl::ToDoubleSeconds(absl::Now() - start);
+
+        return stats;
+    }
+
+    absl::StatusOr<OfflineVideoStats> ProcessVideoInChunks(
+        const CalculatorGraphConfig& config,
+        const OfflineVideoOptions& options,
+        const ChunkedVideoOptions& chunk_options,
+        const std::map<std::string, Packet>& side_packets,
+        OfflineResultsCallback on_results
+    )
+    {
+        RET_CHECK_GT(chunk_options.chunk_us, 0);
+        int64 end_us = options.end_us;
+        if (end_us < 0)
+        {
+            cv::VideoCapture capture(options.input_video_path);
+            RET_CHECK(capture.isOpened()) << "Could not open " << options.input_video_path;
+            const double fps = capture.get(cv::CAP_PROP_FPS);
+            const double frame_count = capture.get(cv::CAP_PROP_FRAME_COUNT);
+            if (fps <= 0 || frame_count <= 0)
+            {
+                LOG(WARNING) << "Unknown video length, processing it in one chunk.";
+                return ProcessVideoOffline(config, options, side_packets, std::move(on_results));
+            }
+            // Rounded up, the last chunk reads up to the end of the video
+            end_us = static_cast<int64>(frame_count * 1e6 / fps) + 1;
+        }
+
+        std::vector<OfflineVideoOptions> chunks;
+        for (int64 start_us = options.start_us; start_us < end_us; start_us += chunk_options.chunk_us)
+        {
+            OfflineVideoOptions chunk = options;
+            chunk.start_us = start_us;
+            chunk.end_us = std::min(end_us, start_us + chunk_options.chunk_us);
+            chunk.warmup_us = chunks.empty() ? options.warmup_us: chunk_options.overlap_us;
+            chunks.push_back(chunk);
+        }
+        if (options.end_us < 0 && !chunks.empty())
+        {
+            // The length from the container is an estimate
+            chunks.back().end_us = -1;
+        }
+
+        OrderedResultsMerger merger(chunks.size(), std::move(on_results));
+        std::atomic<size_t> next_chunk(0);
+        absl::Mutex mutex;
+        absl::Status status;
+        OfflineVideoStats stats;
+        const absl::Time start = absl::Now();
+
+        std::vector<std::thread> workers;
+        const int worker_count = std::max(1, std::min<int>(chunk_options.workers, chunks.size()));
+        for (int i = 0; i < worker_count; ++i)
+        {
+            workers.emplace_back([&]()
+            {
+                for (size_t chunk = next_chunk++; chunk < chunks.size(); chunk = next_chunk++)
+                {
+                    auto chunk_stats = ProcessVideoOffline(
+                        config, chunks[chunk], side_packets,
+                        [&merger, chunk](Timestamp timestamp, const std::vector<ProctorResult>& results)
+                        { merger.Add(chunk, timestamp, results); }
+                    );
+                    merger.Finish(chunk);
+
+                    absl::MutexLock lock(&mutex);
+                    if (!chunk_stats.ok())
+                    {
+                        status.Update(chunk_stats.status());
+                        continue;
+                    }
+                    stats.frames += chunk_stats->frames;
+                    stats.warmup_frames += chunk_stats->warmup_frames;
+                }
+            });
+        }
+        for (auto& worker: workers) { worker.join(); }
+        MP_RETURN_IF_ERROR(status);
+
+        stats.seconds = absl::ToDoubleSeconds(absl::Now() - start);
+        return stats;
+    }
+
+    ProctorResultCsvWriter::~ProctorResultCsvWriter()
+    { this->Close().IgnoreError(); }
+
+    absl::Status ProctorResultCsvWriter::Open(const std::string& path)
+    {
+        MP_RETURN_IF_ERROR(this->Close());
+        m_file = std::fopen(path.c_str(), "w");
+        if (m_file == nullptr)
+        {
+            return absl::NotFoundError("Could not create " + path);
+        }
+
+        std::fputs(
+            "timestamp_us,face,present_fields,is_carried_forward,"
+            "is_left_eye_blinking,is_right_eye_blinking,horizontal_align,"
+            "vertical_align,facial_activity,face_movement",
+            m_file
+        );
+        for (int i = 0; i < kExpressionSize; ++i) { std::fprintf(m_file, ",expression_%d", i); }
+        for (int i = 0; i < kEmbeddingSize; ++i) { std::fprintf(m_file, ",embedding_%d", i); }
+        std::fputc('\n', m_file);
+        return absl::OkStatus();
+    }
+
+    void ProctorResultCsvWriter::Write(Timestamp timestamp, const std::vector<ProctorResult>& results)
+    {
+        if (m_file == nullptr) { return; }
+        for (size_t face = 0; face < results.size(); ++face)
+        {
+            const auto& result = results[face];
+            std::fprintf(
+                m_file, "%" PRId64 ",%zu,%u,%d,%d,%d,%.6f,%.6f,%.6f,%.6f",
+                timestamp.Value(), face, result.present_fields, result.is_carried_forward,
+                result.is_left_eye_blinking, result.is_right_eye_blinking,
+                result.horizontal_align, result.vertical_align,
+                result.facial_activity, result.face_movement
+            );
+            // Probabilities in FacialExpressionType order
+            float probabilities[kExpressionSize] = {0};
+            for (const auto& expression: result.expressions)
+            {
+                if (expression.type >= 0 && expression.type < kExpressionSize)
+                {
+                    probabilities[expression.type] = expression.probability;
+                }
+            }
+            for (float probability: probabilities) { std::fprintf(m_file, ",%.6f", probability); }
+            for (float value: result.face_reid_embeddings) { std::fprintf(m_file, ",%.6f", value); }
+            std::fputc('\n', m_file);
+        }
+    }
+
+    absl::Status ProctorResultCsvWriter::Close()
+    {
+        if (m_file == nullptr) { return absl::OkStatus(); }
+        const bool failed = std::ferror(m_file) != 0;
+        const bool close_failed = std::fclose(m_file) != 0;
+        m_file = nullptr;
+        if (failed || close_failed)
+        {
+            return absl::InternalError("Failed to write the results file");
+        }
+        return absl::OkStatus();
+    }
+
+} // namespace mediapipe
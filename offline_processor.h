@@ -0,0 +1,145 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Deterministic offline processing of recorded videos
+#ifndef offline_processor_h
+#define offline_processor_h
+
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "mediapipe/framework/calculator_framework.h"
+#include "mediapipe/framework/port/status.h"
+#include "mediapipe/framework/port/statusor.h"
+#include "mp_proctor/calculators/util/proctor_result.h"
+
+namespace mediapipe
+{
+    /**
+     * @brief Options of ProcessVideoOffline()
+     */
+    struct OfflineVideoOptions
+    {
+        std::string input_video_path;
+        // Packets queued per stream before the video reader waits
+        int max_queue_size = 8;
+
+        // Time range to report results for, end_us < 0 for the whole video
+        int64 start_us = 0;
+        int64 end_us = -1;
+        // Frames analyzed before start_us to prime the temporal state of the
+        // graph, their results are discarded
+        int64 warmup_us = 0;
+    };
+
+    /**
+     * @brief Options of ProcessVideoInChunks()
+     */
+    struct ChunkedVideoOptions
+    {
+        // Graph instances running in parallel
+        int workers = 2;
+        // Length of a chunk, more chunks than workers balance the load
+        int64 chunk_us = 600 * 1000000LL;
+        // Warmup of each chunk but the first one
+        int64 overlap_us = 1000000;
+    };
+
+    /**
+     * @brief Outcome of ProcessVideoOffline()
+     */
+    struct OfflineVideoStats
+    {
+        // Frames reported, without the warmup frames
+        int64 frames = 0;
+        int64 warmup_frames = 0;
+        double seconds = 0;
+
+        double fps() const { return seconds > 0 ? frames / seconds: 0; }
+    };
+
+    // Called in timestamp order with the results of each frame with faces
+    using OfflineResultsCallback =
+        std::function<void(Timestamp timestamp, const std::vector<ProctorResult>& results)>;
+
+    /**
+     * @brief Turn a live proctoring graph into an offline one
+     *
+     * Bypasses FlowLimiterCalculator, FrameChangeGateCalculator and
+     * AdaptiveFrameSamplerCalculator, so that every frame is analyzed.
+     */
+    absl::Status MakeOffline(CalculatorGraphConfig* config);
+
+    /**
+     * @brief Run every frame of a video file through the graph, as fast as
+     *        the graph allows
+     *
+     * Frames are timestamped with the container timestamps, and the reader
+     * waits whenever an input queue of the graph is full instead of dropping
+     * frames, so the results are reproducible. The graph is made offline with
+     * MakeOffline() and must output multi_face_proctor_results.
+     */
+    absl::StatusOr<OfflineVideoStats> ProcessVideoOffline(
+        CalculatorGraphConfig config,
+        const OfflineVideoOptions& options,
+        const std::map<std::string, Packet>& side_packets,
+        OfflineResultsCallback on_results
+    );
+
+    /**
+     * @brief Split a video into time chunks analyzed by parallel graph
+     *        instances, and merge their results into one ordered stream
+     *
+     * Each chunk but the first is primed with overlap_us of the preceding
+     * video, so that e.g. FaceMovementCalculator and FaceActivityCalculator
+     * have a previous frame to compare the first frame of the chunk with.
+     * on_results is called from the worker threads, one call at a time and
+     * in timestamp order. Falls back to ProcessVideoOffline() if the length
+     * of the video is unknown.
+     */
+    absl::StatusOr<OfflineVideoStats> ProcessVideoInChunks(
+        const CalculatorGraphConfig& config,
+        const OfflineVideoOptions& options,
+        const ChunkedVideoOptions& chunk_options,
+        const std::map<std::string, Packet>& side_packets,
+        OfflineResultsCallback on_results
+    );
+
+    /**
+     * @brief Write ProctorResults as CSV, one row per face and frame
+     */
+    class ProctorResultCsvWriter
+    {
+    private:
+        FILE* m_file = nullptr;
+
+    public:
+        ProctorResultCsvWriter() = default;
+        ~ProctorResultCsvWriter();
+
+        ProctorResultCsvWriter(const ProctorResultCsvWriter&) = delete;
+        ProctorResultCsvWriter& operator=(const ProctorResultCsvWriter&) = delete;
+
+        // Creates the file and writes the header
+        absl::Status Open(const std::string& path);
+        void Write(Timestamp timestamp, const std::vector<ProctorResult>& results);
+        absl::Status Close();
+    };
+
+} // namespace mediapipe
+
+#endif
@@ -0,0 +1,11 @@
+"""Proctoring toolkit with zero-copy NumPy frames.
+
+Frames are (H, W, 3) RGB, (H, W, 4) RGBA or (H, W) gray uint8 arrays.
+Results are NumPy structured arrays of RESULT_DTYPE, one row per face and
+frame; results['embeddings'] is an (N, 128) float32 view and
+results['expressions'] an (N, 8) float32 view of the probabilities in
+FacialExpressionType order.
+"""
+from pymp_proctor._engine import Engine, RESULT_DTYPE, process_video
+
+__all__ = ['Engine', 'RESULT_DTYPE', 'process_video']
@@ -0,0 +1,3 @@
+from pymp_proctor.applications.webcam_proctor import webcam_proctor
+
+__all__ = ['webcam_proctor']
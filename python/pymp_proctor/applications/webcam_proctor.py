@@ -0,0 +1,39 @@
+"""Proctors the webcam and shows the annotated frames."""
+import time
+
+import cv2
+
+from pymp_proctor import Engine
+
+WINDOW_NAME = 'MediaPipe Proctor'
+
+
+def webcam_proctor(camera=0, graph_config=''):
+  engine = Engine(graph_config=graph_config, annotated=True)
+  capture = cv2.VideoCapture(camera)
+  start = time.monotonic()
+  try:
+    while capture.isOpened():
+      ok, frame = capture.read()
+      if not ok:
+        continue
+      rgb = cv2.cvtColor(cv2.flip(frame, 1), cv2.COLOR_BGR2RGB)
+      engine.submit(rgb, int((time.monotonic() - start) * 1e6))
+
+      results = engine.take_results()
+      for result in results:
+        print('face %d: blinking %s/%s, align %.2f/%.2f' % (
+            result['face'], result['is_left_eye_blinking'],
+            result['is_right_eye_blinking'], result['horizontal_align'],
+            result['vertical_align']))
+
+      annotated = engine.latest_frame()
+      if annotated is not None:
+        cv2.imshow(WINDOW_NAME, cv2.cvtColor(annotated, cv2.COLOR_RGB2BGR))
+      # Press any key to exit.
+      if cv2.waitKey(1) >= 0:
+        break
+  finally:
+    capture.release()
+    engine.close()
+    cv2.destroyAllWindows()
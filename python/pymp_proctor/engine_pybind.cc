@@ -0,0 +1,365 @@
+// Copyright 2019 The Authors (https://github.com/sawthiha/mp_proctor/blob/master/AUTHORS).
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// Python bindings of ProctorEngine
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/synchronization/mutex.h"
+#include "mediapipe/framework/port/parse_text_proto.h"
+#include "mp_proctor/engine/proctor_engine.h"
+#include "mp_proctor/graphs/module_toggles.h"
+#include "mp_proctor/graphs/proctor_graph_builder.h"
+#include "mp_proctor/offline_processor.h"
+#include "pybind11/numpy.h"
+#include "pybind11/pybind11.h"
+
+namespace py = pybind11;
+
+namespace mediapipe
+{
+
+    namespace
+    {
+        constexpr int kEmbeddingSize  = 128;
+        constexpr int kExpressionSize = 8;
+
+        /**
+         * @brief Row of the results array, a flat copy of ProctorResult
+         *
+         * expressions holds the probabilities in FacialExpressionType order.
+         */
+        struct ResultRecord
+        {
+            int64_t timestamp_us;
+            int32_t face;
+            uint32_t present_fields;
+            bool is_carried_forward;
+            bool is_left_eye_blinking;
+            bool is_right_eye_blinking;
+            double horizontal_align;
+            double vertical_align;
+            double facial_activity;
+            double face_movement;
+            float expressions[kExpressionSize];
+            float embeddings[kEmbeddingSize];
+        };
+
+        /**
+         * @brief Results gathered on the graph threads, handed to Python in
+         *        one array per call
+         */
+        class ResultsBuffer
+        {
+        private:
+            absl::Mutex m_mutex;
+            std::vector<ResultRecord> m_records ABSL_GUARDED_BY(m_mutex);
+
+        public:
+            void Append(Timestamp timestamp, const std::vector<ProctorResult>& results)
+            {
+                absl::MutexLock lock(&m_mutex);
+                for (size_t face = 0; face < results.size(); ++face)
+                {
+                    const auto& result = results[face];
+                    ResultRecord record = {};
+                    record.timestamp_us = timestamp.Value();
+                    record.face = face;
+                    record.present_fields = result.present_fields;
+                    record.is_carried_forward = result.is_carried_forward;
+                    record.is_left_eye_blinking = result.is_left_eye_blinking;
+                    record.is_right_eye_blinking = result.is_right_eye_blinking;
+                    record.horizontal_align = result.horizontal_align;
+                    record.vertical_align = result.vertical_align;
+                    record.facial_activity = result.facial_activity;
+                    record.face_movement = result.face_movement;
+                    for (const auto& expression: result.expressions)
+                    {
+                        if (expression.type >= 0 && expression.type < kExpressionSize)
+                        {
+                            record.expressions[expression.type] = expression.probability;
+                        }
+                    }
+                    std::memcpy(record.embeddings, result.face_reid_embeddings, sizeof(record.embeddings));
+                    m_records.push_back(record);
+                }
+            }
+
+            std::vector<ResultRecord> Take()
+            {
+                absl::MutexLock lock(&m_mutex);
+                return std::move(m_records);
+            }
+        };
+
+        // Hands the records over to NumPy without copying them
+        py::array_t<ResultRecord> ToArray(std::vector<ResultRecord> records)
+        {
+            auto* buffer = new std::vector<ResultRecord>(std::move(records));
+            py::capsule owner(buffer, [](void* data) { delete static_cast<std::vector<ResultRecord>*>(data); });
+            return py::array_t<ResultRecord>(buffer->size(), buffer->data(), owner);
+        }
+
+        void ThrowIfError(const absl::Status& status)
+        {
+            if (!status.ok()) { throw std::runtime_error(std::string(status.message())); }
+        }
+
+        // Frame layout of an (H, W), (H, W, 3) or (H, W, 4) uint8 array
+        struct FrameLayout
+        {
+            ImageFormat::Format format;
+            int width;
+            int height;
+            int width_step;
+        };
+
+        FrameLayout GetFrameLayout(const py::array& frame, int skip_dims)
+        {
+            if (!py::isinstance<py::array_t<uint8_t>>(frame))
+            {
+                throw py::value_error("Frames must be uint8 arrays");
+            }
+            const int ndim = frame.ndim() - skip_dims;
+            const int channels = ndim == 2 ? 1: (ndim == 3 ? frame.shape(skip_dims + 2): 0);
+            FrameLayout layout;
+            switch (channels)
+            {
+                case 1: layout.format = ImageFormat::GRAY8; break;
+                case 3: layout.format = ImageFormat::SRGB; break;
+                case 4: layout.format = ImageFormat::SRGBA; break;
+                default: throw py::value_error("Frames must be gray, RGB or RGBA arrays");
+            }
+            // Rows may be padded, pixels must be packed
+            if (frame.strides(skip_dims + 1) != channels || (ndim == 3 && frame.strides(skip_dims + 2) != 1))
+            {
+                throw py::value_error("Frame rows must be contiguous");
+            }
+            layout.height = frame.shape(skip_dims);
+            layout.width = frame.shape(skip_dims + 1);
+            layout.width_step = frame.strides(skip_dims);
+            return layout;
+        }
+
+        ProctorEngineOptions MakeOptions(
+            const std::string& graph_config, int max_queue_size, const std::string& drop_policy,
+            bool enable_reid, bool enable_affect, bool annotated
+        )
+        {
+            ProctorEngineOptions options;
+            if (!graph_config.empty() &&
+                !ParseTextProto<CalculatorGraphConfig>(graph_config, &options.config))
+            {
+                throw py::value_error("Could not parse the graph config");
+            }
+            options.max_queue_size = max_queue_size;
+            auto policy = ParseDropPolicy(drop_policy);
+            ThrowIfError(policy.status());
+            options.drop_policy = *policy;
+            options.side_packets = {
+                {kEnableReidSidePacket, MakePacket<bool>(enable_reid)},
+                {kEnableAffectSidePacket, MakePacket<bool>(enable_affect)},
+                {kEnableRenderSidePacket, MakePacket<bool>(annotated)},
+            };
+            return options;
+        }
+
+        /**
+         * @brief ProctorEngine collecting its results for Python
+         */
+        class PyEngine
+        {
+        private:
+            std::unique_ptr<ProctorEngine> m_engine;
+            ResultsBuffer m_results;
+
+            absl::Mutex m_frame_mutex;
+            std::vector<uint8_t> m_frame ABSL_GUARDED_BY(m_frame_mutex);
+            FrameLayout m_frame_layout ABSL_GUARDED_BY(m_frame_mutex) = {ImageFormat::SRGB, 0, 0, 0};
+
+        public:
+            PyEngine(
+                const std::string& graph_config, int max_queue_size, const std::string& drop_policy,
+                bool enable_reid, bool enable_affect, bool annotated
+            )
+            {
+                auto options = MakeOptions(
+                    graph_config, max_queue_size, drop_policy, enable_reid, enable_affect, annotated
+                );
+                EngineFrameCallback on_frame;
+                if (annotated)
+                {
+                    on_frame = [this](Timestamp, const ImageFrame& frame)
+                    {
+                        absl::MutexLock lock(&m_frame_mutex);
+                        m_frame.resize(frame.PixelDataSizeStoredContiguously());
+                        frame.CopyToBuffer(m_frame.data(), m_frame.size());
+                        m_frame_layout = {frame.Format(), frame.Width(), frame.Height(),
+                                          frame.Width() * frame.NumberOfChannels()};
+                    };
+                }
+                py::gil_scoped_release release;
+                auto engine = ProctorEngine::Create(
+                    options,
+                    [this](Timestamp timestamp, const std::vector<ProctorResult>& results)
+                    { m_results.Append(timestamp, results); },
+                    on_frame
+                );
+                ThrowIfError(engine.status());
+                m_engine = std::move(engine).value();
+            }
+
+            ~PyEngine()
+            {
+                py::gil_scoped_release release;
+                m_engine.reset();
+            }
+
+            // The frame is kept alive, not copied, until the graph is done with it
+            void Submit(const py::array& frame, int64_t timestamp_us)
+            {
+                const FrameLayout layout = GetFrameLayout(frame, 0);
+                // Released from a graph thread, which must take the GIL
+                auto* owner = new py::object(frame);
+                auto release = [owner]()
+                {
+                    py::gil_scoped_acquire acquire;
+                    delete owner;
+                };
+                const auto* pixels = static_cast<const uint8*>(frame.data());
+                absl::Status status;
+                {
+                    py::gil_scoped_release release_gil;
+                    status = m_engine->Submit(
+                        layout.format, layout.width, layout.height, layout.width_step,
+                        pixels, timestamp_us, release
+                    );
+                }
+                ThrowIfError(status);
+            }
+
+            py::array_t<ResultRecord> TakeResults()
+            { return ToArray(m_results.Take()); }
+
+            // Copy of the latest annotated frame, None before the first one
+            py::object LatestFrame()
+            {
+                absl::MutexLock lock(&m_frame_mutex);
+                if (m_frame.empty()) { return py::none(); }
+                const int channels = m_frame_layout.width_step / m_frame_layout.width;
+                py::array_t<uint8_t> frame(std::vector<ssize_t>{m_frame_layout.height, m_frame_layout.width, channels});
+                std::memcpy(frame.mutable_data(), m_frame.data(), m_frame.size());
+                return std::move(frame);
+            }
+
+            void Close()
+            {
+                absl::Status status;
+                {
+                    py::gil_scoped_release release;
+                    status = m_engine->Close();
+                }
+                ThrowIfError(status);
+            }
+
+            size_t dropped() const { return m_engine->dropped(); }
+        };
+
+        /**
+         * @brief Analyze every frame of a (T, H, W, C) array, with the GIL
+         *        released for the whole video
+         */
+        py::array_t<ResultRecord> ProcessVideo(
+            const py::array& frames, double fps, const std::string& graph_config,
+            bool enable_reid, bool enable_affect
+        )
+        {
+            if (frames.ndim() < 3) { throw py::value_error("Expected a (T, H, W[, C]) array"); }
+            if (fps <= 0) { throw py::value_error("fps must be positive"); }
+            const FrameLayout layout = GetFrameLayout(frames, 1);
+            const auto* data = static_cast<const uint8*>(frames.data());
+            const ssize_t count = frames.shape(0), frame_stride = frames.strides(0);
+
+            auto options = MakeOptions(graph_config, 2, "block", enable_reid, enable_affect, false);
+            ResultsBuffer results;
+            absl::Status status;
+            {
+                py::gil_scoped_release release;
+                status = [&]() -> absl::Status
+                {
+                    if (options.config.node_size() == 0)
+                    {
+                        ASSIGN_OR_RETURN(auto request, ParseProctorGraphRequest("results"));
+                        ASSIGN_OR_RETURN(options.config, BuildProctorGraph(request));
+                    }
+                    // Every frame is analyzed, like offline videos
+                    MP_RETURN_IF_ERROR(MakeOffline(&options.config));
+                    ASSIGN_OR_RETURN(auto engine, ProctorEngine::Create(
+                        options,
+                        [&results](Timestamp timestamp, const std::vector<ProctorResult>& frame_results)
+                        { results.Append(timestamp, frame_results); },
+                        nullptr
+                    ));
+                    // The array outlives the engine, frames are used in place
+                    for (ssize_t i = 0; i < count; ++i)
+                    {
+                        MP_RETURN_IF_ERROR(engine->Submit(
+                            layout.format, layout.width, layout.height, layout.width_step,
+                            data + i * frame_stride, static_cast<int64>(i * 1e6 / fps), nullptr
+                        ));
+                    }
+                    return engine->Close();
+                }();
+            }
+            ThrowIfError(status);
+            return ToArray(results.Take());
+        }
+    } // namespace
+
+} // namespace mediapipe
+
+PYBIND11_MODULE(_engine, m)
+{
+    using mediapipe::PyEngine;
+    using mediapipe::ResultRecord;
+
+    m.doc() = "Proctoring engine with zero-copy NumPy frames";
+    PYBIND11_NUMPY_DTYPE(ResultRecord, timestamp_us, face, present_fields,
+        is_carried_forward, is_left_eye_blinking, is_right_eye_blinking,
+        horizontal_align, vertical_align, facial_activity, face_movement,
+        expressions, embeddings);
+    m.attr("RESULT_DTYPE") = py::dtype::of<ResultRecord>();
+
+    py::class_<PyEngine>(m, "Engine")
+        .def(py::init<const std::string&, int, const std::string&, bool, bool, bool>(),
+             py::arg("graph_config") = "", py::arg("max_queue_size") = 2,
+             py::arg("drop_policy") = "drop_oldest", py::arg("enable_reid") = true,
+             py::arg("enable_affect") = true, py::arg("annotated") = false)
+        .def("submit", &PyEngine::Submit, py::arg("frame"), py::arg("timestamp_us"),
+             "Submit an RGB, RGBA or gray uint8 frame without copying it.")
+        .def("take_results", &PyEngine::TakeResults,
+             "Results since the last call, as an array of RESULT_DTYPE.")
+        .def("latest_frame", &PyEngine::LatestFrame,
+             "Latest annotated frame, if the engine was created with annotated=True.")
+        .def("close", &PyEngine::Close)
+        .def_property_readonly("dropped", &PyEngine::dropped);
+
+    m.def("process_video", &mediapipe::ProcessVideo,
+          py::arg("frames"), py::arg("fps") = 30.0, py::arg("graph_config") = "",
+          py::arg("enable_reid") = true, py::arg("enable_affect") = true,
+          "Analyze every frame of a (T, H, W, C) uint8 array, returns an array of RESULT_DTYPE.");
+}